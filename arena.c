@@ -0,0 +1,83 @@
+#include "arena.h"
+#include "log.h"
+#include <stdlib.h>
+
+#define ARENA_DEFAULT_BLOCKSIZE (64 * 1024)
+#define ARENA_ALIGNMENT _Alignof(max_align_t)
+
+struct ArenaBlock
+{
+	struct ArenaBlock* next;
+	size_t size;
+	size_t used;
+	_Alignas(max_align_t) char buffer[];
+};
+
+static struct ArenaBlock* arena_newblock(size_t size)
+{
+	struct ArenaBlock* block = malloc(sizeof(struct ArenaBlock) + size);
+	if(!block)
+	{
+		log_error("malloc failed, in <%s>", __func__);
+	}
+
+	block->next = NULL;
+	block->size = size;
+	block->used = 0;
+	return block;
+}
+
+struct Arena* arena_ctor(struct Arena* self, size_t blocksize)
+{
+	log_assert(self, "is NULL");
+
+	//If blocksize is 0, use default size
+	self->blocksize = blocksize ? blocksize : ARENA_DEFAULT_BLOCKSIZE;
+	self->blocks = arena_newblock(self->blocksize);
+	return self;
+}
+
+void* arena_alloc(struct Arena* self, size_t size)
+{
+	log_assert(self, "is NULL");
+	log_assert(size, "Allocating 0 bytes is unnecessary");
+
+	size = (size + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+	struct ArenaBlock* block = self->blocks;
+	if(block->size - block->used < size)
+	{
+		if(size > self->blocksize / 4)
+		{
+			//Big allocations get their own block, placed behind the current
+			//one so that the space left in it is not wasted
+			struct ArenaBlock* bigblock = arena_newblock(size);
+			bigblock->next = block->next;
+			block->next = bigblock;
+			bigblock->used = size;
+			return bigblock->buffer;
+		}
+
+		block = arena_newblock(self->blocksize);
+		block->next = self->blocks;
+		self->blocks = block;
+	}
+
+	void* ret = block->buffer + block->used;
+	block->used += size;
+	return ret;
+}
+
+void arena_dtor(struct Arena* self)
+{
+	log_assert(self, "is NULL");
+
+	struct ArenaBlock* block = self->blocks;
+	while(block)
+	{
+		struct ArenaBlock* next = block->next;
+		free(block);
+		block = next;
+	}
+
+	self->blocks = NULL;
+}
@@ -0,0 +1,18 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+//NOTE: Memory is never freed individually, only all at once in arena_dtor
+struct ArenaBlock;
+struct Arena
+{
+	struct ArenaBlock* blocks;
+	size_t blocksize;
+};
+
+struct Arena* arena_ctor(struct Arena* self, size_t blocksize);
+void* arena_alloc(struct Arena* self, size_t size);
+void arena_dtor(struct Arena* self);
+
+#endif
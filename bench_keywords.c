@@ -0,0 +1,235 @@
+/*
+	Copyright (C) 2017 Erik Wallström
+
+	This file is part of Erwall.
+
+	Erwall is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Erwall is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Erwall.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//Microbenchmark of keyword recognition: erw_getkeyword against the compare
+//chain it replaced. Build with 'make bench', run as
+//'bench_keywords [file] [runs]'. Without a file an identifier-heavy source
+//is generated.
+
+//For the static erw_getkeyword
+#include "erw_tokenizer.c"
+#include "file.h"
+
+#include <stdio.h>
+#include <time.h>
+
+//The keywords in the order the old chain tested them
+static const struct
+{
+	const char* name;
+	size_t len;
+	enum erw_TokenType type;
+} erw_chainkeywords[] = {
+	{"let", sizeof("let") - 1, erw_TOKENTYPE_KEYWORD_LET},
+	{"mut", sizeof("mut") - 1, erw_TOKENTYPE_KEYWORD_MUT},
+	{"func", sizeof("func") - 1, erw_TOKENTYPE_KEYWORD_FUNC},
+	{"type", sizeof("type") - 1, erw_TOKENTYPE_KEYWORD_TYPE},
+	{"return", sizeof("return") - 1, erw_TOKENTYPE_KEYWORD_RETURN},
+	{"if", sizeof("if") - 1, erw_TOKENTYPE_KEYWORD_IF},
+	{"elseif", sizeof("elseif") - 1, erw_TOKENTYPE_KEYWORD_ELSEIF},
+	{"else", sizeof("else") - 1, erw_TOKENTYPE_KEYWORD_ELSE},
+	{"cast", sizeof("cast") - 1, erw_TOKENTYPE_KEYWORD_CAST},
+	{"defer", sizeof("defer") - 1, erw_TOKENTYPE_KEYWORD_DEFER},
+	{"while", sizeof("while") - 1, erw_TOKENTYPE_KEYWORD_WHILE},
+	{"struct", sizeof("struct") - 1, erw_TOKENTYPE_KEYWORD_STRUCT},
+	{"union", sizeof("union") - 1, erw_TOKENTYPE_KEYWORD_UNION},
+	{"enum", sizeof("enum") - 1, erw_TOKENTYPE_KEYWORD_ENUM},
+	{"array", sizeof("array") - 1, erw_TOKENTYPE_KEYWORD_ARRAY},
+	{"unsafe", sizeof("unsafe") - 1, erw_TOKENTYPE_KEYWORD_UNSAFE},
+	{"and", sizeof("and") - 1, erw_TOKENTYPE_OPERATOR_AND},
+	{"or", sizeof("or") - 1, erw_TOKENTYPE_OPERATOR_OR},
+	{"true", sizeof("true") - 1, erw_TOKENTYPE_LITERAL_BOOL},
+	{"false", sizeof("false") - 1, erw_TOKENTYPE_LITERAL_BOOL},
+};
+
+//One length check and memcmp per keyword, like the old chain
+static enum erw_TokenType erw_chainkeyword(const char* text, size_t len)
+{
+	size_t numkeywords = sizeof(erw_chainkeywords)
+		/ sizeof(erw_chainkeywords[0]);
+	for(size_t i = 0; i < numkeywords; i++)
+	{
+		if(erw_chainkeywords[i].len == len &&
+			!memcmp(erw_chainkeywords[i].name, text, len))
+		{
+			return erw_chainkeywords[i].type;
+		}
+	}
+
+	return erw_TOKENTYPE_IDENT;
+}
+
+//About half keywords, the rest identifiers that share their first letters
+static char* erw_bench_generate(size_t numwords)
+{
+	static const char* const words[] = {
+		"let", "mut", "func", "return", "if", "else", "while", "and",
+		"true", "cast", "index", "lettuce", "muted", "function", "result",
+		"iffy", "elsewhere", "whiled", "andrew", "counter"
+	};
+	size_t numchoices = sizeof(words) / sizeof(words[0]);
+
+	char* ret = malloc(numwords * 16 + 1);
+	if(!ret)
+	{
+		log_error("malloc failed <%s>", __func__);
+	}
+
+	size_t pos = 0;
+	uint32_t seed = 1;
+	for(size_t i = 0; i < numwords; i++)
+	{
+		seed = seed * 1664525 + 1013904223;
+		const char* word = words[(seed >> 16) % numchoices];
+		size_t len = strlen(word);
+		memcpy(ret + pos, word, len);
+		pos += len;
+		ret[pos++] = i % 8 == 7 ? '\n' : ' ';
+	}
+
+	ret[pos] = '\0';
+	return ret;
+}
+
+static double erw_bench_now(void)
+{
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec * 1000.0 + time.tv_nsec / 1000000.0;
+}
+
+int main(int argc, char** argv)
+{
+	struct File file = {0};
+	char* generated = NULL;
+	const char* source;
+	if(argc > 1)
+	{
+		file_ctor(&file, argv[1], FILEMODE_READ | FILEMODE_MAP);
+		source = file.data;
+	}
+	else
+	{
+		generated = erw_bench_generate(1200000);
+		source = generated;
+	}
+
+	size_t runs = argc > 2 ? (size_t)atol(argv[2]) : 20;
+
+	//The lowercase words, as the tokenizer would hand them over
+	Vec(size_t) offsets = vec_ctor(size_t, 0);
+	Vec(size_t) lens = vec_ctor(size_t, 0);
+	size_t pos = 0;
+	while(source[pos])
+	{
+		if(islower(source[pos]))
+		{
+			size_t start = pos;
+			while(isalnum(source[pos]) || source[pos] == '_')
+			{
+				pos++;
+			}
+
+			vec_pushback(offsets, start);
+			vec_pushback(lens, pos - start);
+		}
+		else if(isalnum(source[pos]) || source[pos] == '_')
+		{
+			while(isalnum(source[pos]) || source[pos] == '_')
+			{
+				pos++;
+			}
+		}
+		else
+		{
+			pos++;
+		}
+	}
+
+	size_t numwords = vec_getsize(offsets);
+	double besthash = 0.0;
+	double bestchain = 0.0;
+	size_t numkeywords = 0;
+	for(size_t i = 0; i < runs; i++)
+	{
+		//Summing the results keeps the calls from being optimized out
+		size_t hashsum = 0;
+		double start = erw_bench_now();
+		for(size_t j = 0; j < numwords; j++)
+		{
+			hashsum += erw_getkeyword(source + offsets[j], lens[j]);
+		}
+
+		double hashtime = erw_bench_now() - start;
+
+		size_t chainsum = 0;
+		numkeywords = 0;
+		start = erw_bench_now();
+		for(size_t j = 0; j < numwords; j++)
+		{
+			enum erw_TokenType type = erw_chainkeyword(
+				source + offsets[j],
+				lens[j]
+			);
+			chainsum += type;
+			numkeywords += type != erw_TOKENTYPE_IDENT;
+		}
+
+		double chaintime = erw_bench_now() - start;
+		if(hashsum != chainsum)
+		{
+			log_error("The hash and the chain disagree");
+		}
+
+		if(!i || hashtime < besthash)
+		{
+			besthash = hashtime;
+		}
+
+		if(!i || chaintime < bestchain)
+		{
+			bestchain = chaintime;
+		}
+	}
+
+	printf(
+		"%zu words (%zu keywords), best of %zu runs\n"
+			"compare chain: %.2f ms\n"
+			"perfect hash:  %.2f ms (%.2fx)\n",
+		numwords,
+		numkeywords,
+		runs,
+		bestchain,
+		besthash,
+		besthash > 0.0 ? bestchain / besthash : 0.0
+	);
+
+	vec_dtor(lens);
+	vec_dtor(offsets);
+	if(generated)
+	{
+		free(generated);
+	}
+	else
+	{
+		file_dtor(&file);
+	}
+
+	return 0;
+}
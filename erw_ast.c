@@ -18,154 +18,217 @@
 */
 
 #include "erw_ast.h"
+#include "erw_intern.h"
 #include "log.h"
 #include <stdlib.h>
+#include <string.h>
+
+const char* const erw_astnodetypenames[] = {
+	[erw_ASTNODETYPE_START] = "Start",
+	[erw_ASTNODETYPE_FUNCPROT] = "Function Prototype",
+	[erw_ASTNODETYPE_FUNCDEF] = "Function Definition",
+	[erw_ASTNODETYPE_TYPEDECLR] = "Type Declaration",
+	[erw_ASTNODETYPE_VARDECLR] = "Variable Declaration",
+	[erw_ASTNODETYPE_BLOCK] = "Block",
+	[erw_ASTNODETYPE_IF] = "If Statement",
+	[erw_ASTNODETYPE_ELSEIF] = "Elseif Statement",
+	[erw_ASTNODETYPE_ELSE] = "Else Statement",
+	[erw_ASTNODETYPE_RETURN] = "Return Statement",
+	[erw_ASTNODETYPE_ASSIGNMENT] = "Assignment",
+	[erw_ASTNODETYPE_UNEXPR] = "Unary Expression",
+	[erw_ASTNODETYPE_BINEXPR] = "Binary Expression",
+	[erw_ASTNODETYPE_FUNCCALL] = "Function Call",
+	[erw_ASTNODETYPE_CAST] = "Type Cast",
+	[erw_ASTNODETYPE_DEFER] = "Defer Statement",
+	[erw_ASTNODETYPE_WHILE] = "While Statement",
+	[erw_ASTNODETYPE_ENUM] = "Enum Type",
+	[erw_ASTNODETYPE_ENUMMEMBER] = "Enum Member",
+	[erw_ASTNODETYPE_STRUCTMEMBER] = "Struct Member",
+	[erw_ASTNODETYPE_STRUCT] = "Struct Type",
+	[erw_ASTNODETYPE_UNION] = "Union Type",
+	[erw_ASTNODETYPE_UNSAFE] = "Unsafe Statement",
+	[erw_ASTNODETYPE_REFERENCE] = "Reference Type",
+	[erw_ASTNODETYPE_ARRAY] = "Array Type",
+	[erw_ASTNODETYPE_SLICE] = "Slice Type",
+	[erw_ASTNODETYPE_LITERAL] = "Literal",
+	[erw_ASTNODETYPE_TYPE] = "Named Type",
+	[erw_ASTNODETYPE_FUNCTYPE] = "Function Type",
+	[erw_ASTNODETYPE_ACCESS] = "Array Access",
+	[erw_ASTNODETYPE_STRUCTLITERAL] = "Struct Literal",
+	[erw_ASTNODETYPE_ARRAYLITERAL] = "Array Literal",
+	[erw_ASTNODETYPE_UNIONLITERAL] = "Union Literal",
+};
+
+struct erw_AST* erw_ast_ctor(
+	struct erw_AST* self, 
+	const struct erw_TokenStream* tokens)
+{
+	log_assert(self, "is NULL");
+	log_assert(tokens, "is NULL");
+	*self = (struct erw_AST){.tokens = tokens};
+	erw_ast_new(self, erw_ASTNODETYPE_START, erw_AST_NOTOKEN);
+	return self;
+}
 
-const struct erw_ASTNodeType* const erw_ASTNODETYPE_START =
-	&(struct erw_ASTNodeType){"Start"};
-const struct erw_ASTNodeType* const erw_ASTNODETYPE_FUNCPROT =
-	&(struct erw_ASTNodeType){"Function Prototype"};
-const struct erw_ASTNodeType* const erw_ASTNODETYPE_FUNCDEF =
-	&(struct erw_ASTNodeType){"Function Definition"};
-const struct erw_ASTNodeType* const erw_ASTNODETYPE_TYPEDECLR =
-	&(struct erw_ASTNodeType){"Type Declaration"};
-const struct erw_ASTNodeType* const erw_ASTNODETYPE_VARDECLR =
-	&(struct erw_ASTNodeType){"Variable Declaration"};
-const struct erw_ASTNodeType* const erw_ASTNODETYPE_BLOCK =
-	&(struct erw_ASTNodeType){"Block"};
-const struct erw_ASTNodeType* const erw_ASTNODETYPE_IF =
-	&(struct erw_ASTNodeType){"If Statement"};
-const struct erw_ASTNodeType* const erw_ASTNODETYPE_ELSEIF =
-	&(struct erw_ASTNodeType){"Elseif Statement"};
-const struct erw_ASTNodeType* const erw_ASTNODETYPE_ELSE =
-	&(struct erw_ASTNodeType){"Else Statement"};
-const struct erw_ASTNodeType* const erw_ASTNODETYPE_RETURN =
-	&(struct erw_ASTNodeType){"Return Statement"};
-const struct erw_ASTNodeType* const erw_ASTNODETYPE_ASSIGNMENT =
-	&(struct erw_ASTNodeType){"Assignment"};
-const struct erw_ASTNodeType* const erw_ASTNODETYPE_UNEXPR =
-	&(struct erw_ASTNodeType){"Unary Expression"};
-const struct erw_ASTNodeType* const erw_ASTNODETYPE_BINEXPR =
-	&(struct erw_ASTNodeType){"Binary Expression"};
-const struct erw_ASTNodeType* const erw_ASTNODETYPE_FUNCCALL =
-	&(struct erw_ASTNodeType){"Function Call"};
-const struct erw_ASTNodeType* const erw_ASTNODETYPE_CAST =
-	&(struct erw_ASTNodeType){"Type Cast"};
-const struct erw_ASTNodeType* const erw_ASTNODETYPE_DEFER =
-	&(struct erw_ASTNodeType){"Defer Statement"};
-const struct erw_ASTNodeType* const erw_ASTNODETYPE_WHILE =
-	&(struct erw_ASTNodeType){"While Statement"};
-const struct erw_ASTNodeType* const erw_ASTNODETYPE_ENUM =
-	&(struct erw_ASTNodeType){"Enum Type"};
-const struct erw_ASTNodeType* const erw_ASTNODETYPE_ENUMMEMBER =
-	&(struct erw_ASTNodeType){"Enum Member"};
-const struct erw_ASTNodeType* const erw_ASTNODETYPE_STRUCTMEMBER =
-	&(struct erw_ASTNodeType){"Struct Member"};
-const struct erw_ASTNodeType* const erw_ASTNODETYPE_STRUCT =
-	&(struct erw_ASTNodeType){"Struct Type"};
-const struct erw_ASTNodeType* const erw_ASTNODETYPE_UNION =
-	&(struct erw_ASTNodeType){"Union Type"};
-const struct erw_ASTNodeType* const erw_ASTNODETYPE_UNSAFE =
-	&(struct erw_ASTNodeType){"Unsafe Statement"};
-const struct erw_ASTNodeType* const erw_ASTNODETYPE_REFERENCE =
-	&(struct erw_ASTNodeType){"Reference Type"};
-const struct erw_ASTNodeType* const erw_ASTNODETYPE_ARRAY =
-	&(struct erw_ASTNodeType){"Array Type"};
-const struct erw_ASTNodeType* const erw_ASTNODETYPE_SLICE =
-	&(struct erw_ASTNodeType){"Slice Type"};
-const struct erw_ASTNodeType* const erw_ASTNODETYPE_LITERAL =
-	&(struct erw_ASTNodeType){"Literal"};
-const struct erw_ASTNodeType* const erw_ASTNODETYPE_TYPE = 
-	&(struct erw_ASTNodeType){"Named Type"};
-const struct erw_ASTNodeType* const erw_ASTNODETYPE_FUNCTYPE =
-	&(struct erw_ASTNodeType){"Function Type"};
-const struct erw_ASTNodeType* const erw_ASTNODETYPE_ACCESS = 
-	&(struct erw_ASTNodeType){"Array Access"};
-const struct erw_ASTNodeType* const erw_ASTNODETYPE_STRUCTLITERAL = 
-	&(struct erw_ASTNodeType){"Struct Literal"};
-const struct erw_ASTNodeType* const erw_ASTNODETYPE_ARRAYLITERAL =
-	&(struct erw_ASTNodeType){"Array Literal"};
-const struct erw_ASTNodeType* const erw_ASTNODETYPE_UNIONLITERAL = 
-	&(struct erw_ASTNodeType){"Union Literal"};
-
-struct erw_ASTNode* erw_ast_new(
-	const struct erw_ASTNodeType* type, 
-	struct erw_Token* token)
+uint32_t erw_ast_new(
+	struct erw_AST* self,
+	enum erw_ASTNodeType type, 
+	uint32_t token)
 {
-	log_assert(type, "is NULL");
-	struct erw_ASTNode* self = calloc(1, sizeof(struct erw_ASTNode));
-	if(!self)
+	log_assert(self, "is NULL");
+	log_assert(type < erw_ASTNODETYPE_COUNT, "invalid type (%i)", type);
+	log_assert(
+		token == erw_AST_NOTOKEN || token < self->tokens->numtokens, 
+		"out of bounds (%u, %zu)", 
+		token, 
+		self->tokens->numtokens
+	);
+	if(self->numnodes == self->nodecapacity)
 	{
-		log_error("calloc failed, in <%s>", __func__);
-	}
+		if(self->nodecapacity > UINT32_MAX / 2)
+		{
+			log_error("Too many AST nodes");
+		}
 
-	self->token = token;
-	self->type = type;
-	if(self->type == erw_ASTNODETYPE_START)
-	{
-		self->start.children = vec_ctor(struct erw_ASTNode*, 0);
-	}
-	else if(self->type == erw_ASTNODETYPE_FUNCPROT)
-	{
-		self->funcprot.params = vec_ctor(struct erw_ASTNode*, 0);
-	}
-	else if(self->type == erw_ASTNODETYPE_FUNCDEF)
-	{
-		self->funcdef.params = vec_ctor(struct erw_ASTNode*, 0);
-	}
-	else if(self->type == erw_ASTNODETYPE_BLOCK)
-	{
-		self->block.stmts = vec_ctor(struct erw_ASTNode*, 0);
-	}
-	else if(self->type == erw_ASTNODETYPE_IF)
-	{
-		self->if_.elseifs = vec_ctor(struct erw_ASTNode*, 0);
-	}
-	else if(self->type == erw_ASTNODETYPE_FUNCCALL)
-	{
-		self->funccall.args = vec_ctor(struct erw_ASTNode*, 0);
-	}
-	else if(self->type == erw_ASTNODETYPE_ENUM)
-	{
-		self->enum_.members = vec_ctor(struct erw_ASTNode*, 0);
-	}
-	else if(self->type == erw_ASTNODETYPE_STRUCT)
-	{
-		self->struct_.members = vec_ctor(struct erw_ASTNode*, 0);
-	}
-	else if(self->type == erw_ASTNODETYPE_UNION)
-	{
-		self->union_.members = vec_ctor(struct erw_ASTNode*, 0);
+		self->nodecapacity = self->nodecapacity 
+			? self->nodecapacity * 2 
+			: 1024;
+		self->nodes = realloc(
+			self->nodes, 
+			self->nodecapacity * sizeof(struct erw_ASTNode)
+		);
+		if(!self->nodes)
+		{
+			log_error("realloc failed, in <%s>", __func__);
+		}
 	}
-	else if(self->type == erw_ASTNODETYPE_FUNCTYPE)
+
+	struct erw_ASTNode* node = &self->nodes[self->numnodes];
+	memset(node, 0, sizeof(struct erw_ASTNode));
+	node->token = token;
+	node->type = type;
+	return self->numnodes++;
+}
+
+struct erw_ASTList erw_ast_newlist(
+	struct erw_AST* self, 
+	const uint32_t* children,
+	size_t numchildren)
+{
+	log_assert(self, "is NULL");
+	log_assert(children || !numchildren, "is NULL");
+	if(self->numextra + numchildren > self->extracapacity)
 	{
-		self->functype.params = vec_ctor(struct erw_ASTNode*, 0);
+		if(self->numextra + numchildren > UINT32_MAX / 2)
+		{
+			log_error("Too many AST nodes");
+		}
+
+		while(self->numextra + numchildren > self->extracapacity)
+		{
+			self->extracapacity = self->extracapacity 
+				? self->extracapacity * 2 
+				: 1024;
+		}
+
+		self->extra = realloc(
+			self->extra, 
+			self->extracapacity * sizeof(uint32_t)
+		);
+		if(!self->extra)
+		{
+			log_error("realloc failed, in <%s>", __func__);
+		}
 	}
-	else if(self->type == erw_ASTNODETYPE_STRUCTLITERAL)
+
+	struct erw_ASTList list = {.begin = self->numextra, .size = numchildren};
+	if(numchildren)
 	{
-		self->structliteral.names = vec_ctor(struct erw_Token*, 0);
-		self->structliteral.values = vec_ctor(struct erw_ASTNode*, 0);
+		memcpy(
+			self->extra + self->numextra, 
+			children, 
+			numchildren * sizeof(uint32_t)
+		);
 	}
-	else if(self->type == erw_ASTNODETYPE_ARRAYLITERAL)
+
+	self->numextra += numchildren;
+	return list;
+}
+
+struct erw_ASTNode* erw_ast_getnode_(
+	const struct erw_AST* self, 
+	uint32_t index)
+{
+	log_assert(self, "is NULL");
+	log_assert(
+		index && index < self->numnodes, 
+		"invalid child (%u, %zu)", 
+		index, 
+		self->numnodes
+	);
+	return &self->nodes[index];
+}
+
+struct erw_Token erw_ast_gettoken(const struct erw_AST* self, uint32_t token)
+{
+	log_assert(self, "is NULL");
+	log_assert(token != erw_AST_NOTOKEN, "node has no token");
+	return erw_tokenstream_get(self->tokens, token);
+}
+
+struct erw_Literal erw_ast_getliteral(
+	const struct erw_AST* self, 
+	uint32_t token)
+{
+	log_assert(self, "is NULL");
+	log_assert(token != erw_AST_NOTOKEN, "node has no token");
+	return erw_tokenstream_getliteral(self->tokens, token);
+}
+
+const char* erw_ast_getstr(const struct erw_AST* self, uint32_t token)
+{
+	log_assert(self, "is NULL");
+	log_assert(token != erw_AST_NOTOKEN, "node has no token");
+	const char* atom = self->tokens->atoms[token];
+	if(atom)
 	{
-		self->arrayliteral.values = vec_ctor(struct erw_ASTNode*, 0);
+		return atom;
 	}
 
-	return self;
+	return erw_intern(
+		self->tokens->source + self->tokens->offsets[token], 
+		self->tokens->lens[token]
+	);
 }
 
-static void erw_ast_printinternaltoken(struct erw_Token* token, size_t level)
+static void erw_ast_printinternaltoken(
+	const struct erw_AST* self, 
+	uint32_t index, 
+	size_t level)
 {
+	struct erw_Token token = erw_ast_gettoken(self, index);
 	for(size_t i = 0; i < level; i++)
 	{
 		printf("    ");
 		printf("│");
 	}
 	
-	printf("─ %s (%s)\n", token->type->name, token->text);
+	printf(
+		"─ %s (%.*s)\n", 
+		erw_tokentypeinfos[token.type].name, 
+		(int)token.len, 
+		token.text
+	);
 }
 
-static void erw_ast_printinternal(struct erw_ASTNode* ast, size_t level)
+static void erw_ast_printchild(
+	const struct erw_AST* self, 
+	uint32_t child, 
+	size_t level);
+static void erw_ast_printinternal(
+	const struct erw_AST* self, 
+	const struct erw_ASTNode* ast, 
+	size_t level)
 {
 	if(ast != NULL)
 	{
@@ -175,439 +238,265 @@ static void erw_ast_printinternal(struct erw_ASTNode* ast, size_t level)
 			printf("│");
 		}
 		
-		if(ast->token)
+		if(ast->token != erw_AST_NOTOKEN)
 		{
-			printf("─ %s (%s)\n", ast->type->name, ast->token->text);
+			struct erw_Token token = erw_ast_gettoken(self, ast->token);
+			printf(
+				"─ %s (%.*s)\n", 
+				erw_astnodetypenames[ast->type], 
+				(int)token.len, 
+				token.text
+			);
 		}
 		else
 		{
-			printf("─ %s\n", ast->type->name);
+			printf("─ %s\n", erw_astnodetypenames[ast->type]);
 		}
 
-		if(ast->type == erw_ASTNODETYPE_START)
+		switch(ast->type)
 		{
-			for(size_t i = 0; i < vec_getsize(ast->start.children); i++)
+		case erw_ASTNODETYPE_START:
+			for(size_t i = 0; i < ast->start.children.size; i++)
 			{
-				erw_ast_printinternal(ast->start.children[i], level + 1);
+				erw_ast_printchild(
+					self, 
+					self->extra[ast->start.children.begin + i], 
+					level + 1
+				);
 			}
-		}
-		else if(ast->type == erw_ASTNODETYPE_FUNCPROT)
-		{
-			for(size_t i = 0; i < vec_getsize(ast->funcprot.params); i++)
+			break;
+		case erw_ASTNODETYPE_FUNCPROT:
+			for(size_t i = 0; i < ast->funcprot.params.size; i++)
 			{
-				erw_ast_printinternal(ast->funcprot.params[i], level + 1);
+				erw_ast_printchild(
+					self, 
+					self->extra[ast->funcprot.params.begin + i], 
+					level + 1
+				);
 			}
 
-			erw_ast_printinternaltoken(ast->funcprot.name, level + 1);
-			erw_ast_printinternal(ast->funcprot.type, level + 1);
-		}
-		else if(ast->type == erw_ASTNODETYPE_FUNCDEF)
-		{
-			for(size_t i = 0; i < vec_getsize(ast->funcdef.params); i++)
+			erw_ast_printinternaltoken(self, ast->funcprot.name, level + 1);
+			erw_ast_printchild(self, ast->funcprot.type, level + 1);
+			break;
+		case erw_ASTNODETYPE_FUNCDEF:
+			for(size_t i = 0; i < ast->funcdef.params.size; i++)
 			{
-				erw_ast_printinternal(ast->funcdef.params[i], level + 1);
+				erw_ast_printchild(
+					self, 
+					self->extra[ast->funcdef.params.begin + i], 
+					level + 1
+				);
 			}
 
-			erw_ast_printinternaltoken(ast->funcdef.name, level + 1);
-			erw_ast_printinternal(ast->funcdef.type, level + 1);
-			erw_ast_printinternal(ast->funcdef.block, level + 1);
-		}
-		else if(ast->type == erw_ASTNODETYPE_TYPEDECLR)
-		{
-			erw_ast_printinternaltoken(ast->typedeclr.name, level + 1);
-			erw_ast_printinternal(ast->typedeclr.type, level + 1);
-		}
-		else if(ast->type == erw_ASTNODETYPE_VARDECLR)
-		{
-			erw_ast_printinternaltoken(ast->vardeclr.name, level + 1);
-			erw_ast_printinternal(ast->vardeclr.type, level + 1);
-			erw_ast_printinternal(ast->vardeclr.value, level + 1);
-		}
-		else if(ast->type == erw_ASTNODETYPE_BLOCK)
-		{
-			for(size_t i = 0; i < vec_getsize(ast->block.stmts); i++)
+			erw_ast_printinternaltoken(self, ast->funcdef.name, level + 1);
+			erw_ast_printchild(self, ast->funcdef.type, level + 1);
+			erw_ast_printchild(self, ast->funcdef.block, level + 1);
+			break;
+		case erw_ASTNODETYPE_TYPEDECLR:
+			erw_ast_printinternaltoken(self, ast->typedeclr.name, level + 1);
+			erw_ast_printchild(self, ast->typedeclr.type, level + 1);
+			break;
+		case erw_ASTNODETYPE_VARDECLR:
+			erw_ast_printinternaltoken(self, ast->vardeclr.name, level + 1);
+			erw_ast_printchild(self, ast->vardeclr.type, level + 1);
+			erw_ast_printchild(self, ast->vardeclr.value, level + 1);
+			break;
+		case erw_ASTNODETYPE_BLOCK:
+			for(size_t i = 0; i < ast->block.stmts.size; i++)
 			{
-				erw_ast_printinternal(ast->block.stmts[i], level + 1);
+				erw_ast_printchild(
+					self, 
+					self->extra[ast->block.stmts.begin + i], 
+					level + 1
+				);
 			}
-		}
-		else if(ast->type == erw_ASTNODETYPE_IF)
-		{
-			for(size_t i = 0; i < vec_getsize(ast->if_.elseifs); i++)
+			break;
+		case erw_ASTNODETYPE_IF:
+			for(size_t i = 0; i < ast->if_.elseifs.size; i++)
 			{
-				erw_ast_printinternal(ast->if_.elseifs[i], level + 1);
+				erw_ast_printchild(
+					self, 
+					self->extra[ast->if_.elseifs.begin + i], 
+					level + 1
+				);
 			}
 
-			erw_ast_printinternal(ast->if_.expr, level + 1);
-			erw_ast_printinternal(ast->if_.block, level + 1);
-			erw_ast_printinternal(ast->if_.else_, level + 1);
-		}
-		else if(ast->type == erw_ASTNODETYPE_ELSEIF)
-		{
-			erw_ast_printinternal(ast->elseif.expr, level + 1);
-			erw_ast_printinternal(ast->elseif.block, level + 1);
-		}
-		else if(ast->type == erw_ASTNODETYPE_ELSE)
-		{
-			erw_ast_printinternal(ast->else_.block, level + 1);
-		}
-		else if(ast->type == erw_ASTNODETYPE_RETURN)
-		{
-			erw_ast_printinternal(ast->return_.expr, level + 1);
-		}
-		else if(ast->type == erw_ASTNODETYPE_ASSIGNMENT)
-		{
-			erw_ast_printinternal(ast->assignment.assignee, level + 1);
-			erw_ast_printinternal(ast->assignment.expr, level + 1);
-		}
-		else if(ast->type == erw_ASTNODETYPE_UNEXPR)
-		{
-			erw_ast_printinternal(ast->unexpr.expr, level + 1);
-		}
-		else if(ast->type == erw_ASTNODETYPE_BINEXPR)
-		{
-			erw_ast_printinternal(ast->binexpr.expr1, level + 1);
-			erw_ast_printinternal(ast->binexpr.expr2, level + 1);
-		}
-		else if(ast->type == erw_ASTNODETYPE_FUNCCALL)
-		{
-			erw_ast_printinternal(ast->funccall.callee, level + 1);
-			for(size_t i = 0; i < vec_getsize(ast->funccall.args); i++)
+			erw_ast_printchild(self, ast->if_.expr, level + 1);
+			erw_ast_printchild(self, ast->if_.block, level + 1);
+			erw_ast_printchild(self, ast->if_.else_, level + 1);
+			break;
+		case erw_ASTNODETYPE_ELSEIF:
+			erw_ast_printchild(self, ast->elseif.expr, level + 1);
+			erw_ast_printchild(self, ast->elseif.block, level + 1);
+			break;
+		case erw_ASTNODETYPE_ELSE:
+			erw_ast_printchild(self, ast->else_.block, level + 1);
+			break;
+		case erw_ASTNODETYPE_RETURN:
+			erw_ast_printchild(self, ast->return_.expr, level + 1);
+			break;
+		case erw_ASTNODETYPE_ASSIGNMENT:
+			erw_ast_printchild(self, ast->assignment.assignee, level + 1);
+			erw_ast_printchild(self, ast->assignment.expr, level + 1);
+			break;
+		case erw_ASTNODETYPE_UNEXPR:
+			erw_ast_printchild(self, ast->unexpr.expr, level + 1);
+			break;
+		case erw_ASTNODETYPE_BINEXPR:
+			erw_ast_printchild(self, ast->binexpr.expr1, level + 1);
+			erw_ast_printchild(self, ast->binexpr.expr2, level + 1);
+			break;
+		case erw_ASTNODETYPE_FUNCCALL:
+			erw_ast_printchild(self, ast->funccall.callee, level + 1);
+			for(size_t i = 0; i < ast->funccall.args.size; i++)
 			{
-				erw_ast_printinternal(ast->funccall.args[i], level + 1);
+				erw_ast_printchild(
+					self, 
+					self->extra[ast->funccall.args.begin + i], 
+					level + 1
+				);
 			}
-		}
-		else if(ast->type == erw_ASTNODETYPE_DEFER)
-		{
-			erw_ast_printinternal(ast->defer.block, level + 1);
-		}
-		else if(ast->type == erw_ASTNODETYPE_UNSAFE)
-		{
-			erw_ast_printinternal(ast->unsafe.block, level + 1);
-		}
-		else if(ast->type == erw_ASTNODETYPE_CAST)
-		{
-			erw_ast_printinternal(ast->cast.type, level + 1);
-			erw_ast_printinternal(ast->cast.expr, level + 1);
-		}
-		else if(ast->type == erw_ASTNODETYPE_WHILE)
-		{
-			erw_ast_printinternal(ast->while_.expr, level + 1);
-			erw_ast_printinternal(ast->while_.block, level + 1);
-		}
-		else if(ast->type == erw_ASTNODETYPE_ENUM)
-		{
-			for(size_t i = 0; i < vec_getsize(ast->enum_.members); i++)
+			break;
+		case erw_ASTNODETYPE_DEFER:
+			erw_ast_printchild(self, ast->defer.block, level + 1);
+			break;
+		case erw_ASTNODETYPE_UNSAFE:
+			erw_ast_printchild(self, ast->unsafe.block, level + 1);
+			break;
+		case erw_ASTNODETYPE_CAST:
+			erw_ast_printchild(self, ast->cast.type, level + 1);
+			erw_ast_printchild(self, ast->cast.expr, level + 1);
+			break;
+		case erw_ASTNODETYPE_WHILE:
+			erw_ast_printchild(self, ast->while_.expr, level + 1);
+			erw_ast_printchild(self, ast->while_.block, level + 1);
+			break;
+		case erw_ASTNODETYPE_ENUM:
+			for(size_t i = 0; i < ast->enum_.members.size; i++)
 			{
-				erw_ast_printinternal(ast->enum_.members[i], level + 1);
+				erw_ast_printchild(
+					self, 
+					self->extra[ast->enum_.members.begin + i], 
+					level + 1
+				);
 			}
-		}
-		else if(ast->type == erw_ASTNODETYPE_ENUMMEMBER)
-		{
-			erw_ast_printinternaltoken(ast->enummember.name, level + 1);
-			erw_ast_printinternal(ast->enummember.value, level + 1);
-		}
-		else if(ast->type == erw_ASTNODETYPE_STRUCTMEMBER)
-		{
-			erw_ast_printinternaltoken(ast->structmember.name, level + 1);
-			erw_ast_printinternal(ast->structmember.type, level + 1);
-			erw_ast_printinternal(ast->structmember.value, level + 1);
-		}
-		else if(ast->type == erw_ASTNODETYPE_STRUCT)
-		{
-			for(size_t i = 0; i < vec_getsize(ast->struct_.members); i++)
+			break;
+		case erw_ASTNODETYPE_ENUMMEMBER:
+			erw_ast_printinternaltoken(self, ast->enummember.name, level + 1);
+			erw_ast_printchild(self, ast->enummember.value, level + 1);
+			break;
+		case erw_ASTNODETYPE_STRUCTMEMBER:
+			erw_ast_printinternaltoken(self, ast->structmember.name, level + 1);
+			erw_ast_printchild(self, ast->structmember.type, level + 1);
+			erw_ast_printchild(self, ast->structmember.value, level + 1);
+			break;
+		case erw_ASTNODETYPE_STRUCT:
+			for(size_t i = 0; i < ast->struct_.members.size; i++)
 			{
-				erw_ast_printinternal(ast->struct_.members[i], level + 1);
+				erw_ast_printchild(
+					self, 
+					self->extra[ast->struct_.members.begin + i], 
+					level + 1
+				);
 			}
-		}
-		else if(ast->type == erw_ASTNODETYPE_UNION)
-		{
-			for(size_t i = 0; i < vec_getsize(ast->union_.members); i++)
+			break;
+		case erw_ASTNODETYPE_UNION:
+			for(size_t i = 0; i < ast->union_.members.size; i++)
 			{
-				erw_ast_printinternal(ast->union_.members[i], level + 1);
+				erw_ast_printchild(
+					self, 
+					self->extra[ast->union_.members.begin + i], 
+					level + 1
+				);
 			}
-		}
-		else if(ast->type == erw_ASTNODETYPE_REFERENCE)
-		{
-			erw_ast_printinternal(ast->reference.type, level + 1);
-		}
-		else if(ast->type == erw_ASTNODETYPE_ARRAY)
-		{
-			erw_ast_printinternal(ast->array.type, level + 1);
-			erw_ast_printinternal(ast->array.size, level + 1);
-		}
-		else if(ast->type == erw_ASTNODETYPE_SLICE)
-		{
-			erw_ast_printinternal(ast->slice.type, level + 1);
-		}
-		else if(ast->type == erw_ASTNODETYPE_FUNCTYPE)
-		{
-			for(size_t i = 0; i < vec_getsize(ast->functype.params); i++)
+			break;
+		case erw_ASTNODETYPE_REFERENCE:
+			erw_ast_printchild(self, ast->reference.type, level + 1);
+			break;
+		case erw_ASTNODETYPE_ARRAY:
+			erw_ast_printchild(self, ast->array.type, level + 1);
+			erw_ast_printchild(self, ast->array.size, level + 1);
+			break;
+		case erw_ASTNODETYPE_SLICE:
+			erw_ast_printchild(self, ast->slice.type, level + 1);
+			break;
+		case erw_ASTNODETYPE_FUNCTYPE:
+			for(size_t i = 0; i < ast->functype.params.size; i++)
 			{
-				erw_ast_printinternal(ast->functype.params[i], level + 1);
+				erw_ast_printchild(
+					self, 
+					self->extra[ast->functype.params.begin + i], 
+					level + 1
+				);
 			}
 
-			erw_ast_printinternal(ast->functype.type, level + 1);
-		}
-		else if(ast->type == erw_ASTNODETYPE_TYPE) { }
-		else if(ast->type == erw_ASTNODETYPE_LITERAL) { }
-		else if(ast->type == erw_ASTNODETYPE_ACCESS) 
-		{ 
-			erw_ast_printinternal(ast->access.expr, level + 1);
-			erw_ast_printinternal(ast->access.index, level + 1);
-		}
-		else if(ast->type == erw_ASTNODETYPE_STRUCTLITERAL)
-		{
+			erw_ast_printchild(self, ast->functype.type, level + 1);
+			break;
+		case erw_ASTNODETYPE_TYPE:
+		case erw_ASTNODETYPE_LITERAL:
+			break;
+		case erw_ASTNODETYPE_ACCESS:
+			erw_ast_printchild(self, ast->access.expr, level + 1);
+			erw_ast_printchild(self, ast->access.index, level + 1);
+			break;
+		case erw_ASTNODETYPE_STRUCTLITERAL:
 			//Assume equal number of names and values
-			for(size_t i = 0; i < vec_getsize(ast->structliteral.names); i++)
+			for(size_t i = 0; i < ast->structliteral.names.size; i++)
 			{
 				erw_ast_printinternaltoken(
-					ast->structliteral.names[i], 
+					self,
+					erw_ast_getchild(self, ast->structliteral.names, i)->token, 
+					level + 1
+				);
+				erw_ast_printchild(
+					self, 
+					self->extra[ast->structliteral.values.begin + i], 
 					level + 1
 				);
-				erw_ast_printinternal(ast->structliteral.values[i], level + 1);
 			}
-		}
-		else if(ast->type == erw_ASTNODETYPE_ARRAYLITERAL)
-		{
-			for(size_t i = 0; i < vec_getsize(ast->arrayliteral.values); i++)
+			break;
+		case erw_ASTNODETYPE_ARRAYLITERAL:
+			for(size_t i = 0; i < ast->arrayliteral.values.size; i++)
 			{
-				erw_ast_printinternal(ast->arrayliteral.values[i], level + 1);
+				erw_ast_printchild(
+					self, 
+					self->extra[ast->arrayliteral.values.begin + i], 
+					level + 1
+				);
 			}
-		}
-		else if(ast->type == erw_ASTNODETYPE_UNIONLITERAL)
-		{
-			erw_ast_printinternal(ast->unionliteral.type, level + 1);
-			erw_ast_printinternal(ast->unionliteral.value, level + 1);
-		}
-		else
-		{
-			log_assert(0, "This shouldn't happen (%s)'", ast->type->name);
+			break;
+		case erw_ASTNODETYPE_UNIONLITERAL:
+			erw_ast_printchild(self, ast->unionliteral.type, level + 1);
+			erw_ast_printchild(self, ast->unionliteral.value, level + 1);
+			break;
+		default:
+			log_assert(
+				0,
+				"This shouldn't happen (%s)'",
+				erw_astnodetypenames[ast->type]
+			);
+			break;
 		}
 	}
 }
 
-void erw_ast_print(struct erw_ASTNode* ast)
+static void erw_ast_printchild(
+	const struct erw_AST* self, 
+	uint32_t child, 
+	size_t level)
 {
-	log_assert(ast, "is NULL");
-	erw_ast_printinternal(ast, 0);
+	erw_ast_printinternal(self, erw_ast_get(self, child), level);
 }
 
-void erw_ast_dtor(struct erw_ASTNode* ast)
+void erw_ast_print(const struct erw_AST* self)
 {
-	if(!ast)
-	{
-		return;
-	}
-	else if(ast->type == erw_ASTNODETYPE_START)
-	{
-		for(size_t i = 0; i < vec_getsize(ast->start.children); i++)
-		{
-			erw_ast_dtor(ast->start.children[i]);
-		}
-
-		vec_dtor(ast->start.children);
-	}
-	else if(ast->type == erw_ASTNODETYPE_FUNCPROT)
-	{
-		for(size_t i = 0; i < vec_getsize(ast->funcprot.params); i++)
-		{
-			erw_ast_dtor(ast->funcprot.params[i]);
-		}
-
-		vec_dtor(ast->funcprot.params);
-		erw_ast_dtor(ast->funcprot.type);
-	}
-	else if(ast->type == erw_ASTNODETYPE_FUNCDEF)
-	{
-		for(size_t i = 0; i < vec_getsize(ast->funcdef.params); i++)
-		{
-			erw_ast_dtor(ast->funcdef.params[i]);
-		}
-
-		vec_dtor(ast->funcdef.params);
-		erw_ast_dtor(ast->funcdef.type);
-		erw_ast_dtor(ast->funcdef.block);
-	}
-	else if(ast->type == erw_ASTNODETYPE_TYPEDECLR)
-	{
-		erw_ast_dtor(ast->typedeclr.type);
-	}
-	else if(ast->type == erw_ASTNODETYPE_VARDECLR)
-	{
-		erw_ast_dtor(ast->vardeclr.type);
-		erw_ast_dtor(ast->vardeclr.value);
-	}
-	else if(ast->type == erw_ASTNODETYPE_BLOCK)
-	{
-		for(size_t i = 0; i < vec_getsize(ast->block.stmts); i++)
-		{
-			erw_ast_dtor(ast->block.stmts[i]);
-		}
-
-		vec_dtor(ast->block.stmts);
-	}
-	else if(ast->type == erw_ASTNODETYPE_IF)
-	{
-		for(size_t i = 0; i < vec_getsize(ast->if_.elseifs); i++)
-		{
-			erw_ast_dtor(ast->if_.elseifs[i]);
-		}
-
-		vec_dtor(ast->if_.elseifs);
-		erw_ast_dtor(ast->if_.expr);
-		erw_ast_dtor(ast->if_.block);
-		erw_ast_dtor(ast->if_.else_);
-	}
-	else if(ast->type == erw_ASTNODETYPE_ELSEIF)
-	{
-		erw_ast_dtor(ast->elseif.expr);
-		erw_ast_dtor(ast->elseif.block);
-	}
-	else if(ast->type == erw_ASTNODETYPE_ELSE)
-	{
-		erw_ast_dtor(ast->else_.block);
-	}
-	else if(ast->type == erw_ASTNODETYPE_RETURN)
-	{
-		erw_ast_dtor(ast->return_.expr);
-	}
-	else if(ast->type == erw_ASTNODETYPE_ASSIGNMENT)
-	{
-		erw_ast_dtor(ast->assignment.assignee);
-		erw_ast_dtor(ast->assignment.expr);
-	}
-	else if(ast->type == erw_ASTNODETYPE_UNEXPR)
-	{
-		erw_ast_dtor(ast->unexpr.expr);
-	}
-	else if(ast->type == erw_ASTNODETYPE_BINEXPR)
-	{
-		erw_ast_dtor(ast->binexpr.expr1);
-		erw_ast_dtor(ast->binexpr.expr2);
-	}
-	else if(ast->type == erw_ASTNODETYPE_FUNCCALL)
-	{
-		erw_ast_dtor(ast->funccall.callee);
-		for(size_t i = 0; i < vec_getsize(ast->funccall.args); i++)
-		{
-			erw_ast_dtor(ast->funccall.args[i]);
-		}
-
-		vec_dtor(ast->funccall.args);
-	}
-	else if(ast->type == erw_ASTNODETYPE_DEFER)
-	{
-		erw_ast_dtor(ast->defer.block);
-	}
-	else if(ast->type == erw_ASTNODETYPE_UNSAFE)
-	{
-		erw_ast_dtor(ast->unsafe.block);
-	}
-	else if(ast->type == erw_ASTNODETYPE_CAST)
-	{
-		erw_ast_dtor(ast->cast.type);
-		erw_ast_dtor(ast->cast.expr);
-	}
-	else if(ast->type == erw_ASTNODETYPE_WHILE)
-	{
-		erw_ast_dtor(ast->while_.expr);
-		erw_ast_dtor(ast->while_.block);
-	}
-	else if(ast->type == erw_ASTNODETYPE_ENUM)
-	{
-		for(size_t i = 0; i < vec_getsize(ast->enum_.members); i++)
-		{
-			erw_ast_dtor(ast->enum_.members[i]);
-		}
-
-		vec_dtor(ast->enum_.members);
-	}
-	else if(ast->type == erw_ASTNODETYPE_ENUMMEMBER)
-	{
-		erw_ast_dtor(ast->enummember.value);
-	}
-	else if(ast->type == erw_ASTNODETYPE_STRUCTMEMBER)
-	{
-		erw_ast_dtor(ast->structmember.type);
-		erw_ast_dtor(ast->structmember.value);
-	}
-	else if(ast->type == erw_ASTNODETYPE_STRUCT)
-	{
-		for(size_t i = 0; i < vec_getsize(ast->struct_.members); i++)
-		{
-			erw_ast_dtor(ast->struct_.members[i]);
-		}
-
-		vec_dtor(ast->struct_.members);
-	}
-	else if(ast->type == erw_ASTNODETYPE_UNION)
-	{
-		for(size_t i = 0; i < vec_getsize(ast->union_.members); i++)
-		{
-			erw_ast_dtor(ast->union_.members[i]);
-		}
-
-		vec_dtor(ast->union_.members);
-	}
-	else if(ast->type == erw_ASTNODETYPE_REFERENCE)
-	{
-		erw_ast_dtor(ast->reference.type);
-	}
-	else if(ast->type == erw_ASTNODETYPE_ARRAY)
-	{
-		erw_ast_dtor(ast->array.type);
-		erw_ast_dtor(ast->array.size);
-	}
-	else if(ast->type == erw_ASTNODETYPE_SLICE)
-	{
-		erw_ast_dtor(ast->slice.type);
-	}
-	else if(ast->type == erw_ASTNODETYPE_FUNCTYPE)
-	{
-		for(size_t i = 0; i < vec_getsize(ast->functype.params); i++)
-		{
-			erw_ast_dtor(ast->functype.params[i]);
-		}
-
-		vec_dtor(ast->functype.params);
-		erw_ast_dtor(ast->functype.type);
-	}
-	else if(ast->type == erw_ASTNODETYPE_TYPE) { }
-	else if(ast->type == erw_ASTNODETYPE_LITERAL) { }
-	else if(ast->type == erw_ASTNODETYPE_ACCESS) 
-	{ 
-		erw_ast_dtor(ast->access.expr);
-		erw_ast_dtor(ast->access.index);
-	}
-	else if(ast->type == erw_ASTNODETYPE_STRUCTLITERAL)
-	{
-		for(size_t i = 0; i < vec_getsize(ast->structliteral.names); i++)
-		{
-			erw_ast_dtor(ast->structliteral.values[i]);
-		}
-
-		vec_dtor(ast->structliteral.names);
-		vec_dtor(ast->structliteral.values);
-	}
-	else if(ast->type == erw_ASTNODETYPE_ARRAYLITERAL)
-	{
-		for(size_t i = 0; i < vec_getsize(ast->arrayliteral.values); i++)
-		{
-			erw_ast_dtor(ast->arrayliteral.values[i]);
-		}
-
-		vec_dtor(ast->arrayliteral.values);
-	}
-	else if(ast->type == erw_ASTNODETYPE_UNIONLITERAL)
-	{
-		erw_ast_dtor(ast->unionliteral.type);
-		erw_ast_dtor(ast->unionliteral.value);
-	}
-	else
-	{
-		log_assert(0, "This shouldn't happen (%s)'", ast->type->name);
-	}
-
-	free(ast);
+	log_assert(self, "is NULL");
+	erw_ast_printinternal(self, &self->nodes[0], 0);
 }
 
+void erw_ast_dtor(struct erw_AST* self)
+{
+	log_assert(self, "is NULL");
+	free(self->nodes);
+	free(self->extra);
+}
@@ -23,44 +23,52 @@
 #include "erw_tokenizer.h"
 #include "vec.h"
 
-struct erw_ASTNodeType
+enum erw_ASTNodeType
 {
-	const char* name;
+	erw_ASTNODETYPE_START,
+	erw_ASTNODETYPE_FUNCPROT,
+	erw_ASTNODETYPE_FUNCDEF,
+	erw_ASTNODETYPE_TYPEDECLR,
+	erw_ASTNODETYPE_VARDECLR,
+	erw_ASTNODETYPE_BLOCK,
+	erw_ASTNODETYPE_IF,
+	erw_ASTNODETYPE_ELSEIF,
+	erw_ASTNODETYPE_ELSE,
+	erw_ASTNODETYPE_RETURN,
+	erw_ASTNODETYPE_ASSIGNMENT,
+	erw_ASTNODETYPE_UNEXPR,
+	erw_ASTNODETYPE_BINEXPR,
+	erw_ASTNODETYPE_FUNCCALL,
+	erw_ASTNODETYPE_CAST,
+	erw_ASTNODETYPE_DEFER,
+	erw_ASTNODETYPE_WHILE,
+	erw_ASTNODETYPE_ENUM,
+	erw_ASTNODETYPE_STRUCTMEMBER,
+	erw_ASTNODETYPE_ENUMMEMBER,
+	erw_ASTNODETYPE_STRUCT,
+	erw_ASTNODETYPE_UNION,
+	erw_ASTNODETYPE_UNSAFE,
+	erw_ASTNODETYPE_REFERENCE,
+	erw_ASTNODETYPE_ARRAY,
+	erw_ASTNODETYPE_SLICE,
+	erw_ASTNODETYPE_LITERAL,
+	erw_ASTNODETYPE_TYPE,
+	erw_ASTNODETYPE_FUNCTYPE,
+	erw_ASTNODETYPE_ACCESS,
+	erw_ASTNODETYPE_STRUCTLITERAL,
+	erw_ASTNODETYPE_ARRAYLITERAL,
+	erw_ASTNODETYPE_UNIONLITERAL,
+	erw_ASTNODETYPE_COUNT,
 };
 
-extern const struct erw_ASTNodeType* const erw_ASTNODETYPE_START;
-extern const struct erw_ASTNodeType* const erw_ASTNODETYPE_FUNCPROT;
-extern const struct erw_ASTNodeType* const erw_ASTNODETYPE_FUNCDEF;
-extern const struct erw_ASTNodeType* const erw_ASTNODETYPE_TYPEDECLR;
-extern const struct erw_ASTNodeType* const erw_ASTNODETYPE_VARDECLR;
-extern const struct erw_ASTNodeType* const erw_ASTNODETYPE_BLOCK;
-extern const struct erw_ASTNodeType* const erw_ASTNODETYPE_IF;
-extern const struct erw_ASTNodeType* const erw_ASTNODETYPE_ELSEIF;
-extern const struct erw_ASTNodeType* const erw_ASTNODETYPE_ELSE;
-extern const struct erw_ASTNodeType* const erw_ASTNODETYPE_RETURN;
-extern const struct erw_ASTNodeType* const erw_ASTNODETYPE_ASSIGNMENT;
-extern const struct erw_ASTNodeType* const erw_ASTNODETYPE_UNEXPR;
-extern const struct erw_ASTNodeType* const erw_ASTNODETYPE_BINEXPR;
-extern const struct erw_ASTNodeType* const erw_ASTNODETYPE_FUNCCALL;
-extern const struct erw_ASTNodeType* const erw_ASTNODETYPE_CAST;
-extern const struct erw_ASTNodeType* const erw_ASTNODETYPE_DEFER;
-extern const struct erw_ASTNodeType* const erw_ASTNODETYPE_WHILE;
-extern const struct erw_ASTNodeType* const erw_ASTNODETYPE_ENUM;
-extern const struct erw_ASTNodeType* const erw_ASTNODETYPE_STRUCTMEMBER;
-extern const struct erw_ASTNodeType* const erw_ASTNODETYPE_ENUMMEMBER;
-extern const struct erw_ASTNodeType* const erw_ASTNODETYPE_STRUCT;
-extern const struct erw_ASTNodeType* const erw_ASTNODETYPE_UNION;
-extern const struct erw_ASTNodeType* const erw_ASTNODETYPE_UNSAFE;
-extern const struct erw_ASTNodeType* const erw_ASTNODETYPE_REFERENCE;
-extern const struct erw_ASTNodeType* const erw_ASTNODETYPE_ARRAY;
-extern const struct erw_ASTNodeType* const erw_ASTNODETYPE_SLICE;
-extern const struct erw_ASTNodeType* const erw_ASTNODETYPE_LITERAL;
-extern const struct erw_ASTNodeType* const erw_ASTNODETYPE_TYPE;
-extern const struct erw_ASTNodeType* const erw_ASTNODETYPE_FUNCTYPE;
-extern const struct erw_ASTNodeType* const erw_ASTNODETYPE_ACCESS;
-extern const struct erw_ASTNodeType* const erw_ASTNODETYPE_STRUCTLITERAL;
-extern const struct erw_ASTNodeType* const erw_ASTNODETYPE_ARRAYLITERAL;
-extern const struct erw_ASTNodeType* const erw_ASTNODETYPE_UNIONLITERAL;
+extern const char* const erw_astnodetypenames[];
+
+//A range of erw_AST.extra
+struct erw_ASTList
+{
+	uint32_t begin;
+	uint32_t size;
+};
 
 struct erw_ASTNode
 {
@@ -68,199 +76,257 @@ struct erw_ASTNode
 	{
 		struct
 		{
-			Vec(struct erw_ASTNode*) children;
+			struct erw_ASTList children;
 		} start;
 
 		struct
 		{
-			Vec(struct erw_ASTNode*) params;
-			struct erw_Token* name;
-			struct erw_ASTNode* type;
+			struct erw_ASTList params;
+			uint32_t name;
+			uint32_t type;
 			int foreign;
 		} funcprot;
 
 		struct
 		{
-			Vec(struct erw_ASTNode*) params;
-			struct erw_Token* name;
-			struct erw_ASTNode* type;
-			struct erw_ASTNode* block;
+			struct erw_ASTList params;
+			uint32_t name;
+			uint32_t type;
+			uint32_t block;
 		} funcdef;
 
 		struct
 		{
-			struct erw_Token* name;
-			struct erw_ASTNode* type;
+			uint32_t name;
+			uint32_t type;
 		} typedeclr;
 
 		struct
 		{
-			struct erw_Token* name;
-			struct erw_ASTNode* type;
-			struct erw_ASTNode* value;
+			uint32_t name;
+			uint32_t type;
+			uint32_t value;
 			int mutable;
 		} vardeclr;
 
 		struct
 		{
-			struct erw_Token* name;
-			struct erw_ASTNode* type;
-			struct erw_ASTNode* value;
+			uint32_t name;
+			uint32_t type;
+			uint32_t value;
 		} structmember;
 
 		struct
 		{
-			Vec(struct erw_ASTNode*) stmts;
+			struct erw_ASTList stmts;
 		} block;
 
 		struct
 		{
-			Vec(struct erw_ASTNode*) elseifs;
-			struct erw_ASTNode* expr;
-			struct erw_ASTNode* block;
-			struct erw_ASTNode* else_;
+			struct erw_ASTList elseifs;
+			uint32_t expr;
+			uint32_t block;
+			uint32_t else_;
 		} if_;
 
 		struct
 		{
-			struct erw_ASTNode* expr;
-			struct erw_ASTNode* block;
+			uint32_t expr;
+			uint32_t block;
 		} elseif;
 
 		struct
 		{
-			struct erw_ASTNode* block;
+			uint32_t block;
 		} else_;
 
 		struct
 		{
-			struct erw_ASTNode* expr;
+			uint32_t expr;
 		} return_;
 
 		struct
 		{
-			struct erw_ASTNode* assignee;
-			struct erw_ASTNode* expr;
+			uint32_t assignee;
+			uint32_t expr;
 		} assignment;
 
 		struct
 		{
-			struct erw_ASTNode* expr;
+			uint32_t expr;
 			int left; //Used to distinguish reference/dereference //XXX: Ugly
 			int mutable; //Used to distinguish mutable referencing
 		} unexpr;
 
 		struct
 		{
-			struct erw_ASTNode* expr1;
-			struct erw_ASTNode* expr2;
+			uint32_t expr1;
+			uint32_t expr2;
 		} binexpr;
 
 		struct
 		{
-			Vec(struct erw_ASTNode*) args;
-			struct erw_ASTNode* callee;
+			struct erw_ASTList args;
+			uint32_t callee;
 		} funccall;
 
 		struct
 		{
-			struct erw_ASTNode* type;
-			struct erw_ASTNode* expr;
+			uint32_t type;
+			uint32_t expr;
 		} cast;
 
 		struct
 		{
-			struct erw_ASTNode* block;
+			uint32_t block;
 		} defer;
 
 		struct
 		{
-			struct erw_ASTNode* expr;
-			struct erw_ASTNode* block;
+			uint32_t expr;
+			uint32_t block;
 		} while_;
 
 		struct //Add type?
 		{
-			Vec(struct erw_ASTNode*) members;
+			struct erw_ASTList members;
 		} enum_;
 
 		struct
 		{
-			struct erw_Token* name;
-			struct erw_ASTNode* value;
+			uint32_t name;
+			uint32_t value;
 		} enummember;
 
 		struct
 		{
-			Vec(struct erw_ASTNode*) members;
+			struct erw_ASTList members;
 		} struct_;
 
 		struct
 		{
-			Vec(struct erw_ASTNode*) members;
+			struct erw_ASTList members;
 		} union_;
 
 		struct
 		{
-			struct erw_ASTNode* block;
+			uint32_t block;
 		} unsafe;
 
 		struct
 		{
-			struct erw_ASTNode* type;
+			uint32_t type;
 			int mutable;
 		} reference;
 
 		struct
 		{
-			struct erw_ASTNode* type;
-			struct erw_ASTNode* size;
+			uint32_t type;
+			uint32_t size;
 		} array;
 
 		struct
 		{
-			struct erw_ASTNode* type;
+			uint32_t type;
 		} slice;
 
 		struct
 		{
-			Vec(struct erw_ASTNode*) params;
-			struct erw_ASTNode* type;
+			struct erw_ASTList params;
+			uint32_t type;
 		} functype;
 
 		struct
 		{
-			struct erw_ASTNode* expr;
-			struct erw_ASTNode* index;
+			uint32_t expr;
+			uint32_t index;
 		} access;
 
 		struct
 		{
-			Vec(struct erw_Token*) names;
-			Vec(struct erw_ASTNode*) values;
+			struct erw_ASTList names; //Literals, only for their tokens
+			struct erw_ASTList values;
 		} structliteral;
 
 		struct
 		{
-			Vec(struct erw_ASTNode*) values;
+			struct erw_ASTList values;
 		} arrayliteral;
 
 		struct
 		{
-			struct erw_ASTNode* type;
-			struct erw_ASTNode* value;
+			uint32_t type;
+			uint32_t value;
 		} unionliteral;
 	};
 
-	const struct erw_ASTNodeType* type;
-	struct erw_Token* token;
+	enum erw_ASTNodeType type;
+	uint32_t token;
 };
 
-struct erw_ASTNode* erw_ast_new(
-	const struct erw_ASTNodeType* type, 
-	struct erw_Token* token
+//Nodes are stored in one array and refer to each other by index. The root 
+//(erw_ASTNODETYPE_START) is at index 0, which is never a child, so a child of 
+//0 means there is none. Tokens and names of nodes are indices into tokens, 
+//erw_AST_NOTOKEN if a node has none.
+struct erw_AST
+{
+	const struct erw_TokenStream* tokens;
+	struct erw_ASTNode* nodes;
+	uint32_t* extra; //Children of lists
+	size_t numnodes;
+	size_t numextra;
+	size_t nodecapacity;
+	size_t extracapacity;
+};
+
+//NOTE: Node pointers are only valid until the next node is added
+#define erw_ast_get(ast, index) \
+	((index) ? &(ast)->nodes[(index)] : NULL)
+#define erw_ast_getchild(ast, list, i) \
+	(&(ast)->nodes[(ast)->extra[(list).begin + (i)]])
+//For children that are always there. Never NULL, a child of 0 is caught in 
+//debug builds
+#ifndef NDEBUG
+#define erw_ast_getnode(ast, index) erw_ast_getnode_((ast), (index))
+#else
+#define erw_ast_getnode(ast, index) (&(ast)->nodes[(index)])
+#endif
+
+#define erw_AST_NOTOKEN UINT32_MAX
+//Without unpacking the token
+#define erw_ast_gettokentype(ast, token) \
+	((enum erw_TokenType)(ast)->tokens->types[(token)])
+
+//Adds the root
+struct erw_AST* erw_ast_ctor(
+	struct erw_AST* self, 
+	const struct erw_TokenStream* tokens
+);
+uint32_t erw_ast_new(
+	struct erw_AST* self,
+	enum erw_ASTNodeType type, 
+	uint32_t token
+);
+//Copies the children to the end of extra
+struct erw_ASTList erw_ast_newlist(
+	struct erw_AST* self, 
+	const uint32_t* children,
+	size_t numchildren
+);
+struct erw_ASTNode* erw_ast_getnode_(
+	const struct erw_AST* self, 
+	uint32_t index
+);
+//Unpacks a token of a node
+struct erw_Token erw_ast_gettoken(const struct erw_AST* self, uint32_t token);
+//The value of a literal token of a node
+struct erw_Literal erw_ast_getliteral(
+	const struct erw_AST* self, 
+	uint32_t token
 );
-void erw_ast_print(struct erw_ASTNode* ast);
-void erw_ast_dtor(struct erw_ASTNode* ast);
+//The interned string of a token of a node
+const char* erw_ast_getstr(const struct erw_AST* self, uint32_t token);
+void erw_ast_print(const struct erw_AST* self);
+void erw_ast_dtor(struct erw_AST* self);
 
 #endif
@@ -0,0 +1,166 @@
+/*
+	Copyright (C) 2017 Erik Wallström
+
+	This file is part of Erwall.
+
+	Erwall is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Erwall is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Erwall.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "erw_batch.h"
+#include "erw_interpreter.h"
+#include "log.h"
+#include <pthread.h>
+#include <setjmp.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+//The jobs a thread was given. Other threads take from the same cursor when
+//stealing, so ranges get a cache line each.
+struct erw_BatchRange
+{
+	_Alignas(64) atomic_size_t next;
+	size_t end;
+};
+
+struct erw_BatchThread
+{
+	struct erw_BytecodeImage* image;
+	size_t entry;
+	struct erw_BatchJob* jobs;
+	struct erw_BatchRange* ranges;
+	size_t numthreads;
+	size_t index; //Of its own range
+};
+
+static void erw_batch_onerror(void* udata)
+{
+	longjmp(*(jmp_buf*)udata, 1);
+}
+
+//Errors jump back here, the interpreter is then reset for the next job
+static void erw_batch_runjob(
+	struct erw_BatchThread* self,
+	struct erw_Interpreter* interpreter,
+	struct erw_BatchJob* job,
+	jmp_buf* onerror)
+{
+	if(setjmp(*onerror))
+	{
+		job->isfailed = 1;
+		erw_interpreter_dtor(interpreter);
+		erw_interpreter_ctor(interpreter, self->image, erw_BATCH_MAXSTACKSIZE);
+		return;
+	}
+
+	interpreter->registers[0].int_ = job->input;
+	erw_interpreter_call(interpreter, self->entry);
+	job->output = interpreter->registers[0].int_;
+	job->isfailed = 0;
+}
+
+//Takes jobs of its own range first, then goes through the other ranges in
+//turn until all of them are empty
+static void* erw_batch_work(void* udata)
+{
+	struct erw_BatchThread* self = udata;
+	struct erw_Interpreter interpreter;
+	erw_interpreter_ctor(&interpreter, self->image, erw_BATCH_MAXSTACKSIZE);
+
+	jmp_buf onerror;
+	log_seterrorhandler(erw_batch_onerror, &onerror);
+
+	size_t victim = self->index;
+	for(size_t i = 0; i < self->numthreads;)
+	{
+		struct erw_BatchRange* range = &self->ranges[victim];
+		size_t job = atomic_fetch_add_explicit(
+			&range->next,
+			1,
+			memory_order_relaxed
+		);
+		if(job >= range->end)
+		{
+			victim = (victim + 1) % self->numthreads;
+			i++;
+			continue;
+		}
+
+		erw_batch_runjob(self, &interpreter, &self->jobs[job], &onerror);
+	}
+
+	log_seterrorhandler(NULL, NULL);
+	erw_interpreter_dtor(&interpreter);
+	return NULL;
+}
+
+void erw_batch_run(
+	struct erw_BytecodeImage* image,
+	size_t entry,
+	struct erw_BatchJob* jobs,
+	size_t numjobs,
+	size_t numthreads)
+{
+	log_assert(image, "is NULL");
+	log_assert(jobs || !numjobs, "is NULL");
+	log_assert(numthreads, "is 0");
+
+	if(numthreads > numjobs)
+	{
+		numthreads = numjobs ? numjobs : 1;
+	}
+
+	struct erw_BatchRange* ranges = aligned_alloc(
+		_Alignof(struct erw_BatchRange),
+		numthreads * sizeof(struct erw_BatchRange)
+	);
+	struct erw_BatchThread* threads = malloc(
+		numthreads * sizeof(struct erw_BatchThread)
+	);
+	pthread_t* handles = malloc(numthreads * sizeof(pthread_t));
+	if(!ranges || !threads || !handles)
+	{
+		log_error("malloc failed <%s>", __func__);
+	}
+
+	for(size_t i = 0; i < numthreads; i++)
+	{
+		atomic_init(&ranges[i].next, numjobs * i / numthreads);
+		ranges[i].end = numjobs * (i + 1) / numthreads;
+		threads[i] = (struct erw_BatchThread){
+			.image = image,
+			.entry = entry,
+			.jobs = jobs,
+			.ranges = ranges,
+			.numthreads = numthreads,
+			.index = i
+		};
+	}
+
+	for(size_t i = 0; i < numthreads; i++)
+	{
+		if(pthread_create(&handles[i], NULL, erw_batch_work, &threads[i]))
+		{
+			log_error("pthread_create failed <%s>", __func__);
+		}
+	}
+
+	for(size_t i = 0; i < numthreads; i++)
+	{
+		pthread_join(handles[i], NULL);
+	}
+
+	free(handles);
+	free(threads);
+	free(ranges);
+}
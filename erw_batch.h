@@ -0,0 +1,48 @@
+/*
+	Copyright (C) 2017 Erik Wallström
+
+	This file is part of Erwall.
+
+	Erwall is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Erwall is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Erwall.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ERW_BATCH_H
+#define ERW_BATCH_H
+
+#include "erw_bytecode.h"
+
+//Stack of every thread, in slots
+#define erw_BATCH_MAXSTACKSIZE (4 * 1024 * 1024)
+
+struct erw_BatchJob
+{
+	int64_t input; //Passed to the function in r0
+	int64_t output; //r0 once it returned
+	int isfailed; //If it stopped with an error instead, output is then unset
+};
+
+//Calls the function at offset entry once per job, spread over numthreads
+//threads. The image is only read, so all threads share it, but every thread
+//runs its own interpreter. A job that fails doesn't stop the others.
+//Jobs are split evenly up front, threads that are done with theirs take jobs
+//that are left of the others.
+void erw_batch_run(
+	struct erw_BytecodeImage* image,
+	size_t entry,
+	struct erw_BatchJob* jobs,
+	size_t numjobs,
+	size_t numthreads
+);
+
+#endif
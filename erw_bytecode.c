@@ -0,0 +1,1962 @@
+/*
+	Copyright (C) 2017 Erik Wallström
+
+	This file is part of Erwall.
+
+	Erwall is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Erwall is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Erwall.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "erw_bytecode.h"
+#include "erw_error.h"
+#include "erw_intern.h"
+#include "erw_verifier.h"
+#include "log.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define erw_MAXSLOTS UINT16_MAX
+
+enum erw_ValueKind
+{
+	erw_VALUEKIND_INT,
+	erw_VALUEKIND_UINT,
+	erw_VALUEKIND_FLOAT,
+};
+
+struct erw_Value //How a type is represented in a register
+{
+	enum erw_ValueKind kind;
+	size_t size;
+};
+
+struct erw_ScopeSlots
+{
+	struct erw_Scope* scope;
+	size_t base; //Slot of the first variable in the scope
+	size_t numdeclared; //Variables visible at the current statement
+};
+
+struct erw_Deferred
+{
+	struct erw_ASTNode* block;
+	struct erw_Scope* scope;
+	size_t depth; //Number of visible scopes where it was deferred
+};
+
+struct erw_PendingFunc
+{
+	struct erw_ASTNode* node;
+	struct erw_Scope* scope; //The scope of the function itself
+};
+
+struct erw_CallFixup
+{
+	size_t pos; //Position of the jump target in the instruction stream
+	struct erw_ASTNode* node; //The called function
+};
+
+struct erw_FuncOffset
+{
+	struct erw_ASTNode* node;
+	size_t offset;
+};
+
+struct erw_BytecodeGenerator
+{
+	Vec(uint8_t) instructions;
+	Vec(struct erw_BytecodeFunc) functions;
+	Vec(struct erw_BytecodePosition) positions;
+	Vec(struct erw_FuncOffset) offsets;
+	Vec(struct erw_PendingFunc) pending;
+	Vec(struct erw_CallFixup) calls;
+
+	//State of the function being generated
+	Vec(struct erw_ScopeSlots) scopes;
+	Vec(struct erw_Deferred) deferred;
+	struct erw_Type* rettype;
+	size_t numslots;
+	size_t numregs; //Registers are allocated like a stack
+
+	const struct erw_AST* ast;
+	struct erw_Lines* lines;
+};
+
+static void erw_unsupported(
+	struct erw_BytecodeGenerator* self,
+	uint32_t token,
+	const char* what)
+{
+	struct erw_Token unpacked = erw_ast_gettoken(self->ast, token);
+	struct Str msg;
+	str_ctorfmt(&msg, "%s is not supported by the bytecode generator", what);
+	erw_error(
+		msg.data,
+		erw_lines_get(self->lines, unpacked.linenum),
+		unpacked.linenum,
+		unpacked.column,
+		unpacked.column + unpacked.len - 1
+	);
+	str_dtor(&msg);
+}
+
+//Of the token of node
+static enum erw_TokenType erw_tokentype(
+	struct erw_BytecodeGenerator* self,
+	struct erw_ASTNode* node)
+{
+	return erw_ast_gettokentype(self->ast, node->token);
+}
+
+static struct erw_Value erw_getvalue(
+	struct erw_BytecodeGenerator* self,
+	struct erw_Type* type,
+	uint32_t token)
+{
+	struct erw_Type* base = type;
+	while(base->info == erw_TYPEINFO_NAMED)
+	{
+		base = base->named.type;
+	}
+
+	struct erw_Value ret = {.kind = erw_VALUEKIND_UINT, .size = 8};
+	if(base->info == erw_TYPEINFO_INT)
+	{
+		ret.kind = base->int_.signed_ ? erw_VALUEKIND_INT : erw_VALUEKIND_UINT;
+		ret.size = base->int_.size;
+	}
+	else if(base->info == erw_TYPEINFO_FLOAT)
+	{
+		ret.kind = erw_VALUEKIND_FLOAT;
+		ret.size = base->float_.size;
+	}
+	else if(base->info == erw_TYPEINFO_BOOL || base->info == erw_TYPEINFO_CHAR)
+	{
+		ret.size = 1;
+	}
+	else
+	{
+		struct Str typestr = erw_type_tostring(type);
+		struct Str what;
+		str_ctorfmt(&what, "Type '%s'", typestr.data);
+		erw_unsupported(self, token, what.data);
+		str_dtor(&what);
+		str_dtor(&typestr);
+	}
+
+	return ret;
+}
+
+//Instructions emitted from here on are attributed to token
+static void erw_markposition(
+	struct erw_BytecodeGenerator* self,
+	uint32_t token)
+{
+	struct erw_Token unpacked = erw_ast_gettoken(self->ast, token);
+	struct erw_BytecodePosition position = {
+		.offset = vec_getsize(self->instructions),
+		.linenum = unpacked.linenum,
+		.column = unpacked.column
+	};
+
+	size_t numpositions = vec_getsize(self->positions);
+	struct erw_BytecodePosition* last = numpositions 
+		? &self->positions[numpositions - 1] 
+		: NULL;
+	if(last && last->offset == position.offset)
+	{
+		*last = position;
+	}
+	else if(!last 
+		|| last->linenum != position.linenum 
+		|| last->column != position.column)
+	{
+		vec_pushback(self->positions, position);
+	}
+}
+
+static size_t erw_emit(
+	struct erw_BytecodeGenerator* self,
+	const uint8_t* bytes,
+	size_t size)
+{
+	size_t ret = vec_getsize(self->instructions);
+	vec_pushbackwitharr(self->instructions, bytes, size);
+	return ret;
+}
+
+#define erw_EMIT(self, ...) \
+	erw_emit((self), (uint8_t[]){__VA_ARGS__}, sizeof((uint8_t[]){__VA_ARGS__}))
+
+//NOTE: Immediates are little endian, see erw_interpreter.h
+static void erw_emitslot(
+	struct erw_BytecodeGenerator* self,
+	enum erw_InstructionID id,
+	size_t reg,
+	size_t slot)
+{
+	if(id == erw_INSTRUCTIONID_LOAD)
+	{
+		erw_EMIT(self, id, reg, slot & 0xFF, slot >> 8);
+	}
+	else
+	{
+		erw_EMIT(self, id, slot & 0xFF, slot >> 8, reg);
+	}
+}
+
+//Returns the position of the jump target, which is set by erw_patch
+static size_t erw_emitjump(
+	struct erw_BytecodeGenerator* self,
+	enum erw_InstructionID id)
+{
+	return erw_EMIT(self, id, 0, 0, 0, 0) + 1;
+}
+
+static size_t erw_emitjumpreg(
+	struct erw_BytecodeGenerator* self,
+	enum erw_InstructionID id,
+	size_t reg)
+{
+	return erw_EMIT(self, id, reg, 0, 0, 0, 0) + 2;
+}
+
+static void erw_patch(
+	struct erw_BytecodeGenerator* self,
+	size_t pos,
+	size_t target)
+{
+	uint32_t value = target;
+	uint8_t bytes[4] = {value, value >> 8, value >> 16, value >> 24};
+	memcpy(self->instructions + pos, bytes, sizeof(bytes));
+}
+
+static void erw_patchall(
+	struct erw_BytecodeGenerator* self,
+	Vec(size_t) fixups,
+	size_t target)
+{
+	for(size_t i = 0; i < vec_getsize(fixups); i++)
+	{
+		erw_patch(self, fixups[i], target);
+	}
+}
+
+static void erw_emitloadl(
+	struct erw_BytecodeGenerator* self,
+	size_t reg,
+	uint64_t value)
+{
+	if(value <= UINT8_MAX)
+	{
+		erw_EMIT(self, erw_INSTRUCTIONID_LOADL8, reg, value);
+	}
+	else if(value <= UINT16_MAX)
+	{
+		erw_EMIT(self, erw_INSTRUCTIONID_LOADL16, reg, value, value >> 8);
+	}
+	else if(value <= UINT32_MAX)
+	{
+		erw_EMIT(
+			self,
+			erw_INSTRUCTIONID_LOADL32,
+			reg,
+			value,
+			value >> 8,
+			value >> 16,
+			value >> 24
+		);
+	}
+	else
+	{
+		erw_EMIT(
+			self,
+			erw_INSTRUCTIONID_LOADL64,
+			reg,
+			value,
+			value >> 8,
+			value >> 16,
+			value >> 24,
+			value >> 32,
+			value >> 40,
+			value >> 48,
+			value >> 56
+		);
+	}
+}
+
+//Wraps a register to the size of an integer type
+static void erw_emitnarrow(
+	struct erw_BytecodeGenerator* self,
+	size_t reg,
+	struct erw_Value value)
+{
+	if(value.kind == erw_VALUEKIND_FLOAT || value.size >= 8)
+	{
+		return;
+	}
+
+	static const enum erw_InstructionID sext[] = {
+		[1] = erw_INSTRUCTIONID_SEXT8,
+		[2] = erw_INSTRUCTIONID_SEXT16,
+		[4] = erw_INSTRUCTIONID_SEXT32,
+	};
+	static const enum erw_InstructionID zext[] = {
+		[1] = erw_INSTRUCTIONID_ZEXT8,
+		[2] = erw_INSTRUCTIONID_ZEXT16,
+		[4] = erw_INSTRUCTIONID_ZEXT32,
+	};
+
+	erw_EMIT(
+		self,
+		value.kind == erw_VALUEKIND_INT ? sext[value.size] : zext[value.size],
+		reg,
+		reg
+	);
+}
+
+static size_t erw_allocreg(
+	struct erw_BytecodeGenerator* self,
+	uint32_t token)
+{
+	if(self->numregs >= erw_NUMREGISTERS)
+	{
+		erw_unsupported(self, token, "An expression this deep");
+	}
+
+	return self->numregs++;
+}
+
+static struct erw_VarDeclr* erw_findvar(
+	struct erw_BytecodeGenerator* self,
+	const char* name,
+	size_t* slot)
+{
+	//Only variables declared before the current statement are visible, like
+	//when the semantics were checked
+	for(size_t i = vec_getsize(self->scopes); i-- > 0;)
+	{
+		struct erw_ScopeSlots* scope = &self->scopes[i];
+		for(size_t j = 0; j < scope->numdeclared; j++)
+		{
+			struct erw_VarDeclr* var = &scope->scope->variables[j];
+			if(erw_ast_getstr(self->ast, var->node->vardeclr.name) == name)
+			{
+				*slot = scope->base + j;
+				return var;
+			}
+		}
+	}
+
+	log_assert(0, "undeclared variable (%s)", name);
+	return NULL;
+}
+
+static struct erw_Type* erw_gettype(
+	struct erw_BytecodeGenerator* self,
+	struct erw_Scope* scope,
+	struct erw_ASTNode* node)
+{
+	struct erw_Type* ret = NULL;
+	switch(node->type)
+	{
+	case erw_ASTNODETYPE_LITERAL:
+		switch(erw_tokentype(self, node))
+		{
+		case erw_TOKENTYPE_IDENT:
+			{
+				size_t slot;
+				const char* name = erw_ast_getstr(self->ast, node->token);
+				ret = erw_findvar(self, name, &slot)->type;
+			}
+			break;
+		case erw_TOKENTYPE_LITERAL_INT:
+			ret = erw_type_builtins[erw_TYPEBUILTIN_INT32];
+			break;
+		case erw_TOKENTYPE_LITERAL_FLOAT:
+			ret = erw_type_builtins[erw_TYPEBUILTIN_FLOAT32];
+			break;
+		case erw_TOKENTYPE_LITERAL_CHAR:
+			ret = erw_type_builtins[erw_TYPEBUILTIN_CHAR];
+			break;
+		case erw_TOKENTYPE_LITERAL_BOOL:
+			ret = erw_type_builtins[erw_TYPEBUILTIN_BOOL];
+			break;
+		default:
+			erw_unsupported(
+				self,
+				node->token,
+				erw_tokentypeinfos[erw_tokentype(self, node)].name
+			);
+			break;
+		}
+		break;
+	case erw_ASTNODETYPE_BINEXPR:
+		{
+			switch(erw_tokentype(self, node))
+			{
+			case erw_TOKENTYPE_OPERATOR_EQUAL:
+			case erw_TOKENTYPE_OPERATOR_NOTEQUAL:
+			case erw_TOKENTYPE_OPERATOR_LESS:
+			case erw_TOKENTYPE_OPERATOR_LESSOREQUAL:
+			case erw_TOKENTYPE_OPERATOR_GREATER:
+			case erw_TOKENTYPE_OPERATOR_GREATEROREQUAL:
+			case erw_TOKENTYPE_OPERATOR_AND:
+			case erw_TOKENTYPE_OPERATOR_OR:
+				ret = erw_type_builtins[erw_TYPEBUILTIN_BOOL];
+				break;
+			case erw_TOKENTYPE_OPERATOR_ACCESS:
+				erw_unsupported(self, node->token, "Member access");
+				break;
+			default:
+				ret = erw_gettype(
+					self,
+					scope,
+					erw_ast_getnode(self->ast, node->binexpr.expr1)
+				);
+				break;
+			}
+		}
+		break;
+	case erw_ASTNODETYPE_UNEXPR:
+		switch(erw_tokentype(self, node))
+		{
+		case erw_TOKENTYPE_OPERATOR_NOT:
+			ret = erw_type_builtins[erw_TYPEBUILTIN_BOOL];
+			break;
+		case erw_TOKENTYPE_OPERATOR_SUB:
+			ret = erw_gettype(
+				self,
+				scope,
+				erw_ast_getnode(self->ast, node->unexpr.expr)
+			);
+			break;
+		default:
+			erw_unsupported(self, node->token, "Referencing");
+			break;
+		}
+		break;
+	case erw_ASTNODETYPE_CAST:
+		ret = erw_scope_createtype(
+			scope,
+			erw_ast_getnode(self->ast, node->cast.type),
+			self->lines
+		);
+		break;
+	case erw_ASTNODETYPE_FUNCCALL:
+		{
+			struct erw_ASTNode* callee = erw_ast_getnode(
+				self->ast,
+				node->funccall.callee
+			);
+			if(callee->type != erw_ASTNODETYPE_LITERAL)
+			{
+				erw_unsupported(self, node->token, "Calling a function value");
+			}
+
+			ret = erw_scope_findfunc(
+				scope,
+				erw_ast_getstr(self->ast, callee->token)
+			)->type;
+		}
+		break;
+	default:
+		erw_unsupported(self, node->token, erw_astnodetypenames[node->type]);
+		break;
+	}
+
+	return ret;
+}
+
+static size_t erw_lowerexpr(
+	struct erw_BytecodeGenerator* self,
+	struct erw_Scope* scope,
+	struct erw_ASTNode* node
+);
+
+static int erw_iscomparison(
+	struct erw_BytecodeGenerator* self,
+	struct erw_ASTNode* node)
+{
+	if(node->type != erw_ASTNODETYPE_BINEXPR)
+	{
+		return 0;
+	}
+
+	enum erw_TokenType op = erw_tokentype(self, node);
+	return op == erw_TOKENTYPE_OPERATOR_EQUAL
+		|| op == erw_TOKENTYPE_OPERATOR_NOTEQUAL
+		|| op == erw_TOKENTYPE_OPERATOR_LESS
+		|| op == erw_TOKENTYPE_OPERATOR_LESSOREQUAL
+		|| op == erw_TOKENTYPE_OPERATOR_GREATER
+		|| op == erw_TOKENTYPE_OPERATOR_GREATEROREQUAL;
+}
+
+//The instruction of an arithmetic operator, or its assigning form, on value
+static enum erw_InstructionID erw_getarithmetic(
+	enum erw_TokenType op, 
+	struct erw_Value value)
+{
+	int isfloat = value.kind == erw_VALUEKIND_FLOAT;
+	int isuint = value.kind == erw_VALUEKIND_UINT;
+	switch(op)
+	{
+	case erw_TOKENTYPE_OPERATOR_ADD:
+	case erw_TOKENTYPE_OPERATOR_ADDASSIGN:
+		return isfloat ? erw_INSTRUCTIONID_FADD : erw_INSTRUCTIONID_ADD;
+	case erw_TOKENTYPE_OPERATOR_SUB:
+	case erw_TOKENTYPE_OPERATOR_SUBASSIGN:
+		return isfloat ? erw_INSTRUCTIONID_FSUB : erw_INSTRUCTIONID_SUB;
+	case erw_TOKENTYPE_OPERATOR_MUL:
+	case erw_TOKENTYPE_OPERATOR_MULASSIGN:
+		return isfloat ? erw_INSTRUCTIONID_FMUL : erw_INSTRUCTIONID_MUL;
+	case erw_TOKENTYPE_OPERATOR_DIV:
+	case erw_TOKENTYPE_OPERATOR_DIVASSIGN:
+		return isfloat ? erw_INSTRUCTIONID_FDIV
+			: isuint ? erw_INSTRUCTIONID_UDIV : erw_INSTRUCTIONID_DIV;
+	case erw_TOKENTYPE_OPERATOR_MOD:
+	case erw_TOKENTYPE_OPERATOR_MODASSIGN:
+		return isfloat ? erw_INSTRUCTIONID_FMOD
+			: isuint ? erw_INSTRUCTIONID_UMOD : erw_INSTRUCTIONID_MOD;
+	case erw_TOKENTYPE_OPERATOR_POW:
+	case erw_TOKENTYPE_OPERATOR_POWASSIGN:
+		return isfloat ? erw_INSTRUCTIONID_FPOW : erw_INSTRUCTIONID_POW;
+	default:
+		log_assert(
+			0,
+			"this shouldn't happen (%s)",
+			erw_tokentypeinfos[op].name
+		);
+		return erw_INSTRUCTIONID_ADD;
+	}
+}
+
+//Emits the compare of a comparison and returns the conditional jump that is
+//taken when it is true
+static enum erw_InstructionID erw_lowercompare(
+	struct erw_BytecodeGenerator* self,
+	struct erw_Scope* scope,
+	struct erw_ASTNode* node,
+	int* isfloat)
+{
+	struct erw_ASTNode* expr1 = erw_ast_getnode(self->ast, node->binexpr.expr1);
+	struct erw_ASTNode* expr2 = erw_ast_getnode(self->ast, node->binexpr.expr2);
+	struct erw_Value value = erw_getvalue(
+		self,
+		erw_gettype(self, scope, expr1),
+		node->token
+	);
+
+	size_t reg1 = erw_lowerexpr(self, scope, expr1);
+	size_t reg2 = erw_lowerexpr(self, scope, expr2);
+	if(value.kind == erw_VALUEKIND_FLOAT)
+	{
+		erw_EMIT(self, erw_INSTRUCTIONID_FCMP, reg1, reg2);
+	}
+	else if(value.kind == erw_VALUEKIND_UINT)
+	{
+		erw_EMIT(self, erw_INSTRUCTIONID_UCMP, reg1, reg2);
+	}
+	else
+	{
+		erw_EMIT(self, erw_INSTRUCTIONID_CMP, reg1, reg2);
+	}
+
+	self->numregs = reg1;
+	*isfloat = value.kind == erw_VALUEKIND_FLOAT;
+
+	enum erw_TokenType op = erw_tokentype(self, node);
+	switch(op)
+	{
+	case erw_TOKENTYPE_OPERATOR_EQUAL:
+		return erw_INSTRUCTIONID_JE;
+	case erw_TOKENTYPE_OPERATOR_NOTEQUAL:
+		return erw_INSTRUCTIONID_JNE;
+	case erw_TOKENTYPE_OPERATOR_LESS:
+		return erw_INSTRUCTIONID_JL;
+	case erw_TOKENTYPE_OPERATOR_LESSOREQUAL:
+		return erw_INSTRUCTIONID_JLE;
+	case erw_TOKENTYPE_OPERATOR_GREATER:
+		return erw_INSTRUCTIONID_JG;
+	default:
+		return erw_INSTRUCTIONID_JGE;
+	}
+}
+
+//Emits jumps that are taken when the boolean expression equals jumpif, their
+//targets are pushed to fixups
+static void erw_lowerbranch(
+	struct erw_BytecodeGenerator* self,
+	struct erw_Scope* scope,
+	struct erw_ASTNode* node,
+	int jumpif,
+	Vec(size_t)* fixups)
+{
+	if(node->type == erw_ASTNODETYPE_BINEXPR
+		&& (erw_tokentype(self, node) == erw_TOKENTYPE_OPERATOR_AND
+			|| erw_tokentype(self, node) == erw_TOKENTYPE_OPERATOR_OR))
+	{
+		int isand = erw_tokentype(self, node) == erw_TOKENTYPE_OPERATOR_AND;
+		if(isand != jumpif)
+		{
+			//Both operands decide on their own, e.g. 'a and b' is false as soon
+			//as one of them is false
+			erw_lowerbranch(
+				self,
+				scope,
+				erw_ast_getnode(self->ast, node->binexpr.expr1),
+				jumpif,
+				fixups
+			);
+			erw_lowerbranch(
+				self,
+				scope,
+				erw_ast_getnode(self->ast, node->binexpr.expr2),
+				jumpif,
+				fixups
+			);
+		}
+		else
+		{
+			Vec(size_t) skip = vec_ctor(size_t, 0);
+			erw_lowerbranch(
+				self,
+				scope,
+				erw_ast_getnode(self->ast, node->binexpr.expr1),
+				!jumpif,
+				&skip
+			);
+			erw_lowerbranch(
+				self,
+				scope,
+				erw_ast_getnode(self->ast, node->binexpr.expr2),
+				jumpif,
+				fixups
+			);
+			erw_patchall(self, skip, vec_getsize(self->instructions));
+			vec_dtor(skip);
+		}
+	}
+	else if(node->type == erw_ASTNODETYPE_UNEXPR
+		&& erw_tokentype(self, node) == erw_TOKENTYPE_OPERATOR_NOT)
+	{
+		erw_lowerbranch(
+			self,
+			scope,
+			erw_ast_getnode(self->ast, node->unexpr.expr),
+			!jumpif,
+			fixups
+		);
+	}
+	else if(erw_iscomparison(self, node))
+	{
+		static const enum erw_InstructionID negated[] = {
+			[erw_INSTRUCTIONID_JNE] = erw_INSTRUCTIONID_JE,
+			[erw_INSTRUCTIONID_JGE] = erw_INSTRUCTIONID_JL,
+			[erw_INSTRUCTIONID_JLE] = erw_INSTRUCTIONID_JG,
+			[erw_INSTRUCTIONID_JE] = erw_INSTRUCTIONID_JNE,
+			[erw_INSTRUCTIONID_JG] = erw_INSTRUCTIONID_JLE,
+			[erw_INSTRUCTIONID_JL] = erw_INSTRUCTIONID_JGE,
+		};
+
+		int isfloat;
+		enum erw_InstructionID jump = erw_lowercompare(
+			self,
+			scope,
+			node,
+			&isfloat
+		);
+
+		if(jumpif)
+		{
+			vec_pushback(*fixups, erw_emitjump(self, jump));
+		}
+		else if(isfloat)
+		{
+			//The negated jump would be wrong for NaN, so jump past an
+			//unconditional jump instead
+			size_t skip = erw_emitjump(self, jump);
+			vec_pushback(*fixups, erw_emitjump(self, erw_INSTRUCTIONID_JMP));
+			erw_patch(self, skip, vec_getsize(self->instructions));
+		}
+		else
+		{
+			vec_pushback(*fixups, erw_emitjump(self, negated[jump]));
+		}
+	}
+	else if(node->type == erw_ASTNODETYPE_LITERAL
+		&& erw_tokentype(self, node) == erw_TOKENTYPE_LITERAL_BOOL)
+	{
+		struct erw_Literal literal = erw_ast_getliteral(self->ast, node->token);
+		if(literal.value.uint == (uint64_t)jumpif)
+		{
+			vec_pushback(*fixups, erw_emitjump(self, erw_INSTRUCTIONID_JMP));
+		}
+	}
+	else
+	{
+		size_t reg = erw_lowerexpr(self, scope, node);
+		self->numregs = reg;
+		vec_pushback(
+			*fixups,
+			erw_emitjumpreg(
+				self,
+				jumpif ? erw_INSTRUCTIONID_JNZ : erw_INSTRUCTIONID_JZ,
+				reg
+			)
+		);
+	}
+}
+
+static void erw_lowerconversion(
+	struct erw_BytecodeGenerator* self,
+	size_t reg,
+	struct erw_Value from,
+	struct erw_Value to)
+{
+	if(from.kind == erw_VALUEKIND_FLOAT && to.kind == erw_VALUEKIND_FLOAT)
+	{
+		return; //NOTE: Float32 is computed as a double
+	}
+
+	if(to.kind == erw_VALUEKIND_FLOAT)
+	{
+		erw_EMIT(
+			self,
+			from.kind == erw_VALUEKIND_INT
+				? erw_INSTRUCTIONID_ITOF
+				: erw_INSTRUCTIONID_UTOF,
+			reg,
+			reg
+		);
+	}
+	else
+	{
+		if(from.kind == erw_VALUEKIND_FLOAT)
+		{
+			erw_EMIT(self, erw_INSTRUCTIONID_FTOI, reg, reg);
+		}
+
+		erw_emitnarrow(self, reg, to);
+	}
+}
+
+static size_t erw_lowerfunccall(
+	struct erw_BytecodeGenerator* self,
+	struct erw_Scope* scope,
+	struct erw_ASTNode* node)
+{
+	struct erw_ASTNode* callee = erw_ast_getnode(
+		self->ast,
+		node->funccall.callee
+	);
+	if(callee->type != erw_ASTNODETYPE_LITERAL)
+	{
+		erw_unsupported(self, node->token, "Calling a function value");
+	}
+
+	struct erw_FuncDeclr* func = erw_scope_findfunc(
+		scope,
+		erw_ast_getstr(self->ast, callee->token)
+	);
+	log_assert(func, "undeclared function");
+
+	//Registers below ret hold partial results of the enclosing expression,
+	//the callee is free to overwrite them
+	size_t ret = self->numregs;
+	size_t numargs = node->funccall.args.size;
+	for(size_t i = 0; i < numargs; i++)
+	{
+		erw_lowerexpr(
+			self,
+			scope,
+			erw_ast_getchild(self->ast, node->funccall.args, i)
+		);
+	}
+
+	for(size_t i = 0; i < ret; i++)
+	{
+		erw_EMIT(self, erw_INSTRUCTIONID_PUSH, i);
+	}
+
+	if(ret)
+	{
+		for(size_t i = 0; i < numargs; i++)
+		{
+			erw_EMIT(self, erw_INSTRUCTIONID_MOV, i, ret + i);
+		}
+	}
+
+	struct erw_CallFixup call = {
+		.pos = erw_emitjump(self, erw_INSTRUCTIONID_CALL),
+		.node = func->node
+	};
+	vec_pushback(self->calls, call);
+
+	if(ret)
+	{
+		erw_EMIT(self, erw_INSTRUCTIONID_MOV, ret, 0);
+	}
+
+	for(size_t i = ret; i-- > 0;)
+	{
+		erw_EMIT(self, erw_INSTRUCTIONID_POP, i);
+	}
+
+	self->numregs = ret + 1;
+	return ret;
+}
+
+//Leaves the value in a new register and returns it
+static size_t erw_lowerexpr(
+	struct erw_BytecodeGenerator* self,
+	struct erw_Scope* scope,
+	struct erw_ASTNode* node)
+{
+	size_t ret = 0;
+	switch(node->type)
+	{
+	case erw_ASTNODETYPE_LITERAL:
+		{
+			ret = erw_allocreg(self, node->token);
+			switch(erw_tokentype(self, node))
+			{
+			case erw_TOKENTYPE_IDENT:
+				{
+					size_t slot;
+					struct erw_VarDeclr* var = erw_findvar(
+						self, 
+						erw_ast_getstr(self->ast, node->token), 
+						&slot
+					);
+					//Checks if it's supported
+					erw_getvalue(self, var->type, node->token);
+					erw_emitslot(self, erw_INSTRUCTIONID_LOAD, ret, slot);
+				}
+				break;
+			case erw_TOKENTYPE_LITERAL_INT:
+			case erw_TOKENTYPE_LITERAL_FLOAT:
+			case erw_TOKENTYPE_LITERAL_CHAR:
+			case erw_TOKENTYPE_LITERAL_BOOL:
+				//Float literals are loaded as their bits
+				erw_emitloadl(
+					self, 
+					ret, 
+					erw_ast_getliteral(self->ast, node->token).value.uint
+				);
+				break;
+			default:
+				erw_unsupported(
+					self,
+					node->token,
+					erw_tokentypeinfos[erw_tokentype(self, node)].name
+				);
+				break;
+			}
+		}
+		break;
+	case erw_ASTNODETYPE_BINEXPR:
+		{
+			enum erw_TokenType op = erw_tokentype(self, node);
+			switch(op)
+			{
+			case erw_TOKENTYPE_OPERATOR_AND:
+			case erw_TOKENTYPE_OPERATOR_OR:
+				{
+					ret = erw_allocreg(self, node->token);
+					Vec(size_t) fixups = vec_ctor(size_t, 0);
+					erw_emitloadl(self, ret, 0);
+					erw_lowerbranch(self, scope, node, 0, &fixups);
+					erw_emitloadl(self, ret, 1);
+					erw_patchall(self, fixups, vec_getsize(self->instructions));
+					vec_dtor(fixups);
+				}
+				break;
+			case erw_TOKENTYPE_OPERATOR_EQUAL:
+			case erw_TOKENTYPE_OPERATOR_NOTEQUAL:
+			case erw_TOKENTYPE_OPERATOR_LESS:
+			case erw_TOKENTYPE_OPERATOR_LESSOREQUAL:
+			case erw_TOKENTYPE_OPERATOR_GREATER:
+			case erw_TOKENTYPE_OPERATOR_GREATEROREQUAL:
+				{
+					static const enum erw_InstructionID sets[] = {
+						[erw_INSTRUCTIONID_JNE] = erw_INSTRUCTIONID_SETNE,
+						[erw_INSTRUCTIONID_JGE] = erw_INSTRUCTIONID_SETGE,
+						[erw_INSTRUCTIONID_JLE] = erw_INSTRUCTIONID_SETLE,
+						[erw_INSTRUCTIONID_JE] = erw_INSTRUCTIONID_SETE,
+						[erw_INSTRUCTIONID_JG] = erw_INSTRUCTIONID_SETG,
+						[erw_INSTRUCTIONID_JL] = erw_INSTRUCTIONID_SETL,
+					};
+
+					int isfloat;
+					ret = self->numregs;
+					enum erw_InstructionID jump = erw_lowercompare(
+						self,
+						scope,
+						node,
+						&isfloat
+					);
+					erw_EMIT(self, sets[jump], ret);
+					self->numregs = ret + 1;
+				}
+				break;
+			case erw_TOKENTYPE_OPERATOR_ACCESS:
+				erw_unsupported(self, node->token, "Member access");
+				break;
+			default:
+				{
+					struct erw_Value value = erw_getvalue(
+						self,
+						erw_gettype(self, scope, node),
+						node->token
+					);
+
+					enum erw_InstructionID id = erw_getarithmetic(op, value);
+					ret = erw_lowerexpr(
+						self,
+						scope,
+						erw_ast_getnode(self->ast, node->binexpr.expr1)
+					);
+					size_t reg = erw_lowerexpr(
+						self,
+						scope,
+						erw_ast_getnode(self->ast, node->binexpr.expr2)
+					);
+					erw_EMIT(self, id, ret, ret, reg);
+					erw_emitnarrow(self, ret, value);
+					self->numregs = ret + 1;
+				}
+				break;
+			}
+		}
+		break;
+	case erw_ASTNODETYPE_UNEXPR:
+		switch(erw_tokentype(self, node))
+		{
+		case erw_TOKENTYPE_OPERATOR_NOT:
+			ret = erw_lowerexpr(
+				self,
+				scope,
+				erw_ast_getnode(self->ast, node->unexpr.expr)
+			);
+			erw_EMIT(self, erw_INSTRUCTIONID_NOT, ret, ret);
+			break;
+		case erw_TOKENTYPE_OPERATOR_SUB:
+			{
+				struct erw_Value value = erw_getvalue(
+					self,
+					erw_gettype(self, scope, node),
+					node->token
+				);
+
+				ret = erw_lowerexpr(
+					self,
+					scope,
+					erw_ast_getnode(self->ast, node->unexpr.expr)
+				);
+				if(value.kind == erw_VALUEKIND_FLOAT)
+				{
+					erw_EMIT(self, erw_INSTRUCTIONID_FNEG, ret, ret);
+				}
+				else
+				{
+					erw_EMIT(self, erw_INSTRUCTIONID_NEG, ret, ret);
+					erw_emitnarrow(self, ret, value);
+				}
+			}
+			break;
+		default:
+			erw_unsupported(self, node->token, "Referencing");
+			break;
+		}
+		break;
+	case erw_ASTNODETYPE_CAST:
+		{
+			struct erw_Value from = erw_getvalue(
+				self,
+				erw_gettype(
+					self,
+					scope,
+					erw_ast_getnode(self->ast, node->cast.expr)
+				),
+				node->token
+			);
+			struct erw_Value to = erw_getvalue(
+				self,
+				erw_gettype(self, scope, node),
+				node->token
+			);
+
+			ret = erw_lowerexpr(
+				self,
+				scope,
+				erw_ast_getnode(self->ast, node->cast.expr)
+			);
+			erw_lowerconversion(self, ret, from, to);
+		}
+		break;
+	case erw_ASTNODETYPE_FUNCCALL:
+		ret = erw_lowerfunccall(self, scope, node);
+		break;
+	default:
+		erw_unsupported(self, node->token, erw_astnodetypenames[node->type]);
+		break;
+	}
+
+	return ret;
+}
+
+static void erw_lowerblock(
+	struct erw_BytecodeGenerator* self,
+	struct erw_Scope* scope,
+	struct erw_ASTNode* blocknode,
+	size_t numdeclared
+);
+
+//Runs the deferred blocks from the newest down to index 'to'
+static void erw_lowerdeferred(struct erw_BytecodeGenerator* self, size_t to)
+{
+	for(size_t i = vec_getsize(self->deferred); i-- > to;)
+	{
+		//A deferred block only sees the scopes that were visible where it was
+		//deferred, and none of the other deferred blocks
+		struct erw_Deferred deferred = self->deferred[i];
+		Vec(struct erw_ScopeSlots) scopes = self->scopes;
+		Vec(struct erw_Deferred) outer = self->deferred;
+		self->scopes = vec_ctor(struct erw_ScopeSlots, deferred.depth);
+		vec_pushbackwitharr(self->scopes, scopes, deferred.depth);
+		self->deferred = vec_ctor(struct erw_Deferred, 0);
+
+		erw_lowerblock(self, deferred.scope, deferred.block, 0);
+
+		vec_dtor(self->deferred);
+		vec_dtor(self->scopes);
+		self->deferred = outer;
+		self->scopes = scopes;
+	}
+}
+
+static void erw_lowerstore(
+	struct erw_BytecodeGenerator* self,
+	struct erw_ASTNode* assignee,
+	size_t reg)
+{
+	if(assignee->type != erw_ASTNODETYPE_LITERAL)
+	{
+		erw_unsupported(self, assignee->token, "Assigning through a reference");
+	}
+
+	size_t slot;
+	erw_findvar(self, erw_ast_getstr(self->ast, assignee->token), &slot);
+	erw_emitslot(self, erw_INSTRUCTIONID_STORE, reg, slot);
+}
+
+static void erw_lowerassignment(
+	struct erw_BytecodeGenerator* self,
+	struct erw_Scope* scope,
+	struct erw_ASTNode* node)
+{
+	enum erw_TokenType op = erw_tokentype(self, node);
+	struct erw_ASTNode* assignee = erw_ast_getnode(
+		self->ast,
+		node->assignment.assignee
+	);
+	struct erw_ASTNode* expr = erw_ast_getnode(
+		self->ast,
+		node->assignment.expr
+	);
+	if(op == erw_TOKENTYPE_OPERATOR_ASSIGN)
+	{
+		size_t reg = erw_lowerexpr(self, scope, expr);
+		erw_lowerstore(self, assignee, reg);
+		self->numregs = reg;
+		return;
+	}
+
+	struct erw_Value value = erw_getvalue(
+		self,
+		erw_gettype(self, scope, assignee),
+		node->token
+	);
+
+	enum erw_InstructionID id = erw_getarithmetic(op, value);
+	size_t reg = erw_lowerexpr(self, scope, assignee);
+	size_t reg2 = erw_lowerexpr(self, scope, expr);
+	erw_EMIT(self, id, reg, reg, reg2);
+	erw_emitnarrow(self, reg, value);
+	erw_lowerstore(self, assignee, reg);
+	self->numregs = reg;
+}
+
+static void erw_lowerreturn(
+	struct erw_BytecodeGenerator* self,
+	struct erw_Scope* scope,
+	struct erw_ASTNode* node)
+{
+	struct erw_ASTNode* expr = erw_ast_get(self->ast, node->return_.expr);
+	if(expr)
+	{
+		erw_lowerexpr(self, scope, expr); //Into r0
+		self->numregs = 0;
+	}
+
+	if(vec_getsize(self->deferred))
+	{
+		if(expr)
+		{
+			erw_EMIT(self, erw_INSTRUCTIONID_PUSH, 0);
+		}
+
+		erw_lowerdeferred(self, 0);
+		if(expr)
+		{
+			erw_EMIT(self, erw_INSTRUCTIONID_POP, 0);
+		}
+	}
+
+	erw_EMIT(self, erw_INSTRUCTIONID_RET);
+}
+
+static void erw_lowerif(
+	struct erw_BytecodeGenerator* self,
+	struct erw_Scope* scope,
+	struct erw_ASTNode* node,
+	size_t* child)
+{
+	Vec(size_t) end = vec_ctor(size_t, 0);
+	Vec(size_t) next = vec_ctor(size_t, 0);
+	size_t numelseifs = node->if_.elseifs.size;
+
+	erw_lowerbranch(
+		self,
+		scope,
+		erw_ast_getnode(self->ast, node->if_.expr),
+		0,
+		&next
+	);
+	erw_lowerblock(
+		self,
+		scope->children[(*child)++],
+		erw_ast_getnode(self->ast, node->if_.block),
+		0
+	);
+	for(size_t i = 0; i < numelseifs; i++)
+	{
+		vec_pushback(end, erw_emitjump(self, erw_INSTRUCTIONID_JMP));
+		erw_patchall(self, next, vec_getsize(self->instructions));
+		vec_clear(next);
+
+		struct erw_ASTNode* elseif = erw_ast_getchild(
+			self->ast,
+			node->if_.elseifs,
+			i
+		);
+		erw_markposition(self, elseif->token);
+		erw_lowerbranch(
+			self,
+			scope,
+			erw_ast_getnode(self->ast, elseif->elseif.expr),
+			0,
+			&next
+		);
+		erw_lowerblock(
+			self,
+			scope->children[(*child)++],
+			erw_ast_getnode(self->ast, elseif->elseif.block),
+			0
+		);
+	}
+
+	struct erw_ASTNode* else_ = erw_ast_get(self->ast, node->if_.else_);
+	if(else_)
+	{
+		vec_pushback(end, erw_emitjump(self, erw_INSTRUCTIONID_JMP));
+		erw_patchall(self, next, vec_getsize(self->instructions));
+		vec_clear(next);
+		erw_lowerblock(
+			self,
+			scope->children[(*child)++],
+			erw_ast_getnode(self->ast, else_->else_.block),
+			0
+		);
+	}
+
+	erw_patchall(self, next, vec_getsize(self->instructions));
+	erw_patchall(self, end, vec_getsize(self->instructions));
+	vec_dtor(next);
+	vec_dtor(end);
+}
+
+static void erw_lowerwhile(
+	struct erw_BytecodeGenerator* self,
+	struct erw_Scope* scope,
+	struct erw_ASTNode* node,
+	size_t* child)
+{
+	//The condition is placed after the body, so each iteration only takes
+	//one jump
+	size_t cond = erw_emitjump(self, erw_INSTRUCTIONID_JMP);
+	size_t body = vec_getsize(self->instructions);
+	erw_lowerblock(
+		self,
+		scope->children[(*child)++],
+		erw_ast_getnode(self->ast, node->while_.block),
+		0
+	);
+	erw_patch(self, cond, vec_getsize(self->instructions));
+	erw_markposition(self, node->token);
+
+	Vec(size_t) fixups = vec_ctor(size_t, 0);
+	erw_lowerbranch(
+		self,
+		scope,
+		erw_ast_getnode(self->ast, node->while_.expr),
+		1,
+		&fixups
+	);
+	erw_patchall(self, fixups, body);
+	vec_dtor(fixups);
+}
+
+//numdeclared is the number of variables in scope that are declared before the
+//block, i.e. the parameters of a function
+static void erw_lowerblock(
+	struct erw_BytecodeGenerator* self,
+	struct erw_Scope* scope,
+	struct erw_ASTNode* blocknode,
+	size_t numdeclared)
+{
+	if(self->numslots + vec_getsize(scope->variables) > erw_MAXSLOTS)
+	{
+		erw_unsupported(self, blocknode->token, "A function this large");
+	}
+
+	struct erw_ScopeSlots slots = {
+		.scope = scope,
+		.base = self->numslots,
+		.numdeclared = numdeclared
+	};
+	vec_pushback(self->scopes, slots);
+	self->numslots += vec_getsize(scope->variables);
+
+	size_t numdeferred = vec_getsize(self->deferred);
+	size_t child = 0; //Scopes of nested blocks were added in order
+	int returned = 0;
+	for(size_t i = 0; i < blocknode->block.stmts.size; i++)
+	{
+		log_assert(!self->numregs, "leaked registers (%zu)", self->numregs);
+		struct erw_ASTNode* stmt = erw_ast_getchild(
+			self->ast,
+			blocknode->block.stmts,
+			i
+		);
+		//Calls have no token of their own
+		erw_markposition(
+			self, 
+			stmt->type == erw_ASTNODETYPE_FUNCCALL
+				? erw_ast_getnode(self->ast, stmt->funccall.callee)->token
+				: stmt->token
+		);
+		switch(stmt->type)
+		{
+		case erw_ASTNODETYPE_FUNCDEF:
+			{
+				struct erw_PendingFunc func = {
+					.node = stmt,
+					.scope = scope->children[child++]
+				};
+				vec_pushback(self->pending, func);
+			}
+			break;
+		case erw_ASTNODETYPE_VARDECLR:
+			{
+				//Slots without a value are zeroed by ENTER
+				struct erw_ScopeSlots* current = &self->scopes[
+					vec_getsize(self->scopes) - 1
+				];
+				if(stmt->vardeclr.value)
+				{
+					size_t reg = erw_lowerexpr(
+						self,
+						scope,
+						erw_ast_getnode(self->ast, stmt->vardeclr.value)
+					);
+					erw_emitslot(
+						self,
+						erw_INSTRUCTIONID_STORE,
+						reg,
+						current->base + current->numdeclared
+					);
+					self->numregs = reg;
+				}
+
+				current->numdeclared++;
+			}
+			break;
+		case erw_ASTNODETYPE_IF:
+			erw_lowerif(self, scope, stmt, &child);
+			break;
+		case erw_ASTNODETYPE_WHILE:
+			erw_lowerwhile(self, scope, stmt, &child);
+			break;
+		case erw_ASTNODETYPE_RETURN:
+			erw_lowerreturn(self, scope, stmt);
+			returned = 1;
+			break;
+		case erw_ASTNODETYPE_DEFER:
+			{
+				struct erw_Deferred deferred = {
+					.block = erw_ast_getnode(self->ast, stmt->defer.block),
+					.scope = scope->children[child++],
+					.depth = vec_getsize(self->scopes)
+				};
+				vec_pushback(self->deferred, deferred);
+			}
+			break;
+		case erw_ASTNODETYPE_UNSAFE:
+			erw_lowerblock(
+				self,
+				scope->children[child++],
+				erw_ast_getnode(self->ast, stmt->unsafe.block),
+				0
+			);
+			break;
+		case erw_ASTNODETYPE_ASSIGNMENT:
+			erw_lowerassignment(self, scope, stmt);
+			break;
+		case erw_ASTNODETYPE_FUNCCALL:
+			self->numregs = erw_lowerfunccall(self, scope, stmt);
+			break;
+		case erw_ASTNODETYPE_TYPEDECLR:
+			break;
+		default:
+			erw_unsupported(
+				self,
+				stmt->token,
+				erw_astnodetypenames[stmt->type]
+			);
+			break;
+		}
+	}
+
+	if(!returned)
+	{
+		erw_lowerdeferred(self, numdeferred);
+	}
+
+	vec_collapse(
+		self->deferred,
+		numdeferred,
+		vec_getsize(self->deferred) - numdeferred
+	);
+	vec_popback(self->scopes);
+}
+
+static void erw_lowerfunc(
+	struct erw_BytecodeGenerator* self,
+	struct erw_PendingFunc func)
+{
+	struct erw_ASTNode* node = func.node;
+	size_t numparams = node->funcdef.params.size;
+	if(numparams > erw_NUMREGISTERS)
+	{
+		erw_unsupported(self, node->funcdef.name, "A function this long");
+	}
+
+	struct erw_BytecodeFunc bytecodefunc = {
+		.name = erw_ast_getstr(self->ast, node->funcdef.name),
+		.offset = vec_getsize(self->instructions),
+		.numparams = numparams
+	};
+	vec_pushback(self->functions, bytecodefunc);
+
+	struct erw_FuncOffset offset = {
+		.node = node,
+		.offset = bytecodefunc.offset
+	};
+	vec_pushback(self->offsets, offset);
+
+	self->numslots = 0;
+	self->numregs = 0;
+	erw_markposition(self, node->funcdef.name);
+	size_t enter = erw_EMIT(self, erw_INSTRUCTIONID_ENTER, 0, 0);
+	for(size_t i = 0; i < numparams; i++)
+	{
+		erw_emitslot(self, erw_INSTRUCTIONID_STORE, i, i);
+	}
+
+	struct erw_ASTNode* block = erw_ast_getnode(self->ast, node->funcdef.block);
+	erw_lowerblock(self, func.scope, block, numparams);
+	size_t numstmts = block->block.stmts.size;
+	if(!numstmts 
+		|| erw_ast_getchild(self->ast, block->block.stmts, numstmts - 1)->type
+			!= erw_ASTNODETYPE_RETURN)
+	{
+		erw_EMIT(self, erw_INSTRUCTIONID_RET);
+	}
+
+	self->instructions[enter + 1] = self->numslots & 0xFF;
+	self->instructions[enter + 2] = self->numslots >> 8;
+}
+
+static int erw_funcoffset_compare(const void* a, const void* b)
+{
+	const struct erw_FuncOffset* offset1 = a;
+	const struct erw_FuncOffset* offset2 = b;
+	return (offset1->node > offset2->node) - (offset1->node < offset2->node);
+}
+
+struct erw_Bytecode erw_bytecode_generate(
+	const struct erw_AST* ast,
+	struct erw_Scope* scope,
+	struct erw_Lines* lines)
+{
+	log_assert(ast, "is NULL");
+	log_assert(scope, "is NULL");
+	log_assert(lines, "is NULL");
+
+	struct erw_BytecodeGenerator self = {
+		.instructions = vec_ctor(uint8_t, 0),
+		.functions = vec_ctor(struct erw_BytecodeFunc, 0),
+		.positions = vec_ctor(struct erw_BytecodePosition, 0),
+		.offsets = vec_ctor(struct erw_FuncOffset, 0),
+		.pending = vec_ctor(struct erw_PendingFunc, 0),
+		.calls = vec_ctor(struct erw_CallFixup, 0),
+		.scopes = vec_ctor(struct erw_ScopeSlots, 0),
+		.deferred = vec_ctor(struct erw_Deferred, 0),
+		.ast = ast,
+		.lines = lines
+	};
+
+	size_t child = 0;
+	struct erw_ASTList children = ast->nodes[0].start.children;
+	for(size_t i = 0; i < children.size; i++)
+	{
+		struct erw_ASTNode* node = erw_ast_getchild(ast, children, i);
+		if(node->type == erw_ASTNODETYPE_FUNCDEF)
+		{
+			struct erw_PendingFunc func = {
+				.node = node,
+				.scope = scope->children[child++]
+			};
+			vec_pushback(self.pending, func);
+		}
+	}
+
+	//Nested functions are generated after the function they are declared in
+	for(size_t i = 0; i < vec_getsize(self.pending); i++)
+	{
+		erw_lowerfunc(&self, self.pending[i]);
+	}
+
+	//Resolve the calls
+	qsort(
+		self.offsets,
+		vec_getsize(self.offsets),
+		sizeof(struct erw_FuncOffset),
+		erw_funcoffset_compare
+	);
+
+	for(size_t i = 0; i < vec_getsize(self.calls); i++)
+	{
+		struct erw_FuncOffset key = {.node = self.calls[i].node};
+		struct erw_FuncOffset* offset = bsearch(
+			&key,
+			self.offsets,
+			vec_getsize(self.offsets),
+			sizeof(struct erw_FuncOffset),
+			erw_funcoffset_compare
+		);
+		if(!offset)
+		{
+			log_error(
+				"Call to a function that wasn't generated <%s>",
+				__func__
+			);
+		}
+		else
+		{
+			erw_patch(&self, self.calls[i].pos, offset->offset);
+		}
+	}
+
+	if(vec_getsize(self.instructions) > UINT32_MAX)
+	{
+		log_error(
+			"Too much bytecode (%zu bytes)",
+			vec_getsize(self.instructions)
+		);
+	}
+
+	struct erw_FuncDeclr* mainfunc = erw_scope_findfunc(
+		scope,
+		erw_intern("main", sizeof("main") - 1)
+	);
+	log_assert(mainfunc, "no main function");
+
+	struct erw_FuncOffset key = {.node = mainfunc->node};
+	struct erw_FuncOffset* entry = bsearch(
+		&key,
+		self.offsets,
+		vec_getsize(self.offsets),
+		sizeof(struct erw_FuncOffset),
+		erw_funcoffset_compare
+	);
+	if(!entry)
+	{
+		log_error("main wasn't generated <%s>", __func__);
+	}
+
+	//Statements that didn't emit anything at the end don't have instructions
+	while(vec_getsize(self.positions) 
+		&& self.positions[vec_getsize(self.positions) - 1].offset 
+			== vec_getsize(self.instructions))
+	{
+		vec_popback(self.positions);
+	}
+
+	struct erw_Bytecode ret = {
+		.instructions = self.instructions,
+		.functions = self.functions,
+		.positions = self.positions,
+		.entry = entry ? entry->offset : 0
+	};
+
+	vec_dtor(self.offsets);
+	vec_dtor(self.pending);
+	vec_dtor(self.calls);
+	vec_dtor(self.scopes);
+	vec_dtor(self.deferred);
+	return ret;
+}
+
+//erw_bytecode_serialize writes the header field by field
+_Static_assert(
+	sizeof(struct erw_BytecodeHeader) == 52, 
+	"erw_BytecodeHeader has padding"
+);
+
+static void erw_pushu32(Vec(uint8_t)* data, size_t value)
+{
+	uint8_t bytes[4] = {value, value >> 8, value >> 16, value >> 24};
+	vec_pushbackwitharr(*data, bytes, sizeof(bytes));
+}
+
+//Highest register the instructions use plus one
+static size_t erw_numregisters(Vec(uint8_t) instructions)
+{
+	size_t ret = 1; //r0 holds the return value
+	size_t pos = 0;
+	while(pos < vec_getsize(instructions))
+	{
+		const struct erw_InstructionInfo* info = 
+			&erw_instructioninfos[instructions[pos]];
+		if(instructions[pos] == erw_INSTRUCTIONID_PUSHN
+			|| instructions[pos] == erw_INSTRUCTIONID_POPN)
+		{
+			ret = instructions[pos + 1] > ret ? instructions[pos + 1] : ret;
+		}
+
+		const uint8_t* operand = instructions + pos + 1;
+		for(const char* c = info->operands; *c; c++)
+		{
+			if(*c == 'r' && *operand >= ret)
+			{
+				ret = *operand + 1;
+			}
+
+			operand += erw_operandsize(*c);
+		}
+
+		pos += info->size;
+	}
+
+	return ret;
+}
+
+Vec(uint8_t) erw_bytecode_serialize(struct erw_Bytecode* self)
+{
+	log_assert(self, "is NULL");
+
+	size_t numfunctions = vec_getsize(self->functions);
+	size_t numpositions = vec_getsize(self->positions);
+	size_t numinstructions = vec_getsize(self->instructions);
+	size_t functions = sizeof(struct erw_BytecodeHeader);
+	size_t positions = functions 
+		+ numfunctions * sizeof(struct erw_BytecodeFuncEntry);
+	size_t instructions = positions 
+		+ numpositions * sizeof(struct erw_BytecodePositionEntry);
+	size_t constants = instructions + numinstructions;
+
+	//The constant pool only holds the function names for now
+	size_t constantssize = 0;
+	for(size_t i = 0; i < numfunctions; i++)
+	{
+		constantssize += strlen(self->functions[i].name) + 1;
+	}
+
+	if(constants + constantssize > UINT32_MAX)
+	{
+		log_error("Too much bytecode (%zu bytes)", constants + constantssize);
+	}
+
+	Vec(uint8_t) ret = vec_ctor(uint8_t, constants + constantssize);
+	vec_pushbackwitharr(ret, erw_BYTECODE_MAGIC, 4);
+	erw_pushu32(&ret, erw_BYTECODE_VERSION);
+	erw_pushu32(&ret, constants + constantssize);
+	erw_pushu32(&ret, self->entry);
+	erw_pushu32(&ret, erw_numregisters(self->instructions));
+	erw_pushu32(&ret, functions);
+	erw_pushu32(&ret, numfunctions);
+	erw_pushu32(&ret, positions);
+	erw_pushu32(&ret, numpositions);
+	erw_pushu32(&ret, instructions);
+	erw_pushu32(&ret, numinstructions);
+	erw_pushu32(&ret, constants);
+	erw_pushu32(&ret, constantssize);
+
+	size_t name = 0;
+	for(size_t i = 0; i < numfunctions; i++)
+	{
+		erw_pushu32(&ret, name);
+		erw_pushu32(&ret, self->functions[i].offset);
+		erw_pushu32(&ret, self->functions[i].numparams);
+		name += strlen(self->functions[i].name) + 1;
+	}
+
+	for(size_t i = 0; i < numpositions; i++)
+	{
+		erw_pushu32(&ret, self->positions[i].offset);
+		erw_pushu32(&ret, self->positions[i].linenum);
+		erw_pushu32(&ret, self->positions[i].column);
+	}
+
+	vec_pushbackwitharr(ret, self->instructions, numinstructions);
+	for(size_t i = 0; i < numfunctions; i++)
+	{
+		const char* str = self->functions[i].name;
+		vec_pushbackwitharr(ret, str, strlen(str) + 1);
+	}
+
+	return ret;
+}
+
+void erw_bytecode_dtor(struct erw_Bytecode* self)
+{
+	log_assert(self, "is NULL");
+	vec_dtor(self->instructions);
+	vec_dtor(self->functions);
+	vec_dtor(self->positions);
+}
+
+struct erw_BytecodeImage* erw_bytecodeimage_ctor(
+	struct erw_BytecodeImage* self, 
+	const uint8_t* data, 
+	size_t size)
+{
+	log_assert(self, "is NULL");
+	log_assert(data, "is NULL");
+
+	//The header is used in place, which only works on little endian hosts
+	const uint16_t endianness = 1;
+	if(*(const uint8_t*)&endianness != 1)
+	{
+		log_error("Bytecode can only be loaded on little endian machines");
+	}
+
+	const struct erw_BytecodeHeader* header = 
+		(const struct erw_BytecodeHeader*)data;
+	if(size < sizeof(struct erw_BytecodeHeader) 
+		|| memcmp(header->magic, erw_BYTECODE_MAGIC, 4))
+	{
+		log_error("Not an Erwall bytecode file");
+	}
+
+	if(header->version != erw_BYTECODE_VERSION)
+	{
+		log_error(
+			"Unsupported bytecode version (%" PRIu32 ", expected %i)",
+			header->version,
+			erw_BYTECODE_VERSION
+		);
+	}
+
+	//Sections are checked in 64 bits so that the sums can't overflow
+	uint64_t functionsend = header->functions 
+		+ (uint64_t)header->numfunctions 
+			* sizeof(struct erw_BytecodeFuncEntry);
+	uint64_t positionsend = header->positions 
+		+ (uint64_t)header->numpositions 
+			* sizeof(struct erw_BytecodePositionEntry);
+	if(header->size > size
+		|| header->functions % _Alignof(struct erw_BytecodeFuncEntry)
+		|| functionsend > header->size
+		|| header->positions % _Alignof(struct erw_BytecodePositionEntry)
+		|| positionsend > header->size
+		|| (uint64_t)header->instructions + header->numinstructions 
+			> header->size
+		|| (uint64_t)header->constants + header->constantssize > header->size
+		|| header->entry >= header->numinstructions)
+	{
+		log_error("Corrupt bytecode file (invalid header)");
+	}
+
+	//The register count is configurable, see erw_NUMREGISTERS
+	if(header->numregisters > erw_NUMREGISTERS)
+	{
+		log_error(
+			"Bytecode needs %" PRIu32 " registers, the interpreter has %i",
+			header->numregisters,
+			erw_NUMREGISTERS
+		);
+	}
+
+	self->data = data;
+	self->size = header->size;
+	self->mapsize = 0;
+	self->functions = 
+		(const struct erw_BytecodeFuncEntry*)(data + header->functions);
+	self->numfunctions = header->numfunctions;
+	self->positions = 
+		(const struct erw_BytecodePositionEntry*)(data + header->positions);
+	self->numpositions = header->numpositions;
+	self->instructions = data + header->instructions;
+	self->numinstructions = header->numinstructions;
+	self->constants = (const char*)data + header->constants;
+	self->constantssize = header->constantssize;
+	self->entry = header->entry;
+	self->numregisters = header->numregisters;
+
+	if(self->constantssize && self->constants[self->constantssize - 1])
+	{
+		log_error("Corrupt bytecode file (unterminated constant pool)");
+	}
+
+	for(size_t i = 0; i < self->numfunctions; i++)
+	{
+		if(self->functions[i].name >= self->constantssize
+			|| self->functions[i].offset >= self->numinstructions
+			|| (i && self->functions[i].offset 
+				<= self->functions[i - 1].offset))
+		{
+			log_error("Corrupt bytecode file (invalid function %zu)", i);
+		}
+	}
+
+	for(size_t i = 0; i < self->numpositions; i++)
+	{
+		if(self->positions[i].offset >= self->numinstructions
+			|| (i && self->positions[i].offset 
+				<= self->positions[i - 1].offset))
+		{
+			log_error("Corrupt bytecode file (invalid position %zu)", i);
+		}
+	}
+
+	self->maxframesize = erw_verifier_verify(self);
+	return self;
+}
+
+struct erw_BytecodeImage* erw_bytecodeimage_ctorfromfile(
+	struct erw_BytecodeImage* self, 
+	const char* path)
+{
+	log_assert(self, "is NULL");
+	log_assert(path, "is NULL");
+
+	int fd = open(path, O_RDONLY);
+	if(fd == -1)
+	{
+		log_error("%s: '%s'", strerror(errno), path);
+	}
+
+	struct stat info;
+	if(fstat(fd, &info))
+	{
+		log_error("%s: '%s'", strerror(errno), path);
+	}
+
+	if(!info.st_size)
+	{
+		log_error("Not an Erwall bytecode file");
+	}
+
+	void* map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if(map == MAP_FAILED)
+	{
+		log_error("%s: '%s'", strerror(errno), path);
+	}
+
+	close(fd); //The mapping stays valid
+	erw_bytecodeimage_ctor(self, map, info.st_size);
+	self->mapsize = info.st_size;
+	return self;
+}
+
+//Number of entries with an offset of at most offset, entries are sorted
+#define erw_COUNTUPTO(entries, numentries, offset, ret) \
+	do \
+	{ \
+		size_t begin = 0; \
+		size_t end = (numentries); \
+		while(begin < end) \
+		{ \
+			size_t middle = begin + (end - begin) / 2; \
+			if((entries)[middle].offset <= (offset)) \
+			{ \
+				begin = middle + 1; \
+			} \
+			else \
+			{ \
+				end = middle; \
+			} \
+		} \
+		(ret) = begin; \
+	} while(0)
+
+const struct erw_BytecodeFuncEntry* erw_bytecodeimage_findfunc(
+	struct erw_BytecodeImage* self,
+	size_t offset)
+{
+	log_assert(self, "is NULL");
+	size_t count;
+	erw_COUNTUPTO(self->functions, self->numfunctions, offset, count);
+	return count ? &self->functions[count - 1] : NULL;
+}
+
+const struct erw_BytecodePositionEntry* erw_bytecodeimage_findposition(
+	struct erw_BytecodeImage* self,
+	size_t offset)
+{
+	log_assert(self, "is NULL");
+	size_t count;
+	erw_COUNTUPTO(self->positions, self->numpositions, offset, count);
+	return count ? &self->positions[count - 1] : NULL;
+}
+
+#undef erw_COUNTUPTO
+
+void erw_bytecodeimage_save(struct erw_BytecodeImage* self, const char* path)
+{
+	log_assert(self, "is NULL");
+	log_assert(path, "is NULL");
+
+	FILE* file = fopen(path, "wb");
+	if(!file)
+	{
+		log_error("%s: '%s'", strerror(errno), path);
+	}
+
+	if(fwrite(self->data, 1, self->size, file) != self->size
+		|| fclose(file) == EOF)
+	{
+		log_error("%s: '%s'", strerror(errno), path);
+	}
+}
+
+void erw_bytecodeimage_print(struct erw_BytecodeImage* self)
+{
+	log_assert(self, "is NULL");
+
+	size_t func = 0;
+	size_t position = 0;
+	size_t pos = 0;
+	while(pos < self->numinstructions)
+	{
+		while(func < self->numfunctions
+			&& self->functions[func].offset == pos)
+		{
+			printf(
+				"%s%s: (%" PRIu32 " params)\n",
+				func ? "\n" : "",
+				self->constants + self->functions[func].name,
+				self->functions[func].numparams
+			);
+			func++;
+		}
+
+		if(position < self->numpositions 
+			&& self->positions[position].offset == pos)
+		{
+			printf(
+				"          ; line %" PRIu32 ", column %" PRIu32 "\n",
+				self->positions[position].linenum,
+				self->positions[position].column
+			);
+			position++;
+		}
+
+		uint8_t id = self->instructions[pos];
+		if(id >= erw_INSTRUCTIONID_COUNT 
+			|| pos + erw_instructioninfos[id].size > self->numinstructions)
+		{
+			log_error("Corrupt bytecode (at %zu)", pos);
+		}
+
+		const struct erw_InstructionInfo* info = &erw_instructioninfos[id];
+		printf("%8zu  %-8s", pos, info->name);
+
+		const uint8_t* operand = self->instructions + pos + 1;
+		for(const char* c = info->operands; *c; c++)
+		{
+			uint64_t value = 0;
+			size_t size = erw_operandsize(*c);
+			for(size_t i = 0; i < size; i++)
+			{
+				value |= (uint64_t)operand[i] << (i * 8);
+			}
+
+			printf(c == info->operands ? " " : ", ");
+			if(*c == 'r')
+			{
+				printf("r%" PRIu64, value);
+			}
+			else if(*c == 's')
+			{
+				printf("[%" PRIu64 "]", value);
+			}
+			else if(*c == 't')
+			{
+				printf("@%" PRIu64, value);
+			}
+			else if(*c == 'i')
+			{
+				printf("%" PRIi32, (int32_t)value);
+			}
+			else
+			{
+				printf("%" PRIu64, value);
+			}
+
+			operand += size;
+		}
+
+		putchar('\n');
+		pos += info->size;
+	}
+}
+
+void erw_bytecodeimage_dtor(struct erw_BytecodeImage* self)
+{
+	log_assert(self, "is NULL");
+	if(self->mapsize)
+	{
+		munmap((void*)self->data, self->mapsize);
+	}
+}
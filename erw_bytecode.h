@@ -0,0 +1,145 @@
+/*
+	Copyright (C) 2017 Erik Wallström
+
+	This file is part of Erwall.
+
+	Erwall is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Erwall is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Erwall.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ERW_BYTECODE_H
+#define ERW_BYTECODE_H
+
+#include "erw_semantics.h"
+#include "erw_interpreter.h"
+
+struct erw_BytecodeFunc
+{
+	const char* name;
+	size_t offset; //Into erw_Bytecode.instructions
+	size_t numparams;
+};
+
+//Instructions from offset up to the next position were generated for the 
+//source at linenum and column
+struct erw_BytecodePosition
+{
+	size_t offset; //Into erw_Bytecode.instructions
+	size_t linenum;
+	size_t column;
+};
+
+struct erw_Bytecode
+{
+	Vec(uint8_t) instructions;
+	Vec(struct erw_BytecodeFunc) functions; //In the order they were emitted
+	Vec(struct erw_BytecodePosition) positions; //Sorted by offset
+	size_t entry; //Offset of main
+};
+
+//Lowers a checked AST to instructions for erw_Interpreter. Values that don't
+//fit in a register (references, arrays, slices, structs, unions and enums)
+//are not supported yet and are reported as errors.
+struct erw_Bytecode erw_bytecode_generate(
+	const struct erw_AST* ast,
+	struct erw_Scope* scope,
+	struct erw_Lines* lines
+);
+//Lays the bytecode out as an .erwc file, see erw_BytecodeHeader
+Vec(uint8_t) erw_bytecode_serialize(struct erw_Bytecode* self);
+void erw_bytecode_dtor(struct erw_Bytecode* self);
+
+#define erw_BYTECODE_MAGIC "ERWC"
+#define erw_BYTECODE_VERSION 4
+
+//An .erwc file starts with this header, followed by the function table, the
+//position table, the instruction stream and the constant pool. Offsets are
+//from the start of the file and integers are little endian, so a file can be
+//mapped anywhere and executed in place.
+struct erw_BytecodeHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t size; //Of the whole file
+	uint32_t entry; //Offset of main into the instruction stream
+	uint32_t numregisters; //The interpreter has to have at least this many
+	uint32_t functions;
+	uint32_t numfunctions;
+	uint32_t positions;
+	uint32_t numpositions;
+	uint32_t instructions;
+	uint32_t numinstructions; //In bytes
+	uint32_t constants;
+	uint32_t constantssize; //In bytes
+};
+
+struct erw_BytecodeFuncEntry
+{
+	uint32_t name; //Offset of a NUL-terminated string in the constant pool
+	uint32_t offset; //Into the instruction stream
+	uint32_t numparams;
+};
+
+struct erw_BytecodePositionEntry
+{
+	uint32_t offset; //Into the instruction stream
+	uint32_t linenum;
+	uint32_t column;
+};
+
+//A validated view of an .erwc file, the sections point into the file
+struct erw_BytecodeImage
+{
+	const uint8_t* data;
+	size_t size;
+	size_t mapsize; //0 if data isn't mapped by the image
+	const struct erw_BytecodeFuncEntry* functions;
+	size_t numfunctions;
+	const struct erw_BytecodePositionEntry* positions;
+	size_t numpositions;
+	const uint8_t* instructions;
+	size_t numinstructions;
+	const char* constants;
+	size_t constantssize;
+	size_t entry;
+	size_t numregisters;
+	size_t maxframesize; //In slots, see erw_verifier.h
+};
+
+//Verifies the bytecode, see erw_verifier.h
+//NOTE: data is not copied, it has to outlive the image
+struct erw_BytecodeImage* erw_bytecodeimage_ctor(
+	struct erw_BytecodeImage* self, 
+	const uint8_t* data, 
+	size_t size
+);
+//Maps an .erwc file into memory with a single mmap
+struct erw_BytecodeImage* erw_bytecodeimage_ctorfromfile(
+	struct erw_BytecodeImage* self, 
+	const char* path
+);
+//The function and the source position an instruction belongs to, NULL if
+//there is none
+const struct erw_BytecodeFuncEntry* erw_bytecodeimage_findfunc(
+	struct erw_BytecodeImage* self,
+	size_t offset
+);
+const struct erw_BytecodePositionEntry* erw_bytecodeimage_findposition(
+	struct erw_BytecodeImage* self,
+	size_t offset
+);
+void erw_bytecodeimage_save(struct erw_BytecodeImage* self, const char* path);
+void erw_bytecodeimage_print(struct erw_BytecodeImage* self);
+void erw_bytecodeimage_dtor(struct erw_BytecodeImage* self);
+
+#endif
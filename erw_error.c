@@ -47,8 +47,9 @@ void erw_error(
 		ansicode_fprintf(&numcolor, stderr, "%zu", column);
 		fprintf(stderr, "): %s", msg);
 
+		size_t linelen = strcspn(line, "\n");
 		size_t printpos = 0;
-		for(; printpos < strlen(line); printpos++)
+		for(; printpos < linelen; printpos++)
 		{
 			if(!isblank(line[printpos]))
 			{
@@ -56,7 +57,12 @@ void erw_error(
 			}
 		}
 
-		fprintf(stderr, "\n\n    %s\n    ", line + printpos);
+		fprintf(
+			stderr, 
+			"\n\n    %.*s\n    ", 
+			(int)(linelen - printpos), 
+			line + printpos
+		);
 		for(size_t i = 0; i < column - printpos - 1; i++)
 		{
 			fprintf(stderr, " ");
@@ -97,8 +103,9 @@ void erw_warning(
 	fprintf(stderr, ", column ");
 	ansicode_fprintf(&numcolor, stderr, "%zu", column);
 
+	size_t linelen = strcspn(line, "\n");
 	size_t printpos = 0;
-	for(; printpos < strlen(line); printpos++)
+	for(; printpos < linelen; printpos++)
 	{
 		if(!isblank(line[printpos]))
 		{
@@ -109,7 +116,12 @@ void erw_warning(
 	fprintf(stderr, "): %s", msg);
 	if(linenum)
 	{
-		fprintf(stderr, "\n\n    %s\n    ", line + printpos);
+		fprintf(
+			stderr, 
+			"\n\n    %.*s\n    ", 
+			(int)(linelen - printpos), 
+			line + printpos
+		);
 		for(size_t i = 0; i < column - printpos - 1; i++)
 		{
 			fprintf(stderr, " ");
@@ -123,3 +135,47 @@ void erw_warning(
 		fprintf(stderr, "\n");
 	}
 }
+
+void erw_lines_ctor(struct erw_Lines* self, const char* source)
+{
+	log_assert(self, "is NULL");
+	log_assert(source, "is NULL");
+
+	self->source = source;
+	self->starts = NULL;
+}
+
+const char* erw_lines_get(struct erw_Lines* self, size_t linenum)
+{
+	log_assert(self, "is NULL");
+	if(!self->starts)
+	{
+		self->starts = vec_ctor(uint32_t, 0);
+		vec_pushback(self->starts, 0);
+		for(const char* c = self->source; (c = strchr(c, '\n')); c++)
+		{
+			vec_pushback(self->starts, (uint32_t)(c + 1 - self->source));
+		}
+	}
+
+	log_assert(
+		linenum && linenum <= vec_getsize(self->starts), 
+		"invalid line (%zu)", 
+		linenum
+	);
+	return self->source + self->starts[linenum - 1];
+}
+
+size_t erw_lines_getlen(struct erw_Lines* self, size_t linenum)
+{
+	return strcspn(erw_lines_get(self, linenum), "\n");
+}
+
+void erw_lines_dtor(struct erw_Lines* self)
+{
+	log_assert(self, "is NULL");
+	if(self->starts)
+	{
+		vec_dtor(self->starts);
+	}
+}
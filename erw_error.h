@@ -20,15 +20,33 @@
 #ifndef ERW_ERROR
 #define ERW_ERROR
 
+#include "vec.h"
 #include <stddef.h>
-
+#include <stdint.h>
+
+//Where the lines of a source start. Only errors and warnings look lines up, 
+//so the offsets are found the first time erw_lines_get is called.
+//NOTE: The source has to outlive it, and be smaller than 4 GiB
+struct erw_Lines
+{
+	const char* source;
+	Vec(uint32_t) starts; //NULL until the first lookup
+};
+
+void erw_lines_ctor(struct erw_Lines* self, const char* source);
+//Line linenum (counted from 1), it ends with the following '\n' (or '\0')
+const char* erw_lines_get(struct erw_Lines* self, size_t linenum);
+size_t erw_lines_getlen(struct erw_Lines* self, size_t linenum);
+void erw_lines_dtor(struct erw_Lines* self);
+
+//NOTE: 'line' only has to be terminated by '\n' or '\0'
 void erw_error(
 	const char* msg, 
 	const char* line, 
 	size_t linenum, 
 	size_t column, 
 	size_t to
-);
+) __attribute__((noreturn));
 
 void erw_warning(
 	const char* msg, 
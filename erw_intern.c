@@ -0,0 +1,155 @@
+/*
+	Copyright (C) 2017 Erik Wallström
+
+	This file is part of Erwall.
+
+	Erwall is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Erwall is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Erwall.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "erw_intern.h"
+#include "erw_type.h"
+#include "arena.h"
+#include "log.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+struct erw_Atom
+{
+	size_t hash;
+	size_t len;
+	const char* str; //NULL if the slot is empty
+};
+
+static struct
+{
+	struct erw_Atom* slots;
+	size_t capacity; //0 until the first call to erw_intern, then a power of 2
+	size_t count;
+	struct Arena arena;
+} erw_atoms;
+
+static size_t erw_intern_hash(const char* text, size_t len) //FNV-1a
+{
+	size_t hash = 14695981039346656037ULL;
+	for(size_t i = 0; i < len; i++)
+	{
+		hash ^= (unsigned char)text[i];
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+static void erw_intern_insert(struct erw_Atom atom)
+{
+	if((erw_atoms.count + 1) * 2 > erw_atoms.capacity)
+	{
+		struct erw_Atom* oldslots = erw_atoms.slots;
+		size_t oldcapacity = erw_atoms.capacity;
+		erw_atoms.capacity *= 2;
+		erw_atoms.slots = calloc(erw_atoms.capacity, sizeof(struct erw_Atom));
+		if(!erw_atoms.slots)
+		{
+			log_error("calloc failed in <%s>", __func__);
+		}
+
+		erw_atoms.count = 0;
+		for(size_t i = 0; i < oldcapacity; i++)
+		{
+			if(oldslots[i].str)
+			{
+				erw_intern_insert(oldslots[i]);
+			}
+		}
+
+		free(oldslots);
+	}
+
+	size_t i = atom.hash & (erw_atoms.capacity - 1);
+	while(erw_atoms.slots[i].str)
+	{
+		i = (i + 1) & (erw_atoms.capacity - 1);
+	}
+
+	erw_atoms.slots[i] = atom;
+	erw_atoms.count++;
+}
+
+static void erw_intern_init(void)
+{
+	erw_atoms.capacity = 256;
+	erw_atoms.count = 0;
+	erw_atoms.slots = calloc(erw_atoms.capacity, sizeof(struct erw_Atom));
+	if(!erw_atoms.slots)
+	{
+		log_error("calloc failed in <%s>", __func__);
+	}
+
+	arena_ctor(&erw_atoms.arena, 0);
+
+	//Builtin type names are used as atoms directly, they are never copied
+	for(size_t i = 0; i < erw_TYPEBUILTIN_COUNT; i++)
+	{
+		const char* name = erw_type_builtins[i]->named.name;
+		size_t len = strlen(name);
+		erw_intern_insert((struct erw_Atom){
+			.hash = erw_intern_hash(name, len),
+			.len = len,
+			.str = name
+		});
+	}
+}
+
+const char* erw_intern(const char* text, size_t len)
+{
+	log_assert(text, "is NULL");
+	if(!erw_atoms.capacity)
+	{
+		erw_intern_init();
+	}
+
+	size_t hash = erw_intern_hash(text, len);
+	size_t i = hash & (erw_atoms.capacity - 1);
+	while(erw_atoms.slots[i].str)
+	{
+		if(erw_atoms.slots[i].hash == hash && 
+			erw_atoms.slots[i].len == len &&
+			!memcmp(erw_atoms.slots[i].str, text, len))
+		{
+			return erw_atoms.slots[i].str;
+		}
+
+		i = (i + 1) & (erw_atoms.capacity - 1);
+	}
+
+	char* str = arena_alloc(&erw_atoms.arena, len + 1);
+	memcpy(str, text, len);
+	str[len] = '\0';
+	erw_intern_insert((struct erw_Atom){.hash = hash, .len = len, .str = str});
+	return str;
+}
+
+void erw_intern_clear(void)
+{
+	if(erw_atoms.capacity)
+	{
+		free(erw_atoms.slots);
+		arena_dtor(&erw_atoms.arena);
+		erw_atoms.slots = NULL;
+		erw_atoms.capacity = 0;
+		erw_atoms.count = 0;
+	}
+}
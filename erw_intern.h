@@ -0,0 +1,32 @@
+/*
+	Copyright (C) 2017 Erik Wallström
+
+	This file is part of Erwall.
+
+	Erwall is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Erwall is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Erwall.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ERW_INTERN_H
+#define ERW_INTERN_H
+
+#include <stddef.h>
+
+//Returns the atom for text[0..len). An atom is a NUL-terminated string that 
+//is unique for its spelling, so atoms can be compared by pointer. 
+//NOTE: The names of the builtin types are their own atoms
+const char* erw_intern(const char* text, size_t len);
+void erw_intern_clear(void); //Frees all atoms
+
+#endif
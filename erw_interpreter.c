@@ -1,250 +1,916 @@
 #include "erw_interpreter.h"
+#include "erw_profile.h"
+#include "erw_tier.h"
+#include "erw_jit.h"
 #include "log.h"
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 
-/*
-static void erw_interpreter_loadl8(struct erw_Interpreter* self)
+//Return address of the frame pushed by erw_interpreter_call
+#define erw_RETSENTINEL SIZE_MAX
+//Return address of the frame a segment starts with, see
+//erw_interpreter_pushsegment
+#define erw_SEGMENTSENTINEL (SIZE_MAX - 1)
+
+//Values of erw_Interpreter.flags, FCMP sets UNORDERED if either operand is NaN
+#define erw_FLAGS_LESS -1
+#define erw_FLAGS_EQUAL 0
+#define erw_FLAGS_GREATER 1
+#define erw_FLAGS_UNORDERED 2
+
+const struct erw_InstructionInfo erw_instructioninfos[] = {
+	[erw_INSTRUCTIONID_LOADL8] 	= {"loadl8", "rb", 3},
+	[erw_INSTRUCTIONID_LOADL16] = {"loadl16", "rh", 4},
+	[erw_INSTRUCTIONID_LOADL32] = {"loadl32", "rw", 6},
+	[erw_INSTRUCTIONID_LOADL64] = {"loadl64", "rq", 10},
+	[erw_INSTRUCTIONID_ADD] 	= {"add", "rrr", 4},
+	[erw_INSTRUCTIONID_SUB] 	= {"sub", "rrr", 4},
+	[erw_INSTRUCTIONID_MUL] 	= {"mul", "rrr", 4},
+	[erw_INSTRUCTIONID_DIV] 	= {"div", "rrr", 4},
+	[erw_INSTRUCTIONID_POW] 	= {"pow", "rrr", 4},
+	[erw_INSTRUCTIONID_MOD] 	= {"mod", "rrr", 4},
+	[erw_INSTRUCTIONID_UDIV] 	= {"udiv", "rrr", 4},
+	[erw_INSTRUCTIONID_UMOD] 	= {"umod", "rrr", 4},
+	[erw_INSTRUCTIONID_FADD] 	= {"fadd", "rrr", 4},
+	[erw_INSTRUCTIONID_FSUB] 	= {"fsub", "rrr", 4},
+	[erw_INSTRUCTIONID_FMUL] 	= {"fmul", "rrr", 4},
+	[erw_INSTRUCTIONID_FDIV] 	= {"fdiv", "rrr", 4},
+	[erw_INSTRUCTIONID_FPOW] 	= {"fpow", "rrr", 4},
+	[erw_INSTRUCTIONID_FMOD] 	= {"fmod", "rrr", 4},
+	[erw_INSTRUCTIONID_NEG] 	= {"neg", "rr", 3},
+	[erw_INSTRUCTIONID_FNEG] 	= {"fneg", "rr", 3},
+	[erw_INSTRUCTIONID_NOT] 	= {"not", "rr", 3},
+	[erw_INSTRUCTIONID_ITOF] 	= {"itof", "rr", 3},
+	[erw_INSTRUCTIONID_UTOF] 	= {"utof", "rr", 3},
+	[erw_INSTRUCTIONID_FTOI] 	= {"ftoi", "rr", 3},
+	[erw_INSTRUCTIONID_SEXT8] 	= {"sext8", "rr", 3},
+	[erw_INSTRUCTIONID_SEXT16] 	= {"sext16", "rr", 3},
+	[erw_INSTRUCTIONID_SEXT32] 	= {"sext32", "rr", 3},
+	[erw_INSTRUCTIONID_ZEXT8] 	= {"zext8", "rr", 3},
+	[erw_INSTRUCTIONID_ZEXT16] 	= {"zext16", "rr", 3},
+	[erw_INSTRUCTIONID_ZEXT32] 	= {"zext32", "rr", 3},
+	[erw_INSTRUCTIONID_MOV] 	= {"mov", "rr", 3},
+	[erw_INSTRUCTIONID_LOAD] 	= {"load", "rs", 4},
+	[erw_INSTRUCTIONID_STORE] 	= {"store", "sr", 4},
+	[erw_INSTRUCTIONID_PUSH] 	= {"push", "r", 2},
+	[erw_INSTRUCTIONID_POP] 	= {"pop", "r", 2},
+	[erw_INSTRUCTIONID_ENTER] 	= {"enter", "s", 3},
+	[erw_INSTRUCTIONID_CALL] 	= {"call", "t", 5},
+	[erw_INSTRUCTIONID_RET] 	= {"ret", "", 1},
+	[erw_INSTRUCTIONID_CMP] 	= {"cmp", "rr", 3},
+	[erw_INSTRUCTIONID_UCMP] 	= {"ucmp", "rr", 3},
+	[erw_INSTRUCTIONID_FCMP] 	= {"fcmp", "rr", 3},
+	[erw_INSTRUCTIONID_JMP] 	= {"jmp", "t", 5},
+	[erw_INSTRUCTIONID_JNE] 	= {"jne", "t", 5},
+	[erw_INSTRUCTIONID_JGE] 	= {"jge", "t", 5},
+	[erw_INSTRUCTIONID_JLE] 	= {"jle", "t", 5},
+	[erw_INSTRUCTIONID_JE] 		= {"je", "t", 5},
+	[erw_INSTRUCTIONID_JG] 		= {"jg", "t", 5},
+	[erw_INSTRUCTIONID_JL] 		= {"jl", "t", 5},
+	[erw_INSTRUCTIONID_JZ] 		= {"jz", "rt", 6},
+	[erw_INSTRUCTIONID_JNZ] 	= {"jnz", "rt", 6},
+	[erw_INSTRUCTIONID_SETNE] 	= {"setne", "r", 2},
+	[erw_INSTRUCTIONID_SETGE] 	= {"setge", "r", 2},
+	[erw_INSTRUCTIONID_SETLE] 	= {"setle", "r", 2},
+	[erw_INSTRUCTIONID_SETE] 	= {"sete", "r", 2},
+	[erw_INSTRUCTIONID_SETG] 	= {"setg", "r", 2},
+	[erw_INSTRUCTIONID_SETL] 	= {"setl", "r", 2},
+	[erw_INSTRUCTIONID_CMPJNE] 	= {"cmpjne", "rrt", 7},
+	[erw_INSTRUCTIONID_CMPJGE] 	= {"cmpjge", "rrt", 7},
+	[erw_INSTRUCTIONID_CMPJLE] 	= {"cmpjle", "rrt", 7},
+	[erw_INSTRUCTIONID_CMPJE] 	= {"cmpje", "rrt", 7},
+	[erw_INSTRUCTIONID_CMPJG] 	= {"cmpjg", "rrt", 7},
+	[erw_INSTRUCTIONID_CMPJL] 	= {"cmpjl", "rrt", 7},
+	[erw_INSTRUCTIONID_UCMPJNE] = {"ucmpjne", "rrt", 7},
+	[erw_INSTRUCTIONID_UCMPJGE] = {"ucmpjge", "rrt", 7},
+	[erw_INSTRUCTIONID_UCMPJLE] = {"ucmpjle", "rrt", 7},
+	[erw_INSTRUCTIONID_UCMPJE] 	= {"ucmpje", "rrt", 7},
+	[erw_INSTRUCTIONID_UCMPJG] 	= {"ucmpjg", "rrt", 7},
+	[erw_INSTRUCTIONID_UCMPJL] 	= {"ucmpjl", "rrt", 7},
+	[erw_INSTRUCTIONID_ADDI] 	= {"addi", "rri", 7},
+	[erw_INSTRUCTIONID_PUSHN] 	= {"pushn", "b", 2},
+	[erw_INSTRUCTIONID_POPN] 	= {"popn", "b", 2},
+	[erw_INSTRUCTIONID_HALT] 	= {"halt", "", 1},
+};
+
+_Static_assert(
+	sizeof(erw_instructioninfos) / sizeof(erw_instructioninfos[0])
+		== erw_INSTRUCTIONID_COUNT,
+	"erw_instructioninfos is missing an instruction"
+);
+
+size_t erw_operandsize(char operand)
 {
-	log_assert(self, "is NULL");
-
-	*(uint8_t*)(self->registers[self->instructions[self->ip + 1]].buffer) = 
-		*(uint8_t*)(self->instructions + self->ip + 2);
-
-	self->ip += 3;
+	return operand == 'r' || operand == 'b' ? 1
+		: operand == 's' || operand == 'h' ? 2
+		: operand == 't' || operand == 'w' || operand == 'i' ? 4
+		: 8;
 }
 
-static void erw_interpreter_loadl16(struct erw_Interpreter* self)
+//NOTE: Immediates are stored little endian, this assumes a little endian host
+static uint16_t erw_read16(const uint8_t* data)
 {
-	log_assert(self, "is NULL");
+	uint16_t ret;
+	memcpy(&ret, data, sizeof(ret));
+	return ret;
+}
 
-	*(uint16_t*)(self->registers[self->instructions[self->ip + 1]].buffer) = 
-		*(uint16_t*)(self->instructions + self->ip + 2);
+static uint32_t erw_read32(const uint8_t* data)
+{
+	uint32_t ret;
+	memcpy(&ret, data, sizeof(ret));
+	return ret;
+}
 
-	self->ip += 3 + 2;
+static uint64_t erw_read64(const uint8_t* data)
+{
+	uint64_t ret;
+	memcpy(&ret, data, sizeof(ret));
+	return ret;
 }
 
-static void erw_interpreter_loadl32(struct erw_Interpreter* self)
+static int64_t erw_pow(int64_t base, int64_t exponent)
 {
-	log_assert(self, "is NULL");
+	if(exponent < 0)
+	{
+		if(base == 1 || base == -1)
+		{
+			return (exponent & 1) ? base : 1;
+		}
 
-	*(uint32_t*)(self->registers[self->instructions[self->ip + 1]].buffer) = 
-		*(uint32_t*)(self->instructions + self->ip + 2);
+		return 0; //Truncated towards zero like DIV
+	}
 
-	self->ip += 3 + 4;
+	uint64_t ret = 1;
+	uint64_t tmp = base;
+	while(exponent)
+	{
+		if(exponent & 1)
+		{
+			ret *= tmp;
+		}
+
+		tmp *= tmp;
+		exponent >>= 1;
+	}
+
+	return ret;
 }
 
-static void erw_interpreter_loadl64(struct erw_Interpreter* self)
+static int64_t erw_ftoi(double value)
 {
-	log_assert(self, "is NULL");
-
-	*(uint64_t*)(self->registers[self->instructions[self->ip + 1]].buffer) = 
-		*(uint64_t*)(self->instructions + self->ip + 2);
+	//Out of range and NaN give INT64_MIN, like cvttsd2si on x86-64
+	if(value >= -9223372036854775808.0 && value < 9223372036854775808.0)
+	{
+		return (int64_t)value;
+	}
 
-	self->ip += 3 + 8;
+	return INT64_MIN;
 }
 
-static void erw_interpreter_add(struct erw_Interpreter* self)
+//Moves on to the segment after the current one, allocating it the first time
+//the stack gets there
+static struct erw_StackSegment* erw_interpreter_nextsegment(
+	struct erw_Interpreter* self)
 {
-	log_assert(self, "is NULL");
-
-	*(uint64_t*)(self->registers[self->instructions[self->ip + 1]].buffer) = 
-		*(uint64_t*)self->registers[self->instructions[self->ip + 2]].buffer + 
-		*(uint64_t*)self->registers[self->instructions[self->ip + 3]].buffer;
+	struct erw_StackSegment* segment = self->segment;
+	if(!segment || !segment->next)
+	{
+		if(self->segmentsize > self->maxstacksize - self->stacksize)
+		{
+			log_error("Stack overflow");
+		}
+
+		struct erw_StackSegment* next = malloc(
+			sizeof(struct erw_StackSegment)
+				+ self->segmentsize * sizeof(union erw_Register)
+		);
+		if(!next)
+		{
+			log_error("malloc failed <%s>", __func__);
+		}
+
+		next->prev = segment;
+		next->next = NULL;
+		if(segment)
+		{
+			segment->next = next;
+		}
+
+		self->stacksize += self->segmentsize;
+		segment = next;
+	}
+	else
+	{
+		segment = segment->next;
+	}
 
-	self->ip += 4;
+	self->segment = segment;
+	self->stacklimit = segment->slots + self->segmentsize - self->maxframesize;
+	return segment;
 }
 
-static void erw_interpreter_sub(struct erw_Interpreter* self)
+//Starts the frame of a call in the next segment. Below it are the return
+//address and the top of the stack of the caller, then a frame that returns to
+//erw_SEGMENTSENTINEL and the frame pointer of the caller like CALL pushes.
+//Returns the new frame pointer.
+static union erw_Register* erw_interpreter_pushsegment(
+	struct erw_Interpreter* self,
+	union erw_Register* sp,
+	size_t retip,
+	union erw_Register* fp)
 {
-	log_assert(self, "is NULL");
-
-	*(uint64_t*)(self->registers[self->instructions[self->ip + 1]].buffer) = 
-		*(uint64_t*)self->registers[self->instructions[self->ip + 2]].buffer - 
-		*(uint64_t*)self->registers[self->instructions[self->ip + 3]].buffer;
+	union erw_Register* base = erw_interpreter_nextsegment(self)->slots;
+	base[0].uint = retip;
+	base[1].frame = sp;
+	base[2].uint = erw_SEGMENTSENTINEL;
+	base[3].frame = fp;
+	return base + 4;
+}
 
-	self->ip += 4;
+//Returns to the segment before, once RET reached erw_SEGMENTSENTINEL. Restores
+//sp of the caller and returns the real return address.
+static size_t erw_interpreter_popsegment(
+	struct erw_Interpreter* self,
+	union erw_Register** sp)
+{
+	union erw_Register* base = self->segment->slots;
+	log_assert(*sp == base + 2, "not at the start of a segment");
+	*sp = base[1].frame;
+	self->segment = self->segment->prev;
+	self->stacklimit = self->segment->slots + self->segmentsize
+		- self->maxframesize;
+	return base[0].uint;
 }
 
-static void erw_interpreter_mul(struct erw_Interpreter* self)
+struct erw_Interpreter* erw_interpreter_ctor(
+	struct erw_Interpreter* self,
+	struct erw_BytecodeImage* image,
+	size_t maxstacksize)
 {
 	log_assert(self, "is NULL");
-
-	*(uint64_t*)(self->registers[self->instructions[self->ip + 1]].buffer) = 
-		*(uint64_t*)self->registers[self->instructions[self->ip + 2]].buffer * 
-		*(uint64_t*)self->registers[self->instructions[self->ip + 3]].buffer;
-
-	self->ip += 4;
+	log_assert(image, "is NULL");
+
+	//Segments start with 4 slots for erw_interpreter_pushsegment, so any
+	//frame still fits
+	self->numinstructions = image->numinstructions;
+	self->instructions = image->instructions;
+	self->maxframesize = image->maxframesize;
+	self->segmentsize = image->maxframesize + 4 > erw_STACK_SEGMENTSIZE
+		? image->maxframesize + 4
+		: erw_STACK_SEGMENTSIZE;
+	self->stacksize = 0;
+	self->maxstacksize = maxstacksize > self->segmentsize
+		? maxstacksize
+		: self->segmentsize;
+	self->segment = NULL;
+	self->ip = 0;
+	self->flags = erw_FLAGS_EQUAL;
+	self->profile = NULL;
+	self->tier = NULL;
+	self->jit = NULL;
+	memset(self->registers, 0, sizeof(self->registers));
+
+	self->sp = erw_interpreter_nextsegment(self)->slots;
+	self->fp = self->sp;
+	return self;
 }
 
-static void erw_interpreter_div(struct erw_Interpreter* self)
+//NOTE: The instruction stream was checked by the verifier when it was loaded
+//(see erw_verifier.h), so registers, slots and jump targets are not checked
+//here. Only calls check the stack, for room for the largest frame, and move to
+//the next segment if there isn't.
+void erw_interpreter_call(struct erw_Interpreter* self, size_t entry)
 {
 	log_assert(self, "is NULL");
+	log_assert(
+		entry < self->numinstructions,
+		"invalid entry (%zu)",
+		entry
+	);
 
-	*(uint64_t*)(self->registers[self->instructions[self->ip + 1]].buffer) = 
-		*(uint64_t*)self->registers[self->instructions[self->ip + 2]].buffer / 
-		*(uint64_t*)self->registers[self->instructions[self->ip + 3]].buffer;
+	//Direct threading with computed goto: every handler ends in its own
+	//indirect jump, which predicts much better than a single switch
+	static void* const labels[] = {
+		[erw_INSTRUCTIONID_LOADL8] 	= &&loadl8,
+		[erw_INSTRUCTIONID_LOADL16] = &&loadl16,
+		[erw_INSTRUCTIONID_LOADL32] = &&loadl32,
+		[erw_INSTRUCTIONID_LOADL64] = &&loadl64,
+		[erw_INSTRUCTIONID_ADD] 	= &&add,
+		[erw_INSTRUCTIONID_SUB] 	= &&sub,
+		[erw_INSTRUCTIONID_MUL] 	= &&mul,
+		[erw_INSTRUCTIONID_DIV] 	= &&div,
+		[erw_INSTRUCTIONID_POW] 	= &&pow,
+		[erw_INSTRUCTIONID_MOD] 	= &&mod,
+		[erw_INSTRUCTIONID_UDIV] 	= &&udiv,
+		[erw_INSTRUCTIONID_UMOD] 	= &&umod,
+		[erw_INSTRUCTIONID_FADD] 	= &&fadd,
+		[erw_INSTRUCTIONID_FSUB] 	= &&fsub,
+		[erw_INSTRUCTIONID_FMUL] 	= &&fmul,
+		[erw_INSTRUCTIONID_FDIV] 	= &&fdiv,
+		[erw_INSTRUCTIONID_FPOW] 	= &&fpow,
+		[erw_INSTRUCTIONID_FMOD] 	= &&fmod,
+		[erw_INSTRUCTIONID_NEG] 	= &&neg,
+		[erw_INSTRUCTIONID_FNEG] 	= &&fneg,
+		[erw_INSTRUCTIONID_NOT] 	= &&not,
+		[erw_INSTRUCTIONID_ITOF] 	= &&itof,
+		[erw_INSTRUCTIONID_UTOF] 	= &&utof,
+		[erw_INSTRUCTIONID_FTOI] 	= &&ftoi,
+		[erw_INSTRUCTIONID_SEXT8] 	= &&sext8,
+		[erw_INSTRUCTIONID_SEXT16] 	= &&sext16,
+		[erw_INSTRUCTIONID_SEXT32] 	= &&sext32,
+		[erw_INSTRUCTIONID_ZEXT8] 	= &&zext8,
+		[erw_INSTRUCTIONID_ZEXT16] 	= &&zext16,
+		[erw_INSTRUCTIONID_ZEXT32] 	= &&zext32,
+		[erw_INSTRUCTIONID_MOV] 	= &&mov,
+		[erw_INSTRUCTIONID_LOAD] 	= &&load,
+		[erw_INSTRUCTIONID_STORE] 	= &&store,
+		[erw_INSTRUCTIONID_PUSH] 	= &&push,
+		[erw_INSTRUCTIONID_POP] 	= &&pop,
+		[erw_INSTRUCTIONID_ENTER] 	= &&enter,
+		[erw_INSTRUCTIONID_CALL] 	= &&call,
+		[erw_INSTRUCTIONID_RET] 	= &&ret,
+		[erw_INSTRUCTIONID_CMP] 	= &&cmp,
+		[erw_INSTRUCTIONID_UCMP] 	= &&ucmp,
+		[erw_INSTRUCTIONID_FCMP] 	= &&fcmp,
+		[erw_INSTRUCTIONID_JMP] 	= &&jmp,
+		[erw_INSTRUCTIONID_JNE] 	= &&jne,
+		[erw_INSTRUCTIONID_JGE] 	= &&jge,
+		[erw_INSTRUCTIONID_JLE] 	= &&jle,
+		[erw_INSTRUCTIONID_JE] 		= &&je,
+		[erw_INSTRUCTIONID_JG] 		= &&jg,
+		[erw_INSTRUCTIONID_JL] 		= &&jl,
+		[erw_INSTRUCTIONID_JZ] 		= &&jz,
+		[erw_INSTRUCTIONID_JNZ] 	= &&jnz,
+		[erw_INSTRUCTIONID_SETNE] 	= &&setne,
+		[erw_INSTRUCTIONID_SETGE] 	= &&setge,
+		[erw_INSTRUCTIONID_SETLE] 	= &&setle,
+		[erw_INSTRUCTIONID_SETE] 	= &&sete,
+		[erw_INSTRUCTIONID_SETG] 	= &&setg,
+		[erw_INSTRUCTIONID_SETL] 	= &&setl,
+		[erw_INSTRUCTIONID_CMPJNE] 	= &&cmpjne,
+		[erw_INSTRUCTIONID_CMPJGE] 	= &&cmpjge,
+		[erw_INSTRUCTIONID_CMPJLE] 	= &&cmpjle,
+		[erw_INSTRUCTIONID_CMPJE] 	= &&cmpje,
+		[erw_INSTRUCTIONID_CMPJG] 	= &&cmpjg,
+		[erw_INSTRUCTIONID_CMPJL] 	= &&cmpjl,
+		[erw_INSTRUCTIONID_UCMPJNE] = &&ucmpjne,
+		[erw_INSTRUCTIONID_UCMPJGE] = &&ucmpjge,
+		[erw_INSTRUCTIONID_UCMPJLE] = &&ucmpjle,
+		[erw_INSTRUCTIONID_UCMPJE] 	= &&ucmpje,
+		[erw_INSTRUCTIONID_UCMPJG] 	= &&ucmpjg,
+		[erw_INSTRUCTIONID_UCMPJL] 	= &&ucmpjl,
+		[erw_INSTRUCTIONID_ADDI] 	= &&addi,
+		[erw_INSTRUCTIONID_PUSHN] 	= &&pushn,
+		[erw_INSTRUCTIONID_POPN] 	= &&popn,
+		[erw_INSTRUCTIONID_HALT] 	= &&halt,
+	};
+
+	_Static_assert(
+		sizeof(labels) / sizeof(labels[0]) == erw_INSTRUCTIONID_COUNT,
+		"labels is missing an instruction"
+	);
 
-	self->ip += 4;
-}
+	//Profiling swaps in a table that sends every instruction through the 
+	//profile handler first, so it costs nothing when it's off
+	static void* const profilelabels[] = {
+		[0 ... erw_INSTRUCTIONID_COUNT - 1] = &&profile
+	};
 
-static void erw_interpreter_pow(struct erw_Interpreter* self)
-{
-	log_assert(self, "is NULL");
+	//Tiering and the JIT only send calls and returns elsewhere, so the rest of
+	//the table is copied
+	void* hooklabels[erw_INSTRUCTIONID_COUNT];
+	if(self->jit)
+	{
+		memcpy(hooklabels, labels, sizeof(labels));
+		hooklabels[erw_INSTRUCTIONID_CALL] = &&jitcall;
+		hooklabels[erw_INSTRUCTIONID_RET] = &&jitret;
+	}
+	else if(self->tier)
+	{
+		memcpy(hooklabels, labels, sizeof(labels));
+		hooklabels[erw_INSTRUCTIONID_CALL] = &&tiercall;
+	}
 
-	*(uint64_t*)(self->registers[self->instructions[self->ip + 1]].buffer) = 
-		*(uint64_t*)self->registers[self->instructions[self->ip + 2]].buffer + 
-		*(uint64_t*)self->registers[self->instructions[self->ip + 3]].buffer;
+	void* const* const dispatch = self->profile ? profilelabels
+		: self->jit || self->tier ? hooklabels
+		: labels;
 
-	self->ip += 4;
-}
+	//The hot state is kept in locals so it can live in machine registers
+	const uint8_t* const code = self->instructions;
+	const uint8_t* pc = code + entry;
+	union erw_Register* const r = self->registers;
+	union erw_Register* sp = self->sp;
+	union erw_Register* fp = self->fp;
+	int flags = self->flags;
 
-static void erw_interpreter_mod(struct erw_Interpreter* self)
-{
-	log_assert(self, "is NULL");
+	if(sp > self->stacklimit)
+	{
+		sp = erw_interpreter_pushsegment(self, sp, erw_RETSENTINEL, fp);
+	}
+	else
+	{
+		(sp++)->uint = erw_RETSENTINEL;
+		(sp++)->frame = fp;
+	}
 
-	*(uint64_t*)(self->registers[self->instructions[self->ip + 1]].buffer) = 
-		*(uint64_t*)self->registers[self->instructions[self->ip + 2]].buffer % 
-		*(uint64_t*)self->registers[self->instructions[self->ip + 3]].buffer;
+	//Calls leave room for the largest frame, see erw_verifier.h
+	union erw_Register* stacklimit = self->stacklimit;
+	fp = sp;
+	if(self->profile)
+	{
+		erw_profile_enter(self->profile, entry);
+	}
 
-	self->ip += 4;
-}
+	size_t next = entry; //Offset where the JIT continues
+	if(self->jit)
+	{
+		goto jitenter;
+	}
 
-static void erw_interpreter_mov8(struct erw_Interpreter* self)
-{
-	log_assert(self, "is NULL");
-}
+#define erw_DISPATCH() goto *dispatch[*pc]
+#define erw_BINOP(field, op) \
+	r[pc[1]].field = r[pc[2]].field op r[pc[3]].field; \
+	pc += 4; \
+	erw_DISPATCH()
+#define erw_UNOP(expr) \
+	r[pc[1]] = (union erw_Register){expr}; \
+	pc += 3; \
+	erw_DISPATCH()
+#define erw_JUMPIF(cond) \
+	pc = (cond) ? code + erw_read32(pc + 1) : pc + 5; \
+	erw_DISPATCH()
+#define erw_SETIF(cond) \
+	r[pc[1]].uint = (cond); \
+	pc += 2; \
+	erw_DISPATCH()
+#define erw_CMPJUMPIF(field, cond) \
+	flags = (r[pc[1]].field > r[pc[2]].field) \
+		- (r[pc[1]].field < r[pc[2]].field); \
+	pc = (cond) ? code + erw_read32(pc + 3) : pc + 7; \
+	erw_DISPATCH()
+
+	erw_DISPATCH();
+
+loadl8:
+	r[pc[1]].uint = pc[2];
+	pc += 3;
+	erw_DISPATCH();
+
+loadl16:
+	r[pc[1]].uint = erw_read16(pc + 2);
+	pc += 4;
+	erw_DISPATCH();
+
+loadl32:
+	r[pc[1]].uint = erw_read32(pc + 2);
+	pc += 6;
+	erw_DISPATCH();
+
+loadl64:
+	r[pc[1]].uint = erw_read64(pc + 2);
+	pc += 10;
+	erw_DISPATCH();
+
+	//Integer arithmetic is done unsigned so that overflow wraps
+add:
+	erw_BINOP(uint, +);
+
+sub:
+	erw_BINOP(uint, -);
+
+mul:
+	erw_BINOP(uint, *);
+
+div:
+	if(!r[pc[3]].int_)
+	{
+		log_error("Division by zero");
+	}
 
-static void erw_interpreter_mov16(struct erw_Interpreter* self)
-{
-	log_assert(self, "is NULL");
-}
+	r[pc[1]].int_ = r[pc[3]].int_ == -1
+		? (int64_t)(0 - r[pc[2]].uint) //INT64_MIN / -1 wraps
+		: r[pc[2]].int_ / r[pc[3]].int_;
+	pc += 4;
+	erw_DISPATCH();
 
-static void erw_interpreter_mov32(struct erw_Interpreter* self)
-{
-	log_assert(self, "is NULL");
-}
+pow:
+	r[pc[1]].int_ = erw_pow(r[pc[2]].int_, r[pc[3]].int_);
+	pc += 4;
+	erw_DISPATCH();
 
-static void erw_interpreter_mov64(struct erw_Interpreter* self)
-{
-	log_assert(self, "is NULL");
-}
+mod:
+	if(!r[pc[3]].int_)
+	{
+		log_error("Division by zero");
+	}
 
-static void erw_interpreter_push(struct erw_Interpreter* self)
-{
-	log_assert(self, "is NULL");
+	r[pc[1]].int_ = r[pc[3]].int_ == -1 ? 0 : r[pc[2]].int_ % r[pc[3]].int_;
+	pc += 4;
+	erw_DISPATCH();
 
-	self->sp++;
-	if(self->sp >= self->stacksize)
+udiv:
+	if(!r[pc[3]].uint)
 	{
-		log_error("Stack overflow");
+		log_error("Division by zero");
 	}
-}
 
-static void erw_interpreter_pop(struct erw_Interpreter* self)
-{
-	log_assert(self, "is NULL");
+	erw_BINOP(uint, /);
 
-	if(!self->sp)
+umod:
+	if(!r[pc[3]].uint)
 	{
-		log_error("Stack underflow");
+		log_error("Division by zero");
 	}
 
-	self->sp++;
-}
+	erw_BINOP(uint, %);
 
-static void erw_interpreter_call(struct erw_Interpreter* self)
-{
-	log_assert(self, "is NULL");
+fadd:
+	erw_BINOP(float_, +);
 
-}
+fsub:
+	erw_BINOP(float_, -);
 
-static void erw_interpreter_ret(struct erw_Interpreter* self)
-{
-	log_assert(self, "is NULL");
+fmul:
+	erw_BINOP(float_, *);
 
-}
+fdiv:
+	erw_BINOP(float_, /);
 
-static void erw_interpreter_setrunners(struct erw_Interpreter* self)
-{
-	log_assert(self, "is NULL");
+fpow:
+	r[pc[1]].float_ = pow(r[pc[2]].float_, r[pc[3]].float_);
+	pc += 4;
+	erw_DISPATCH();
 
-	self->runners[0] 	= erw_interpreter_loadl8;
-	self->runners[1] 	= erw_interpreter_loadl16;
-	self->runners[2] 	= erw_interpreter_loadl32;
-	self->runners[3] 	= erw_interpreter_loadl64;
-	self->runners[4] 	= erw_interpreter_add;
-	self->runners[5] 	= erw_interpreter_sub;
-	self->runners[6]	= erw_interpreter_mul;
-	self->runners[7] 	= erw_interpreter_div;
-	self->runners[8] 	= erw_interpreter_pow;
-	self->runners[9] 	= erw_interpreter_mod;
-}
+fmod:
+	r[pc[1]].float_ = fmod(r[pc[2]].float_, r[pc[3]].float_);
+	pc += 4;
+	erw_DISPATCH();
 
-static void erw_interpreter_run(struct erw_Interpreter* self)
-{
-	log_assert(self, "is NULL");
-	while(self->ip < self->numinstructions)
+neg:
+	erw_UNOP(.uint = 0 - r[pc[2]].uint);
+
+fneg:
+	erw_UNOP(.float_ = -r[pc[2]].float_);
+
+not:
+	erw_UNOP(.uint = !r[pc[2]].uint);
+
+itof:
+	erw_UNOP(.float_ = (double)r[pc[2]].int_);
+
+utof:
+	erw_UNOP(.float_ = (double)r[pc[2]].uint);
+
+ftoi:
+	erw_UNOP(.int_ = erw_ftoi(r[pc[2]].float_));
+
+sext8:
+	erw_UNOP(.int_ = (int8_t)r[pc[2]].uint);
+
+sext16:
+	erw_UNOP(.int_ = (int16_t)r[pc[2]].uint);
+
+sext32:
+	erw_UNOP(.int_ = (int32_t)r[pc[2]].uint);
+
+zext8:
+	erw_UNOP(.uint = (uint8_t)r[pc[2]].uint);
+
+zext16:
+	erw_UNOP(.uint = (uint16_t)r[pc[2]].uint);
+
+zext32:
+	erw_UNOP(.uint = (uint32_t)r[pc[2]].uint);
+
+mov:
+	r[pc[1]] = r[pc[2]];
+	pc += 3;
+	erw_DISPATCH();
+
+load:
+	r[pc[1]] = fp[erw_read16(pc + 2)];
+	pc += 4;
+	erw_DISPATCH();
+
+store:
+	fp[erw_read16(pc + 1)] = r[pc[3]];
+	pc += 4;
+	erw_DISPATCH();
+
+push:
+	*sp++ = r[pc[1]];
+	pc += 2;
+	erw_DISPATCH();
+
+pop:
+	r[pc[1]] = *--sp;
+	pc += 2;
+	erw_DISPATCH();
+
+enter:
 	{
-		self->runners[self->instructions[self->ip]](self);
+		size_t numslots = erw_read16(pc + 1);
+		memset(sp, 0, numslots * sizeof(union erw_Register));
+		sp += numslots;
+		pc += 3;
+		erw_DISPATCH();
 	}
-}
 
-*/
+call:
+	if(sp > stacklimit)
+	{
+		sp = erw_interpreter_pushsegment(self, sp, pc + 5 - code, fp);
+		stacklimit = self->stacklimit;
+	}
+	else
+	{
+		(sp++)->uint = pc + 5 - code;
+		(sp++)->frame = fp;
+	}
 
-struct erw_Interpreter* erw_interpreter_ctor(
-	struct erw_Interpreter* self, 
-	uint8_t* instructions,
-	size_t numinstructions, 
-	size_t stacksize)
-{
-	log_assert(self, "is NULL");
-	log_assert(instructions, "is NULL");
+	fp = sp;
+	pc = code + erw_read32(pc + 1);
+	erw_DISPATCH();
 
-	self->numinstructions = numinstructions;
-	self->instructions = instructions;
-	self->ip = 0;
-	self->sp = 0;
-	memset(self->registers, 0, sizeof(struct erw_Register) * erw_NUMREGISTERS);
+ret:
+	{
+		sp = fp;
+		fp = (--sp)->frame;
+		size_t retip = (--sp)->uint;
+		if(retip >= erw_SEGMENTSENTINEL)
+		{
+			if(retip == erw_SEGMENTSENTINEL)
+			{
+				retip = erw_interpreter_popsegment(self, &sp);
+				stacklimit = self->stacklimit;
+			}
+
+			if(retip == erw_RETSENTINEL)
+			{
+				goto done;
+			}
+		}
+
+		pc = code + retip;
+		erw_DISPATCH();
+	}
+
+cmp:
+	flags = (r[pc[1]].int_ > r[pc[2]].int_) - (r[pc[1]].int_ < r[pc[2]].int_);
+	pc += 3;
+	erw_DISPATCH();
+
+ucmp:
+	flags = (r[pc[1]].uint > r[pc[2]].uint) - (r[pc[1]].uint < r[pc[2]].uint);
+	pc += 3;
+	erw_DISPATCH();
 
-	self->stack = malloc(stacksize);
-	if(!self->stack)
+fcmp:
+	if(isunordered(r[pc[1]].float_, r[pc[2]].float_))
 	{
-		log_error("malloc failed <%s>", __func__);
+		flags = erw_FLAGS_UNORDERED;
+	}
+	else
+	{
+		flags = (r[pc[1]].float_ > r[pc[2]].float_)
+			- (r[pc[1]].float_ < r[pc[2]].float_);
 	}
 
-	//erw_interpreter_setrunners(self);
-	//erw_interpreter_run(self);
+	pc += 3;
+	erw_DISPATCH();
 
-	return self;
+jmp:
+	pc = code + erw_read32(pc + 1);
+	erw_DISPATCH();
+
+jne:
+	erw_JUMPIF(flags != erw_FLAGS_EQUAL);
+
+jge:
+	erw_JUMPIF(flags == erw_FLAGS_EQUAL || flags == erw_FLAGS_GREATER);
+
+jle:
+	erw_JUMPIF(flags == erw_FLAGS_EQUAL || flags == erw_FLAGS_LESS);
+
+je:
+	erw_JUMPIF(flags == erw_FLAGS_EQUAL);
+
+jg:
+	erw_JUMPIF(flags == erw_FLAGS_GREATER);
+
+jl:
+	erw_JUMPIF(flags == erw_FLAGS_LESS);
+
+jz:
+	pc = r[pc[1]].uint ? pc + 6 : code + erw_read32(pc + 2);
+	erw_DISPATCH();
+
+jnz:
+	pc = r[pc[1]].uint ? code + erw_read32(pc + 2) : pc + 6;
+	erw_DISPATCH();
+
+setne:
+	erw_SETIF(flags != erw_FLAGS_EQUAL);
+
+setge:
+	erw_SETIF(flags == erw_FLAGS_EQUAL || flags == erw_FLAGS_GREATER);
+
+setle:
+	erw_SETIF(flags == erw_FLAGS_EQUAL || flags == erw_FLAGS_LESS);
+
+sete:
+	erw_SETIF(flags == erw_FLAGS_EQUAL);
+
+setg:
+	erw_SETIF(flags == erw_FLAGS_GREATER);
+
+setl:
+	erw_SETIF(flags == erw_FLAGS_LESS);
+
+cmpjne:
+	erw_CMPJUMPIF(int_, flags != erw_FLAGS_EQUAL);
+
+cmpjge:
+	erw_CMPJUMPIF(int_, flags != erw_FLAGS_LESS);
+
+cmpjle:
+	erw_CMPJUMPIF(int_, flags != erw_FLAGS_GREATER);
+
+cmpje:
+	erw_CMPJUMPIF(int_, flags == erw_FLAGS_EQUAL);
+
+cmpjg:
+	erw_CMPJUMPIF(int_, flags == erw_FLAGS_GREATER);
+
+cmpjl:
+	erw_CMPJUMPIF(int_, flags == erw_FLAGS_LESS);
+
+ucmpjne:
+	erw_CMPJUMPIF(uint, flags != erw_FLAGS_EQUAL);
+
+ucmpjge:
+	erw_CMPJUMPIF(uint, flags != erw_FLAGS_LESS);
+
+ucmpjle:
+	erw_CMPJUMPIF(uint, flags != erw_FLAGS_GREATER);
+
+ucmpje:
+	erw_CMPJUMPIF(uint, flags == erw_FLAGS_EQUAL);
+
+ucmpjg:
+	erw_CMPJUMPIF(uint, flags == erw_FLAGS_GREATER);
+
+ucmpjl:
+	erw_CMPJUMPIF(uint, flags == erw_FLAGS_LESS);
+
+addi:
+	r[pc[1]].uint = r[pc[2]].uint + (uint64_t)(int32_t)erw_read32(pc + 3);
+	pc += 7;
+	erw_DISPATCH();
+
+pushn:
+	memcpy(sp, r, pc[1] * sizeof(union erw_Register));
+	sp += pc[1];
+	pc += 2;
+	erw_DISPATCH();
+
+popn:
+	sp -= pc[1];
+	memcpy(r, sp, pc[1] * sizeof(union erw_Register));
+	pc += 2;
+	erw_DISPATCH();
+
+profile:
+	{
+		struct erw_Profile* profile = self->profile;
+		profile->opcodes[*pc]++;
+		profile->executions[pc - code]++;
+		if(*pc == erw_INSTRUCTIONID_CALL)
+		{
+			erw_profile_enter(profile, erw_read32(pc + 1));
+		}
+		else if(*pc == erw_INSTRUCTIONID_RET)
+		{
+			erw_profile_leave(profile);
+		}
+
+		goto *labels[*pc];
+	}
+
+tiercall:
+	{
+		erw_TierNative native = erw_tier_lookup(self->tier, erw_read32(pc + 1));
+		if(!native)
+		{
+			goto call;
+		}
+
+		//Calls from native code back into the interpreter go above this frame
+		self->sp = sp;
+		self->fp = fp;
+		native(&self->tier->runtime);
+		pc += 5;
+		erw_DISPATCH();
+	}
+
+jitcall:
+	if(sp > stacklimit)
+	{
+		sp = erw_interpreter_pushsegment(self, sp, pc + 5 - code, fp);
+		stacklimit = self->stacklimit;
+	}
+	else
+	{
+		(sp++)->uint = pc + 5 - code;
+		(sp++)->frame = fp;
+	}
+
+	fp = sp;
+	next = erw_read32(pc + 1);
+	goto jitenter;
+
+jitret:
+	sp = fp;
+	fp = (--sp)->frame;
+	next = (--sp)->uint;
+
+jitenter:
+	{
+		//Runs JIT code until it returns to the interpreter or reaches code
+		//that has to be interpreted. Returns to erw_SEGMENTSENTINEL always
+		//leave JIT code, so segments are only popped here.
+		struct erw_Jit* jit = self->jit;
+		while(1)
+		{
+			if(next == erw_SEGMENTSENTINEL)
+			{
+				next = erw_interpreter_popsegment(self, &sp);
+				stacklimit = self->stacklimit;
+			}
+
+			const void* native;
+			if(next == erw_RETSENTINEL)
+			{
+				goto done;
+			}
+			else if(!(native = erw_jit_lookup(jit, next)))
+			{
+				break;
+			}
+
+			jit->state.sp = sp;
+			jit->state.fp = fp;
+			jit->state.stacklimit = stacklimit;
+			jit->state.flags = flags;
+			struct erw_JitExit jitexit = jit->enter(&jit->state, native);
+			sp = jit->state.sp;
+			fp = jit->state.fp;
+			flags = jit->state.flags;
+			next = jitexit.next;
+			if(jitexit.isfallback)
+			{
+				break;
+			}
+		}
+
+		pc = code + next;
+		erw_DISPATCH();
+	}
+
+halt:
+	pc += 1;
+	while(self->profile && vec_getsize(self->profile->frames))
+	{
+		erw_profile_leave(self->profile); //Calls that never returned
+	}
+
+done:
+#undef erw_DISPATCH
+#undef erw_BINOP
+#undef erw_UNOP
+#undef erw_JUMPIF
+#undef erw_SETIF
+#undef erw_CMPJUMPIF
+	self->ip = pc - code;
+	self->sp = sp;
+	self->fp = fp;
+	self->flags = flags;
 }
 
 void erw_interpreter_dtor(struct erw_Interpreter* self)
 {
 	log_assert(self, "is NULL");
-	free(self->stack);
-}
-
-/* TODO: 
-#include "vec.h"
-int main(void)
-{
-	Vec(uint8_t) instructions = vec_ctor(uint8_t, 0);
-	vec_pushbackwitharr(
-		instructions, 
-		((uint8_t[]){
-			erw_INSTRUCTIONID_LOADL8, 0, 3,
-			erw_INSTRUCTIONID_LOADL8, 1, 9,
-			erw_INSTRUCTIONID_LOADL8, 2, 2,
-			erw_INSTRUCTIONID_ADD, 0, 0, 1,
-			erw_INSTRUCTIONID_MUL, 2, 0, 2,
-		}),
-		17
-	);
+	while(self->segment->prev)
+	{
+		self->segment = self->segment->prev;
+	}
 
-	struct erw_Interpreter interpreter;
-	erw_interpreter_ctor(&interpreter, instructions, vec_getsize(instructions), 1024);
-	printf("Result: %lu\n", *(uint64_t*)interpreter.registers[2].buffer);
-	erw_interpreter_dtor(&interpreter);
+	while(self->segment)
+	{
+		struct erw_StackSegment* next = self->segment->next;
+		free(self->segment);
+		self->segment = next;
+	}
 }
-*/
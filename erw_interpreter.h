@@ -23,70 +23,179 @@
 #include <stdint.h>
 #include <stddef.h>
 
-#define erw_NUMREGISTERS 4
-#define erw_NUMINSTRUCTIONS 29
+//Register operands are one byte, so there can be at most 256 registers. Can
+//be lowered at build time (-Derw_NUMREGISTERS=N) to shrink the register file.
+#ifndef erw_NUMREGISTERS
+#define erw_NUMREGISTERS 256
+#endif
+
+_Static_assert(
+	erw_NUMREGISTERS >= 2 && erw_NUMREGISTERS <= 256,
+	"erw_NUMREGISTERS has to be in [2, 256]"
+);
 
+//Instructions are variable length: an opcode byte followed by its operands. 
+//Registers (r) are one byte, frame slots (s) two bytes and jump targets (t) 
+//four byte offsets from the start of the instruction stream. Immediates are
+//little endian and unaligned.
 enum erw_InstructionID
 {
-	erw_INSTRUCTIONID_LOADL8,
-	erw_INSTRUCTIONID_LOADL16,
-	erw_INSTRUCTIONID_LOADL32,
-	erw_INSTRUCTIONID_LOADL64,
-	erw_INSTRUCTIONID_ADD,
-	erw_INSTRUCTIONID_SUB,
-	erw_INSTRUCTIONID_MUL,
-	erw_INSTRUCTIONID_DIV, 	
-	erw_INSTRUCTIONID_POW,
-	erw_INSTRUCTIONID_MOD, 	
-	erw_INSTRUCTIONID_FADD,
-	erw_INSTRUCTIONID_FSUB, 	
-	erw_INSTRUCTIONID_FMUL,
-	erw_INSTRUCTIONID_FDIV, 	
-	erw_INSTRUCTIONID_FPOW,
-	erw_INSTRUCTIONID_FMOD, 	
-	erw_INSTRUCTIONID_MOV,
-	erw_INSTRUCTIONID_PUSH,
-	erw_INSTRUCTIONID_POP,
-	erw_INSTRUCTIONID_CALL, 	
-	erw_INSTRUCTIONID_RET, 	
-	erw_INSTRUCTIONID_CMP, 	
-	erw_INSTRUCTIONID_JMP,
-	erw_INSTRUCTIONID_JNE, 	
-	erw_INSTRUCTIONID_JGE,
-	erw_INSTRUCTIONID_JLE, 	
-	erw_INSTRUCTIONID_JE,
-	erw_INSTRUCTIONID_JG, 	
-	erw_INSTRUCTIONID_JL,
+	erw_INSTRUCTIONID_LOADL8, 	//r imm8, zero extended
+	erw_INSTRUCTIONID_LOADL16, 	//r imm16, zero extended
+	erw_INSTRUCTIONID_LOADL32, 	//r imm32, zero extended
+	erw_INSTRUCTIONID_LOADL64, 	//r imm64
+	erw_INSTRUCTIONID_ADD, 		//r r r
+	erw_INSTRUCTIONID_SUB, 		//r r r
+	erw_INSTRUCTIONID_MUL, 		//r r r
+	erw_INSTRUCTIONID_DIV, 		//r r r
+	erw_INSTRUCTIONID_POW, 		//r r r
+	erw_INSTRUCTIONID_MOD, 		//r r r
+	erw_INSTRUCTIONID_UDIV, 	//r r r
+	erw_INSTRUCTIONID_UMOD, 	//r r r
+	erw_INSTRUCTIONID_FADD, 	//r r r
+	erw_INSTRUCTIONID_FSUB, 	//r r r
+	erw_INSTRUCTIONID_FMUL, 	//r r r
+	erw_INSTRUCTIONID_FDIV, 	//r r r
+	erw_INSTRUCTIONID_FPOW, 	//r r r
+	erw_INSTRUCTIONID_FMOD, 	//r r r
+	erw_INSTRUCTIONID_NEG, 		//r r
+	erw_INSTRUCTIONID_FNEG, 	//r r
+	erw_INSTRUCTIONID_NOT, 		//r r
+	erw_INSTRUCTIONID_ITOF, 	//r r
+	erw_INSTRUCTIONID_UTOF, 	//r r
+	erw_INSTRUCTIONID_FTOI, 	//r r
+	erw_INSTRUCTIONID_SEXT8, 	//r r
+	erw_INSTRUCTIONID_SEXT16, 	//r r
+	erw_INSTRUCTIONID_SEXT32, 	//r r
+	erw_INSTRUCTIONID_ZEXT8, 	//r r
+	erw_INSTRUCTIONID_ZEXT16, 	//r r
+	erw_INSTRUCTIONID_ZEXT32, 	//r r
+	erw_INSTRUCTIONID_MOV, 		//r r
+	erw_INSTRUCTIONID_LOAD, 	//r s
+	erw_INSTRUCTIONID_STORE, 	//s r
+	erw_INSTRUCTIONID_PUSH, 	//r
+	erw_INSTRUCTIONID_POP, 		//r
+	erw_INSTRUCTIONID_ENTER, 	//s, reserves s zeroed slots for locals
+	erw_INSTRUCTIONID_CALL, 	//t
+	erw_INSTRUCTIONID_RET,
+	erw_INSTRUCTIONID_CMP, 		//r r
+	erw_INSTRUCTIONID_UCMP, 	//r r
+	erw_INSTRUCTIONID_FCMP, 	//r r
+	erw_INSTRUCTIONID_JMP, 		//t
+	erw_INSTRUCTIONID_JNE, 		//t
+	erw_INSTRUCTIONID_JGE, 		//t
+	erw_INSTRUCTIONID_JLE, 		//t
+	erw_INSTRUCTIONID_JE, 		//t
+	erw_INSTRUCTIONID_JG, 		//t
+	erw_INSTRUCTIONID_JL, 		//t
+	erw_INSTRUCTIONID_JZ, 		//r t
+	erw_INSTRUCTIONID_JNZ, 		//r t
+	erw_INSTRUCTIONID_SETNE, 	//r
+	erw_INSTRUCTIONID_SETGE, 	//r
+	erw_INSTRUCTIONID_SETLE, 	//r
+	erw_INSTRUCTIONID_SETE, 	//r
+	erw_INSTRUCTIONID_SETG, 	//r
+	erw_INSTRUCTIONID_SETL, 	//r
+
+	//Superinstructions, made by erw_peephole_optimize. Fused compares set the
+	//flags just like CMP and UCMP.
+	erw_INSTRUCTIONID_CMPJNE, 	//r r t
+	erw_INSTRUCTIONID_CMPJGE, 	//r r t
+	erw_INSTRUCTIONID_CMPJLE, 	//r r t
+	erw_INSTRUCTIONID_CMPJE, 	//r r t
+	erw_INSTRUCTIONID_CMPJG, 	//r r t
+	erw_INSTRUCTIONID_CMPJL, 	//r r t
+	erw_INSTRUCTIONID_UCMPJNE, 	//r r t
+	erw_INSTRUCTIONID_UCMPJGE, 	//r r t
+	erw_INSTRUCTIONID_UCMPJLE, 	//r r t
+	erw_INSTRUCTIONID_UCMPJE, 	//r r t
+	erw_INSTRUCTIONID_UCMPJG, 	//r r t
+	erw_INSTRUCTIONID_UCMPJL, 	//r r t
+	erw_INSTRUCTIONID_ADDI, 	//r r imm32, sign extended
+	erw_INSTRUCTIONID_PUSHN, 	//imm8, pushes r0 up to (not including) r[imm8]
+	erw_INSTRUCTIONID_POPN, 	//imm8, undoes PUSHN
+
+	erw_INSTRUCTIONID_HALT,
+	erw_INSTRUCTIONID_COUNT,
+};
+
+struct erw_InstructionInfo
+{
+	const char* name;
+	//One character per operand: 'r' register, 's' slot, 't' jump target, 
+	//'b', 'h', 'w', 'q' for 8, 16, 32 and 64 bit immediates and 'i' for a 
+	//signed 32 bit immediate
+	const char* operands;
+	size_t size; //In bytes, including the opcode
 };
 
-struct erw_Register
+extern const struct erw_InstructionInfo erw_instructioninfos[];
+
+//Size in bytes of an operand in erw_InstructionInfo.operands
+size_t erw_operandsize(char operand);
+
+union erw_Register
+{
+	int64_t int_;
+	uint64_t uint;
+	double float_;
+	union erw_Register* frame; //Saved frame pointers on the stack
+};
+
+#define erw_STACK_SEGMENTSIZE (64 * 1024) //In slots, unless frames are larger
+
+//The stack grows a segment at a time. Frames never straddle segments, a call
+//that doesn't fit starts the next one. Segments are kept once allocated, so
+//returning and calling again reuses them.
+struct erw_StackSegment
 {
-	char buffer[8];
+	struct erw_StackSegment* prev;
+	struct erw_StackSegment* next;
+	union erw_Register slots[];
 };
 
-struct erw_Interpreter;
-typedef void(*erw_InstructionRunner)(struct erw_Interpreter*);
+struct erw_BytecodeImage;
+struct erw_Profile;
+struct erw_Tier;
+struct erw_Jit;
 
+//Calling convention: arguments are passed in r0, r1, ... and the return 
+//value in r0. Registers are shared by all frames, so the caller saves the 
+//ones it needs with PUSH/POP. CALL pushes the return address and the frame 
+//pointer, slots are indexed from the new frame pointer.
 struct erw_Interpreter
 {
-	struct erw_Register registers[erw_NUMREGISTERS];
-	erw_InstructionRunner runners[erw_NUMINSTRUCTIONS];
-	uint8_t* instructions;
-	char* stack;
+	union erw_Register registers[erw_NUMREGISTERS];
+	const uint8_t* instructions;
+	struct erw_StackSegment* segment; //The one sp is in
+	union erw_Register* stacklimit; //Calls above it start the next segment
 
-	size_t numinstructions;
-	size_t stacksize;
+	size_t maxframesize; //In slots, see erw_verifier.h
+	size_t numinstructions; //Size of the instruction stream in bytes
+	size_t segmentsize; //In slots
+	size_t stacksize; //Of all segments, in slots
+	size_t maxstacksize; //In slots
 	size_t ip;
-	size_t sp;
+	union erw_Register* sp;
+	union erw_Register* fp;
+	int flags; //Result of the last compare, see erw_interpreter.c
+	struct erw_Profile* profile; //NULL unless profiling, see erw_profile.h
+	struct erw_Tier* tier; //NULL unless tiering, see erw_tier.h
+	struct erw_Jit* jit; //NULL unless compiling, see erw_jit.h
 };
 
+//maxstacksize only bounds runaway recursion, segments are allocated as the
+//stack grows
+//NOTE: The image has to outlive the interpreter
 struct erw_Interpreter* erw_interpreter_ctor(
 	struct erw_Interpreter* self, 
-	uint8_t* instructions,
-	size_t numinstructions,
-	size_t stacksize
+	struct erw_BytecodeImage* image,
+	size_t maxstacksize
 );
 
+//Calls the function at offset entry and runs until it returns or HALT is 
+//reached. The return value is left in r0.
+void erw_interpreter_call(struct erw_Interpreter* self, size_t entry);
 void erw_interpreter_dtor(struct erw_Interpreter* self);
 
 #endif
@@ -0,0 +1,463 @@
+/*
+	Copyright (C) 2017 Erik Wallström
+
+	This file is part of Erwall.
+
+	Erwall is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Erwall is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Erwall.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "erw_ir.h"
+#include "log.h"
+#include <stdlib.h>
+#include <string.h>
+
+static int erw_funcoffset_compare(const void* a, const void* b)
+{
+	const uint64_t* offset = a;
+	const struct erw_BytecodeFunc* func = b;
+	return (*offset > func->offset) - (*offset < func->offset);
+}
+
+Vec(struct erw_IRInstruction) erw_ir_decode(struct erw_Bytecode* bytecode)
+{
+	log_assert(bytecode, "is NULL");
+
+	Vec(struct erw_IRInstruction) ret = vec_ctor(
+		struct erw_IRInstruction,
+		vec_getsize(bytecode->instructions) / 3
+	);
+
+	size_t pos = 0;
+	while(pos < vec_getsize(bytecode->instructions))
+	{
+		struct erw_IRInstruction instruction = {
+			.id = bytecode->instructions[pos],
+			.offset = pos
+		};
+
+		const struct erw_InstructionInfo* info =
+			&erw_instructioninfos[instruction.id];
+		const uint8_t* operand = bytecode->instructions + pos + 1;
+		for(size_t i = 0; info->operands[i]; i++)
+		{
+			size_t size = erw_operandsize(info->operands[i]);
+			for(size_t j = 0; j < size; j++)
+			{
+				instruction.operands[i] |= (uint64_t)operand[j] << (j * 8);
+			}
+
+			operand += size;
+		}
+
+		if(instruction.id == erw_INSTRUCTIONID_CALL)
+		{
+			//Functions are in the order they were emitted
+			struct erw_BytecodeFunc* func = bsearch(
+				&instruction.operands[0],
+				bytecode->functions,
+				vec_getsize(bytecode->functions),
+				sizeof(struct erw_BytecodeFunc),
+				erw_funcoffset_compare
+			);
+			if(!func)
+			{
+				log_error("Call to a non-function <%s>", __func__);
+			}
+			else
+			{
+				instruction.numargs = func->numparams;
+			}
+		}
+
+		vec_pushback(ret, instruction);
+		pos += info->size;
+	}
+
+	for(size_t i = 0; i < vec_getsize(ret); i++)
+	{
+		const char* operands = erw_instructioninfos[ret[i].id].operands;
+		for(size_t j = 0; operands[j]; j++)
+		{
+			if(operands[j] == 't')
+			{
+				ret[erw_ir_find(ret, ret[i].operands[j])].istarget = 1;
+			}
+		}
+	}
+
+	for(size_t i = 0; i < vec_getsize(bytecode->functions); i++)
+	{
+		ret[erw_ir_find(ret, bytecode->functions[i].offset)].istarget = 1;
+	}
+
+	return ret;
+}
+
+static void erw_ir_encodeinstruction(
+	Vec(uint8_t)* data,
+	const struct erw_IRInstruction* instruction)
+{
+	const struct erw_InstructionInfo* info =
+		&erw_instructioninfos[instruction->id];
+	vec_pushback(*data, instruction->id);
+	for(size_t i = 0; info->operands[i]; i++)
+	{
+		size_t size = erw_operandsize(info->operands[i]);
+		for(size_t j = 0; j < size; j++)
+		{
+			vec_pushback(*data, instruction->operands[i] >> (j * 8));
+		}
+	}
+}
+
+void erw_ir_encode(
+	struct erw_Bytecode* bytecode,
+	Vec(struct erw_IRInstruction) decoded,
+	Vec(struct erw_IRInstruction) instructions)
+{
+	log_assert(bytecode, "is NULL");
+	log_assert(decoded, "is NULL");
+	log_assert(instructions, "is NULL");
+
+	//offsets[i] is where decoded instruction i ends up
+	size_t numdecoded = vec_getsize(decoded);
+	Vec(size_t) offsets = vec_ctor(size_t, numdecoded + 1);
+	vec_expand(offsets, 0, numdecoded + 1);
+	size_t next = 0;
+	size_t offset = 0;
+	for(size_t i = 0; i < vec_getsize(instructions); i++)
+	{
+		if(instructions[i].isremoved)
+		{
+			continue;
+		}
+
+		if(instructions[i].offset != erw_IR_INSERTED)
+		{
+			size_t index = erw_ir_find(decoded, instructions[i].offset);
+			log_assert(index >= next, "instructions out of order");
+			while(next <= index)
+			{
+				offsets[next++] = offset;
+			}
+		}
+
+		offset += erw_instructioninfos[instructions[i].id].size;
+	}
+
+	while(next <= numdecoded)
+	{
+		offsets[next++] = offset;
+	}
+
+	Vec(uint8_t) data = vec_ctor(uint8_t, offset);
+	for(size_t i = 0; i < vec_getsize(instructions); i++)
+	{
+		if(instructions[i].isremoved)
+		{
+			continue;
+		}
+
+		struct erw_IRInstruction instruction = instructions[i];
+		const char* operands = erw_instructioninfos[instruction.id].operands;
+		for(size_t j = 0; operands[j]; j++)
+		{
+			if(operands[j] == 't')
+			{
+				instruction.operands[j] = offsets[
+					erw_ir_find(decoded, instruction.operands[j])
+				];
+			}
+		}
+
+		erw_ir_encodeinstruction(&data, &instruction);
+	}
+
+	for(size_t i = 0; i < vec_getsize(bytecode->functions); i++)
+	{
+		bytecode->functions[i].offset = offsets[
+			erw_ir_find(decoded, bytecode->functions[i].offset)
+		];
+	}
+
+	bytecode->entry = offsets[erw_ir_find(decoded, bytecode->entry)];
+
+	//A position whose instructions were all removed is replaced by the next
+	size_t numpositions = vec_getsize(bytecode->positions);
+	size_t numkept = 0;
+	for(size_t i = 0; i < numpositions; i++)
+	{
+		struct erw_BytecodePosition position = bytecode->positions[i];
+		position.offset = offsets[erw_ir_find(decoded, position.offset)];
+		if(numkept
+			&& bytecode->positions[numkept - 1].offset == position.offset)
+		{
+			numkept--;
+		}
+
+		if(position.offset < offset)
+		{
+			bytecode->positions[numkept++] = position;
+		}
+	}
+
+	vec_collapse(bytecode->positions, numkept, numpositions - numkept);
+
+	vec_dtor(bytecode->instructions);
+	bytecode->instructions = data;
+	vec_dtor(offsets);
+}
+
+size_t erw_ir_search(
+	Vec(struct erw_IRInstruction) instructions,
+	size_t offset)
+{
+	log_assert(instructions, "is NULL");
+	size_t first = 0;
+	size_t count = vec_getsize(instructions);
+	while(count)
+	{
+		size_t half = count / 2;
+		if(instructions[first + half].offset < offset)
+		{
+			first += half + 1;
+			count -= half + 1;
+		}
+		else
+		{
+			count = half;
+		}
+	}
+
+	return first < vec_getsize(instructions)
+			&& instructions[first].offset == offset
+		? first
+		: SIZE_MAX;
+}
+
+size_t erw_ir_find(Vec(struct erw_IRInstruction) decoded, size_t offset)
+{
+	size_t ret = erw_ir_search(decoded, offset);
+	log_assert(ret != SIZE_MAX, "no instruction at %zu", offset);
+	return ret;
+}
+
+int erw_ir_isbranch(enum erw_InstructionID id)
+{
+	return id != erw_INSTRUCTIONID_CALL
+		&& strchr(erw_instructioninfos[id].operands, 't') != NULL;
+}
+
+//If the first operand of the instruction is a register it writes
+static int erw_ir_writesfirst(enum erw_InstructionID id)
+{
+	return erw_instructioninfos[id].operands[0] == 'r'
+		&& id != erw_INSTRUCTIONID_PUSH
+		&& id != erw_INSTRUCTIONID_CMP
+		&& id != erw_INSTRUCTIONID_UCMP
+		&& id != erw_INSTRUCTIONID_FCMP
+		&& id != erw_INSTRUCTIONID_JZ
+		&& id != erw_INSTRUCTIONID_JNZ
+		&& !(id >= erw_INSTRUCTIONID_CMPJNE && id <= erw_INSTRUCTIONID_UCMPJL);
+}
+
+int erw_ir_isread(const struct erw_IRInstruction* instruction, size_t operand)
+{
+	log_assert(instruction, "is NULL");
+	const char* operands = erw_instructioninfos[instruction->id].operands;
+	return operand < strlen(operands)
+		&& operands[operand] == 'r'
+		&& (operand || !erw_ir_writesfirst(instruction->id));
+}
+
+int erw_ir_iswritten(
+	const struct erw_IRInstruction* instruction,
+	size_t operand)
+{
+	log_assert(instruction, "is NULL");
+	return !operand && erw_ir_writesfirst(instruction->id);
+}
+
+void erw_ir_registerusedef(
+	const struct erw_IRInstruction* instruction,
+	uint64_t* use,
+	uint64_t* def,
+	void* udata)
+{
+	log_assert(instruction, "is NULL");
+	log_assert(use, "is NULL");
+	log_assert(def, "is NULL");
+	(void)udata;
+
+	enum erw_InstructionID id = instruction->id;
+	if(instruction->isremoved)
+	{
+		return;
+	}
+	else if(id == erw_INSTRUCTIONID_RET || id == erw_INSTRUCTIONID_HALT)
+	{
+		erw_ir_set(use, 0); //The return value
+	}
+	else if(id == erw_INSTRUCTIONID_PUSHN || id == erw_INSTRUCTIONID_POPN)
+	{
+		for(size_t i = 0; i < instruction->operands[0]; i++)
+		{
+			erw_ir_set(id == erw_INSTRUCTIONID_PUSHN ? use : def, i);
+		}
+	}
+	else if(id == erw_INSTRUCTIONID_CALL)
+	{
+		//The callee may overwrite any register, so the caller saves the ones
+		//it still needs
+		for(size_t i = 0; i < erw_NUMREGISTERS; i++)
+		{
+			erw_ir_set(i < instruction->numargs ? use : def, i);
+		}
+	}
+	else
+	{
+		const char* operands = erw_instructioninfos[id].operands;
+		for(size_t i = 0; operands[i]; i++)
+		{
+			if(erw_ir_isread(instruction, i))
+			{
+				erw_ir_set(use, instruction->operands[i]);
+			}
+			else if(erw_ir_iswritten(instruction, i))
+			{
+				erw_ir_set(def, instruction->operands[i]);
+			}
+		}
+	}
+}
+
+int erw_ir_reads(const struct erw_IRInstruction* instruction, size_t reg)
+{
+	log_assert(reg < erw_NUMREGISTERS, "invalid register (%zu)", reg);
+	uint64_t use[erw_IR_REGISTERWORDS] = {0};
+	uint64_t def[erw_IR_REGISTERWORDS] = {0};
+	erw_ir_registerusedef(instruction, use, def, NULL);
+	return erw_ir_isset(use, reg);
+}
+
+int erw_ir_writes(const struct erw_IRInstruction* instruction, size_t reg)
+{
+	log_assert(reg < erw_NUMREGISTERS, "invalid register (%zu)", reg);
+	uint64_t use[erw_IR_REGISTERWORDS] = {0};
+	uint64_t def[erw_IR_REGISTERWORDS] = {0};
+	erw_ir_registerusedef(instruction, use, def, NULL);
+	return erw_ir_isset(def, reg);
+}
+
+Vec(uint64_t) erw_ir_liveness(
+	Vec(struct erw_IRInstruction) decoded,
+	size_t begin,
+	size_t end,
+	size_t numwords,
+	erw_IRUseDef usedef,
+	void* udata)
+{
+	log_assert(decoded, "is NULL");
+	log_assert(begin <= end && end <= vec_getsize(decoded), "invalid range");
+	log_assert(usedef, "is NULL");
+
+	//Rows of numwords words, one per instruction
+	size_t count = end - begin;
+	Vec(uint64_t) ret = vec_ctor(uint64_t, count * numwords);
+	Vec(uint64_t) in = vec_ctor(uint64_t, count * numwords);
+	Vec(uint64_t) use = vec_ctor(uint64_t, count * numwords);
+	Vec(uint64_t) def = vec_ctor(uint64_t, count * numwords);
+	vec_expand(ret, 0, count * numwords);
+	vec_expand(in, 0, count * numwords);
+	vec_expand(use, 0, count * numwords);
+	vec_expand(def, 0, count * numwords);
+	memset(ret, 0, count * numwords * sizeof(uint64_t));
+	memset(in, 0, count * numwords * sizeof(uint64_t));
+	memset(use, 0, count * numwords * sizeof(uint64_t));
+	memset(def, 0, count * numwords * sizeof(uint64_t));
+
+	//SIZE_MAX if the instruction doesn't have that successor
+	Vec(size_t) next = vec_ctor(size_t, count);
+	Vec(size_t) target = vec_ctor(size_t, count);
+	vec_expand(next, 0, count);
+	vec_expand(target, 0, count);
+	for(size_t i = 0; i < count; i++)
+	{
+		const struct erw_IRInstruction* instruction = &decoded[begin + i];
+		usedef(instruction, use + i * numwords, def + i * numwords, udata);
+
+		enum erw_InstructionID id = instruction->id;
+		next[i] = i + 1 < count
+			&& id != erw_INSTRUCTIONID_JMP
+			&& id != erw_INSTRUCTIONID_RET
+			&& id != erw_INSTRUCTIONID_HALT
+			? i + 1
+			: SIZE_MAX;
+		target[i] = SIZE_MAX;
+		if(erw_ir_isbranch(id) && !instruction->isremoved)
+		{
+			//The target is the last operand of every jump
+			size_t numoperands = strlen(erw_instructioninfos[id].operands);
+			size_t index = erw_ir_find(
+				decoded,
+				instruction->operands[numoperands - 1]
+			);
+			log_assert(
+				index >= begin && index < end,
+				"jump out of range (%zu)",
+				index
+			);
+			target[i] = index - begin;
+		}
+	}
+
+	//Iterating backwards converges in a couple of passes per loop level
+	int changed = 1;
+	while(changed)
+	{
+		changed = 0;
+		for(size_t i = count; i-- > 0;)
+		{
+			uint64_t* out = ret + i * numwords;
+			for(size_t j = 0; j < numwords; j++)
+			{
+				uint64_t word = 0;
+				if(next[i] != SIZE_MAX)
+				{
+					word |= in[next[i] * numwords + j];
+				}
+
+				if(target[i] != SIZE_MAX)
+				{
+					word |= in[target[i] * numwords + j];
+				}
+
+				out[j] = word;
+				word = use[i * numwords + j] | (word & ~def[i * numwords + j]);
+				if(word != in[i * numwords + j])
+				{
+					in[i * numwords + j] = word;
+					changed = 1;
+				}
+			}
+		}
+	}
+
+	vec_dtor(target);
+	vec_dtor(next);
+	vec_dtor(def);
+	vec_dtor(use);
+	vec_dtor(in);
+	return ret;
+}
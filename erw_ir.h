@@ -0,0 +1,102 @@
+/*
+	Copyright (C) 2017 Erik Wallström
+
+	This file is part of Erwall.
+
+	Erwall is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Erwall is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Erwall.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ERW_IR_H
+#define ERW_IR_H
+
+#include "erw_bytecode.h"
+
+//Decoded instructions that the bytecode passes work on. Operands keep their
+//encoded meaning, jump and call targets are offsets into the decoded stream.
+#define erw_IR_MAXOPERANDS 3
+#define erw_IR_INSERTED SIZE_MAX //Offset of instructions added by a pass
+#define erw_IR_REGISTERWORDS ((erw_NUMREGISTERS + 63) / 64)
+
+struct erw_IRInstruction
+{
+	enum erw_InstructionID id;
+	uint64_t operands[erw_IR_MAXOPERANDS];
+	size_t offset; //In the decoded stream
+	int istarget; //If something jumps or calls here
+	int isremoved; //Skipped by erw_ir_encode
+	size_t numargs; //Parameters of the called function, for CALL
+};
+
+//Sets the bits of the variables an instruction reads (use) and writes (def)
+typedef void (*erw_IRUseDef)(
+	const struct erw_IRInstruction* instruction,
+	uint64_t* use,
+	uint64_t* def,
+	void* udata
+);
+
+Vec(struct erw_IRInstruction) erw_ir_decode(struct erw_Bytecode* bytecode);
+//Replaces the instructions of bytecode, which have to be in the order of
+//decoded. Jumps to an instruction go to the first one with its offset, or to
+//the next kept instruction if it was removed. Inserted instructions are only
+//reached by falling through.
+void erw_ir_encode(
+	struct erw_Bytecode* bytecode,
+	Vec(struct erw_IRInstruction) decoded,
+	Vec(struct erw_IRInstruction) instructions
+);
+//Index of the first instruction at offset, or SIZE_MAX if no instruction 
+//starts there. The instructions have to be sorted by offset.
+size_t erw_ir_search(
+	Vec(struct erw_IRInstruction) instructions,
+	size_t offset
+);
+//Like erw_ir_search, but an instruction has to start at offset
+size_t erw_ir_find(Vec(struct erw_IRInstruction) decoded, size_t offset);
+
+int erw_ir_isbranch(enum erw_InstructionID id); //Jumps, not calls
+//If a register operand is read or written. Instructions may also use
+//registers implicitly, see erw_ir_registerusedef.
+int erw_ir_isread(const struct erw_IRInstruction* instruction, size_t operand);
+int erw_ir_iswritten(
+	const struct erw_IRInstruction* instruction,
+	size_t operand
+);
+void erw_ir_registerusedef(
+	const struct erw_IRInstruction* instruction,
+	uint64_t* use,
+	uint64_t* def,
+	void* udata
+);
+int erw_ir_reads(const struct erw_IRInstruction* instruction, size_t reg);
+int erw_ir_writes(const struct erw_IRInstruction* instruction, size_t reg);
+
+//Backwards dataflow over the decoded instructions [begin, end), which must
+//not jump outside the range. Returns numwords words per instruction with the
+//variables that are live after it.
+Vec(uint64_t) erw_ir_liveness(
+	Vec(struct erw_IRInstruction) decoded,
+	size_t begin,
+	size_t end,
+	size_t numwords,
+	erw_IRUseDef usedef,
+	void* udata
+);
+
+#define erw_ir_isset(bits, i) \
+	(((bits)[(i) / 64] >> ((i) % 64)) & 1)
+#define erw_ir_set(bits, i) \
+	((bits)[(i) / 64] |= (uint64_t)1 << ((i) % 64))
+
+#endif
@@ -0,0 +1,1159 @@
+/*
+	Copyright (C) 2017 Erik Wallström
+
+	This file is part of Erwall.
+
+	Erwall is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Erwall is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Erwall.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#define _GNU_SOURCE //memfd_create
+#include "erw_jit.h"
+#include "erw_ir.h"
+#include "log.h"
+#include <errno.h>
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define erw_JIT_CHUNKSIZE (1024 * 1024)
+//rbx points this many registers into the register file, so that the first 32
+//registers are reached with a disp8
+#define erw_JIT_REGISTERBIAS 16
+
+//JIT code keeps the interpreter state in callee saved registers: rbx points
+//into the registers, rbp holds the flags, r13 and r14 point to the top of the
+//stack and the frame and r15 to the erw_JitState
+enum erw_JitRegister
+{
+	erw_JITREGISTER_RAX,
+	erw_JITREGISTER_RCX,
+	erw_JITREGISTER_RDX,
+	erw_JITREGISTER_RBX,
+	erw_JITREGISTER_RSP,
+	erw_JITREGISTER_RBP,
+	erw_JITREGISTER_RSI,
+	erw_JITREGISTER_RDI,
+	erw_JITREGISTER_R13 = 13,
+	erw_JITREGISTER_R14,
+	erw_JITREGISTER_R15,
+};
+
+//Condition codes of jcc, setcc and cmovcc
+enum erw_JitCondition
+{
+	erw_JITCONDITION_ALWAYS = -1, //jmp
+	erw_JITCONDITION_B = 0x2,
+	erw_JITCONDITION_AE = 0x3,
+	erw_JITCONDITION_E = 0x4,
+	erw_JITCONDITION_NE = 0x5,
+	erw_JITCONDITION_BE = 0x6,
+	erw_JITCONDITION_A = 0x7,
+	erw_JITCONDITION_P = 0xA,
+	erw_JITCONDITION_L = 0xC,
+	erw_JITCONDITION_G = 0xF,
+};
+
+//Tests of erw_Interpreter.flags, which is kept in ebp
+enum erw_JitFlagsTest
+{
+	erw_JITFLAGSTEST_NE,
+	erw_JITFLAGSTEST_GE,
+	erw_JITFLAGSTEST_LE,
+	erw_JITFLAGSTEST_E,
+	erw_JITFLAGSTEST_G,
+	erw_JITFLAGSTEST_L,
+	erw_JITFLAGSTEST_NOTLESS,
+	erw_JITFLAGSTEST_NOTGREATER,
+};
+
+enum erw_JitFixupType
+{
+	erw_JITFIXUPTYPE_JUMP, //To an instruction in the function
+	erw_JITFIXUPTYPE_FALLBACK, //To the interpreter, at an instruction
+	erw_JITFIXUPTYPE_EXIT, //To the interpreter, at the offset in rax
+};
+
+struct erw_JitFixup
+{
+	enum erw_JitFixupType type;
+	size_t pos; //Of the rel32
+	size_t target; //Offset into the instruction stream
+};
+
+struct erw_JitCompiler
+{
+	//Emitted a few bytes at a time, so it grows geometrically unlike a Vec
+	uint8_t* code;
+	size_t size;
+	size_t capacity;
+	Vec(struct erw_JitFixup) fixups;
+};
+
+static void erw_jitcompiler_ctor(
+	struct erw_JitCompiler* self,
+	size_t capacity,
+	size_t numfixups)
+{
+	self->code = malloc(capacity);
+	if(!self->code)
+	{
+		log_error("malloc failed, in <%s>", __func__);
+	}
+
+	self->size = 0;
+	self->capacity = capacity;
+	self->fixups = vec_ctor(struct erw_JitFixup, numfixups);
+}
+
+static void erw_jitcompiler_dtor(struct erw_JitCompiler* self)
+{
+	vec_dtor(self->fixups);
+	free(self->code);
+}
+
+static void erw_jit_emit(
+	struct erw_JitCompiler* compiler,
+	const uint8_t* bytes,
+	size_t numbytes)
+{
+	if(compiler->size + numbytes > compiler->capacity)
+	{
+		compiler->capacity = compiler->capacity * 2 + numbytes;
+		compiler->code = realloc(compiler->code, compiler->capacity);
+		if(!compiler->code)
+		{
+			log_error("realloc failed, in <%s>", __func__);
+		}
+	}
+
+	memcpy(compiler->code + compiler->size, bytes, numbytes);
+	compiler->size += numbytes;
+}
+
+#define erw_JIT_EMIT(compiler, ...) \
+	erw_jit_emit( \
+		compiler, \
+		(const uint8_t[]){__VA_ARGS__}, \
+		sizeof((const uint8_t[]){__VA_ARGS__}) \
+	)
+
+static void erw_jit_emit32(struct erw_JitCompiler* compiler, uint32_t value)
+{
+	erw_JIT_EMIT(compiler, value, value >> 8, value >> 16, value >> 24);
+}
+
+//Emits [prefix] [REX] opcode modrm [sib] [disp] with the memory operand
+//[base + disp]. opcode is one byte or two starting with 0F.
+static void erw_jit_mem(
+	struct erw_JitCompiler* compiler,
+	uint8_t prefix,
+	int iswide,
+	uint16_t opcode,
+	enum erw_JitRegister reg,
+	enum erw_JitRegister base,
+	int32_t disp)
+{
+	if(prefix)
+	{
+		erw_JIT_EMIT(compiler, prefix);
+	}
+
+	uint8_t rex = 0x40 | iswide << 3 | (reg >> 3) << 2 | base >> 3;
+	if(rex != 0x40)
+	{
+		erw_JIT_EMIT(compiler, rex);
+	}
+
+	if(opcode > 0xFF)
+	{
+		erw_JIT_EMIT(compiler, opcode >> 8);
+	}
+
+	//No displacement, disp8 or disp32. [rbp] and [r13] always need one.
+	uint8_t mod = !disp && (base & 7) != erw_JITREGISTER_RBP ? 0x00
+		: disp >= INT8_MIN && disp <= INT8_MAX ? 0x40
+		: 0x80;
+	erw_JIT_EMIT(compiler, opcode, mod | (reg & 7) << 3 | (base & 7));
+	if((base & 7) == erw_JITREGISTER_RSP)
+	{
+		erw_JIT_EMIT(compiler, 0x24);
+	}
+
+	if(mod == 0x40)
+	{
+		erw_JIT_EMIT(compiler, disp);
+	}
+	else if(mod == 0x80)
+	{
+		erw_jit_emit32(compiler, disp);
+	}
+}
+
+//Memory operand of a VM register
+static void erw_jit_vmreg(
+	struct erw_JitCompiler* compiler,
+	uint8_t prefix,
+	int iswide,
+	uint16_t opcode,
+	enum erw_JitRegister reg,
+	uint64_t vmreg)
+{
+	erw_jit_mem(
+		compiler,
+		prefix,
+		iswide,
+		opcode,
+		reg,
+		erw_JITREGISTER_RBX,
+		((int32_t)vmreg - erw_JIT_REGISTERBIAS)
+			* (int32_t)sizeof(union erw_Register)
+	);
+}
+
+static void erw_jit_branch(
+	struct erw_JitCompiler* compiler,
+	enum erw_JitCondition condition,
+	enum erw_JitFixupType type,
+	size_t target)
+{
+	if(condition == erw_JITCONDITION_ALWAYS)
+	{
+		erw_JIT_EMIT(compiler, 0xE9);
+	}
+	else
+	{
+		erw_JIT_EMIT(compiler, 0x0F, 0x80 + condition);
+	}
+
+	struct erw_JitFixup fixup = {
+		.type = type,
+		.pos = compiler->size,
+		.target = target
+	};
+	vec_pushback(compiler->fixups, fixup);
+	erw_jit_emit32(compiler, 0);
+}
+
+static void erw_jit_patch(
+	struct erw_JitCompiler* compiler,
+	size_t pos,
+	size_t target)
+{
+	uint32_t rel = target - (pos + 4);
+	memcpy(compiler->code + pos, &rel, sizeof(rel));
+}
+
+//Sets ebp from the x86 flags of a compare, less and greater are the
+//condition codes that mean the first operand was smaller or larger
+static void erw_jit_setflags(
+	struct erw_JitCompiler* compiler,
+	enum erw_JitCondition less,
+	enum erw_JitCondition greater)
+{
+	erw_JIT_EMIT(
+		compiler,
+		0x0F, 0x90 + greater, 0xC0, //setcc al
+		0x0F, 0x90 + less, 0xC1, //setcc cl
+		0x28, 0xC8, //sub al, cl
+		0x0F, 0xBE, 0xE8 //movsx ebp, al
+	);
+}
+
+//Emits a test of ebp and returns the condition code that is set if it holds
+static enum erw_JitCondition erw_jit_testflags(
+	struct erw_JitCompiler* compiler,
+	enum erw_JitFlagsTest test)
+{
+	switch(test)
+	{
+	case erw_JITFLAGSTEST_NE:
+		erw_JIT_EMIT(compiler, 0x85, 0xED); //test ebp, ebp
+		return erw_JITCONDITION_NE;
+	case erw_JITFLAGSTEST_GE:
+		erw_JIT_EMIT(compiler, 0x83, 0xFD, 0x01); //cmp ebp, 1
+		return erw_JITCONDITION_BE; //0 or 1 as unsigned
+	case erw_JITFLAGSTEST_LE:
+		erw_JIT_EMIT(
+			compiler,
+			0x8D, 0x4D, 0x01, //lea ecx, [rbp + 1]
+			0x83, 0xF9, 0x01 //cmp ecx, 1
+		);
+		return erw_JITCONDITION_BE; //-1 or 0
+	case erw_JITFLAGSTEST_E:
+		erw_JIT_EMIT(compiler, 0x85, 0xED);
+		return erw_JITCONDITION_E;
+	case erw_JITFLAGSTEST_G:
+		erw_JIT_EMIT(compiler, 0x83, 0xFD, 0x01);
+		return erw_JITCONDITION_E;
+	case erw_JITFLAGSTEST_L:
+		erw_JIT_EMIT(compiler, 0x83, 0xFD, 0xFF); //cmp ebp, -1
+		return erw_JITCONDITION_E;
+	case erw_JITFLAGSTEST_NOTLESS:
+		erw_JIT_EMIT(compiler, 0x83, 0xFD, 0xFF);
+		return erw_JITCONDITION_NE;
+	case erw_JITFLAGSTEST_NOTGREATER:
+		erw_JIT_EMIT(compiler, 0x83, 0xFD, 0x01);
+		return erw_JITCONDITION_NE;
+	}
+
+	log_assert(0, "invalid test (%i)", test);
+	return erw_JITCONDITION_ALWAYS;
+}
+
+//Continues at the offset in rax: in its JIT code if there is any, otherwise
+//in the interpreter
+static void erw_jit_dispatch(struct erw_JitCompiler* compiler)
+{
+	erw_jit_mem(
+		compiler,
+		0,
+		1,
+		0x8B,
+		erw_JITREGISTER_RCX,
+		erw_JITREGISTER_R15,
+		offsetof(struct erw_JitState, entries)
+	);
+	erw_JIT_EMIT(
+		compiler,
+		0x48, 0x8B, 0x0C, 0xC1, //mov rcx, [rcx + rax * 8]
+		0x48, 0x85, 0xC9 //test rcx, rcx
+	);
+	erw_jit_branch(compiler, erw_JITCONDITION_E, erw_JITFIXUPTYPE_EXIT, 0);
+	erw_JIT_EMIT(compiler, 0xFF, 0xE1); //jmp rcx
+}
+
+//Falls back to the interpreter if a call could overflow the stack
+static void erw_jit_checkstack(struct erw_JitCompiler* compiler, size_t offset)
+{
+	erw_jit_mem(
+		compiler,
+		0,
+		1,
+		0x3B,
+		erw_JITREGISTER_R13,
+		erw_JITREGISTER_R15,
+		offsetof(struct erw_JitState, stacklimit)
+	); //cmp r13, [r15 + stacklimit]
+	erw_jit_branch(
+		compiler,
+		erw_JITCONDITION_A,
+		erw_JITFIXUPTYPE_FALLBACK,
+		offset
+	);
+}
+
+static void erw_jit_instruction(
+	struct erw_JitCompiler* compiler,
+	const struct erw_IRInstruction* instruction)
+{
+	static const enum erw_JitFlagsTest jumptests[] = {
+		erw_JITFLAGSTEST_NE,
+		erw_JITFLAGSTEST_GE,
+		erw_JITFLAGSTEST_LE,
+		erw_JITFLAGSTEST_E,
+		erw_JITFLAGSTEST_G,
+		erw_JITFLAGSTEST_L,
+	};
+	static const enum erw_JitFlagsTest cmpjumptests[] = {
+		erw_JITFLAGSTEST_NE,
+		erw_JITFLAGSTEST_NOTLESS,
+		erw_JITFLAGSTEST_NOTGREATER,
+		erw_JITFLAGSTEST_E,
+		erw_JITFLAGSTEST_G,
+		erw_JITFLAGSTEST_L,
+	};
+	static const uint8_t sseops[] = {
+		[erw_INSTRUCTIONID_FADD - erw_INSTRUCTIONID_FADD] = 0x58,
+		[erw_INSTRUCTIONID_FSUB - erw_INSTRUCTIONID_FADD] = 0x5C,
+		[erw_INSTRUCTIONID_FMUL - erw_INSTRUCTIONID_FADD] = 0x59,
+		[erw_INSTRUCTIONID_FDIV - erw_INSTRUCTIONID_FADD] = 0x5E,
+	};
+
+	const enum erw_JitRegister rax = erw_JITREGISTER_RAX;
+	const enum erw_JitRegister rcx = erw_JITREGISTER_RCX;
+	const enum erw_JitRegister r13 = erw_JITREGISTER_R13;
+	const enum erw_JitRegister r14 = erw_JITREGISTER_R14;
+	const uint64_t* operands = instruction->operands;
+	size_t offset = instruction->offset;
+	enum erw_InstructionID id = instruction->id;
+	switch(id)
+	{
+	case erw_INSTRUCTIONID_LOADL8:
+	case erw_INSTRUCTIONID_LOADL16:
+	case erw_INSTRUCTIONID_LOADL32:
+	case erw_INSTRUCTIONID_LOADL64:
+		if(operands[1] <= INT32_MAX)
+		{
+			erw_jit_vmreg(compiler, 0, 1, 0xC7, 0, operands[0]); //mov [], imm32
+			erw_jit_emit32(compiler, operands[1]);
+			break;
+		}
+
+		erw_JIT_EMIT(compiler, 0x48, 0xB8); //mov rax, imm64
+		erw_jit_emit32(compiler, operands[1]);
+		erw_jit_emit32(compiler, operands[1] >> 32);
+		erw_jit_vmreg(compiler, 0, 1, 0x89, rax, operands[0]);
+		break;
+	case erw_INSTRUCTIONID_ADD:
+	case erw_INSTRUCTIONID_SUB:
+	case erw_INSTRUCTIONID_MUL:
+		erw_jit_vmreg(compiler, 0, 1, 0x8B, rax, operands[1]);
+		erw_jit_vmreg(
+			compiler,
+			0,
+			1,
+			id == erw_INSTRUCTIONID_ADD ? 0x03
+				: id == erw_INSTRUCTIONID_SUB ? 0x2B
+				: 0x0FAF,
+			rax,
+			operands[2]
+		);
+		erw_jit_vmreg(compiler, 0, 1, 0x89, rax, operands[0]);
+		break;
+	case erw_INSTRUCTIONID_ADDI:
+		erw_jit_vmreg(compiler, 0, 1, 0x8B, rax, operands[1]);
+		erw_JIT_EMIT(compiler, 0x48, 0x05); //add rax, imm32
+		erw_jit_emit32(compiler, operands[2]);
+		erw_jit_vmreg(compiler, 0, 1, 0x89, rax, operands[0]);
+		break;
+	case erw_INSTRUCTIONID_DIV:
+	case erw_INSTRUCTIONID_MOD:
+	case erw_INSTRUCTIONID_UDIV:
+	case erw_INSTRUCTIONID_UMOD:
+		{
+			//Division by zero and INT64_MIN / -1 are left to the interpreter
+			int issigned = id == erw_INSTRUCTIONID_DIV
+				|| id == erw_INSTRUCTIONID_MOD;
+			erw_jit_vmreg(compiler, 0, 1, 0x8B, rcx, operands[2]);
+			erw_JIT_EMIT(compiler, 0x48, 0x85, 0xC9); //test rcx, rcx
+			erw_jit_branch(
+				compiler,
+				erw_JITCONDITION_E,
+				erw_JITFIXUPTYPE_FALLBACK,
+				offset
+			);
+			if(issigned)
+			{
+				erw_JIT_EMIT(compiler, 0x48, 0x83, 0xF9, 0xFF); //cmp rcx, -1
+				erw_jit_branch(
+					compiler,
+					erw_JITCONDITION_E,
+					erw_JITFIXUPTYPE_FALLBACK,
+					offset
+				);
+			}
+
+			erw_jit_vmreg(compiler, 0, 1, 0x8B, rax, operands[1]);
+			if(issigned)
+			{
+				erw_JIT_EMIT(compiler, 0x48, 0x99, 0x48, 0xF7, 0xF9); //idiv rcx
+			}
+			else
+			{
+				erw_JIT_EMIT(compiler, 0x31, 0xD2, 0x48, 0xF7, 0xF1); //div rcx
+			}
+
+			int isdiv = id == erw_INSTRUCTIONID_DIV
+				|| id == erw_INSTRUCTIONID_UDIV;
+			erw_jit_vmreg(
+				compiler,
+				0,
+				1,
+				0x89,
+				isdiv ? rax : erw_JITREGISTER_RDX,
+				operands[0]
+			);
+		}
+		break;
+	case erw_INSTRUCTIONID_FADD:
+	case erw_INSTRUCTIONID_FSUB:
+	case erw_INSTRUCTIONID_FMUL:
+	case erw_INSTRUCTIONID_FDIV:
+		erw_jit_vmreg(compiler, 0xF2, 0, 0x0F10, rax, operands[1]); //xmm0
+		erw_jit_vmreg(
+			compiler,
+			0xF2,
+			0,
+			0x0F00 | sseops[id - erw_INSTRUCTIONID_FADD],
+			rax,
+			operands[2]
+		);
+		erw_jit_vmreg(compiler, 0xF2, 0, 0x0F11, rax, operands[0]);
+		break;
+	case erw_INSTRUCTIONID_NEG:
+		erw_jit_vmreg(compiler, 0, 1, 0x8B, rax, operands[1]);
+		erw_JIT_EMIT(compiler, 0x48, 0xF7, 0xD8); //neg rax
+		erw_jit_vmreg(compiler, 0, 1, 0x89, rax, operands[0]);
+		break;
+	case erw_INSTRUCTIONID_FNEG:
+		erw_jit_vmreg(compiler, 0, 1, 0x8B, rax, operands[1]);
+		erw_JIT_EMIT(compiler, 0x48, 0x0F, 0xBA, 0xF8, 0x3F); //btc rax, 63
+		erw_jit_vmreg(compiler, 0, 1, 0x89, rax, operands[0]);
+		break;
+	case erw_INSTRUCTIONID_NOT:
+		erw_JIT_EMIT(compiler, 0x31, 0xC0); //xor eax, eax
+		erw_jit_vmreg(compiler, 0, 1, 0x83, 7, operands[1]); //cmp [], imm8
+		erw_JIT_EMIT(compiler, 0x00, 0x0F, 0x94, 0xC0); //0, sete al
+		erw_jit_vmreg(compiler, 0, 1, 0x89, rax, operands[0]);
+		break;
+	case erw_INSTRUCTIONID_ITOF:
+		erw_jit_vmreg(compiler, 0xF2, 1, 0x0F2A, rax, operands[1]); //cvtsi2sd
+		erw_jit_vmreg(compiler, 0xF2, 0, 0x0F11, rax, operands[0]);
+		break;
+	case erw_INSTRUCTIONID_FTOI:
+		//cvttsd2si gives INT64_MIN for NaN and out of range values too
+		erw_jit_vmreg(compiler, 0xF2, 1, 0x0F2C, rax, operands[1]);
+		erw_jit_vmreg(compiler, 0, 1, 0x89, rax, operands[0]);
+		break;
+	case erw_INSTRUCTIONID_SEXT8:
+	case erw_INSTRUCTIONID_SEXT16:
+	case erw_INSTRUCTIONID_SEXT32:
+	case erw_INSTRUCTIONID_ZEXT8:
+	case erw_INSTRUCTIONID_ZEXT16:
+	case erw_INSTRUCTIONID_ZEXT32:
+	case erw_INSTRUCTIONID_MOV:
+		{
+			//movsx, movsxd, movzx and 32 or 64 bit mov
+			static const uint16_t opcodes[] = {
+				0x0FBE, 0x0FBF, 0x63, 0x0FB6, 0x0FB7, 0x8B, 0x8B
+			};
+			erw_jit_vmreg(
+				compiler,
+				0,
+				id <= erw_INSTRUCTIONID_SEXT32 || id == erw_INSTRUCTIONID_MOV,
+				opcodes[id - erw_INSTRUCTIONID_SEXT8],
+				rax,
+				operands[1]
+			);
+			erw_jit_vmreg(compiler, 0, 1, 0x89, rax, operands[0]);
+		}
+		break;
+	case erw_INSTRUCTIONID_LOAD:
+		erw_jit_mem(compiler, 0, 1, 0x8B, rax, r14, operands[1] * 8);
+		erw_jit_vmreg(compiler, 0, 1, 0x89, rax, operands[0]);
+		break;
+	case erw_INSTRUCTIONID_STORE:
+		erw_jit_vmreg(compiler, 0, 1, 0x8B, rax, operands[1]);
+		erw_jit_mem(compiler, 0, 1, 0x89, rax, r14, operands[0] * 8);
+		break;
+	case erw_INSTRUCTIONID_PUSH:
+		erw_jit_vmreg(compiler, 0, 1, 0x8B, rax, operands[0]);
+		erw_jit_mem(compiler, 0, 1, 0x89, rax, r13, 0);
+		erw_JIT_EMIT(compiler, 0x49, 0x83, 0xC5, 0x08); //add r13, 8
+		break;
+	case erw_INSTRUCTIONID_POP:
+		erw_JIT_EMIT(compiler, 0x49, 0x83, 0xED, 0x08); //sub r13, 8
+		erw_jit_mem(compiler, 0, 1, 0x8B, rax, r13, 0);
+		erw_jit_vmreg(compiler, 0, 1, 0x89, rax, operands[0]);
+		break;
+	case erw_INSTRUCTIONID_PUSHN:
+		erw_jit_vmreg(compiler, 0, 1, 0x8D, erw_JITREGISTER_RSI, 0); //lea
+		erw_JIT_EMIT(
+			compiler,
+			0x4C, 0x89, 0xEF, //mov rdi, r13
+			0xB9 //mov ecx, imm32
+		);
+		erw_jit_emit32(compiler, operands[0]);
+		erw_JIT_EMIT(
+			compiler,
+			0xF3, 0x48, 0xA5, //rep movsq
+			0x49, 0x89, 0xFD //mov r13, rdi
+		);
+		break;
+	case erw_INSTRUCTIONID_POPN:
+		erw_JIT_EMIT(compiler, 0x49, 0x81, 0xED); //sub r13, imm32
+		erw_jit_emit32(compiler, operands[0] * 8);
+		erw_jit_vmreg(compiler, 0, 1, 0x8D, erw_JITREGISTER_RDI, 0); //lea
+		erw_JIT_EMIT(
+			compiler,
+			0x4C, 0x89, 0xEE, //mov rsi, r13
+			0xB9
+		);
+		erw_jit_emit32(compiler, operands[0]);
+		erw_JIT_EMIT(compiler, 0xF3, 0x48, 0xA5);
+		break;
+	case erw_INSTRUCTIONID_ENTER:
+		if(operands[0])
+		{
+			erw_JIT_EMIT(
+				compiler,
+				0x4C, 0x89, 0xEF, //mov rdi, r13
+				0x31, 0xC0, //xor eax, eax
+				0xB9
+			);
+			erw_jit_emit32(compiler, operands[0]);
+			erw_JIT_EMIT(
+				compiler,
+				0xF3, 0x48, 0xAB, //rep stosq
+				0x49, 0x89, 0xFD //mov r13, rdi
+			);
+		}
+		break;
+	case erw_INSTRUCTIONID_CALL:
+		//Pushes the return offset and the frame like the interpreter. Only
+		//calls check the stack (see erw_verifier.h), the interpreter reports
+		//overflows.
+		erw_jit_checkstack(compiler, offset);
+		erw_JIT_EMIT(compiler, 0xB8);
+		erw_jit_emit32(compiler, offset + erw_instructioninfos[id].size);
+		erw_jit_mem(compiler, 0, 1, 0x89, rax, r13, 0);
+		erw_jit_mem(compiler, 0, 1, 0x89, r14, r13, 8);
+		erw_JIT_EMIT(
+			compiler,
+			0x49, 0x83, 0xC5, 0x10, //add r13, 16
+			0x4D, 0x89, 0xEE, //mov r14, r13
+			0xB8
+		);
+		erw_jit_emit32(compiler, operands[0]);
+		erw_jit_dispatch(compiler);
+		break;
+	case erw_INSTRUCTIONID_RET:
+		//Both sentinels of the interpreter, -1 and -2, leave JIT code
+		erw_JIT_EMIT(compiler, 0x4D, 0x89, 0xF5); //mov r13, r14
+		erw_jit_mem(compiler, 0, 1, 0x8B, r14, r13, -8);
+		erw_jit_mem(compiler, 0, 1, 0x8B, rax, r13, -16);
+		erw_JIT_EMIT(
+			compiler,
+			0x49, 0x83, 0xED, 0x10, //sub r13, 16
+			0x48, 0x83, 0xF8, 0xFE //cmp rax, -2
+		);
+		erw_jit_branch(compiler, erw_JITCONDITION_AE, erw_JITFIXUPTYPE_EXIT, 0);
+		erw_jit_dispatch(compiler);
+		break;
+	case erw_INSTRUCTIONID_CMP:
+	case erw_INSTRUCTIONID_UCMP:
+	case erw_INSTRUCTIONID_CMPJNE:
+	case erw_INSTRUCTIONID_CMPJGE:
+	case erw_INSTRUCTIONID_CMPJLE:
+	case erw_INSTRUCTIONID_CMPJE:
+	case erw_INSTRUCTIONID_CMPJG:
+	case erw_INSTRUCTIONID_CMPJL:
+	case erw_INSTRUCTIONID_UCMPJNE:
+	case erw_INSTRUCTIONID_UCMPJGE:
+	case erw_INSTRUCTIONID_UCMPJLE:
+	case erw_INSTRUCTIONID_UCMPJE:
+	case erw_INSTRUCTIONID_UCMPJG:
+	case erw_INSTRUCTIONID_UCMPJL:
+		{
+			int issigned = id == erw_INSTRUCTIONID_CMP
+				|| (id >= erw_INSTRUCTIONID_CMPJNE
+					&& id <= erw_INSTRUCTIONID_CMPJL);
+			erw_jit_vmreg(compiler, 0, 1, 0x8B, rax, operands[0]);
+			erw_jit_vmreg(compiler, 0, 1, 0x3B, rax, operands[1]);
+			erw_jit_setflags(
+				compiler,
+				issigned ? erw_JITCONDITION_L : erw_JITCONDITION_B,
+				issigned ? erw_JITCONDITION_G : erw_JITCONDITION_A
+			);
+			if(id == erw_INSTRUCTIONID_CMP || id == erw_INSTRUCTIONID_UCMP)
+			{
+				break;
+			}
+
+			size_t index = issigned
+				? id - erw_INSTRUCTIONID_CMPJNE
+				: id - erw_INSTRUCTIONID_UCMPJNE;
+			erw_jit_branch(
+				compiler,
+				erw_jit_testflags(compiler, cmpjumptests[index]),
+				erw_JITFIXUPTYPE_JUMP,
+				operands[2]
+			);
+		}
+		break;
+	case erw_INSTRUCTIONID_FCMP:
+		//Unordered sets ZF, PF and CF, it becomes 2 like in the interpreter
+		erw_jit_vmreg(compiler, 0xF2, 0, 0x0F10, rax, operands[0]);
+		erw_jit_vmreg(compiler, 0x66, 0, 0x0F2E, rax, operands[1]); //ucomisd
+		erw_JIT_EMIT(compiler, 0x0F, 0x9A, 0xC2); //setp dl
+		erw_jit_setflags(compiler, erw_JITCONDITION_B, erw_JITCONDITION_A);
+		erw_JIT_EMIT(
+			compiler,
+			0xB8, 0x02, 0x00, 0x00, 0x00, //mov eax, 2
+			0x84, 0xD2, //test dl, dl
+			0x0F, 0x45, 0xE8 //cmovne ebp, eax
+		);
+		break;
+	case erw_INSTRUCTIONID_JMP:
+		erw_jit_branch(
+			compiler,
+			erw_JITCONDITION_ALWAYS,
+			erw_JITFIXUPTYPE_JUMP,
+			operands[0]
+		);
+		break;
+	case erw_INSTRUCTIONID_JNE:
+	case erw_INSTRUCTIONID_JGE:
+	case erw_INSTRUCTIONID_JLE:
+	case erw_INSTRUCTIONID_JE:
+	case erw_INSTRUCTIONID_JG:
+	case erw_INSTRUCTIONID_JL:
+		erw_jit_branch(
+			compiler,
+			erw_jit_testflags(
+				compiler,
+				jumptests[id - erw_INSTRUCTIONID_JNE]
+			),
+			erw_JITFIXUPTYPE_JUMP,
+			operands[0]
+		);
+		break;
+	case erw_INSTRUCTIONID_JZ:
+	case erw_INSTRUCTIONID_JNZ:
+		erw_jit_vmreg(compiler, 0, 1, 0x83, 7, operands[0]); //cmp [], imm8
+		erw_JIT_EMIT(compiler, 0x00);
+		erw_jit_branch(
+			compiler,
+			id == erw_INSTRUCTIONID_JZ
+				? erw_JITCONDITION_E
+				: erw_JITCONDITION_NE,
+			erw_JITFIXUPTYPE_JUMP,
+			operands[1]
+		);
+		break;
+	case erw_INSTRUCTIONID_SETNE:
+	case erw_INSTRUCTIONID_SETGE:
+	case erw_INSTRUCTIONID_SETLE:
+	case erw_INSTRUCTIONID_SETE:
+	case erw_INSTRUCTIONID_SETG:
+	case erw_INSTRUCTIONID_SETL:
+		{
+			erw_JIT_EMIT(compiler, 0x31, 0xC0); //xor eax, eax
+			enum erw_JitCondition condition = erw_jit_testflags(
+				compiler,
+				jumptests[id - erw_INSTRUCTIONID_SETNE]
+			);
+			erw_JIT_EMIT(compiler, 0x0F, 0x90 + condition, 0xC0); //setcc al
+			erw_jit_vmreg(compiler, 0, 1, 0x89, rax, operands[0]);
+		}
+		break;
+	default:
+		//POW, FPOW, FMOD, UTOF and HALT
+		erw_jit_branch(
+			compiler,
+			erw_JITCONDITION_ALWAYS,
+			erw_JITFIXUPTYPE_FALLBACK,
+			offset
+		);
+		break;
+	}
+}
+
+//Stores the state and returns the offset in rax, and in rdx if it has to be
+//interpreted
+static void erw_jit_exit(struct erw_JitCompiler* compiler)
+{
+	const enum erw_JitRegister r13 = erw_JITREGISTER_R13;
+	const enum erw_JitRegister r14 = erw_JITREGISTER_R14;
+	const enum erw_JitRegister r15 = erw_JITREGISTER_R15;
+	erw_jit_mem(
+		compiler,
+		0,
+		1,
+		0x89,
+		r13,
+		r15,
+		offsetof(struct erw_JitState, sp)
+	);
+	erw_jit_mem(
+		compiler,
+		0,
+		1,
+		0x89,
+		r14,
+		r15,
+		offsetof(struct erw_JitState, fp)
+	);
+	erw_jit_mem(
+		compiler,
+		0,
+		0,
+		0x89,
+		erw_JITREGISTER_RBP,
+		r15,
+		offsetof(struct erw_JitState, flags)
+	);
+	erw_JIT_EMIT(
+		compiler,
+		0x41, 0x5F, //pop r15
+		0x41, 0x5E, //pop r14
+		0x41, 0x5D, //pop r13
+		0x5D, //pop rbp
+		0x5B, //pop rbx
+		0xC3 //ret
+	);
+}
+
+#ifdef __x86_64__
+//The erw_JitEnter that every entry into JIT code goes through
+static void erw_jit_enter(struct erw_JitCompiler* compiler)
+{
+	const enum erw_JitRegister r15 = erw_JITREGISTER_R15;
+	erw_JIT_EMIT(
+		compiler,
+		0x53, //push rbx
+		0x55, //push rbp
+		0x41, 0x55, //push r13
+		0x41, 0x56, //push r14
+		0x41, 0x57, //push r15, which leaves rsp 16 byte aligned
+		0x49, 0x89, 0xFF //mov r15, rdi
+	);
+	erw_jit_mem(
+		compiler,
+		0,
+		1,
+		0x8B,
+		erw_JITREGISTER_RBX,
+		r15,
+		offsetof(struct erw_JitState, registers)
+	);
+	erw_JIT_EMIT(
+		compiler,
+		0x48, 0x83, 0xEB, //sub rbx, imm8
+		-erw_JIT_REGISTERBIAS * (int)sizeof(union erw_Register)
+	);
+	erw_jit_mem(
+		compiler,
+		0,
+		1,
+		0x8B,
+		erw_JITREGISTER_R13,
+		r15,
+		offsetof(struct erw_JitState, sp)
+	);
+	erw_jit_mem(
+		compiler,
+		0,
+		1,
+		0x8B,
+		erw_JITREGISTER_R14,
+		r15,
+		offsetof(struct erw_JitState, fp)
+	);
+	erw_jit_mem(
+		compiler,
+		0,
+		0,
+		0x8B,
+		erw_JITREGISTER_RBP,
+		r15,
+		offsetof(struct erw_JitState, flags)
+	);
+	erw_JIT_EMIT(compiler, 0xFF, 0xE6); //jmp rsi
+}
+#endif
+
+//Copies code to executable memory. Chunks are mapped twice, writable and
+//executable, so no page is both and adding code needs no system calls.
+static uint8_t* erw_jit_install(
+	struct erw_Jit* self,
+	const uint8_t* code,
+	size_t size)
+{
+	size_t numchunks = vec_getsize(self->chunks);
+	struct erw_JitChunk* chunk = numchunks
+		? &self->chunks[numchunks - 1]
+		: NULL;
+	if(!chunk || chunk->size - chunk->used < size)
+	{
+		size_t pagesize = sysconf(_SC_PAGESIZE);
+		struct erw_JitChunk newchunk = {
+			.size = size > erw_JIT_CHUNKSIZE
+				? (size + pagesize - 1) / pagesize * pagesize
+				: erw_JIT_CHUNKSIZE
+		};
+		int fd = memfd_create("erw_jit", MFD_CLOEXEC);
+		if(fd == -1 || ftruncate(fd, newchunk.size))
+		{
+			log_error("%s <%s>", strerror(errno), __func__);
+		}
+
+		newchunk.data = mmap(
+			NULL,
+			newchunk.size,
+			PROT_READ | PROT_EXEC,
+			MAP_SHARED,
+			fd,
+			0
+		);
+		newchunk.writable = mmap(
+			NULL,
+			newchunk.size,
+			PROT_READ | PROT_WRITE,
+			MAP_SHARED,
+			fd,
+			0
+		);
+		if(newchunk.data == MAP_FAILED || newchunk.writable == MAP_FAILED)
+		{
+			log_error("%s <%s>", strerror(errno), __func__);
+		}
+
+		close(fd);
+		vec_pushback(self->chunks, newchunk);
+		chunk = &self->chunks[numchunks];
+	}
+
+	memcpy(chunk->writable + chunk->used, code, size);
+	uint8_t* ret = chunk->data + chunk->used;
+	chunk->used += (size + 15) & ~(size_t)15;
+	return ret;
+}
+
+static void erw_jit_addsymbol(
+	struct erw_Jit* self,
+	const uint8_t* code,
+	size_t size,
+	const char* name)
+{
+	if(self->perfmap)
+	{
+		fprintf(
+			self->perfmap,
+			"%" PRIxPTR " %zx %s\n",
+			(uintptr_t)code,
+			size,
+			name
+		);
+	}
+}
+
+//Decodes the instructions of func, the verifier made sure they end with it
+static void erw_jit_decode(
+	struct erw_BytecodeImage* image,
+	const struct erw_BytecodeFuncEntry* func,
+	size_t end,
+	Vec(struct erw_IRInstruction)* instructions)
+{
+	//Every instruction takes at least a byte, the rest is collapsed after
+	size_t maxinstructions = end - func->offset;
+	vec_expand(*instructions, 0, maxinstructions);
+	const uint8_t* code = image->instructions;
+	size_t numinstructions = 0;
+	size_t pos = func->offset;
+	while(pos < end)
+	{
+		struct erw_IRInstruction* instruction =
+			&(*instructions)[numinstructions++];
+		*instruction = (struct erw_IRInstruction){
+			.id = code[pos],
+			.offset = pos
+		};
+
+		const char* operands = erw_instructioninfos[instruction->id].operands;
+		const uint8_t* operand = code + pos + 1;
+		for(size_t i = 0; operands[i]; i++)
+		{
+			size_t size = erw_operandsize(operands[i]);
+			for(size_t j = 0; j < size; j++)
+			{
+				instruction->operands[i] |= (uint64_t)operand[j] << (j * 8);
+			}
+
+			operand += size;
+		}
+
+		pos += erw_instructioninfos[instruction->id].size;
+	}
+
+	if(numinstructions < maxinstructions)
+	{
+		vec_collapse(
+			*instructions,
+			numinstructions,
+			maxinstructions - numinstructions
+		);
+	}
+}
+
+static void erw_jit_compile(
+	struct erw_Jit* self,
+	const struct erw_BytecodeFuncEntry* func)
+{
+	size_t index = func - self->image->functions;
+	size_t end = index + 1 < self->image->numfunctions
+		? func[1].offset
+		: self->image->numinstructions;
+	Vec(struct erw_IRInstruction) instructions = vec_ctor(
+		struct erw_IRInstruction,
+		end - func->offset
+	);
+	erw_jit_decode(self->image, func, end, &instructions);
+
+	size_t numinstructions = vec_getsize(instructions);
+	struct erw_JitCompiler compiler;
+	erw_jitcompiler_ctor(&compiler, numinstructions * 32 + 64, numinstructions);
+	Vec(size_t) addresses = vec_ctor(size_t, numinstructions);
+	for(size_t i = 0; i < numinstructions; i++)
+	{
+		vec_pushback(addresses, compiler.size);
+		erw_jit_instruction(&compiler, &instructions[i]);
+	}
+
+	//Falling off the end continues wherever the interpreter would
+	erw_jit_branch(
+		&compiler,
+		erw_JITCONDITION_ALWAYS,
+		erw_JITFIXUPTYPE_FALLBACK,
+		end
+	);
+
+	size_t fallbackexit = compiler.size;
+	erw_JIT_EMIT(
+		&compiler,
+		0xBA, 0x01, 0x00, 0x00, 0x00, //mov edx, 1
+		0xEB, 0x02 //jmp past the xor
+	);
+	size_t exit = compiler.size;
+	erw_JIT_EMIT(&compiler, 0x31, 0xD2); //xor edx, edx
+	erw_jit_exit(&compiler);
+
+	size_t numfixups = vec_getsize(compiler.fixups);
+	for(size_t i = 0; i < numfixups; i++)
+	{
+		struct erw_JitFixup fixup = compiler.fixups[i];
+		if(fixup.type == erw_JITFIXUPTYPE_JUMP)
+		{
+			size_t target = erw_ir_search(instructions, fixup.target);
+			erw_jit_patch(&compiler, fixup.pos, addresses[target]);
+		}
+		else if(fixup.type == erw_JITFIXUPTYPE_EXIT)
+		{
+			erw_jit_patch(&compiler, fixup.pos, exit);
+		}
+		else
+		{
+			erw_jit_patch(&compiler, fixup.pos, compiler.size);
+			erw_JIT_EMIT(&compiler, 0xB8); //mov eax, offset
+			erw_jit_emit32(&compiler, fixup.target);
+			erw_JIT_EMIT(&compiler, 0xE9); //jmp rel32
+			erw_jit_emit32(&compiler, 0);
+			erw_jit_patch(&compiler, compiler.size - 4, fallbackexit);
+		}
+	}
+
+	size_t size = compiler.size;
+	uint8_t* code = erw_jit_install(self, compiler.code, size);
+	erw_jit_addsymbol(
+		self,
+		code,
+		size,
+		self->image->constants + func->name
+	);
+
+	//Functions are entered at the start and where their calls return
+	self->entries[func->offset] = code;
+	for(size_t i = 0; i + 1 < numinstructions; i++)
+	{
+		if(instructions[i].id == erw_INSTRUCTIONID_CALL)
+		{
+			self->entries[instructions[i + 1].offset] = code + addresses[i + 1];
+		}
+	}
+
+	vec_dtor(addresses);
+	erw_jitcompiler_dtor(&compiler);
+	vec_dtor(instructions);
+}
+
+#ifdef __x86_64__
+struct erw_Jit* erw_jit_ctor(
+	struct erw_Jit* self,
+	struct erw_BytecodeImage* image,
+	struct erw_Interpreter* interpreter)
+{
+	log_assert(self, "is NULL");
+	log_assert(image, "is NULL");
+	log_assert(interpreter, "is NULL");
+
+	self->image = image;
+	self->entries = vec_ctor(void*, image->numinstructions);
+	vec_expand(self->entries, 0, image->numinstructions);
+	self->isvisited = vec_ctor(uint8_t, image->numinstructions);
+	vec_expand(self->isvisited, 0, image->numinstructions);
+	for(size_t i = 0; i < image->numinstructions; i++)
+	{
+		self->entries[i] = NULL;
+		self->isvisited[i] = 0;
+	}
+
+	self->state = (struct erw_JitState){
+		.registers = interpreter->registers,
+		.entries = self->entries
+	};
+	self->chunks = vec_ctor(struct erw_JitChunk, 0);
+
+	//perf picks up the symbols of JIT code from /tmp/perf-<pid>.map once the
+	//process is done, so it is only flushed by erw_jit_dtor
+	char path[64];
+	snprintf(path, sizeof(path), "/tmp/perf-%ld.map", (long)getpid());
+	self->perfmap = fopen(path, "w");
+
+	struct erw_JitCompiler compiler;
+	erw_jitcompiler_ctor(&compiler, 64, 0);
+	erw_jit_enter(&compiler);
+	size_t size = compiler.size;
+	uint8_t* code = erw_jit_install(self, compiler.code, size);
+	erw_jit_addsymbol(self, code, size, "erw_jit_enter");
+	self->enter = (erw_JitEnter)code;
+	erw_jitcompiler_dtor(&compiler);
+	return self;
+}
+#endif
+
+const void* erw_jit_lookup(struct erw_Jit* self, size_t offset)
+{
+	log_assert(self, "is NULL");
+	log_assert(
+		offset < self->image->numinstructions,
+		"invalid offset (%zu)",
+		offset
+	);
+
+	if(!self->isvisited[offset])
+	{
+		self->isvisited[offset] = 1;
+		const struct erw_BytecodeFuncEntry* func =
+			erw_bytecodeimage_findfunc(self->image, offset);
+		if(func && func->offset == offset)
+		{
+			erw_jit_compile(self, func);
+		}
+	}
+
+	return self->entries[offset];
+}
+
+void erw_jit_dtor(struct erw_Jit* self)
+{
+	log_assert(self, "is NULL");
+
+	for(size_t i = 0; i < vec_getsize(self->chunks); i++)
+	{
+		munmap(self->chunks[i].data, self->chunks[i].size);
+		munmap(self->chunks[i].writable, self->chunks[i].size);
+	}
+
+	if(self->perfmap)
+	{
+		fclose(self->perfmap);
+	}
+
+	vec_dtor(self->chunks);
+	vec_dtor(self->isvisited);
+	vec_dtor(self->entries);
+}
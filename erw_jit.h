@@ -0,0 +1,90 @@
+/*
+	Copyright (C) 2017 Erik Wallström
+
+	This file is part of Erwall.
+
+	Erwall is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Erwall is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Erwall.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ERW_JIT_H
+#define ERW_JIT_H
+
+#include "erw_interpreter.h"
+#include "erw_bytecode.h"
+#include <stdio.h>
+
+//The interpreter state JIT code works on. Frames are the same as in the
+//interpreter, so either can return to the other.
+struct erw_JitState
+{
+	union erw_Register* registers;
+	//Calls above it fall back to the interpreter, which starts the next
+	//segment, see erw_interpreter.h
+	union erw_Register* stacklimit;
+	void* const* entries; //Per offset, NULL where JIT code can't be entered
+	union erw_Register* sp;
+	union erw_Register* fp;
+	int32_t flags;
+};
+
+//Where JIT code stopped: at a RET to the interpreter, a call to a function
+//that isn't compiled or an instruction it leaves to the interpreter
+//(isfallback), like one that has to report an error
+struct erw_JitExit
+{
+	size_t next; //Offset to continue at
+	size_t isfallback;
+};
+
+typedef struct erw_JitExit (*erw_JitEnter)(
+	struct erw_JitState* state,
+	const void* code
+);
+
+struct erw_JitChunk
+{
+	uint8_t* data; //Executable
+	uint8_t* writable; //The same memory, mapped writable
+	size_t size;
+	size_t used;
+};
+
+//A baseline JIT: functions are translated to x86-64 the first time they are
+//called, one template per instruction
+struct erw_Jit
+{
+	struct erw_BytecodeImage* image;
+	struct erw_JitState state;
+	erw_JitEnter enter;
+	Vec(void*) entries;
+	Vec(uint8_t) isvisited; //Per offset, if it was looked up before
+	Vec(struct erw_JitChunk) chunks;
+	FILE* perfmap; //Symbols for perf, see erw_jit_ctor
+};
+
+//NOTE: The image and the interpreter have to outlive the JIT. Only x86-64
+//hosts can run the code it emits, so elsewhere there is no JIT.
+#ifdef __x86_64__
+struct erw_Jit* erw_jit_ctor(
+	struct erw_Jit* self,
+	struct erw_BytecodeImage* image,
+	struct erw_Interpreter* interpreter
+);
+#endif
+//JIT code for offset, compiling the function that starts there the first
+//time. NULL if it has to be interpreted.
+const void* erw_jit_lookup(struct erw_Jit* self, size_t offset);
+void erw_jit_dtor(struct erw_Jit* self);
+
+#endif
@@ -25,18 +25,49 @@
 //TODO: !!!!!!!!!!!!!!!!!!!!!!!!!! erw_parse_funcprot
 struct erw_Parser
 {
-	Vec(struct erw_Token) tokens;
-	Vec(struct Str) lines;
+	const struct erw_TokenStream* tokens;
+	struct erw_Lines* lines;
+	struct erw_AST* ast;
+	Vec(uint32_t) stack; //Children of the lists being parsed
 	size_t current;
 };
 
+//The current token, or the last one once all were parsed
+static size_t erw_parser_index(struct erw_Parser* parser)
+{
+	return parser->current < parser->tokens->numtokens
+		? parser->current
+		: parser->tokens->numtokens - 1;
+}
+
+static enum erw_TokenType erw_parser_type(struct erw_Parser* parser)
+{
+	return parser->tokens->types[erw_parser_index(parser)];
+}
+
+//Reports msg at the current token
+static void erw_parser_error(struct erw_Parser* parser, const char* msg)
+{
+	struct erw_Token token = erw_tokenstream_get(
+		parser->tokens, 
+		erw_parser_index(parser)
+	);
+	erw_error(
+		msg,
+		erw_lines_get(parser->lines, token.linenum),
+		token.linenum,
+		token.column,
+		token.column + token.len - 1
+	);
+}
+
 static int erw_parser_check(
 	struct erw_Parser* parser,
-	const struct erw_TokenType* type)
+	enum erw_TokenType type)
 {
-	if(parser->current < vec_getsize(parser->tokens))
+	if(parser->current < parser->tokens->numtokens)
 	{
-		if(parser->tokens[parser->current].type == type)
+		if(parser->tokens->types[parser->current] == type)
 		{
 			return 1;
 		}
@@ -47,15 +78,19 @@ static int erw_parser_check(
 		str_ctorfmt(
 			&msg,
 			"Expected %s, reached EOF",
-			type->name
+			erw_tokentypeinfos[type].name
 		);
 
+		struct erw_Token token = erw_tokenstream_get(
+			parser->tokens, 
+			erw_parser_index(parser)
+		);
 		erw_error(
 			msg.data,
-			parser->lines[parser->tokens[parser->current].linenum - 1].data,
-			parser->tokens[parser->current].linenum,
-			parser->tokens[parser->current].column,
-			parser->tokens[parser->current].column
+			erw_lines_get(parser->lines, token.linenum),
+			token.linenum,
+			token.column,
+			token.column
 		);
 		str_dtor(&msg);
 	}
@@ -63,9 +98,10 @@ static int erw_parser_check(
 	return 0;
 }
 
-static struct erw_Token* erw_parser_expect(
+//Returns the index of the token for the nodes that keep it
+static uint32_t erw_parser_expect(
 	struct erw_Parser* parser,
-	const struct erw_TokenType* type)
+	enum erw_TokenType type)
 {
 	if(!erw_parser_check(parser, type))
 	{
@@ -73,183 +109,261 @@ static struct erw_Token* erw_parser_expect(
 		str_ctorfmt(
 			&msg,
 			"Expected %s, got %s",
-			type->name,
-			parser->tokens[parser->current].type->name
+			erw_tokentypeinfos[type].name,
+			erw_tokentypeinfos[erw_parser_type(parser)].name
 		);
 
-		erw_error(
-			msg.data,
-			parser->lines[parser->tokens[parser->current].linenum - 1].data,
-			parser->tokens[parser->current].linenum,
-			parser->tokens[parser->current].column,
-			parser->tokens[parser->current].column 
-				+ vec_getsize(parser->tokens[parser->current].text) - 2
-		);
+		erw_parser_error(parser, msg.data);
 		str_dtor(&msg);
 	}
 
-	struct erw_Token* ret = &parser->tokens[parser->current];
-	parser->current++;
-	return ret;
+	return parser->current++;
+}
+
+//The type of the current token, for dispatching on. Reaching EOF is reported 
+//as expecting type.
+static enum erw_TokenType erw_parser_peek(
+	struct erw_Parser* parser,
+	enum erw_TokenType type)
+{
+	erw_parser_check(parser, type);
+	return erw_parser_type(parser);
+}
+
+//Children are pushed on parser->stack while a list is parsed, nested lists 
+//above them, and moved into the AST once it's done
+static struct erw_ASTList erw_parser_poplist(
+	struct erw_Parser* parser,
+	size_t mark)
+{
+	size_t size = vec_getsize(parser->stack) - mark;
+	struct erw_ASTList list = erw_ast_newlist(
+		parser->ast, 
+		parser->stack + mark, 
+		size
+	);
+	if(size)
+	{
+		vec_collapse(parser->stack, mark, size);
+	}
+
+	return list;
 }
 
-static struct erw_ASTNode* erw_parse_expr(struct erw_Parser* parser);
-static struct erw_ASTNode* erw_parse_type(struct erw_Parser* parser);
-static struct erw_ASTNode* erw_parse_factor(struct erw_Parser* parser)
+static void erw_parser_push(struct erw_Parser* parser, uint32_t node)
+{
+	vec_pushback(parser->stack, node);
+}
+
+//NOTE: Only valid until the next node is added, so children are parsed before
+//they are stored
+static struct erw_ASTNode* erw_parser_node(
+	struct erw_Parser* parser, 
+	uint32_t node)
+{
+	return &parser->ast->nodes[node];
+}
+
+static uint32_t erw_parse_expr(struct erw_Parser* parser);
+static uint32_t erw_parse_binexpr(
+	struct erw_Parser* parser,
+	int minprecedence
+);
+static uint32_t erw_parse_type(struct erw_Parser* parser);
+static uint32_t erw_parse_factor(struct erw_Parser* parser)
 { 
-	struct erw_ASTNode* node = NULL;
-	if(erw_parser_check(parser, erw_TOKENTYPE_LITERAL_BOOL) 
-		|| erw_parser_check(parser, erw_TOKENTYPE_LITERAL_CHAR) 
-		|| erw_parser_check(parser, erw_TOKENTYPE_LITERAL_INT) 
-		|| erw_parser_check(parser, erw_TOKENTYPE_LITERAL_FLOAT) 
-		|| erw_parser_check(parser, erw_TOKENTYPE_LITERAL_STRING))
-	{ 
+	uint32_t node = 0;
+	switch(erw_parser_peek(parser, erw_TOKENTYPE_LITERAL_BOOL))
+	{
+	case erw_TOKENTYPE_LITERAL_BOOL:
+	case erw_TOKENTYPE_LITERAL_CHAR:
+	case erw_TOKENTYPE_LITERAL_INT:
+	case erw_TOKENTYPE_LITERAL_FLOAT:
+	case erw_TOKENTYPE_LITERAL_STRING:
 		node = erw_ast_new(
+			parser->ast,
 			erw_ASTNODETYPE_LITERAL, 
-			&parser->tokens[parser->current]
+			erw_parser_index(parser)
 		);
 		parser->current++;
-	}
-	else if(erw_parser_check(parser, erw_TOKENTYPE_IDENT))
-	{ 
+		break;
+	case erw_TOKENTYPE_IDENT:
 		node = erw_ast_new(
+			parser->ast,
 			erw_ASTNODETYPE_LITERAL, //Is this really correct?
 			erw_parser_expect(parser, erw_TOKENTYPE_IDENT)
 		);
-	}
-	else if(erw_parser_check(parser, erw_TOKENTYPE_LPAREN))
-	{ 
+		break;
+	case erw_TOKENTYPE_LPAREN:
 		erw_parser_expect(parser, erw_TOKENTYPE_LPAREN);
 		node = erw_parse_expr(parser);
 		erw_parser_expect(parser, erw_TOKENTYPE_RPAREN);
-	}
-	else if(erw_parser_check(parser, erw_TOKENTYPE_KEYWORD_CAST))
-	{ 
-		node = erw_ast_new(
-			erw_ASTNODETYPE_CAST,
-			erw_parser_expect(parser, erw_TOKENTYPE_KEYWORD_CAST)
-		);
-
-		erw_parser_expect(parser, erw_TOKENTYPE_LPAREN);
-		node->cast.type = erw_parse_type(parser);
-		erw_parser_expect(parser, erw_TOKENTYPE_COMMA);
+		break;
+	case erw_TOKENTYPE_KEYWORD_CAST:
+		{
+			node = erw_ast_new(
+				parser->ast,
+				erw_ASTNODETYPE_CAST,
+				erw_parser_expect(parser, erw_TOKENTYPE_KEYWORD_CAST)
+			);
 
-		node->cast.expr = erw_parse_expr(parser);
-		erw_parser_expect(parser, erw_TOKENTYPE_RPAREN);
-	}
-	else if(erw_parser_check(parser, erw_TOKENTYPE_KEYWORD_STRUCT))
-	{
-		node = erw_ast_new(
-			erw_ASTNODETYPE_STRUCTLITERAL, 
-			erw_parser_expect(parser, erw_TOKENTYPE_KEYWORD_STRUCT)
-		);
+			erw_parser_expect(parser, erw_TOKENTYPE_LPAREN);
+			uint32_t type = erw_parse_type(parser);
+			erw_parser_expect(parser, erw_TOKENTYPE_COMMA);
 
-		erw_parser_expect(parser, erw_TOKENTYPE_LBRACKET);
-		int first = 1;
-		while(!erw_parser_check(parser, erw_TOKENTYPE_RBRACKET))
+			uint32_t expr = erw_parse_expr(parser);
+			erw_parser_expect(parser, erw_TOKENTYPE_RPAREN);
+			erw_parser_node(parser, node)->cast.type = type;
+			erw_parser_node(parser, node)->cast.expr = expr;
+		}
+		break;
+	case erw_TOKENTYPE_KEYWORD_STRUCT:
 		{
-			if(first)
+			node = erw_ast_new(
+				parser->ast,
+				erw_ASTNODETYPE_STRUCTLITERAL, 
+				erw_parser_expect(parser, erw_TOKENTYPE_KEYWORD_STRUCT)
+			);
+
+			//Names and values are pushed in pairs
+			size_t mark = vec_getsize(parser->stack);
+			erw_parser_expect(parser, erw_TOKENTYPE_LBRACKET);
+			int first = 1;
+			while(!erw_parser_check(parser, erw_TOKENTYPE_RBRACKET))
 			{
-				first = 0;
+				if(first)
+				{
+					first = 0;
+				}
+				else
+				{
+					erw_parser_expect(parser, erw_TOKENTYPE_COMMA);
+				}
+
+				uint32_t name = erw_ast_new(
+					parser->ast,
+					erw_ASTNODETYPE_LITERAL,
+					erw_parser_expect(parser, erw_TOKENTYPE_IDENT)
+				);
+
+				erw_parser_expect(parser, erw_TOKENTYPE_OPERATOR_DECLR);
+				uint32_t value = erw_parse_expr(parser);
+				erw_parser_push(parser, name);
+				erw_parser_push(parser, value);
+				if(!erw_parser_check(parser, erw_TOKENTYPE_COMMA))
+				{
+					break;
+				}
 			}
-			else
+
+			erw_parser_expect(parser, erw_TOKENTYPE_RBRACKET);
+			size_t size = (vec_getsize(parser->stack) - mark) / 2;
+			for(size_t i = 0; i < size; i++)
 			{
-				erw_parser_expect(parser, erw_TOKENTYPE_COMMA);
+				erw_parser_push(parser, parser->stack[mark + i * 2]);
 			}
 
-			vec_pushback(
-				node->structliteral.names, 
-				erw_parser_expect(parser, erw_TOKENTYPE_IDENT)
-			);
-
-			erw_parser_expect(parser, erw_TOKENTYPE_OPERATOR_DECLR);
-			vec_pushback(node->structliteral.values, erw_parse_expr(parser));
-			if(!erw_parser_check(parser, erw_TOKENTYPE_COMMA))
+			for(size_t i = 0; i < size; i++)
 			{
-				break;
+				erw_parser_push(parser, parser->stack[mark + i * 2 + 1]);
 			}
-		}
 
-		erw_parser_expect(parser, erw_TOKENTYPE_RBRACKET);
-	}
-	else if(erw_parser_check(parser, erw_TOKENTYPE_KEYWORD_UNION))
-	{
-		node = erw_ast_new(
-			erw_ASTNODETYPE_UNIONLITERAL, 
-			erw_parser_expect(parser, erw_TOKENTYPE_KEYWORD_UNION)
-		);
-		
-		erw_parser_expect(parser, erw_TOKENTYPE_LBRACKET);
-		node->unionliteral.type = erw_parse_type(parser);
-		erw_parser_expect(parser, erw_TOKENTYPE_OPERATOR_DECLR);
-		node->unionliteral.value = erw_parse_expr(parser);
-		erw_parser_expect(parser, erw_TOKENTYPE_RBRACKET);
-	}
-	else if(erw_parser_check(parser, erw_TOKENTYPE_KEYWORD_ARRAY))
-	{
-		node = erw_ast_new(
-			erw_ASTNODETYPE_ARRAYLITERAL, 
-			erw_parser_expect(parser, erw_TOKENTYPE_KEYWORD_ARRAY)
-		);
+			struct erw_ASTList values = erw_parser_poplist(
+				parser, 
+				mark + size * 3
+			);
+			struct erw_ASTList names = erw_parser_poplist(
+				parser, 
+				mark + size * 2
+			);
+			vec_collapse(parser->stack, mark, size * 2);
+			erw_parser_node(parser, node)->structliteral.names = names;
+			erw_parser_node(parser, node)->structliteral.values = values;
+		}
+		break;
+	case erw_TOKENTYPE_KEYWORD_UNION:
+		{
+			node = erw_ast_new(
+				parser->ast,
+				erw_ASTNODETYPE_UNIONLITERAL, 
+				erw_parser_expect(parser, erw_TOKENTYPE_KEYWORD_UNION)
+			);
 		
-		erw_parser_expect(parser, erw_TOKENTYPE_LBRACKET);
-		int first = 1;
-		while(!erw_parser_check(parser, erw_TOKENTYPE_RBRACKET))
+			erw_parser_expect(parser, erw_TOKENTYPE_LBRACKET);
+			uint32_t type = erw_parse_type(parser);
+			erw_parser_expect(parser, erw_TOKENTYPE_OPERATOR_DECLR);
+			uint32_t value = erw_parse_expr(parser);
+			erw_parser_expect(parser, erw_TOKENTYPE_RBRACKET);
+			erw_parser_node(parser, node)->unionliteral.type = type;
+			erw_parser_node(parser, node)->unionliteral.value = value;
+		}
+		break;
+	case erw_TOKENTYPE_KEYWORD_ARRAY:
 		{
-			if(first)
-			{
-				first = 0;
-			}
-			else
+			node = erw_ast_new(
+				parser->ast,
+				erw_ASTNODETYPE_ARRAYLITERAL, 
+				erw_parser_expect(parser, erw_TOKENTYPE_KEYWORD_ARRAY)
+			);
+		
+			size_t mark = vec_getsize(parser->stack);
+			erw_parser_expect(parser, erw_TOKENTYPE_LBRACKET);
+			int first = 1;
+			while(!erw_parser_check(parser, erw_TOKENTYPE_RBRACKET))
 			{
-				erw_parser_expect(parser, erw_TOKENTYPE_COMMA);
-			}
+				if(first)
+				{
+					first = 0;
+				}
+				else
+				{
+					erw_parser_expect(parser, erw_TOKENTYPE_COMMA);
+				}
 
-			vec_pushback(node->arrayliteral.values, erw_parse_expr(parser));
-			if(!erw_parser_check(parser, erw_TOKENTYPE_COMMA))
-			{
-				break;
+				erw_parser_push(parser, erw_parse_expr(parser));
+				if(!erw_parser_check(parser, erw_TOKENTYPE_COMMA))
+				{
+					break;
+				}
 			}
-		}
 
-		erw_parser_expect(parser, erw_TOKENTYPE_RBRACKET);
-	}
+			erw_parser_expect(parser, erw_TOKENTYPE_RBRACKET);
+			struct erw_ASTList values = erw_parser_poplist(parser, mark);
+			erw_parser_node(parser, node)->arrayliteral.values = values;
+		}
+		break;
 	/*else if(erw_parser_check(parser, erw_TOKENTYPE_LBRACKET))
 	{
 		//Slicing
 		
 	}*/
-	else
-	{ 
-		struct Str msg;
-		str_ctorfmt(
-			&msg,
-			"Unexpected %s",
-			parser->tokens[parser->current].type->name
-		);
+	default:
+		{
+			struct Str msg;
+			str_ctorfmt(
+				&msg,
+				"Unexpected %s",
+				erw_tokentypeinfos[erw_parser_type(parser)].name
+			);
 
-		erw_error(
-			msg.data, 
-			parser->lines[parser->tokens[parser->current].linenum - 1].data, 
-			parser->tokens[parser->current].linenum, 
-			parser->tokens[parser->current].column,
-			parser->tokens[parser->current].column 
-				+ vec_getsize(parser->tokens[parser->current].text) - 2
-		);
-		str_dtor(&msg);
+			erw_parser_error(parser, msg.data);
+			str_dtor(&msg);
+		}
+		break;
 	}
 
 	while(1)
 	{
 		if(erw_parser_check(parser, erw_TOKENTYPE_OPERATOR_ACCESS))
 		{
-			struct erw_ASTNode* newnode = erw_ast_new(
+			uint32_t newnode = erw_ast_new(
+				parser->ast,
 				erw_ASTNODETYPE_BINEXPR, 
 				erw_parser_expect(parser, erw_TOKENTYPE_OPERATOR_ACCESS)
 			);
 
-			newnode->binexpr.expr1 = node;
-			newnode->binexpr.expr2 = erw_ast_new(
+			uint32_t member = erw_ast_new(
+				parser->ast,
 				erw_ASTNODETYPE_LITERAL,
 				erw_parser_expect(
 					parser,
@@ -257,39 +371,46 @@ static struct erw_ASTNode* erw_parse_factor(struct erw_Parser* parser)
 				)
 			);
 
+			erw_parser_node(parser, newnode)->binexpr.expr1 = node;
+			erw_parser_node(parser, newnode)->binexpr.expr2 = member;
 			node = newnode;
 		}
 		else if(erw_parser_check(parser, erw_TOKENTYPE_OPERATOR_BITAND))
 		{
-			struct erw_ASTNode* newnode = erw_ast_new(
+			uint32_t newnode = erw_ast_new(
+				parser->ast,
 				erw_ASTNODETYPE_UNEXPR, 
 				erw_parser_expect(parser, erw_TOKENTYPE_OPERATOR_BITAND)
 			);
 			
-			newnode->unexpr.left = 0;
-			newnode->unexpr.expr = node;
+			erw_parser_node(parser, newnode)->unexpr.left = 0;
+			erw_parser_node(parser, newnode)->unexpr.expr = node;
 			node = newnode;
 		}
 		else if(erw_parser_check(parser, erw_TOKENTYPE_LBRACKET))
 		{
 			erw_parser_expect(parser, erw_TOKENTYPE_LBRACKET);
-			struct erw_ASTNode* newnode = erw_ast_new(
+			uint32_t newnode = erw_ast_new(
+				parser->ast,
 				erw_ASTNODETYPE_ACCESS, 
-				NULL
+				erw_AST_NOTOKEN
 			);
 
-			newnode->access.expr = node;
-			newnode->access.index = erw_parse_expr(parser);
+			uint32_t index = erw_parse_expr(parser);
 			erw_parser_expect(parser, erw_TOKENTYPE_RBRACKET);
+			erw_parser_node(parser, newnode)->access.expr = node;
+			erw_parser_node(parser, newnode)->access.index = index;
 			node = newnode;
 		}
 		else if(erw_parser_check(parser, erw_TOKENTYPE_LPAREN))
 		{
-			struct erw_ASTNode* newnode = erw_ast_new(
+			uint32_t newnode = erw_ast_new(
+				parser->ast,
 				erw_ASTNODETYPE_FUNCCALL, 
-				NULL
+				erw_AST_NOTOKEN
 			);
 
+			size_t mark = vec_getsize(parser->stack);
 			erw_parser_expect(parser, erw_TOKENTYPE_LPAREN);
 			int first = 1;
 			while(!erw_parser_check(parser, erw_TOKENTYPE_RPAREN))
@@ -303,7 +424,7 @@ static struct erw_ASTNode* erw_parse_factor(struct erw_Parser* parser)
 					erw_parser_expect(parser, erw_TOKENTYPE_COMMA);
 				}
 
-				vec_pushback(newnode->funccall.args, erw_parse_expr(parser));
+				erw_parser_push(parser, erw_parse_expr(parser));
 				if(!erw_parser_check(parser, erw_TOKENTYPE_COMMA))
 				{
 					break;
@@ -311,7 +432,9 @@ static struct erw_ASTNode* erw_parse_factor(struct erw_Parser* parser)
 			}
 
 			erw_parser_expect(parser, erw_TOKENTYPE_RPAREN);
-			newnode->funccall.callee = node;
+			struct erw_ASTList args = erw_parser_poplist(parser, mark);
+			erw_parser_node(parser, newnode)->funccall.args = args;
+			erw_parser_node(parser, newnode)->funccall.callee = node;
 			node = newnode;
 		}
 		else
@@ -323,289 +446,206 @@ static struct erw_ASTNode* erw_parse_factor(struct erw_Parser* parser)
 	return node;
 }
 
-static struct erw_ASTNode* erw_parse_ref(struct erw_Parser* parser)
+//Prefix operators. Signs only bind looser than exponentiation, so they are
+//only parsed where operators of lower precedence may follow.
+static uint32_t erw_parse_unexpr(
+	struct erw_Parser* parser,
+	int minprecedence)
 { 
-	struct erw_ASTNode* signnode;
-	if(erw_parser_check(parser, erw_TOKENTYPE_OPERATOR_BITAND))
+	uint32_t signnode;
+	if(minprecedence <= erw_PRECEDENCE_SIGN
+		&& (erw_parser_check(parser, erw_TOKENTYPE_OPERATOR_SUB) 
+		|| erw_parser_check(parser, erw_TOKENTYPE_OPERATOR_NOT)))
 	{
 		signnode = erw_ast_new(
+			parser->ast,
 			erw_ASTNODETYPE_UNEXPR,
-			&parser->tokens[parser->current]
+			erw_parser_index(parser)
 		);
 		parser->current++;
-		if(erw_parser_check(parser, erw_TOKENTYPE_KEYWORD_MUT))
-		{
-			erw_parser_expect(parser, erw_TOKENTYPE_KEYWORD_MUT);
-			signnode->unexpr.mutable = 1;
-		}
-
-		signnode->unexpr.expr = erw_parse_factor(parser);
-		signnode->unexpr.left = 1;
+		uint32_t expr = erw_parse_binexpr(parser, erw_PRECEDENCE_SIGN + 1);
+		erw_parser_node(parser, signnode)->unexpr.expr = expr;
+		erw_parser_node(parser, signnode)->unexpr.left = 1;
 	}
-	else
-	{
-		signnode = erw_parse_factor(parser);
-	}
-
-	return signnode;
-}
-
-static struct erw_ASTNode* erw_parse_exponent(struct erw_Parser* parser)
-{ 
-	struct erw_ASTNode* exponode = erw_parse_ref(parser);
-	while(erw_parser_check(parser, erw_TOKENTYPE_OPERATOR_POW))
-	{
-		struct erw_ASTNode* oldnode = exponode;
-		exponode = erw_ast_new(
-			erw_ASTNODETYPE_BINEXPR,
-			erw_parser_expect(parser, erw_TOKENTYPE_OPERATOR_POW)
-		);
-
-		exponode->binexpr.expr1 = oldnode;
-		struct erw_ASTNode* newnode = erw_parse_ref(parser);
-		exponode->binexpr.expr2 = newnode;
-	}
-
-	return exponode;
-}
-
-static struct erw_ASTNode* erw_parse_sign(struct erw_Parser* parser)
-{ 
-	struct erw_ASTNode* signnode;
-	if(erw_parser_check(parser, erw_TOKENTYPE_OPERATOR_SUB) 
-		|| erw_parser_check(parser, erw_TOKENTYPE_OPERATOR_NOT))
+	else if(erw_parser_check(parser, erw_TOKENTYPE_OPERATOR_BITAND))
 	{
 		signnode = erw_ast_new(
+			parser->ast,
 			erw_ASTNODETYPE_UNEXPR,
-			&parser->tokens[parser->current]
+			erw_parser_index(parser)
 		);
 		parser->current++;
-		signnode->unexpr.expr = erw_parse_exponent(parser);
-		signnode->unexpr.left = 1;
+		if(erw_parser_check(parser, erw_TOKENTYPE_KEYWORD_MUT))
+		{
+			erw_parser_expect(parser, erw_TOKENTYPE_KEYWORD_MUT);
+			erw_parser_node(parser, signnode)->unexpr.mutable = 1;
+		}
+
+		uint32_t expr = erw_parse_factor(parser);
+		erw_parser_node(parser, signnode)->unexpr.expr = expr;
+		erw_parser_node(parser, signnode)->unexpr.left = 1;
 	}
 	else
 	{
-		signnode = erw_parse_exponent(parser);
+		signnode = erw_parse_factor(parser);
 	}
 
 	return signnode;
 }
 
-static struct erw_ASTNode* erw_parse_term(struct erw_Parser* parser)
-{ 
-	struct erw_ASTNode* termnode = erw_parse_sign(parser);
-	while(erw_parser_check(parser, erw_TOKENTYPE_OPERATOR_MUL) 
-		|| erw_parser_check(parser, erw_TOKENTYPE_OPERATOR_DIV) 
-		|| erw_parser_check(parser, erw_TOKENTYPE_OPERATOR_MOD))
-	{
-		struct erw_ASTNode* oldnode = termnode;
-		termnode = erw_ast_new(
-			erw_ASTNODETYPE_BINEXPR,
-			&parser->tokens[parser->current]
-		);
-		parser->current++;
-
-		termnode->binexpr.expr1 = oldnode;
-		struct erw_ASTNode* newnode = erw_parse_sign(parser);
-		termnode->binexpr.expr2 = newnode;
-	}
-
-	return termnode;
-}
-
-static struct erw_ASTNode* erw_parse_plusminus(struct erw_Parser* parser)
+//Parses operators binding at least as tight as minprecedence, see 
+//erw_TokenTypeInfo.precedence. All of them are left associative, so the right 
+//operand only takes operators that bind tighter.
+static uint32_t erw_parse_binexpr(
+	struct erw_Parser* parser,
+	int minprecedence)
 { 
-	struct erw_ASTNode* pmnode = erw_parse_term(parser);
-	while(erw_parser_check(parser, erw_TOKENTYPE_OPERATOR_ADD) ||
-		erw_parser_check(parser, erw_TOKENTYPE_OPERATOR_SUB))
+	uint32_t node = erw_parse_unexpr(parser, minprecedence);
+	while(parser->current < parser->tokens->numtokens)
 	{
-		struct erw_ASTNode* oldnode = pmnode;
-		pmnode = erw_ast_new(
-			erw_ASTNODETYPE_BINEXPR,
-			&parser->tokens[parser->current]
-		);
-		parser->current++;
-
-		pmnode->binexpr.expr1 = oldnode;
-		struct erw_ASTNode* newnode = erw_parse_term(parser);
-		pmnode->binexpr.expr2 = newnode;
-	}
-
-	return pmnode;
-}
-
-static struct erw_ASTNode* erw_parse_comparison(struct erw_Parser* parser)
-{ 
-	struct erw_ASTNode* cmpnode = erw_parse_plusminus(parser);
-	while(erw_parser_check(parser, erw_TOKENTYPE_OPERATOR_LESS) 
-		|| erw_parser_check(parser, erw_TOKENTYPE_OPERATOR_LESSOREQUAL) 
-		|| erw_parser_check(parser, erw_TOKENTYPE_OPERATOR_GREATER) 
-		|| erw_parser_check(parser, erw_TOKENTYPE_OPERATOR_GREATEROREQUAL))
-	{ 
-		struct erw_ASTNode* oldnode = cmpnode;
-		cmpnode = erw_ast_new(
-			erw_ASTNODETYPE_BINEXPR,
-			&parser->tokens[parser->current]
-		);
-		parser->current++;
-
-		cmpnode->binexpr.expr1 = oldnode;
-		struct erw_ASTNode* newnode = erw_parse_plusminus(parser);
-		cmpnode->binexpr.expr2 = newnode;
-	}
-
-	return cmpnode;
-}
-
-static struct erw_ASTNode* erw_parse_equality(struct erw_Parser* parser)
-{ 
-	struct erw_ASTNode* eqnode = erw_parse_comparison(parser);
-	while(erw_parser_check(parser, erw_TOKENTYPE_OPERATOR_EQUAL) ||
-		erw_parser_check(parser, erw_TOKENTYPE_OPERATOR_NOTEQUAL))
-	{ 
-		struct erw_ASTNode* oldnode = eqnode;
-		eqnode = erw_ast_new(
-			erw_ASTNODETYPE_BINEXPR,
-			&parser->tokens[parser->current]
-		);
-		parser->current++;
-
-		eqnode->binexpr.expr1 = oldnode;
-		struct erw_ASTNode* newnode = erw_parse_comparison(parser);
-		eqnode->binexpr.expr2 = newnode;
-	}
-
-	return eqnode;
-}
+		int precedence = erw_tokentypeinfos[erw_parser_type(parser)].precedence;
+		if(!precedence || precedence < minprecedence)
+		{
+			break;
+		}
 
-static struct erw_ASTNode* erw_parse_andor(struct erw_Parser* parser)
-{ 
-	struct erw_ASTNode* andornode = erw_parse_equality(parser);
-	while(erw_parser_check(parser, erw_TOKENTYPE_OPERATOR_AND) ||
-		erw_parser_check(parser, erw_TOKENTYPE_OPERATOR_OR))
-	{ 
-		struct erw_ASTNode* oldnode = andornode;
-		andornode = erw_ast_new(
-			erw_ASTNODETYPE_BINEXPR,
-			&parser->tokens[parser->current]
+		uint32_t oldnode = node;
+		node = erw_ast_new(
+			parser->ast, 
+			erw_ASTNODETYPE_BINEXPR, 
+			erw_parser_index(parser)
 		);
 		parser->current++;
 
-		andornode->binexpr.expr1 = oldnode;
-		struct erw_ASTNode* newnode = erw_parse_equality(parser);
-		andornode->binexpr.expr2 = newnode;
+		uint32_t expr2 = erw_parse_binexpr(parser, precedence + 1);
+		erw_parser_node(parser, node)->binexpr.expr1 = oldnode;
+		erw_parser_node(parser, node)->binexpr.expr2 = expr2;
 	}
 
-	return andornode;
+	return node;
 }
 
-static struct erw_ASTNode* erw_parse_expr(struct erw_Parser* parser)
+static uint32_t erw_parse_expr(struct erw_Parser* parser)
 {
-	return erw_parse_andor(parser);
+	return erw_parse_binexpr(parser, 1);
 }
 
-static struct erw_ASTNode* erw_parse_type(struct erw_Parser* parser)
+static uint32_t erw_parse_type(struct erw_Parser* parser)
 { 
-	struct erw_ASTNode* root = NULL;
-	struct erw_ASTNode* node = NULL;
+	uint32_t root = 0;
+	uint32_t node = 0;
 	int done = 0;
 	while(!done)
 	{ 
-		struct erw_ASTNode* tmpnode = NULL;
-		if(erw_parser_check(parser, erw_TOKENTYPE_OPERATOR_BITAND))
-		{ 
+		uint32_t tmpnode = 0;
+		switch(erw_parser_peek(parser, erw_TOKENTYPE_OPERATOR_BITAND))
+		{
+		case erw_TOKENTYPE_OPERATOR_BITAND:
 			erw_parser_expect(parser, erw_TOKENTYPE_OPERATOR_BITAND);
-			tmpnode = erw_ast_new(erw_ASTNODETYPE_REFERENCE, NULL);
+			tmpnode = erw_ast_new(
+				parser->ast, 
+				erw_ASTNODETYPE_REFERENCE, 
+				erw_AST_NOTOKEN
+			);
 			if(erw_parser_check(parser, erw_TOKENTYPE_KEYWORD_MUT))
 			{
 				erw_parser_expect(parser, erw_TOKENTYPE_KEYWORD_MUT);
-				tmpnode->reference.mutable = 1;
+				erw_parser_node(parser, tmpnode)->reference.mutable = 1;
 			}
-		}
-		else if(erw_parser_check(parser, erw_TOKENTYPE_LBRACKET))
-		{ 
+			break;
+		case erw_TOKENTYPE_LBRACKET:
 			erw_parser_expect(parser, erw_TOKENTYPE_LBRACKET);
 			if(erw_parser_check(parser, erw_TOKENTYPE_LITERAL_INT))
 			{
-				tmpnode = erw_ast_new(erw_ASTNODETYPE_ARRAY, NULL);
+				tmpnode = erw_ast_new(
+					parser->ast, 
+					erw_ASTNODETYPE_ARRAY, 
+					erw_AST_NOTOKEN
+				);
 				//Parse expression?
-				tmpnode->array.size = erw_ast_new(
+				uint32_t size = erw_ast_new(
+					parser->ast,
 					erw_ASTNODETYPE_LITERAL,
 					erw_parser_expect(parser, erw_TOKENTYPE_LITERAL_INT)
 				);
+				erw_parser_node(parser, tmpnode)->array.size = size;
 			}
 			else
 			{
-				tmpnode = erw_ast_new(erw_ASTNODETYPE_SLICE, NULL);
+				tmpnode = erw_ast_new(
+					parser->ast, 
+					erw_ASTNODETYPE_SLICE, 
+					erw_AST_NOTOKEN
+				);
 			}
 
 			erw_parser_expect(parser, erw_TOKENTYPE_RBRACKET);
-		}
-		else if(erw_parser_check(parser, erw_TOKENTYPE_KEYWORD_FUNC))
-		{
-			tmpnode = erw_ast_new(
-				erw_ASTNODETYPE_FUNCTYPE,
-				erw_parser_expect(parser, erw_TOKENTYPE_KEYWORD_FUNC)
-			);
-
-			erw_parser_expect(parser, erw_TOKENTYPE_LPAREN);
-			int first = 1;
-			while(!erw_parser_check(parser, erw_TOKENTYPE_RPAREN))
+			break;
+		case erw_TOKENTYPE_KEYWORD_FUNC:
 			{
-				if(first)
-				{
-					first = 0;
-				}
-				else
+				tmpnode = erw_ast_new(
+					parser->ast,
+					erw_ASTNODETYPE_FUNCTYPE,
+					erw_parser_expect(parser, erw_TOKENTYPE_KEYWORD_FUNC)
+				);
+
+				size_t mark = vec_getsize(parser->stack);
+				erw_parser_expect(parser, erw_TOKENTYPE_LPAREN);
+				int first = 1;
+				while(!erw_parser_check(parser, erw_TOKENTYPE_RPAREN))
 				{
-					erw_parser_expect(parser, erw_TOKENTYPE_COMMA);
+					if(first)
+					{
+						first = 0;
+					}
+					else
+					{
+						erw_parser_expect(parser, erw_TOKENTYPE_COMMA);
+					}
+
+					erw_parser_push(parser, erw_parse_type(parser));
+					if(!erw_parser_check(parser, erw_TOKENTYPE_COMMA))
+					{
+						break;
+					}
 				}
 
-				vec_pushback(tmpnode->functype.params, erw_parse_type(parser));
-				if(!erw_parser_check(parser, erw_TOKENTYPE_COMMA))
+				erw_parser_expect(parser, erw_TOKENTYPE_RPAREN);
+				struct erw_ASTList params = erw_parser_poplist(parser, mark);
+				erw_parser_node(parser, tmpnode)->functype.params = params;
+				if(erw_parser_check(parser, erw_TOKENTYPE_OPERATOR_RETURN))
 				{
-					break;
+					erw_parser_expect(parser, erw_TOKENTYPE_OPERATOR_RETURN);
+					uint32_t type = erw_parse_type(parser);
+					erw_parser_node(parser, tmpnode)->functype.type = type;
 				}
-			}
-
-			erw_parser_expect(parser, erw_TOKENTYPE_RPAREN);
-			if(erw_parser_check(parser, erw_TOKENTYPE_OPERATOR_RETURN))
-			{
-				erw_parser_expect(parser, erw_TOKENTYPE_OPERATOR_RETURN);
-				tmpnode->functype.type = erw_parse_type(parser);
-			}
 			
-			done = 1;
-		}
-		else if(erw_parser_check(parser, erw_TOKENTYPE_TYPE))
-		{ 
+				done = 1;
+			}
+			break;
+		case erw_TOKENTYPE_TYPE:
 			tmpnode = erw_ast_new(
+				parser->ast,
 				erw_ASTNODETYPE_TYPE, 
 				erw_parser_expect(parser, erw_TOKENTYPE_TYPE)
 			);
 
 			done = 1; //Break loop
-		}
-		else
-		{
-			struct Str msg;
-			str_ctorfmt(
-				&msg,
-				"Expected '&', '[', or %s. Got %s",
-				erw_TOKENTYPE_TYPE->name,
-				parser->tokens[parser->current].type->name
-			);
+			break;
+		default:
+			{
+				struct Str msg;
+				str_ctorfmt(
+					&msg,
+					"Expected '&', '[', or %s. Got %s",
+					erw_tokentypeinfos[erw_TOKENTYPE_TYPE].name,
+					erw_tokentypeinfos[erw_parser_type(parser)].name
+				);
 
-			erw_error(
-				msg.data, 
-				parser->lines[parser->tokens[parser->current]
-					.linenum - 1].data, 
-				parser->tokens[parser->current].linenum, 
-				parser->tokens[parser->current].column,
-				parser->tokens[parser->current].column + 
-					vec_getsize(parser->tokens[parser->current].text) - 2
-			);
-			str_dtor(&msg);
+				erw_parser_error(parser, msg.data);
+				str_dtor(&msg);
+			}
+			break;
 		}
 
 		if(!root)
@@ -615,7 +655,7 @@ static struct erw_ASTNode* erw_parse_type(struct erw_Parser* parser)
 		}
 		else
 		{
-			node->reference.type = tmpnode;
+			erw_parser_node(parser, node)->reference.type = tmpnode;
 			node = tmpnode;
 		}
 	}
@@ -623,24 +663,26 @@ static struct erw_ASTNode* erw_parse_type(struct erw_Parser* parser)
 	return root;
 }
 
-static struct erw_ASTNode* erw_parse_vardeclr(struct erw_Parser* parser)
+static uint32_t erw_parse_vardeclr(struct erw_Parser* parser)
 {
-	struct erw_ASTNode* node = NULL;
+	uint32_t node = 0;
 	if(erw_parser_check(parser, erw_TOKENTYPE_KEYWORD_LET))
 	{
 		node = erw_ast_new(
+			parser->ast,
 			erw_ASTNODETYPE_VARDECLR,
 			erw_parser_expect(parser, erw_TOKENTYPE_KEYWORD_LET)
 		);
-		node->vardeclr.mutable = 0;
+		erw_parser_node(parser, node)->vardeclr.mutable = 0;
 	}
 	else if(erw_parser_check(parser, erw_TOKENTYPE_KEYWORD_MUT))
 	{
 		node = erw_ast_new(
+			parser->ast,
 			erw_ASTNODETYPE_VARDECLR,
 			erw_parser_expect(parser, erw_TOKENTYPE_KEYWORD_MUT)
 		);
-		node->vardeclr.mutable = 1;
+		erw_parser_node(parser, node)->vardeclr.mutable = 1;
 	}
 	else
 	{
@@ -648,42 +690,39 @@ static struct erw_ASTNode* erw_parse_vardeclr(struct erw_Parser* parser)
 		str_ctorfmt(
 			&msg,
 			"Expected %s or %s, got %s",
-			erw_TOKENTYPE_KEYWORD_LET->name,
-			erw_TOKENTYPE_KEYWORD_MUT->name,
-			parser->tokens[parser->current].type->name
+			erw_tokentypeinfos[erw_TOKENTYPE_KEYWORD_LET].name,
+			erw_tokentypeinfos[erw_TOKENTYPE_KEYWORD_MUT].name,
+			erw_tokentypeinfos[erw_parser_type(parser)].name
 		);
 
-		erw_error(
-			msg.data, 
-			parser->lines[parser->tokens[parser->current].linenum - 1].data, 
-			parser->tokens[parser->current].linenum, 
-			parser->tokens[parser->current].column,
-			parser->tokens[parser->current].column 
-				+ vec_getsize(parser->tokens[parser->current].text) - 2
-		);
+		erw_parser_error(parser, msg.data);
 		str_dtor(&msg);
 	}
 
 	if(node) //Remove warning
 	{
-		node->vardeclr.name = erw_parser_expect(parser, erw_TOKENTYPE_IDENT);
+		erw_parser_node(parser, node)->vardeclr.name = erw_parser_expect(
+			parser, 
+			erw_TOKENTYPE_IDENT
+		);
 		erw_parser_expect(parser, erw_TOKENTYPE_OPERATOR_DECLR);
-		node->vardeclr.type = erw_parse_type(parser);
+		uint32_t type = erw_parse_type(parser);
+		erw_parser_node(parser, node)->vardeclr.type = type;
 
 		if(erw_parser_check(parser, erw_TOKENTYPE_OPERATOR_ASSIGN))
 		{ 
 			erw_parser_expect(parser, erw_TOKENTYPE_OPERATOR_ASSIGN);
-			node->vardeclr.value = erw_parse_expr(parser);
+			uint32_t value = erw_parse_expr(parser);
+			erw_parser_node(parser, node)->vardeclr.value = value;
 		}
 	}
 
 	return node;
 }
 
-static void erw_parse_varlist(
-	struct erw_Parser* parser, 
-	Vec(struct erw_ASTNode*) varlist)
+static struct erw_ASTList erw_parse_varlist(struct erw_Parser* parser)
 {
+	size_t mark = vec_getsize(parser->stack);
 	erw_parser_expect(parser, erw_TOKENTYPE_LPAREN);
 	int first = 1;
 	while(!erw_parser_check(parser, erw_TOKENTYPE_RPAREN))
@@ -697,7 +736,7 @@ static void erw_parse_varlist(
 			erw_parser_expect(parser, erw_TOKENTYPE_COMMA);
 		}
 
-		vec_pushback(varlist, erw_parse_vardeclr(parser));
+		erw_parser_push(parser, erw_parse_vardeclr(parser));
 		if(!erw_parser_check(parser, erw_TOKENTYPE_COMMA))
 		{
 			break;
@@ -705,15 +744,18 @@ static void erw_parse_varlist(
 	}
 
 	erw_parser_expect(parser, erw_TOKENTYPE_RPAREN);
+	return erw_parser_poplist(parser, mark);
 }
 
-static struct erw_ASTNode* erw_parse_struct(struct erw_Parser* parser)
+static uint32_t erw_parse_struct(struct erw_Parser* parser)
 {
-	struct erw_ASTNode* node = erw_ast_new(
+	uint32_t node = erw_ast_new(
+		parser->ast,
 		erw_ASTNODETYPE_STRUCT, 
 		erw_parser_expect(parser, erw_TOKENTYPE_KEYWORD_STRUCT)
 	);
 
+	size_t mark = vec_getsize(parser->stack);
 	erw_parser_expect(parser, erw_TOKENTYPE_LBRACKET);
 	int first = 1;
 	while(!erw_parser_check(parser, erw_TOKENTYPE_RBRACKET))
@@ -727,25 +769,26 @@ static struct erw_ASTNode* erw_parse_struct(struct erw_Parser* parser)
 			erw_parser_expect(parser, erw_TOKENTYPE_COMMA);
 		}
 
-		struct erw_ASTNode* member = erw_ast_new(
+		uint32_t member = erw_ast_new(
+			parser->ast,
 			erw_ASTNODETYPE_STRUCTMEMBER, 
-			NULL
+			erw_AST_NOTOKEN
 		);
 
-		member->structmember.name = erw_parser_expect(
-			parser, 
-			erw_TOKENTYPE_IDENT
-		);
+		uint32_t name = erw_parser_expect(parser, erw_TOKENTYPE_IDENT);
+		erw_parser_node(parser, member)->structmember.name = name;
 		erw_parser_expect(parser, erw_TOKENTYPE_OPERATOR_DECLR);
-		member->structmember.type = erw_parse_type(parser);
+		uint32_t type = erw_parse_type(parser);
+		erw_parser_node(parser, member)->structmember.type = type;
 
 		if(erw_parser_check(parser, erw_TOKENTYPE_OPERATOR_ASSIGN))
 		{
 			erw_parser_expect(parser, erw_TOKENTYPE_OPERATOR_ASSIGN);
-			member->structmember.value = erw_parse_expr(parser);
+			uint32_t value = erw_parse_expr(parser);
+			erw_parser_node(parser, member)->structmember.value = value;
 		}
 
-		vec_pushback(node->struct_.members, member);
+		erw_parser_push(parser, member);
 		if(!erw_parser_check(parser, erw_TOKENTYPE_COMMA))
 		{
 			break;
@@ -753,16 +796,20 @@ static struct erw_ASTNode* erw_parse_struct(struct erw_Parser* parser)
 	}
 
 	erw_parser_expect(parser, erw_TOKENTYPE_RBRACKET);
+	struct erw_ASTList members = erw_parser_poplist(parser, mark);
+	erw_parser_node(parser, node)->struct_.members = members;
 	return node;
 }
 
-static struct erw_ASTNode* erw_parse_union(struct erw_Parser* parser)
+static uint32_t erw_parse_union(struct erw_Parser* parser)
 {
-	struct erw_ASTNode* node = erw_ast_new(
+	uint32_t node = erw_ast_new(
+		parser->ast,
 		erw_ASTNODETYPE_UNION, 
 		erw_parser_expect(parser, erw_TOKENTYPE_KEYWORD_UNION)
 	);
 
+	size_t mark = vec_getsize(parser->stack);
 	erw_parser_expect(parser, erw_TOKENTYPE_LBRACKET);
 	int first = 1;
 	while(!erw_parser_check(parser, erw_TOKENTYPE_RBRACKET))
@@ -776,7 +823,7 @@ static struct erw_ASTNode* erw_parse_union(struct erw_Parser* parser)
 			erw_parser_expect(parser, erw_TOKENTYPE_COMMA);
 		}
 
-		vec_pushback(node->union_.members, erw_parse_type(parser));
+		erw_parser_push(parser, erw_parse_type(parser));
 		if(!erw_parser_check(parser, erw_TOKENTYPE_COMMA))
 		{
 			break;
@@ -784,16 +831,20 @@ static struct erw_ASTNode* erw_parse_union(struct erw_Parser* parser)
 	}
 
 	erw_parser_expect(parser, erw_TOKENTYPE_RBRACKET);
+	struct erw_ASTList members = erw_parser_poplist(parser, mark);
+	erw_parser_node(parser, node)->union_.members = members;
 	return node;
 }
 
-static struct erw_ASTNode* erw_parse_enum(struct erw_Parser* parser)
+static uint32_t erw_parse_enum(struct erw_Parser* parser)
 {
-	struct erw_ASTNode* node = erw_ast_new(
+	uint32_t node = erw_ast_new(
+		parser->ast,
 		erw_ASTNODETYPE_ENUM, 
 		erw_parser_expect(parser, erw_TOKENTYPE_KEYWORD_ENUM)
 	);
 
+	size_t mark = vec_getsize(parser->stack);
 	erw_parser_expect(parser, erw_TOKENTYPE_LBRACKET);
 	int first = 1;
 	while(!erw_parser_check(parser, erw_TOKENTYPE_RBRACKET))
@@ -807,27 +858,28 @@ static struct erw_ASTNode* erw_parse_enum(struct erw_Parser* parser)
 			erw_parser_expect(parser, erw_TOKENTYPE_COMMA);
 		}
 
-		struct erw_ASTNode* membernode = erw_ast_new(
+		uint32_t membernode = erw_ast_new(
+			parser->ast,
 			erw_ASTNODETYPE_ENUMMEMBER, 
-			NULL
+			erw_AST_NOTOKEN
 		);
 
-		membernode->enummember.name = erw_parser_expect(
-			parser, 
-			erw_TOKENTYPE_IDENT
-		);
+		erw_parser_node(parser, membernode)->enummember.name = 
+			erw_parser_expect(parser, erw_TOKENTYPE_IDENT);
 
 		if(erw_parser_check(parser, erw_TOKENTYPE_OPERATOR_ASSIGN))
 		{
 			erw_parser_expect(parser, erw_TOKENTYPE_OPERATOR_ASSIGN);
 			//Parse expression?
-			membernode->enummember.value = erw_ast_new(
+			uint32_t value = erw_ast_new(
+				parser->ast,
 				erw_ASTNODETYPE_LITERAL,
 				erw_parser_expect(parser, erw_TOKENTYPE_LITERAL_INT)
 			);
+			erw_parser_node(parser, membernode)->enummember.value = value;
 		}
 
-		vec_pushback(node->enum_.members, membernode);
+		erw_parser_push(parser, membernode);
 		if(!erw_parser_check(parser, erw_TOKENTYPE_COMMA))
 		{
 			break;
@@ -835,327 +887,372 @@ static struct erw_ASTNode* erw_parse_enum(struct erw_Parser* parser)
 	}
 
 	erw_parser_expect(parser, erw_TOKENTYPE_RBRACKET);
+	struct erw_ASTList members = erw_parser_poplist(parser, mark);
+	erw_parser_node(parser, node)->enum_.members = members;
 	return node;
 }
 
-static struct erw_ASTNode* erw_parse_typedeclr(struct erw_Parser* parser)
+static uint32_t erw_parse_typedeclr(struct erw_Parser* parser)
 { 
-	struct erw_ASTNode* node = erw_ast_new(
+	uint32_t node = erw_ast_new(
+		parser->ast,
 		erw_ASTNODETYPE_TYPEDECLR,
 		erw_parser_expect(parser, erw_TOKENTYPE_KEYWORD_TYPE)
 	);
 
-	node->typedeclr.name = erw_parser_expect(
+	erw_parser_node(parser, node)->typedeclr.name = erw_parser_expect(
 		parser, 
 		erw_TOKENTYPE_TYPE
 	);
 
 	if(erw_parser_check(parser, erw_TOKENTYPE_OPERATOR_DECLR))
 	{ 
+		uint32_t type = 0;
 		erw_parser_expect(parser, erw_TOKENTYPE_OPERATOR_DECLR);
-		if(erw_parser_check(parser, erw_TOKENTYPE_TYPE))
+		switch(erw_parser_peek(parser, erw_TOKENTYPE_TYPE))
 		{
-			node->typedeclr.type = erw_ast_new(
+		case erw_TOKENTYPE_TYPE:
+			type = erw_ast_new(
+				parser->ast,
 				erw_ASTNODETYPE_TYPE,
 				erw_parser_expect(parser, erw_TOKENTYPE_TYPE)
 			);
-		}
-		else if(erw_parser_check(parser, erw_TOKENTYPE_KEYWORD_STRUCT))
-		{
-			node->typedeclr.type = erw_parse_struct(parser);
-		}
-		else if(erw_parser_check(parser, erw_TOKENTYPE_KEYWORD_UNION))
-		{
-			node->typedeclr.type = erw_parse_union(parser);
-		}
-		else if(erw_parser_check(parser, erw_TOKENTYPE_KEYWORD_ENUM))
-		{
-			node->typedeclr.type = erw_parse_enum(parser);
-		}
-		else
-		{
-			struct Str msg;
-			str_ctorfmt(
-				&msg,
-				"Expected %s, %s, %s, or %s. Got %s",
-				erw_TOKENTYPE_TYPE->name,
-				erw_TOKENTYPE_KEYWORD_STRUCT->name,
-				erw_TOKENTYPE_KEYWORD_UNION->name,
-				erw_TOKENTYPE_KEYWORD_ENUM->name,
-				parser->tokens[parser->current].type->name
-			);
+			break;
+		case erw_TOKENTYPE_KEYWORD_STRUCT:
+			type = erw_parse_struct(parser);
+			break;
+		case erw_TOKENTYPE_KEYWORD_UNION:
+			type = erw_parse_union(parser);
+			break;
+		case erw_TOKENTYPE_KEYWORD_ENUM:
+			type = erw_parse_enum(parser);
+			break;
+		default:
+			{
+				struct Str msg;
+				str_ctorfmt(
+					&msg,
+					"Expected %s, %s, %s, or %s. Got %s",
+					erw_tokentypeinfos[erw_TOKENTYPE_TYPE].name,
+					erw_tokentypeinfos[erw_TOKENTYPE_KEYWORD_STRUCT].name,
+					erw_tokentypeinfos[erw_TOKENTYPE_KEYWORD_UNION].name,
+					erw_tokentypeinfos[erw_TOKENTYPE_KEYWORD_ENUM].name,
+					erw_tokentypeinfos[erw_parser_type(parser)].name
+				);
 
-			erw_error(
-				msg.data, 
-				parser->lines[parser->tokens[parser->current]
-					.linenum - 1].data, 
-				parser->tokens[parser->current].linenum, 
-				parser->tokens[parser->current].column,
-				parser->tokens[parser->current].column 
-					+ vec_getsize(parser->tokens[parser->current].text) - 2
-			);
-			str_dtor(&msg);
+				erw_parser_error(parser, msg.data);
+				str_dtor(&msg);
+			}
+			break;
 		}
+
+		erw_parser_node(parser, node)->typedeclr.type = type;
 	}
 
 	erw_parser_expect(parser, erw_TOKENTYPE_END);
 	return node;
 }
 
-static struct erw_ASTNode* erw_parse_func(struct erw_Parser* parser);
-static struct erw_ASTNode* erw_parse_block(struct erw_Parser* parser)
+static uint32_t erw_parse_func(struct erw_Parser* parser);
+static uint32_t erw_parse_block(struct erw_Parser* parser)
 {
-	struct erw_ASTNode* node = erw_ast_new(erw_ASTNODETYPE_BLOCK, NULL);
+	uint32_t node = erw_ast_new(
+		parser->ast, 
+		erw_ASTNODETYPE_BLOCK, 
+		erw_AST_NOTOKEN
+	);
+	size_t mark = vec_getsize(parser->stack);
 	erw_parser_expect(parser, erw_TOKENTYPE_LCURLY);
-	while(!erw_parser_check(parser, erw_TOKENTYPE_RCURLY))
+	int returned = 0; //Statements after return aren't parsed
+	while(!returned && !erw_parser_check(parser, erw_TOKENTYPE_RCURLY))
 	{
-		if(erw_parser_check(parser, erw_TOKENTYPE_KEYWORD_FUNC))
-		{ 
-			vec_pushback(node->block.stmts, erw_parse_func(parser));
+		switch(erw_parser_peek(parser, erw_TOKENTYPE_KEYWORD_FUNC))
+		{
+		case erw_TOKENTYPE_KEYWORD_FUNC:
+			erw_parser_push(parser, erw_parse_func(parser));
 			continue; //Don't require semicolon
-		}
-		else if(erw_parser_check(parser, erw_TOKENTYPE_KEYWORD_TYPE))
-		{ 
-			vec_pushback(node->block.stmts, erw_parse_typedeclr(parser));
+			break;
+		case erw_TOKENTYPE_KEYWORD_TYPE:
+			erw_parser_push(parser, erw_parse_typedeclr(parser));
 			continue; //Don't require semicolon
-		}
-		else if(erw_parser_check(parser, erw_TOKENTYPE_KEYWORD_LET)
-			|| erw_parser_check(parser, erw_TOKENTYPE_KEYWORD_MUT))
-		{
-			vec_pushback(node->block.stmts, erw_parse_vardeclr(parser));
-		}
-		else if(erw_parser_check(parser, erw_TOKENTYPE_IDENT))
-		{ 
-			struct erw_ASTNode* ident = erw_parse_expr(parser);
-			if(parser->tokens[parser->current].type 
-				== erw_TOKENTYPE_OPERATOR_BITAND
-			|| parser->tokens[parser->current].type 
-				== erw_TOKENTYPE_OPERATOR_ACCESS
-			|| parser->tokens[parser->current].type 
-				==  erw_TOKENTYPE_OPERATOR_ASSIGN 
-			|| parser->tokens[parser->current].type 
-				== erw_TOKENTYPE_OPERATOR_ADDASSIGN 
-			|| parser->tokens[parser->current].type 
-				== erw_TOKENTYPE_OPERATOR_SUBASSIGN 
-			|| parser->tokens[parser->current].type 
-				== erw_TOKENTYPE_OPERATOR_MULASSIGN 
-			|| parser->tokens[parser->current].type 
-				== erw_TOKENTYPE_OPERATOR_DIVASSIGN 
-			|| parser->tokens[parser->current].type 
-				== erw_TOKENTYPE_OPERATOR_POWASSIGN 
-			|| parser->tokens[parser->current].type 
-				== erw_TOKENTYPE_OPERATOR_MODASSIGN)
+			break;
+		case erw_TOKENTYPE_KEYWORD_LET:
+		case erw_TOKENTYPE_KEYWORD_MUT:
+			erw_parser_push(parser, erw_parse_vardeclr(parser));
+			break;
+		case erw_TOKENTYPE_IDENT:
 			{
-				struct erw_ASTNode* assignnode = erw_ast_new(
-					erw_ASTNODETYPE_ASSIGNMENT,
-					&parser->tokens[parser->current]
-				);
-
-				parser->current++;
-				struct erw_ASTNode* expr = erw_parse_expr(parser);
-				assignnode->assignment.assignee = ident;
-				assignnode->assignment.expr = expr;
-				vec_pushback(node->block.stmts, assignnode);
+				uint32_t ident = erw_parse_expr(parser);
+				switch(erw_parser_type(parser))
+				{
+				case erw_TOKENTYPE_OPERATOR_BITAND:
+				case erw_TOKENTYPE_OPERATOR_ACCESS:
+				case erw_TOKENTYPE_OPERATOR_ASSIGN:
+				case erw_TOKENTYPE_OPERATOR_ADDASSIGN:
+				case erw_TOKENTYPE_OPERATOR_SUBASSIGN:
+				case erw_TOKENTYPE_OPERATOR_MULASSIGN:
+				case erw_TOKENTYPE_OPERATOR_DIVASSIGN:
+				case erw_TOKENTYPE_OPERATOR_POWASSIGN:
+				case erw_TOKENTYPE_OPERATOR_MODASSIGN:
+					{
+						uint32_t assignnode = erw_ast_new(
+							parser->ast,
+							erw_ASTNODETYPE_ASSIGNMENT,
+							erw_parser_index(parser)
+						);
+
+						parser->current++;
+						uint32_t expr = erw_parse_expr(parser);
+						struct erw_ASTNode* assign = erw_parser_node(
+							parser,
+							assignnode
+						);
+						assign->assignment.assignee = ident;
+						assign->assignment.expr = expr;
+						erw_parser_push(parser, assignnode);
+					}
+					break;
+				default:
+					//Assume struct access/function call
+					erw_parser_push(parser, ident); 
+					break;
+				}
 			}
-			else
+			break;
+		case erw_TOKENTYPE_KEYWORD_IF:
 			{
-				//Assume struct access/function call
-				vec_pushback(node->block.stmts, ident); 
-			}
-		}
-		else if(erw_parser_check(parser, erw_TOKENTYPE_KEYWORD_IF))
-		{ 
-			struct erw_ASTNode* ifnode = erw_ast_new(
-				erw_ASTNODETYPE_IF,
-				erw_parser_expect(parser, erw_TOKENTYPE_KEYWORD_IF)
-			);
-			
-			erw_parser_expect(parser, erw_TOKENTYPE_LPAREN);
-			ifnode->if_.expr = erw_parse_expr(parser);
-			erw_parser_expect(parser, erw_TOKENTYPE_RPAREN);
-			ifnode->if_.block = erw_parse_block(parser);
-			while(erw_parser_check(parser, erw_TOKENTYPE_KEYWORD_ELSEIF))
-			{ 
-				struct erw_ASTNode* elseifnode = erw_ast_new(
-					erw_ASTNODETYPE_ELSEIF,
-					erw_parser_expect(parser, erw_TOKENTYPE_KEYWORD_ELSEIF)
+				uint32_t ifnode = erw_ast_new(
+					parser->ast,
+					erw_ASTNODETYPE_IF,
+					erw_parser_expect(parser, erw_TOKENTYPE_KEYWORD_IF)
 				);
-				
+			
 				erw_parser_expect(parser, erw_TOKENTYPE_LPAREN);
-				elseifnode->elseif.expr = erw_parse_expr(parser);
+				uint32_t expr = erw_parse_expr(parser);
 				erw_parser_expect(parser, erw_TOKENTYPE_RPAREN);
-				elseifnode->elseif.block = erw_parse_block(parser);
-				vec_pushback(ifnode->if_.elseifs, elseifnode);
-			}
+				uint32_t block = erw_parse_block(parser);
+				erw_parser_node(parser, ifnode)->if_.expr = expr;
+				erw_parser_node(parser, ifnode)->if_.block = block;
+
+				size_t elseifmark = vec_getsize(parser->stack);
+				while(erw_parser_check(parser, erw_TOKENTYPE_KEYWORD_ELSEIF))
+				{ 
+					uint32_t elseifnode = erw_ast_new(
+						parser->ast,
+						erw_ASTNODETYPE_ELSEIF,
+						erw_parser_expect(
+							parser, 
+							erw_TOKENTYPE_KEYWORD_ELSEIF
+						)
+					);
+				
+					erw_parser_expect(parser, erw_TOKENTYPE_LPAREN);
+					expr = erw_parse_expr(parser);
+					erw_parser_expect(parser, erw_TOKENTYPE_RPAREN);
+					block = erw_parse_block(parser);
+					erw_parser_node(parser, elseifnode)->elseif.expr = expr;
+					erw_parser_node(parser, elseifnode)->elseif.block = block;
+					erw_parser_push(parser, elseifnode);
+				}
 
-			if(erw_parser_check(parser, erw_TOKENTYPE_KEYWORD_ELSE))
-			{ 
-				struct erw_ASTNode* elsenode = erw_ast_new(
-					erw_ASTNODETYPE_ELSE,
-					erw_parser_expect(parser, erw_TOKENTYPE_KEYWORD_ELSE)
+				struct erw_ASTList elseifs = erw_parser_poplist(
+					parser,
+					elseifmark
 				);
+				erw_parser_node(parser, ifnode)->if_.elseifs = elseifs;
+				if(erw_parser_check(parser, erw_TOKENTYPE_KEYWORD_ELSE))
+				{ 
+					uint32_t elsenode = erw_ast_new(
+						parser->ast,
+						erw_ASTNODETYPE_ELSE,
+						erw_parser_expect(
+							parser, 
+							erw_TOKENTYPE_KEYWORD_ELSE
+						)
+					);
+
+					block = erw_parse_block(parser);
+					erw_parser_node(parser, elsenode)->else_.block = block;
+					erw_parser_node(parser, ifnode)->if_.else_ = elsenode;
+				}
 
-				elsenode->else_.block = erw_parse_block(parser);
-				ifnode->if_.else_ = elsenode;
+				erw_parser_push(parser, ifnode);
+				continue; //Don't require semicolon
 			}
-
-			vec_pushback(node->block.stmts, ifnode);
-			continue; //Don't require semicolon
-		}
-		else if(erw_parser_check(parser, erw_TOKENTYPE_KEYWORD_RETURN))
-		{ 
-			struct erw_ASTNode* retnode = erw_ast_new(
-				erw_ASTNODETYPE_RETURN,
-				erw_parser_expect(parser, erw_TOKENTYPE_KEYWORD_RETURN)
-			);
-
-			if(!erw_parser_check(parser, erw_TOKENTYPE_END))
+			break;
+		case erw_TOKENTYPE_KEYWORD_RETURN:
 			{
-				retnode->return_.expr = erw_parse_expr(parser);
-			}
-
-			erw_parser_expect(parser, erw_TOKENTYPE_END);
-			vec_pushback(node->block.stmts, retnode);
-			break; //Don't parse any statements after return
-		}
-		else if(erw_parser_check(parser, erw_TOKENTYPE_FOREIGN))
-		{ 
-			/*
-			struct erw_ASTNode* foreign = erw_ast_newfromtoken(
-				erw_parser_expect(parser, erw_TOKENTYPE_FOREIGN)
-			);
+				uint32_t retnode = erw_ast_new(
+					parser->ast,
+					erw_ASTNODETYPE_RETURN,
+					erw_parser_expect(parser, erw_TOKENTYPE_KEYWORD_RETURN)
+				);
 
-			struct erw_ASTNode* argsnode = erw_ast_newfromnodetype(
-				erw_ASTNODETYPE_FUNC_ARGS
-			);
+				if(!erw_parser_check(parser, erw_TOKENTYPE_END))
+				{
+					uint32_t expr = erw_parse_expr(parser);
+					erw_parser_node(parser, retnode)->return_.expr = expr;
+				}
 
-			erw_parser_expect(parser, erw_TOKENTYPE_LPAREN);
-			while(!erw_parser_check(parser, erw_TOKENTYPE_RPAREN))
+				erw_parser_push(parser, retnode);
+				returned = 1;
+			}
+		case erw_TOKENTYPE_FOREIGN:
 			{
-				struct erw_ASTNode* argument = erw_parse_expression(parser);
-				erw_ast_addbranch(argsnode, argument);
+				/*
+				struct erw_ASTNode* foreign = erw_ast_newfromtoken(
+					erw_parser_expect(parser, erw_TOKENTYPE_FOREIGN)
+				);
 
-				if(erw_parser_check(parser, erw_TOKENTYPE_COMMA))
-				{
-					erw_parser_expect(parser, erw_TOKENTYPE_COMMA);
-				}
-				else
+				struct erw_ASTNode* argsnode = erw_ast_newfromnodetype(
+					erw_ASTNODETYPE_FUNC_ARGS
+				);
+
+				erw_parser_expect(parser, erw_TOKENTYPE_LPAREN);
+				while(!erw_parser_check(parser, erw_TOKENTYPE_RPAREN))
 				{
-					break;
+					struct erw_ASTNode* argument = erw_parse_expression(parser);
+					erw_ast_addbranch(argsnode, argument);
+
+					if(erw_parser_check(parser, erw_TOKENTYPE_COMMA))
+					{
+						erw_parser_expect(parser, erw_TOKENTYPE_COMMA);
+					}
+					else
+					{
+						break;
+					}
 				}
-			}
 
-			erw_parser_expect(parser, erw_TOKENTYPE_RPAREN);
-			erw_ast_addbranch(foreign, argsnode);
-			erw_ast_addbranch(blocknode, foreign);
-			*/
-		}
-		else if(erw_parser_check(parser, erw_TOKENTYPE_KEYWORD_DEFER))
-		{
-			struct erw_ASTNode* defernode = erw_ast_new(
-				erw_ASTNODETYPE_DEFER,
-				erw_parser_expect(parser, erw_TOKENTYPE_KEYWORD_DEFER)
-			);
+				erw_parser_expect(parser, erw_TOKENTYPE_RPAREN);
+				erw_ast_addbranch(foreign, argsnode);
+				erw_ast_addbranch(blocknode, foreign);
+				*/
+			}
+			break;
+		case erw_TOKENTYPE_KEYWORD_DEFER:
+			{
+				uint32_t defernode = erw_ast_new(
+					parser->ast,
+					erw_ASTNODETYPE_DEFER,
+					erw_parser_expect(parser, erw_TOKENTYPE_KEYWORD_DEFER)
+				);
 
-			defernode->defer.block = erw_parse_block(parser);
-			vec_pushback(node->block.stmts, defernode);
-			continue; //Don't require semicolon
-		}
-		else if(erw_parser_check(parser, erw_TOKENTYPE_KEYWORD_UNSAFE))
-		{
-			struct erw_ASTNode* unsafenode = erw_ast_new(
-				erw_ASTNODETYPE_UNSAFE,
-				erw_parser_expect(parser, erw_TOKENTYPE_KEYWORD_UNSAFE)
-			);
+				uint32_t block = erw_parse_block(parser);
+				erw_parser_node(parser, defernode)->defer.block = block;
+				erw_parser_push(parser, defernode);
+				continue; //Don't require semicolon
+			}
+			break;
+		case erw_TOKENTYPE_KEYWORD_UNSAFE:
+			{
+				uint32_t unsafenode = erw_ast_new(
+					parser->ast,
+					erw_ASTNODETYPE_UNSAFE,
+					erw_parser_expect(parser, erw_TOKENTYPE_KEYWORD_UNSAFE)
+				);
 
-			unsafenode->unsafe.block = erw_parse_block(parser);
-			vec_pushback(node->block.stmts, unsafenode);
-			continue; //Don't require semicolon
-		}
-		else if(erw_parser_check(parser, erw_TOKENTYPE_KEYWORD_WHILE))
-		{
-			struct erw_ASTNode* whilenode = erw_ast_new(
-				erw_ASTNODETYPE_WHILE,
-				erw_parser_expect(parser, erw_TOKENTYPE_KEYWORD_WHILE)
-			);
+				uint32_t block = erw_parse_block(parser);
+				erw_parser_node(parser, unsafenode)->unsafe.block = block;
+				erw_parser_push(parser, unsafenode);
+				continue; //Don't require semicolon
+			}
+			break;
+		case erw_TOKENTYPE_KEYWORD_WHILE:
+			{
+				uint32_t whilenode = erw_ast_new(
+					parser->ast,
+					erw_ASTNODETYPE_WHILE,
+					erw_parser_expect(parser, erw_TOKENTYPE_KEYWORD_WHILE)
+				);
 
-			erw_parser_expect(parser, erw_TOKENTYPE_LPAREN);
-			whilenode->while_.expr = erw_parse_expr(parser);
-			erw_parser_expect(parser, erw_TOKENTYPE_RPAREN);
-			whilenode->while_.block = erw_parse_block(parser);
-			vec_pushback(node->block.stmts, whilenode);
-			continue; //Don't require semicolon
-		}
-		else
-		{ 
-			struct Str msg;
-			str_ctorfmt(
-				&msg,
-				"Unexpected %s",
-				parser->tokens[parser->current].type->name
-			);
+				erw_parser_expect(parser, erw_TOKENTYPE_LPAREN);
+				uint32_t expr = erw_parse_expr(parser);
+				erw_parser_expect(parser, erw_TOKENTYPE_RPAREN);
+				uint32_t block = erw_parse_block(parser);
+				erw_parser_node(parser, whilenode)->while_.expr = expr;
+				erw_parser_node(parser, whilenode)->while_.block = block;
+				erw_parser_push(parser, whilenode);
+				continue; //Don't require semicolon
+			}
+			break;
+		default:
+			{
+				struct Str msg;
+				str_ctorfmt(
+					&msg,
+					"Unexpected %s",
+					erw_tokentypeinfos[erw_parser_type(parser)].name
+				);
 
-			erw_error(
-				msg.data, 
-				parser->lines[parser->tokens[parser->current].linenum - 1].data, 
-				parser->tokens[parser->current].linenum, 
-				parser->tokens[parser->current].column,
-				parser->tokens[parser->current].column 
-					+ vec_getsize(parser->tokens[parser->current].text) - 2
-			);
-			str_dtor(&msg);
+				erw_parser_error(parser, msg.data);
+				str_dtor(&msg);
+			}
+			break;
 		}
 
 		erw_parser_expect(parser, erw_TOKENTYPE_END);
 	}
 
 	erw_parser_expect(parser, erw_TOKENTYPE_RCURLY);
+	struct erw_ASTList stmts = erw_parser_poplist(parser, mark);
+	erw_parser_node(parser, node)->block.stmts = stmts;
 	return node;
 }
 
-static struct erw_ASTNode* erw_parse_func(struct erw_Parser* parser)
+static uint32_t erw_parse_func(struct erw_Parser* parser)
 {
-	struct erw_ASTNode* node = erw_ast_new(
+	uint32_t node = erw_ast_new(
+		parser->ast,
 		erw_ASTNODETYPE_FUNCDEF, 
 		erw_parser_expect(parser, erw_TOKENTYPE_KEYWORD_FUNC)
 	);
 
-	node->funcdef.name = erw_parser_expect(parser, erw_TOKENTYPE_IDENT);
+	erw_parser_node(parser, node)->funcdef.name = erw_parser_expect(
+		parser, 
+		erw_TOKENTYPE_IDENT
+	);
 	erw_parser_expect(parser, erw_TOKENTYPE_OPERATOR_DECLR);
-	erw_parse_varlist(parser, node->funcdef.params);
+	struct erw_ASTList params = erw_parse_varlist(parser);
+	erw_parser_node(parser, node)->funcdef.params = params;
 	if(erw_parser_check(parser, erw_TOKENTYPE_OPERATOR_RETURN))
 	{
 		erw_parser_expect(parser, erw_TOKENTYPE_OPERATOR_RETURN);
-		node->funcdef.type = erw_parse_type(parser);
+		uint32_t type = erw_parse_type(parser);
+		erw_parser_node(parser, node)->funcdef.type = type;
 	}
 
-	node->funcdef.block = erw_parse_block(parser);
+	uint32_t block = erw_parse_block(parser);
+	erw_parser_node(parser, node)->funcdef.block = block;
 	return node;
 }
 
-struct erw_ASTNode* erw_parse(
-	Vec(struct erw_Token) tokens,
-	Vec(struct Str) lines)
+struct erw_AST erw_parse(
+	const struct erw_TokenStream* tokens,
+	struct erw_Lines* lines)
 {
 	log_assert(tokens, "is NULL");
 	log_assert(lines, "is NULL");
 
+	struct erw_AST ast;
+	erw_ast_ctor(&ast, tokens);
 	struct erw_Parser parser = {
 		.tokens = tokens,
 		.lines = lines,
+		.ast = &ast,
+		.stack = vec_ctor(uint32_t, 0),
 		.current = 0
 	};
 
-	struct erw_ASTNode* root = erw_ast_new(erw_ASTNODETYPE_START, NULL);
-	while(parser.current < vec_getsize(tokens))
+	while(parser.current < tokens->numtokens)
 	{
 		if(erw_parser_check(&parser, erw_TOKENTYPE_KEYWORD_FUNC))
 		{
-			vec_pushback(root->start.children, erw_parse_func(&parser));
+			erw_parser_push(&parser, erw_parse_func(&parser));
 		}
 		else if(erw_parser_check(&parser, erw_TOKENTYPE_KEYWORD_TYPE))
 		{
-			vec_pushback(root->start.children, erw_parse_typedeclr(&parser));
+			erw_parser_push(&parser, erw_parse_typedeclr(&parser));
 		}
 		else
 		{
@@ -1163,21 +1260,15 @@ struct erw_ASTNode* erw_parse(
 			str_ctorfmt(
 				&msg,
 				"Unexpected %s",
-				tokens[parser.current].type->name
+				erw_tokentypeinfos[erw_parser_type(&parser)].name
 			);
 
-			erw_error(
-				msg.data,
-				lines[tokens[parser.current].linenum - 1].data,
-				tokens[parser.current].linenum,
-				tokens[parser.current].column,
-				tokens[parser.current].column 
-					+ vec_getsize(tokens[parser.current].text) - 2
-			);
+			erw_parser_error(&parser, msg.data);
 			str_dtor(&msg);
 		}
 	}
 
-	return root;
+	ast.nodes[0].start.children = erw_parser_poplist(&parser, 0);
+	vec_dtor(parser.stack);
+	return ast;
 }
-
@@ -21,10 +21,11 @@
 #define ERW_PARSER_H
 
 #include "erw_tokenizer.h"
+#include "erw_ast.h"
 
-struct erw_ASTNode* erw_parse(
-	Vec(struct erw_Token) tokens,
-	Vec(struct Str) lines
+struct erw_AST erw_parse(
+	const struct erw_TokenStream* tokens,
+	struct erw_Lines* lines
 );
 
 #endif
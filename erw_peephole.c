@@ -0,0 +1,300 @@
+/*
+	Copyright (C) 2017 Erik Wallström
+
+	This file is part of Erwall.
+
+	Erwall is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Erwall is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Erwall.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "erw_peephole.h"
+#include "erw_ir.h"
+#include "log.h"
+
+//Replaces reads of t after 'mov t, s' with s, as long as both registers
+//keep their values and nothing else can jump in between
+static void erw_propagatecopy(
+	Vec(struct erw_IRInstruction) instructions,
+	size_t i)
+{
+	size_t to = instructions[i].operands[0];
+	size_t from = instructions[i].operands[1];
+	for(size_t j = i + 1; j < vec_getsize(instructions); j++)
+	{
+		struct erw_IRInstruction* instruction = &instructions[j];
+		if(instruction->istarget)
+		{
+			return;
+		}
+
+		for(size_t k = 0; k < erw_IR_MAXOPERANDS; k++)
+		{
+			if(erw_ir_isread(instruction, k) && instruction->operands[k] == to)
+			{
+				instruction->operands[k] = from;
+			}
+		}
+
+		//Implicit reads, like the arguments of a CALL, can't be replaced
+		enum erw_InstructionID id = instruction->id;
+		if(erw_ir_reads(instruction, to)
+			|| erw_ir_writes(instruction, to)
+			|| erw_ir_writes(instruction, from)
+			|| erw_ir_isbranch(id)
+			|| id == erw_INSTRUCTIONID_CALL
+			|| id == erw_INSTRUCTIONID_RET
+			|| id == erw_INSTRUCTIONID_HALT)
+		{
+			return;
+		}
+	}
+}
+
+//Index of the next instruction that wasn't removed, or SIZE_MAX if something
+//can jump in between
+static size_t erw_next(Vec(struct erw_IRInstruction) instructions, size_t i)
+{
+	for(size_t j = i + 1; j < vec_getsize(instructions); j++)
+	{
+		if(instructions[j].istarget)
+		{
+			return SIZE_MAX;
+		}
+		else if(!instructions[j].isremoved)
+		{
+			return j;
+		}
+	}
+
+	return SIZE_MAX;
+}
+
+//Returns the index after the instructions that were replaced by fused
+static size_t erw_fuse(
+	Vec(struct erw_IRInstruction) instructions,
+	Vec(uint64_t) live,
+	size_t i,
+	struct erw_IRInstruction* fused)
+{
+	struct erw_IRInstruction* first = &instructions[i];
+	*fused = *first;
+
+	//Sequences can't be fused if something jumps into the middle of them
+	if(first->id == erw_INSTRUCTIONID_PUSH && first->operands[0] == 0)
+	{
+		//PUSH r0, PUSH r1, ... -> PUSHN
+		size_t count = 1;
+		size_t last = i;
+		size_t j;
+		while((j = erw_next(instructions, last)) != SIZE_MAX
+			&& instructions[j].id == erw_INSTRUCTIONID_PUSH
+			&& instructions[j].operands[0] == count)
+		{
+			count++;
+			last = j;
+		}
+
+		if(count > 1)
+		{
+			fused->id = erw_INSTRUCTIONID_PUSHN;
+			fused->operands[0] = count;
+			return last + 1;
+		}
+	}
+	else if(first->id == erw_INSTRUCTIONID_POP && first->operands[0] > 0)
+	{
+		//..., POP r1, POP r0 -> POPN
+		size_t count = first->operands[0] + 1;
+		size_t popped = 1;
+		size_t last = i;
+		size_t j;
+		while(popped < count
+			&& (j = erw_next(instructions, last)) != SIZE_MAX
+			&& instructions[j].id == erw_INSTRUCTIONID_POP
+			&& instructions[j].operands[0] == count - 1 - popped)
+		{
+			popped++;
+			last = j;
+		}
+
+		if(popped == count)
+		{
+			fused->id = erw_INSTRUCTIONID_POPN;
+			fused->operands[0] = count;
+			return last + 1;
+		}
+	}
+
+	size_t index = erw_next(instructions, i);
+	if(index == SIZE_MAX)
+	{
+		return i + 1;
+	}
+
+	struct erw_IRInstruction* second = &instructions[index];
+	if((first->id == erw_INSTRUCTIONID_CMP
+			|| first->id == erw_INSTRUCTIONID_UCMP)
+		&& second->id >= erw_INSTRUCTIONID_JNE
+		&& second->id <= erw_INSTRUCTIONID_JL)
+	{
+		//CMP, Jcc -> CMPJcc
+		fused->id = (first->id == erw_INSTRUCTIONID_CMP
+				? erw_INSTRUCTIONID_CMPJNE
+				: erw_INSTRUCTIONID_UCMPJNE)
+			+ (second->id - erw_INSTRUCTIONID_JNE);
+		fused->operands[2] = second->operands[0];
+		return index + 1;
+	}
+	else if(first->id <= erw_INSTRUCTIONID_LOADL64
+		&& first->operands[1] <= INT32_MAX
+		&& (second->id == erw_INSTRUCTIONID_ADD
+			|| second->id == erw_INSTRUCTIONID_SUB))
+	{
+		//LOADL rt, imm, ADD rd, ra, rt -> ADDI rd, ra, imm
+		size_t tmp = first->operands[0];
+		int64_t imm = first->operands[1];
+		size_t other;
+		if(second->operands[2] == tmp && second->operands[1] != tmp)
+		{
+			other = second->operands[1];
+			imm = second->id == erw_INSTRUCTIONID_SUB ? -imm : imm;
+		}
+		else if(second->id == erw_INSTRUCTIONID_ADD
+			&& second->operands[1] == tmp
+			&& second->operands[2] != tmp)
+		{
+			other = second->operands[2];
+		}
+		else
+		{
+			return i + 1;
+		}
+
+		if(second->operands[0] != tmp
+			&& erw_ir_isset(live + index * erw_IR_REGISTERWORDS, tmp))
+		{
+			return i + 1;
+		}
+
+		fused->id = erw_INSTRUCTIONID_ADDI;
+		fused->operands[0] = second->operands[0];
+		fused->operands[1] = other;
+		fused->operands[2] = (uint32_t)imm;
+		return index + 1;
+	}
+
+	return i + 1;
+}
+
+void erw_peephole_optimize(struct erw_Bytecode* bytecode)
+{
+	log_assert(bytecode, "is NULL");
+
+	Vec(struct erw_IRInstruction) instructions = erw_ir_decode(bytecode);
+	size_t numinstructions = vec_getsize(instructions);
+	for(size_t i = 0; i < numinstructions; i++)
+	{
+		if(instructions[i].id == erw_INSTRUCTIONID_MOV
+			&& instructions[i].operands[0] != instructions[i].operands[1])
+		{
+			erw_propagatecopy(instructions, i);
+		}
+	}
+
+	//Remove moves and loads nothing reads, which copy propagation leaves
+	//behind in most expressions
+	Vec(uint64_t) live = erw_ir_liveness(
+		instructions,
+		0,
+		numinstructions,
+		erw_IR_REGISTERWORDS,
+		erw_ir_registerusedef,
+		NULL
+	);
+	for(size_t i = 0; i < numinstructions; i++)
+	{
+		struct erw_IRInstruction* instruction = &instructions[i];
+		if(instruction->id <= erw_INSTRUCTIONID_LOADL64
+			|| instruction->id == erw_INSTRUCTIONID_MOV
+			|| instruction->id == erw_INSTRUCTIONID_LOAD)
+		{
+			size_t reg = instruction->operands[0];
+			instruction->isremoved = !erw_ir_isset(
+					live + i * erw_IR_REGISTERWORDS,
+					reg
+				)
+				|| (instruction->id == erw_INSTRUCTIONID_MOV
+					&& instruction->operands[1] == reg);
+		}
+	}
+
+	//op rt, ..., MOV rd, rt -> op rd, ...
+	for(size_t i = 1; i < numinstructions; i++)
+	{
+		struct erw_IRInstruction* mov = &instructions[i];
+		if(mov->id != erw_INSTRUCTIONID_MOV
+			|| mov->isremoved
+			|| mov->istarget
+			|| erw_ir_isset(live + i * erw_IR_REGISTERWORDS, mov->operands[1]))
+		{
+			continue;
+		}
+
+		size_t j = i - 1;
+		while(j && instructions[j].isremoved && !instructions[j].istarget)
+		{
+			j--;
+		}
+
+		if(!instructions[j].isremoved
+			&& erw_ir_iswritten(&instructions[j], 0)
+			&& instructions[j].operands[0] == mov->operands[1])
+		{
+			instructions[j].operands[0] = mov->operands[0];
+			mov->isremoved = 1;
+		}
+	}
+
+	vec_dtor(live);
+	live = erw_ir_liveness(
+		instructions,
+		0,
+		numinstructions,
+		erw_IR_REGISTERWORDS,
+		erw_ir_registerusedef,
+		NULL
+	);
+
+	Vec(struct erw_IRInstruction) optimized = vec_ctor(
+		struct erw_IRInstruction,
+		numinstructions
+	);
+	size_t i = 0;
+	while(i < numinstructions)
+	{
+		if(instructions[i].isremoved)
+		{
+			i++;
+			continue;
+		}
+
+		struct erw_IRInstruction fused;
+		i = erw_fuse(instructions, live, i, &fused);
+		vec_pushback(optimized, fused);
+	}
+
+	erw_ir_encode(bytecode, instructions, optimized);
+	vec_dtor(optimized);
+	vec_dtor(live);
+	vec_dtor(instructions);
+}
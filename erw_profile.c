@@ -0,0 +1,288 @@
+/*
+	Copyright (C) 2017 Erik Wallström
+
+	This file is part of Erwall.
+
+	Erwall is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Erwall is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Erwall.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "erw_profile.h"
+#include "log.h"
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+struct erw_ProfileEntry
+{
+	size_t index;
+	uint64_t count;
+};
+
+struct erw_Profile* erw_profile_ctor(
+	struct erw_Profile* self, 
+	size_t numinstructions)
+{
+	log_assert(self, "is NULL");
+
+	memset(self->opcodes, 0, sizeof(self->opcodes));
+	self->executions = vec_ctor(uint64_t, numinstructions);
+	vec_expand(self->executions, 0, numinstructions);
+	memset(self->executions, 0, numinstructions * sizeof(uint64_t));
+	self->funcs = vec_ctor(struct erw_ProfileFunc, numinstructions);
+	vec_expand(self->funcs, 0, numinstructions);
+	memset(self->funcs, 0, numinstructions * sizeof(struct erw_ProfileFunc));
+	self->frames = vec_ctor(struct erw_ProfileFrame, 0);
+	return self;
+}
+
+uint64_t erw_profile_ticks(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	struct timespec ts;
+	timespec_get(&ts, TIME_UTC);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+void erw_profile_enter(struct erw_Profile* self, size_t func)
+{
+	log_assert(self, "is NULL");
+	log_assert(func < vec_getsize(self->funcs), "invalid function (%zu)", func);
+
+	self->funcs[func].calls++;
+	self->funcs[func].depth++;
+	struct erw_ProfileFrame frame = {
+		.func = func,
+		.start = erw_profile_ticks()
+	};
+	vec_pushback(self->frames, frame);
+}
+
+void erw_profile_leave(struct erw_Profile* self)
+{
+	log_assert(self, "is NULL");
+	log_assert(vec_getsize(self->frames), "no active call");
+
+	uint64_t ticks = erw_profile_ticks();
+	struct erw_ProfileFrame frame = self->frames[vec_getsize(self->frames) - 1];
+	vec_popback(self->frames);
+
+	uint64_t elapsed = ticks - frame.start;
+	struct erw_ProfileFunc* func = &self->funcs[frame.func];
+	func->selfticks += elapsed - frame.childticks;
+	if(!--func->depth)
+	{
+		func->totalticks += elapsed;
+	}
+
+	if(vec_getsize(self->frames))
+	{
+		self->frames[vec_getsize(self->frames) - 1].childticks += elapsed;
+	}
+}
+
+static int erw_profileentry_compare(const void* a, const void* b)
+{
+	const struct erw_ProfileEntry* entry1 = a;
+	const struct erw_ProfileEntry* entry2 = b;
+	if(entry1->count != entry2->count)
+	{
+		return (entry1->count < entry2->count)
+			- (entry1->count > entry2->count);
+	}
+
+	return (entry1->index > entry2->index) - (entry1->index < entry2->index);
+}
+
+static void erw_printposition(
+	struct erw_BytecodeImage* image,
+	size_t offset)
+{
+	const struct erw_BytecodeFuncEntry* func = erw_bytecodeimage_findfunc(
+		image,
+		offset
+	);
+	const struct erw_BytecodePositionEntry* position = 
+		erw_bytecodeimage_findposition(image, offset);
+	printf("%s", func ? image->constants + func->name : "?");
+	if(position)
+	{
+		printf(
+			" (line %" PRIu32 ", column %" PRIu32 ")", 
+			position->linenum, 
+			position->column
+		);
+	}
+
+	putchar('\n');
+}
+
+static double erw_percent(uint64_t count, uint64_t total)
+{
+	return total ? count * 100.0 / total : 0.0;
+}
+
+void erw_profile_print(
+	struct erw_Profile* self, 
+	struct erw_BytecodeImage* image,
+	size_t maxentries)
+{
+	log_assert(self, "is NULL");
+	log_assert(image, "is NULL");
+	log_assert(
+		vec_getsize(self->executions) == image->numinstructions, 
+		"profile of another image"
+	);
+
+	//Functions, by the time spent in them
+	Vec(struct erw_ProfileEntry) entries = vec_ctor(
+		struct erw_ProfileEntry, 
+		image->numfunctions
+	);
+	uint64_t totalticks = 0;
+	for(size_t i = 0; i < image->numfunctions; i++)
+	{
+		struct erw_ProfileFunc* func = &self->funcs[image->functions[i].offset];
+		if(func->calls)
+		{
+			struct erw_ProfileEntry entry = {
+				.index = i, 
+				.count = func->selfticks
+			};
+			vec_pushback(entries, entry);
+			totalticks += func->selfticks;
+		}
+	}
+
+	qsort(
+		entries, 
+		vec_getsize(entries), 
+		sizeof(struct erw_ProfileEntry), 
+		erw_profileentry_compare
+	);
+	printf(
+		"Functions:\n\n%8s %14s %14s %10s  %s\n", 
+		"self", 
+		"self " erw_PROFILE_TICKS, 
+		"total " erw_PROFILE_TICKS, 
+		"calls", 
+		"function"
+	);
+	for(size_t i = 0; i < vec_getsize(entries) && i < maxentries; i++)
+	{
+		size_t offset = image->functions[entries[i].index].offset;
+		struct erw_ProfileFunc* func = &self->funcs[offset];
+		printf(
+			"%7.2f%% %14" PRIu64 " %14" PRIu64 " %10" PRIu64 "  ",
+			erw_percent(func->selfticks, totalticks),
+			func->selfticks,
+			func->totalticks,
+			func->calls
+		);
+		erw_printposition(image, offset);
+	}
+
+	//Hot spots, by how often each instruction ran
+	vec_clear(entries);
+	uint64_t total = 0;
+	for(size_t i = 0; i < vec_getsize(self->executions); i++)
+	{
+		if(self->executions[i])
+		{
+			struct erw_ProfileEntry entry = {
+				.index = i, 
+				.count = self->executions[i]
+			};
+			vec_pushback(entries, entry);
+			total += self->executions[i];
+		}
+	}
+
+	qsort(
+		entries, 
+		vec_getsize(entries), 
+		sizeof(struct erw_ProfileEntry), 
+		erw_profileentry_compare
+	);
+	printf(
+		"\nHot spots (%" PRIu64 " instructions executed):\n\n"
+			"%8s %14s %8s  %-8s  %s\n", 
+		total,
+		"", 
+		"executions", 
+		"offset", 
+		"opcode", 
+		"function"
+	);
+	for(size_t i = 0; i < vec_getsize(entries) && i < maxentries; i++)
+	{
+		size_t offset = entries[i].index;
+		printf(
+			"%7.2f%% %14" PRIu64 " %8zu  %-8s  ",
+			erw_percent(entries[i].count, total),
+			entries[i].count,
+			offset,
+			erw_instructioninfos[image->instructions[offset]].name
+		);
+		erw_printposition(image, offset);
+	}
+
+	//Opcodes
+	vec_clear(entries);
+	for(size_t i = 0; i < erw_INSTRUCTIONID_COUNT; i++)
+	{
+		if(self->opcodes[i])
+		{
+			struct erw_ProfileEntry entry = {
+				.index = i, 
+				.count = self->opcodes[i]
+			};
+			vec_pushback(entries, entry);
+		}
+	}
+
+	qsort(
+		entries, 
+		vec_getsize(entries), 
+		sizeof(struct erw_ProfileEntry), 
+		erw_profileentry_compare
+	);
+	printf("\nOpcodes:\n\n%8s %14s  %s\n", "", "executions", "opcode");
+	for(size_t i = 0; i < vec_getsize(entries); i++)
+	{
+		printf(
+			"%7.2f%% %14" PRIu64 "  %s\n",
+			erw_percent(entries[i].count, total),
+			entries[i].count,
+			erw_instructioninfos[entries[i].index].name
+		);
+	}
+
+	vec_dtor(entries);
+}
+
+void erw_profile_dtor(struct erw_Profile* self)
+{
+	log_assert(self, "is NULL");
+	vec_dtor(self->executions);
+	vec_dtor(self->funcs);
+	vec_dtor(self->frames);
+}
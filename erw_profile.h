@@ -0,0 +1,73 @@
+/*
+	Copyright (C) 2017 Erik Wallström
+
+	This file is part of Erwall.
+
+	Erwall is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Erwall is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Erwall.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ERW_PROFILE_H
+#define ERW_PROFILE_H
+
+#include "erw_bytecode.h"
+
+//Ticks are cycles of the time stamp counter on x86, nanoseconds elsewhere
+#if defined(__x86_64__) || defined(__i386__)
+#define erw_PROFILE_TICKS "cycles"
+#else
+#define erw_PROFILE_TICKS "ns"
+#endif
+
+struct erw_ProfileFunc
+{
+	uint64_t calls;
+	uint64_t selfticks; //Not counting the functions it calls
+	uint64_t totalticks; //Recursive calls are only counted once
+	size_t depth; //Active calls
+};
+
+struct erw_ProfileFrame
+{
+	size_t func; //Offset of the called function
+	uint64_t start;
+	uint64_t childticks; //Spent in the functions it called
+};
+
+//Filled in by erw_interpreter_call when it is set in erw_Interpreter.profile.
+//Counters are indexed by offsets into the instruction stream.
+struct erw_Profile
+{
+	uint64_t opcodes[erw_INSTRUCTIONID_COUNT]; //Executions per instruction
+	Vec(uint64_t) executions; //Per offset
+	Vec(struct erw_ProfileFunc) funcs; //Per offset, used at function entries
+	Vec(struct erw_ProfileFrame) frames;
+};
+
+struct erw_Profile* erw_profile_ctor(
+	struct erw_Profile* self, 
+	size_t numinstructions
+);
+uint64_t erw_profile_ticks(void);
+void erw_profile_enter(struct erw_Profile* self, size_t func);
+void erw_profile_leave(struct erw_Profile* self);
+//Prints the hottest functions, instructions and opcodes. Instructions are 
+//mapped to the source through the position table of the image.
+void erw_profile_print(
+	struct erw_Profile* self, 
+	struct erw_BytecodeImage* image,
+	size_t maxentries
+);
+void erw_profile_dtor(struct erw_Profile* self);
+
+#endif
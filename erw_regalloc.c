@@ -0,0 +1,400 @@
+/*
+	Copyright (C) 2017 Erik Wallström
+
+	This file is part of Erwall.
+
+	Erwall is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Erwall is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Erwall.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "erw_regalloc.h"
+#include "erw_ir.h"
+#include "log.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define erw_SPILLED SIZE_MAX
+
+//Instructions of a function in which a slot is live or accessed
+struct erw_Interval
+{
+	size_t slot;
+	size_t start;
+	size_t end; //Inclusive
+	size_t reg; //erw_SPILLED if the slot stays in the frame
+};
+
+static void erw_slotusedef(
+	const struct erw_IRInstruction* instruction,
+	uint64_t* use,
+	uint64_t* def,
+	void* udata)
+{
+	(void)udata;
+	if(instruction->id == erw_INSTRUCTIONID_LOAD)
+	{
+		erw_ir_set(use, instruction->operands[1]);
+	}
+	else if(instruction->id == erw_INSTRUCTIONID_STORE)
+	{
+		erw_ir_set(def, instruction->operands[0]);
+	}
+}
+
+static int erw_interval_compare(const void* a, const void* b)
+{
+	const struct erw_Interval* interval1 = a;
+	const struct erw_Interval* interval2 = b;
+	if(interval1->start != interval2->start)
+	{
+		return (interval1->start > interval2->start) 
+			- (interval1->start < interval2->start);
+	}
+
+	return (interval1->slot > interval2->slot) 
+		- (interval1->slot < interval2->slot);
+}
+
+//Registers below the returned one hold temporaries, arguments or results
+static size_t erw_numtemporaries(
+	Vec(struct erw_IRInstruction) decoded,
+	size_t begin,
+	size_t end)
+{
+	size_t ret = 0;
+	for(size_t i = begin; i < end; i++)
+	{
+		const struct erw_IRInstruction* instruction = &decoded[i];
+		const char* operands = erw_instructioninfos[instruction->id].operands;
+		for(size_t j = 0; operands[j]; j++)
+		{
+			if(operands[j] == 'r' && instruction->operands[j] >= ret)
+			{
+				ret = instruction->operands[j] + 1;
+			}
+		}
+
+		size_t implicit = 0;
+		if(instruction->id == erw_INSTRUCTIONID_PUSHN
+			|| instruction->id == erw_INSTRUCTIONID_POPN)
+		{
+			implicit = instruction->operands[0];
+		}
+		else if(instruction->id == erw_INSTRUCTIONID_CALL)
+		{
+			implicit = instruction->numargs;
+		}
+		else if(instruction->id == erw_INSTRUCTIONID_RET
+			|| instruction->id == erw_INSTRUCTIONID_HALT)
+		{
+			implicit = 1;
+		}
+
+		ret = implicit > ret ? implicit : ret;
+	}
+
+	return ret;
+}
+
+//Linear scan, when the registers run out the interval that ends last is
+//spilled. Returns the intervals sorted by start.
+static Vec(struct erw_Interval) erw_linearscan(
+	Vec(uint64_t) live,
+	Vec(struct erw_IRInstruction) decoded,
+	size_t begin,
+	size_t end,
+	size_t numslots,
+	size_t firstreg)
+{
+	size_t numwords = (numslots + 63) / 64;
+	Vec(struct erw_Interval) ret = vec_ctor(struct erw_Interval, numslots);
+	vec_expand(ret, 0, numslots);
+	for(size_t i = 0; i < numslots; i++)
+	{
+		ret[i] = (struct erw_Interval){
+			.slot = i, 
+			.start = SIZE_MAX, 
+			.end = 0,
+			.reg = erw_SPILLED
+		};
+	}
+
+	for(size_t i = begin; i < end; i++)
+	{
+		size_t accessed = SIZE_MAX;
+		if(decoded[i].id == erw_INSTRUCTIONID_LOAD)
+		{
+			accessed = decoded[i].operands[1];
+		}
+		else if(decoded[i].id == erw_INSTRUCTIONID_STORE)
+		{
+			accessed = decoded[i].operands[0];
+		}
+
+		if(accessed != SIZE_MAX)
+		{
+			log_assert(accessed < numslots, "invalid slot (%zu)", accessed);
+			ret[accessed].start = i < ret[accessed].start 
+				? i 
+				: ret[accessed].start;
+			ret[accessed].end = i;
+		}
+
+		const uint64_t* row = live + (i - begin) * numwords;
+		for(size_t j = 0; j < numwords; j++)
+		{
+			for(uint64_t word = row[j]; word; word &= word - 1)
+			{
+				size_t slot = j * 64 + __builtin_ctzll(word);
+				ret[slot].start = i < ret[slot].start ? i : ret[slot].start;
+				ret[slot].end = i;
+			}
+		}
+	}
+
+	//Slots that are never used don't need anything
+	size_t numintervals = 0;
+	for(size_t i = 0; i < numslots; i++)
+	{
+		if(ret[i].start != SIZE_MAX)
+		{
+			ret[numintervals++] = ret[i];
+		}
+	}
+
+	vec_collapse(ret, numintervals, numslots - numintervals);
+	qsort(ret, numintervals, sizeof(struct erw_Interval), erw_interval_compare);
+
+	Vec(size_t) active = vec_ctor(size_t, 0);
+	Vec(size_t) free_ = vec_ctor(size_t, erw_NUMREGISTERS);
+	for(size_t i = erw_NUMREGISTERS; i-- > firstreg;)
+	{
+		vec_pushback(free_, i);
+	}
+
+	for(size_t i = 0; i < numintervals; i++)
+	{
+		for(size_t j = vec_getsize(active); j-- > 0;)
+		{
+			if(ret[active[j]].end < ret[i].start)
+			{
+				vec_pushback(free_, ret[active[j]].reg);
+				vec_remove(active, j);
+			}
+		}
+
+		if(vec_getsize(free_))
+		{
+			ret[i].reg = free_[vec_getsize(free_) - 1];
+			vec_popback(free_);
+			vec_pushback(active, i);
+			continue;
+		}
+
+		size_t last = SIZE_MAX;
+		for(size_t j = 0; j < vec_getsize(active); j++)
+		{
+			if(last == SIZE_MAX || ret[active[j]].end > ret[active[last]].end)
+			{
+				last = j;
+			}
+		}
+
+		if(last != SIZE_MAX && ret[active[last]].end > ret[i].end)
+		{
+			ret[i].reg = ret[active[last]].reg;
+			ret[active[last]].reg = erw_SPILLED;
+			active[last] = i;
+		}
+	}
+
+	vec_dtor(free_);
+	vec_dtor(active);
+	return ret;
+}
+
+static void erw_allocatefunc(
+	Vec(struct erw_IRInstruction) decoded,
+	size_t begin,
+	size_t end,
+	Vec(struct erw_IRInstruction)* allocated)
+{
+	log_assert(
+		decoded[begin].id == erw_INSTRUCTIONID_ENTER,
+		"function doesn't start with ENTER"
+	);
+
+	size_t numslots = decoded[begin].operands[0];
+	size_t firstreg = erw_numtemporaries(decoded, begin, end);
+	if(!numslots || firstreg >= erw_NUMREGISTERS)
+	{
+		vec_pushbackwitharr(*allocated, decoded + begin, end - begin);
+		return;
+	}
+
+	size_t numwords = (numslots + 63) / 64;
+	Vec(uint64_t) live = erw_ir_liveness(
+		decoded,
+		begin,
+		end,
+		numwords,
+		erw_slotusedef,
+		NULL
+	);
+	Vec(struct erw_Interval) intervals = erw_linearscan(
+		live,
+		decoded,
+		begin,
+		end,
+		numslots,
+		firstreg
+	);
+
+	//Slots that stay in the frame are packed at the start of it
+	Vec(size_t) regs = vec_ctor(size_t, numslots);
+	Vec(size_t) slots = vec_ctor(size_t, numslots);
+	vec_expand(regs, 0, numslots);
+	vec_expand(slots, 0, numslots);
+	size_t numspilled = 0;
+	for(size_t i = 0; i < vec_getsize(intervals); i++)
+	{
+		regs[intervals[i].slot] = intervals[i].reg;
+		if(intervals[i].reg == erw_SPILLED)
+		{
+			slots[intervals[i].slot] = numspilled++;
+		}
+	}
+
+	struct erw_IRInstruction enter = decoded[begin];
+	enter.operands[0] = numspilled;
+	vec_pushback(*allocated, enter);
+
+	//ENTER zeroes the slots, so registers that may be read before they are
+	//written have to be zeroed as well
+	for(size_t i = 0; i < vec_getsize(intervals); i++)
+	{
+		size_t slot = intervals[i].slot;
+		if(regs[slot] != erw_SPILLED && erw_ir_isset(live, slot))
+		{
+			struct erw_IRInstruction zero = {
+				.id = erw_INSTRUCTIONID_LOADL8,
+				.operands = {regs[slot], 0},
+				.offset = erw_IR_INSERTED
+			};
+			vec_pushback(*allocated, zero);
+		}
+	}
+
+	for(size_t i = begin + 1; i < end; i++)
+	{
+		struct erw_IRInstruction instruction = decoded[i];
+		if(instruction.id == erw_INSTRUCTIONID_LOAD)
+		{
+			size_t slot = instruction.operands[1];
+			if(regs[slot] != erw_SPILLED)
+			{
+				instruction.id = erw_INSTRUCTIONID_MOV;
+				instruction.operands[1] = regs[slot];
+			}
+			else
+			{
+				instruction.operands[1] = slots[slot];
+			}
+		}
+		else if(instruction.id == erw_INSTRUCTIONID_STORE)
+		{
+			size_t slot = instruction.operands[0];
+			if(regs[slot] != erw_SPILLED)
+			{
+				instruction.id = erw_INSTRUCTIONID_MOV;
+				instruction.operands[0] = regs[slot];
+			}
+			else
+			{
+				instruction.operands[0] = slots[slot];
+			}
+		}
+		else if(instruction.id == erw_INSTRUCTIONID_CALL)
+		{
+			//The callee may overwrite the registers, so the ones that are still
+			//needed are saved like temporaries. Jumps to the CALL go to the
+			//first PUSH.
+			const uint64_t* row = live + (i - begin) * numwords;
+			for(size_t j = 0; j < vec_getsize(intervals); j++)
+			{
+				size_t slot = intervals[j].slot;
+				if(regs[slot] != erw_SPILLED && erw_ir_isset(row, slot))
+				{
+					struct erw_IRInstruction push = {
+						.id = erw_INSTRUCTIONID_PUSH,
+						.operands = {regs[slot]},
+						.offset = instruction.offset
+					};
+					vec_pushback(*allocated, push);
+					instruction.offset = erw_IR_INSERTED;
+				}
+			}
+
+			vec_pushback(*allocated, instruction);
+			for(size_t j = vec_getsize(intervals); j-- > 0;)
+			{
+				size_t slot = intervals[j].slot;
+				if(regs[slot] != erw_SPILLED && erw_ir_isset(row, slot))
+				{
+					struct erw_IRInstruction pop = {
+						.id = erw_INSTRUCTIONID_POP,
+						.operands = {regs[slot]},
+						.offset = erw_IR_INSERTED
+					};
+					vec_pushback(*allocated, pop);
+				}
+			}
+
+			continue;
+		}
+
+		vec_pushback(*allocated, instruction);
+	}
+
+	vec_dtor(slots);
+	vec_dtor(regs);
+	vec_dtor(intervals);
+	vec_dtor(live);
+}
+
+void erw_regalloc_allocate(struct erw_Bytecode* bytecode)
+{
+	log_assert(bytecode, "is NULL");
+
+	Vec(struct erw_IRInstruction) decoded = erw_ir_decode(bytecode);
+	Vec(struct erw_IRInstruction) allocated = vec_ctor(
+		struct erw_IRInstruction,
+		vec_getsize(decoded)
+	);
+
+	//Functions are in the order they were emitted and cover all instructions
+	size_t numfunctions = vec_getsize(bytecode->functions);
+	for(size_t i = 0; i < numfunctions; i++)
+	{
+		size_t begin = erw_ir_find(decoded, bytecode->functions[i].offset);
+		size_t end = i + 1 < numfunctions
+			? erw_ir_find(decoded, bytecode->functions[i + 1].offset)
+			: vec_getsize(decoded);
+		log_assert(i || !begin, "instructions outside of a function");
+		erw_allocatefunc(decoded, begin, end, &allocated);
+	}
+
+	erw_ir_encode(bytecode, decoded, allocated);
+	vec_dtor(allocated);
+	vec_dtor(decoded);
+}
@@ -0,0 +1,30 @@
+/*
+	Copyright (C) 2017 Erik Wallström
+
+	This file is part of Erwall.
+
+	Erwall is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Erwall is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Erwall.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ERW_REGALLOC_H
+#define ERW_REGALLOC_H
+
+#include "erw_bytecode.h"
+
+//Moves frame slots into the registers that no expression of the function
+//uses, slots that are never live at the same time share one. The rest stay
+//in the frame. Run erw_peephole_optimize afterwards to clean up the moves.
+void erw_regalloc_allocate(struct erw_Bytecode* bytecode);
+
+#endif
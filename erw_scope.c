@@ -22,28 +22,148 @@
 #include "str.h"
 #include "log.h"
 
+#include <stdint.h>
 #include <stdlib.h>
 
+static size_t erw_hashatom(const char* atom)
+{
+	size_t hash = (uintptr_t)atom;
+	hash ^= hash >> 4; //Atoms are often aligned
+	hash *= 11400714819323198485ULL;
+	return hash ^ (hash >> 32);
+}
+
+typedef const char* (*erw_SymbolName)(struct erw_Scope* scope, size_t index);
+
+static const char* erw_scope_varname(struct erw_Scope* scope, size_t index)
+{
+	return erw_ast_getstr(
+		scope->ast, 
+		scope->variables[index].node->vardeclr.name
+	);
+}
+
+static const char* erw_scope_funcname(struct erw_Scope* scope, size_t index)
+{
+	return erw_ast_getstr(
+		scope->ast, 
+		scope->functions[index].node->funcdef.name
+	);
+}
+
+static const char* erw_scope_typename(struct erw_Scope* scope, size_t index)
+{
+	return scope->types[index]->type->named.name;
+}
+
+static void erw_symbolindex_insert(
+	struct erw_SymbolIndex* self, 
+	size_t hash, 
+	size_t index)
+{
+	if((self->count + 1) * 2 > self->capacity) //Keep load factor below 0.5
+	{
+		struct erw_SymbolSlot* oldslots = self->slots;
+		size_t oldcapacity = self->capacity;
+		self->capacity = oldcapacity ? oldcapacity * 2 : 8;
+		self->slots = calloc(self->capacity, sizeof(struct erw_SymbolSlot));
+		if(!self->slots)
+		{
+			log_error("calloc failed in <%s>", __func__);
+		}
+
+		self->count = 0;
+		for(size_t i = 0; i < oldcapacity; i++)
+		{
+			if(oldslots[i].index)
+			{
+				erw_symbolindex_insert(
+					self, 
+					oldslots[i].hash, 
+					oldslots[i].index - 1
+				);
+			}
+		}
+
+		free(oldslots);
+	}
+
+	size_t i = hash & (self->capacity - 1);
+	while(self->slots[i].index)
+	{
+		i = (i + 1) & (self->capacity - 1);
+	}
+
+	self->slots[i].hash = hash;
+	self->slots[i].index = index + 1;
+	self->count++;
+}
+
+//Returns the index + 1 of the symbol named 'name', or 0 if it doesn't exist
+static size_t erw_symbolindex_find(
+	struct erw_SymbolIndex* self, 
+	struct erw_Scope* scope,
+	size_t numsymbols,
+	erw_SymbolName getname,
+	const char* name,
+	size_t hash)
+{
+	//Index symbols that have been pushed since the last lookup
+	while(self->count < numsymbols)
+	{
+		erw_symbolindex_insert(
+			self, 
+			erw_hashatom(getname(scope, self->count)), 
+			self->count
+		);
+	}
+
+	if(!self->capacity)
+	{
+		return 0;
+	}
+
+	size_t i = hash & (self->capacity - 1);
+	while(self->slots[i].index)
+	{
+		if(self->slots[i].hash == hash && 
+			getname(scope, self->slots[i].index - 1) == name)
+		{
+			return self->slots[i].index;
+		}
+
+		i = (i + 1) & (self->capacity - 1);
+	}
+
+	return 0;
+}
+
 struct erw_VarDeclr* erw_scope_findvar(struct erw_Scope* self, const char* name)
 {
 	log_assert(self, "is NULL");
 	log_assert(name, "is NULL");
 
+	size_t hash = erw_hashatom(name);
 	struct erw_Scope* scope = self;
 	while(scope)
 	{
-		for(size_t i = 0; i < vec_getsize(scope->variables); i++)
+		size_t index = erw_symbolindex_find(
+			&scope->varindex, 
+			scope, 
+			vec_getsize(scope->variables), 
+			erw_scope_varname, 
+			name, 
+			hash
+		);
+		if(index)
 		{
-			if(!strcmp(scope->variables[i].node->vardeclr.name->text, name))
-			{
-				return &scope->variables[i];
-			}
+			return &scope->variables[index - 1];
 		}
 
 		scope = scope->parent;
 		if(scope && scope->funcname)
 		{
-			if(strcmp(scope->funcname, self->funcname))
+			if(scope->funcname != self->funcname)
 			{
 				break;
 			}
@@ -64,15 +184,21 @@ struct erw_FuncDeclr* erw_scope_findfunc(
 	log_assert(self, "is NULL");
 	log_assert(name, "is NULL");
 
+	size_t hash = erw_hashatom(name);
 	struct erw_Scope* scope = self;
 	while(scope)
 	{
-		for(size_t i = 0; i < vec_getsize(scope->functions); i++)
+		size_t index = erw_symbolindex_find(
+			&scope->funcindex, 
+			scope, 
+			vec_getsize(scope->functions), 
+			erw_scope_funcname, 
+			name, 
+			hash
+		);
+		if(index)
 		{
-			if(!strcmp(scope->functions[i].node->funcdef.name->text, name))
-			{
-				return &scope->functions[i];
-			}
+			return &scope->functions[index - 1];
 		}
 
 		scope = scope->parent;
@@ -88,15 +214,21 @@ static struct erw_TypeDeclr* erw_scope_findtype(
 	log_assert(self, "is NULL");
 	log_assert(name, "is NULL");
 
+	size_t hash = erw_hashatom(name);
 	struct erw_Scope* scope = self;
 	while(scope)
 	{
-		for(size_t i = 0; i < vec_getsize(scope->types); i++)
+		size_t index = erw_symbolindex_find(
+			&scope->typeindex, 
+			scope, 
+			vec_getsize(scope->types), 
+			erw_scope_typename, 
+			name, 
+			hash
+		);
+		if(index)
 		{
-			if(!strcmp(scope->types[i]->type->named.name, name))
-			{
-				return scope->types[i];
-			}
+			return scope->types[index - 1];
 		}
 
 		scope = scope->parent;
@@ -122,8 +254,12 @@ struct erw_Scope* erw_scope_new(
 	self->types = vec_ctor(struct erw_TypeDeclr*, 0);
 	self->children = vec_ctor(struct erw_Scope*, 0);
 	self->finalizers = vec_ctor(struct erw_Finalizer, 0);
+	self->funcindex = (struct erw_SymbolIndex){0};
+	self->varindex = (struct erw_SymbolIndex){0};
+	self->typeindex = (struct erw_SymbolIndex){0};
 	self->index = index;
 	self->parent = parent;
+	self->ast = parent ? parent->ast : NULL;
 	self->isfunction = isfunction;
 	self->funcname = funcname;
 
@@ -137,19 +273,22 @@ struct erw_Scope* erw_scope_new(
 
 struct erw_VarDeclr* erw_scope_getvar(
 	struct erw_Scope* self, 
-	struct erw_Token* token,
-	struct Str* lines)
+	uint32_t index,
+	struct erw_Lines* lines)
 {
 	log_assert(self, "is NULL");
-	log_assert(token, "is NULL");
+	struct erw_Token token = erw_ast_gettoken(self->ast, index);
 	log_assert(
-		token->type == erw_TOKENTYPE_IDENT, 
+		token.type == erw_TOKENTYPE_IDENT, 
 		"invalid type (%s)", 
-		token->type->name
+		erw_tokentypeinfos[token.type].name
 	);
 	log_assert(lines, "is NULL");
 
-	struct erw_VarDeclr* ret = erw_scope_findvar(self, token->text);
+	struct erw_VarDeclr* ret = erw_scope_findvar(
+		self, 
+		erw_token_getstr(&token)
+	);
 	if(!ret)
 	{ 
 		struct Str msg;
@@ -160,10 +299,10 @@ struct erw_VarDeclr* erw_scope_getvar(
 
 		erw_error(
 			msg.data, 
-			lines[token->linenum - 1].data, 
-			token->linenum, 
-			token->column,
-			token->column + vec_getsize(token->text) - 2
+			erw_lines_get(lines, token.linenum), 
+			token.linenum, 
+			token.column,
+			token.column + token.len - 1
 		);
 		str_dtor(&msg);
 	}
@@ -173,29 +312,32 @@ struct erw_VarDeclr* erw_scope_getvar(
 
 struct erw_FuncDeclr* erw_scope_getfunc(
 	struct erw_Scope* self, 
-	struct erw_Token* token,
-	struct Str* lines)
+	uint32_t index,
+	struct erw_Lines* lines)
 {
 	log_assert(self, "is NULL");
-	log_assert(token, "is NULL");
+	struct erw_Token token = erw_ast_gettoken(self->ast, index);
 	log_assert(
-		token->type == erw_TOKENTYPE_IDENT, 
+		token.type == erw_TOKENTYPE_IDENT, 
 		"invalid type (%s)", 
-		token->type->name
+		erw_tokentypeinfos[token.type].name
 	);
 	log_assert(lines, "is NULL");
 
-	struct erw_FuncDeclr* ret = erw_scope_findfunc(self, token->text);
+	struct erw_FuncDeclr* ret = erw_scope_findfunc(
+		self, 
+		erw_token_getstr(&token)
+	);
 	if(!ret)
 	{ 
 		struct Str msg;
 		str_ctor(&msg, "Undefined function");
 		erw_error(
 			msg.data, 
-			lines[token->linenum - 1].data, 
-			token->linenum, 
-			token->column,
-			token->column + vec_getsize(token->text) - 2
+			erw_lines_get(lines, token.linenum), 
+			token.linenum, 
+			token.column,
+			token.column + token.len - 1
 		);
 		str_dtor(&msg);
 	}
@@ -205,29 +347,32 @@ struct erw_FuncDeclr* erw_scope_getfunc(
 
 struct erw_Type* erw_scope_gettype(
 	struct erw_Scope* self, 
-	struct erw_Token* token,
-	struct Str* lines)
+	uint32_t index,
+	struct erw_Lines* lines)
 {
 	log_assert(self, "is NULL");
-	log_assert(token, "is NULL");
+	struct erw_Token token = erw_ast_gettoken(self->ast, index);
 	log_assert(
-		token->type == erw_TOKENTYPE_TYPE, 
+		token.type == erw_TOKENTYPE_TYPE, 
 		"invalid type (%s)", 
-		token->type->name
+		erw_tokentypeinfos[token.type].name
 	);
 	log_assert(lines, "is NULL");
 
-	struct erw_TypeDeclr* ret = erw_scope_findtype(self, token->text);
+	struct erw_TypeDeclr* ret = erw_scope_findtype(
+		self, 
+		erw_token_getstr(&token)
+	);
 	if(!ret)
 	{ 
 		struct Str msg;
 		str_ctor(&msg, "Undefined type");
 		erw_error(
 			msg.data, 
-			lines[token->linenum - 1].data, 
-			token->linenum, 
-			token->column,
-			token->column + vec_getsize(token->text) - 2
+			erw_lines_get(lines, token.linenum), 
+			token.linenum, 
+			token.column,
+			token.column + token.len - 1
 		);
 		str_dtor(&msg);
 	}
@@ -238,201 +383,188 @@ struct erw_Type* erw_scope_gettype(
 struct erw_Type* erw_scope_createtype(
 	struct erw_Scope* self, 
 	struct erw_ASTNode* node,
-	struct Str* lines)
+	struct erw_Lines* lines)
 {
 	log_assert(self, "is NULL");
 	log_assert(node, "is NULL");
 
-	struct erw_Type* root = NULL;
-	struct erw_Type* type = NULL;
-	int done = 0;
-	while(!done)
+	//Types are built bottom-up, so every child is canonical before its parent
+	//is looked up in the type table
+	struct erw_Type* ret = NULL;
+	switch(node->type)
 	{
-		struct erw_Type* tmptype = NULL;
-		if(node->type == erw_ASTNODETYPE_TYPE)
+	case erw_ASTNODETYPE_TYPE:
+		ret = erw_scope_gettype(self, node->token, lines);
+		//log_assert(ret->size > 0, "invalid size");
+		ret->named.used = 1;
+		break;
+	case erw_ASTNODETYPE_FUNCTYPE:
+	case erw_ASTNODETYPE_FUNCDEF:
 		{
-			tmptype = erw_type_new(erw_TYPEINFO_NAMED, type);
-			struct erw_Type* foundtype = erw_scope_gettype(
-				self, 
-				node->token, 
-				lines
+			struct erw_ASTNode* rettype = node->type == erw_ASTNODETYPE_FUNCTYPE
+				? erw_ast_get(self->ast, node->functype.type)
+				: erw_ast_get(self->ast, node->funcdef.type);
+			struct erw_ASTList paramnodes = 
+				node->type == erw_ASTNODETYPE_FUNCTYPE
+					? node->functype.params
+					: node->funcdef.params;
+
+			size_t numparams = paramnodes.size;
+			Vec(struct erw_Type*) params = vec_ctor(
+				struct erw_Type*,
+				numparams
 			);
-
-			//log_assert(foundtype->size > 0, "invalid size");
-			*tmptype = *foundtype;
-			foundtype->named.used = 1;
-			done = 1; //Break loop
-		}
-		else if(node->type == erw_ASTNODETYPE_FUNCTYPE)
-		{
-			tmptype = erw_type_new(erw_TYPEINFO_FUNC, type);
-			tmptype->func.type = node->functype.type 
-				? erw_scope_createtype(
-						self, 
-						node->functype.type, 
-						lines
-					)
-				: NULL;
-			tmptype->func.size = sizeof(void(*)(void));
-			for(size_t i = 0; i < vec_getsize(node->functype.params); i++)
+			for(size_t i = 0; i < numparams; i++)
 			{
-				vec_pushback(
-					tmptype->func.params, 
-					erw_scope_createtype(self, node->functype.params[i], lines);
+				struct erw_ASTNode* param = erw_ast_getchild(
+					self->ast,
+					paramnodes,
+					i
 				);
-			}
-
-			done = 1; //Break loop
-		}
-		else if(node->type == erw_ASTNODETYPE_FUNCDEF)
-		{
-			tmptype = erw_type_new(erw_TYPEINFO_FUNC, type);
-			tmptype->func.type = node->funcdef.type 
-				? erw_scope_createtype(
-						self, 
-						node->funcdef.type, 
-						lines
-					)
-				: NULL;
-			tmptype->func.size = sizeof(void(*)(void));
-			for(size_t i = 0; i < vec_getsize(node->funcdef.params); i++)
-			{
 				vec_pushback(
-					tmptype->func.params, 
+					params, 
 					erw_scope_createtype(
 						self, 
-						node->funcdef.params[i]->vardeclr.type, 
+						node->type == erw_ASTNODETYPE_FUNCTYPE 
+							? param
+							: erw_ast_getnode(self->ast, param->vardeclr.type), 
 						lines
 					)
 				);
 			}
 
-			done = 1; //Break loop
-		}
-		else if(node->type == erw_ASTNODETYPE_REFERENCE)
-		{
-			tmptype = erw_type_new(erw_TYPEINFO_REFERENCE, type);
-			tmptype->reference.mutable = 0; //NOTE: Temporary
-			tmptype->reference.size = sizeof(void*); //NOTE: Temporary
-			tmptype->parent = type;
-		}
-		else if(node->type == erw_ASTNODETYPE_ARRAY)
-		{
-			tmptype = erw_type_new(erw_TYPEINFO_ARRAY, type);
-			//tmptype->array.mutable = 0; //NOTE: Temporary
-			tmptype->array.elements = atol(node->array.size->token->text); 
-			tmptype->parent = type;
-			//NOTE: No error checking
-		}
-		else if(node->type == erw_ASTNODETYPE_SLICE)
-		{
-			tmptype = erw_type_new(erw_TYPEINFO_SLICE, type);
-			tmptype->slice.mutable = 0; //NOTE: Temporary
-			tmptype->slice.size = sizeof(void*); //NOTE: Temporary
-			tmptype->parent = type;
-		}
-		else
-		{
-			log_assert(0, "this should not happen (%s)", node->type->name);
-		}
-
-		node = node->reference.type;
-		if(!root)
-		{
-			type = tmptype;
-			root = type;
-		}
-		else
-		{
-			if(type->info == erw_TYPEINFO_ARRAY 
-				&& tmptype->info != erw_TYPEINFO_ARRAY)
-			{
-				type->array.size = type->array.elements * tmptype->size;
-				struct erw_Type* lasttype = type->parent;
-				while(lasttype && lasttype->info == erw_TYPEINFO_ARRAY)
-				{
-					lasttype->array.size = lasttype->array.elements 
-						* lasttype->size;
-					lasttype = lasttype->parent;
-				}
-			}
-
-			type->reference.type = tmptype;
-			type = tmptype;
+			ret = erw_type_getfunc(
+				rettype ? erw_scope_createtype(self, rettype, lines) : NULL,
+				params,
+				numparams
+			);
+			vec_dtor(params);
 		}
+		break;
+	case erw_ASTNODETYPE_REFERENCE:
+		ret = erw_type_getreference(
+			erw_scope_createtype(
+				self,
+				erw_ast_getnode(self->ast, node->reference.type),
+				lines
+			),
+			0 //NOTE: Temporary
+		);
+		break;
+	case erw_ASTNODETYPE_ARRAY:
+		ret = erw_type_getarray(
+			erw_scope_createtype(
+				self,
+				erw_ast_getnode(self->ast, node->array.type),
+				lines
+			),
+			erw_ast_getliteral(
+				self->ast, 
+				erw_ast_getnode(self->ast, node->array.size)->token
+			).value.uint
+		); //NOTE: No error checking
+		break;
+	case erw_ASTNODETYPE_SLICE:
+		ret = erw_type_getslice(
+			erw_scope_createtype(
+				self,
+				erw_ast_getnode(self->ast, node->slice.type),
+				lines
+			),
+			0 //NOTE: Temporary
+		);
+		break;
+	default:
+		log_assert(
+			0,
+			"this should not happen (%s)",
+			erw_astnodetypenames[node->type]
+		);
+		break;
 	}
 
-	return root;
+	return ret;
 }
 
 void erw_scope_addvardeclr(
 	struct erw_Scope* self, 
 	struct erw_ASTNode* node,
-	struct Str* lines)
+	struct erw_Lines* lines)
 {
 	log_assert(self, "is NULL");
 	log_assert(node, "is NULL");
 	log_assert(
 		node->type == erw_ASTNODETYPE_VARDECLR, 
 		"invalid type (%s)", 
-		node->type->name
+		erw_astnodetypenames[node->type]
 	);
 	log_assert(lines, "is NULL");
 
+	struct erw_Token name = erw_ast_gettoken(self->ast, node->vardeclr.name);
 	struct erw_VarDeclr* var = erw_scope_findvar(
 		self, 
-		node->vardeclr.name->text
+		erw_token_getstr(&name)
 	);
 	if(var)
 	{
+		struct erw_Token other = erw_ast_gettoken(
+			self->ast, 
+			var->node->vardeclr.name
+		);
 		struct Str msg;
 		str_ctorfmt(
 			&msg,
 			"Redefinition of variable ('%s') declared at line %zu, column %zu", 
-			node->vardeclr.name->text,
-			var->node->vardeclr.name->linenum,
-			var->node->vardeclr.name->column
+			erw_token_getstr(&name),
+			other.linenum,
+			other.column
 		);
 
 		erw_error(
 			msg.data, 
-			lines[node->vardeclr.name->linenum - 1].data, 
-			node->vardeclr.name->linenum, 
-			node->vardeclr.name->column,
-			node->vardeclr.name->column + 
-				vec_getsize(node->vardeclr.name->text) - 2
+			erw_lines_get(lines, name.linenum), 
+			name.linenum, 
+			name.column,
+			name.column + name.len - 1
 		);
 		str_dtor(&msg);
 	}
 
 	struct erw_FuncDeclr* func = erw_scope_findfunc(
 		self, 
-		node->vardeclr.name->text
+		erw_token_getstr(&name)
 	);
 	if(func)
 	{
+		struct erw_Token other = erw_ast_gettoken(
+			self->ast, 
+			func->node->funcdef.name
+		);
 		struct Str msg;
 		str_ctorfmt(
 			&msg,
 			"Redefinition of variable ('%s') declared at line %zu, column %zu", 
-			node->vardeclr.name->text,
-			func->node->funcdef.name->linenum,
-			func->node->funcdef.name->column
+			erw_token_getstr(&name),
+			other.linenum,
+			other.column
 		);
 
 		erw_error(
 			msg.data, 
-			lines[node->vardeclr.name->linenum - 1].data, 
-			node->vardeclr.name->linenum, 
-			node->vardeclr.name->column,
-			node->vardeclr.name->column + 
-				vec_getsize(node->vardeclr.name->text) - 2
+			erw_lines_get(lines, name.linenum), 
+			name.linenum, 
+			name.column,
+			name.column + name.len - 1
 		);
 		str_dtor(&msg);
 	}
 
 	struct erw_VarDeclr symbol;
-	symbol.type = erw_scope_createtype(self, node->vardeclr.type, lines);
+	symbol.type = erw_scope_createtype(
+		self,
+		erw_ast_getnode(self->ast, node->vardeclr.type),
+		lines
+	);
 	symbol.node = node;
 	symbol.used = 0;
 
@@ -451,65 +583,72 @@ void erw_scope_addvardeclr(
 void erw_scope_addfuncdeclr(
 	struct erw_Scope* self, 
 	struct erw_ASTNode* node,
-	struct Str* lines)
+	struct erw_Lines* lines)
 {
 	log_assert(self, "is NULL");
 	log_assert(node, "is NULL");
 	log_assert(
 		node->type == erw_ASTNODETYPE_FUNCDEF, 
 		"invalid type (%s)", 
-		node->type->name
+		erw_astnodetypenames[node->type]
 	);
 	log_assert(lines, "is NULL");
 
+	struct erw_Token name = erw_ast_gettoken(self->ast, node->funcdef.name);
 	struct erw_FuncDeclr* func = erw_scope_findfunc(
 		self, 
-		node->funcdef.name->text
+		erw_token_getstr(&name)
 	);
 	if(func)
 	{
+		struct erw_Token other = erw_ast_gettoken(
+			self->ast, 
+			func->node->funcdef.name
+		);
 		struct Str msg;
 		str_ctorfmt(
 			&msg,
 			"Redefinition of function ('%s') declared at line %zu, column %zu", 
-			node->funcdef.name->text,
-			func->node->funcdef.name->linenum,
-			func->node->funcdef.name->column
+			erw_token_getstr(&name),
+			other.linenum,
+			other.column
 		);
 
 		erw_error(
 			msg.data, 
-			lines[node->funcdef.name->linenum - 1].data, 
-			node->funcdef.name->linenum, 
-			node->funcdef.name->column,
-			node->funcdef.name->column + 
-				vec_getsize(node->funcdef.name->text) - 2
+			erw_lines_get(lines, name.linenum), 
+			name.linenum, 
+			name.column,
+			name.column + name.len - 1
 		);
 		str_dtor(&msg);
 	}
 
 	struct erw_VarDeclr* var = erw_scope_findvar(
 		self, 
-		node->funcdef.name->text
+		erw_token_getstr(&name)
 	);
 	if(var)
 	{
+		struct erw_Token other = erw_ast_gettoken(
+			self->ast, 
+			var->node->vardeclr.name
+		);
 		struct Str msg;
 		str_ctorfmt(
 			&msg,
 			"Redefinition of function ('%s') declared at line %zu, column %zu", 
-			node->funcdef.name->text,
-			var->node->vardeclr.name->linenum,
-			var->node->vardeclr.name->column
+			erw_token_getstr(&name),
+			other.linenum,
+			other.column
 		);
 
 		erw_error(
 			msg.data, 
-			lines[node->funcdef.name->linenum - 1].data, 
-			node->funcdef.name->linenum, 
-			node->funcdef.name->column,
-			node->funcdef.name->column + 
-				vec_getsize(node->funcdef.name->text) - 2
+			erw_lines_get(lines, name.linenum), 
+			name.linenum, 
+			name.column,
+			name.column + name.len - 1
 		);
 		str_dtor(&msg);
 	}
@@ -517,7 +656,11 @@ void erw_scope_addfuncdeclr(
 	struct erw_FuncDeclr symbol;
 	if(node->funcdef.type)
 	{
-		symbol.type = erw_scope_createtype(self, node->funcdef.type, lines);
+		symbol.type = erw_scope_createtype(
+			self,
+			erw_ast_getnode(self->ast, node->funcdef.type),
+			lines
+		);
 	}
 	else
 	{
@@ -532,39 +675,43 @@ void erw_scope_addfuncdeclr(
 void erw_scope_addtypedeclr(
 	struct erw_Scope* self, 
 	struct erw_ASTNode* node,
-	struct Str* lines)
+	struct erw_Lines* lines)
 {
 	log_assert(self, "is NULL");
 	log_assert(node, "is NULL");
 	log_assert(
 		node->type == erw_ASTNODETYPE_TYPEDECLR, 
 		"invalid type (%s)", 
-		node->type->name
+		erw_astnodetypenames[node->type]
 	);
 	log_assert(lines, "is NULL");
 
+	struct erw_Token typename = erw_ast_gettoken(
+		self->ast, 
+		node->typedeclr.name
+	);
 	struct erw_TypeDeclr* type = erw_scope_findtype(
 		self, 
-		node->typedeclr.name->text
+		erw_token_getstr(&typename)
 	);
 	if(type)
 	{
+		struct erw_Token other = erw_ast_gettoken(self->ast, type->node->token);
 		struct Str msg;
 		str_ctorfmt(
 			&msg,
 			"Redefinition of type ('%s') declared at line %zu, column %zu", 
-			node->typedeclr.name->text,
-			type->node->token->linenum,
-			type->node->token->column
+			erw_token_getstr(&typename),
+			other.linenum,
+			other.column
 		);
 
 		erw_error(
 			msg.data, 
-			lines[node->typedeclr.name->linenum - 1].data, 
-			node->typedeclr.name->linenum, 
-			node->typedeclr.name->column,
-			node->typedeclr.name->column + 
-				vec_getsize(node->typedeclr.name->text) - 2
+			erw_lines_get(lines, typename.linenum), 
+			typename.linenum, 
+			typename.column,
+			typename.column + typename.len - 1
 		);
 		str_dtor(&msg);
 	}
@@ -576,330 +723,371 @@ void erw_scope_addtypedeclr(
 	}
 
 	symbol->node = node;
-	symbol->type = erw_type_new(erw_TYPEINFO_NAMED, NULL);
-	symbol->type->named.name = node->typedeclr.name->text;
+	symbol->type = erw_type_new(erw_TYPEINFO_NAMED);
+	symbol->type->named.name = erw_token_getstr(&typename);
 	symbol->type->named.used = 0;
 	vec_pushback(self->types, symbol);
 
-	if(!node->typedeclr.type)
+	struct erw_ASTNode* typenode = erw_ast_get(self->ast, node->typedeclr.type);
+	if(!typenode)
 	{
-		symbol->type->named.type = erw_type_new(erw_TYPEINFO_EMPTY, NULL);
+		symbol->type->named.type = erw_type_new(erw_TYPEINFO_EMPTY);
 		symbol->type->named.size = 0; //Should this be 1?
+		return;
 	}
-	else if(node->typedeclr.type->type == erw_ASTNODETYPE_TYPE)
-	{
-		struct erw_Type* newtype = erw_scope_gettype(
-			self, 
-			node->typedeclr.type->token, 
-			lines
-		);
 
-		symbol->type->named.type = newtype;
-		symbol->type->named.size = newtype->size;
-	}
-	else if(node->typedeclr.type->type == erw_ASTNODETYPE_STRUCT)
+	switch(typenode->type)
 	{
-		struct erw_Type* newtype = erw_type_new(erw_TYPEINFO_STRUCT, NULL);
-		for(size_t i = 0; 
-			i < vec_getsize(node->typedeclr.type->struct_.members);
-			i++)
+	case erw_ASTNODETYPE_TYPE:
 		{
-			struct erw_TypeStructMember member = {
-				.type = erw_scope_createtype(
-					self, 
-					node->typedeclr.type->struct_.members[i]->vardeclr.type,
-					lines
-				),
-				.name = node->typedeclr.type->struct_.members[i]->vardeclr.name
-					->text
-			};
-
-			struct erw_ASTNode* basenode = node->typedeclr.type->struct_
-				.members[i]->vardeclr.type;
-			struct erw_Type* basetype = member.type;
-			while(1)
+			struct erw_Type* newtype = erw_scope_gettype(
+				self, 
+				typenode->token, 
+				lines
+			);
+
+			symbol->type->named.type = newtype;
+			symbol->type->named.size = newtype->size;
+		}
+		break;
+	case erw_ASTNODETYPE_STRUCT:
+		{
+			struct erw_Type* newtype = erw_type_new(erw_TYPEINFO_STRUCT);
+			struct erw_ASTList members = typenode->struct_.members;
+			for(size_t i = 0; i < members.size; i++)
 			{
-				if(basetype->info == erw_TYPEINFO_ARRAY)
-				{
-					basetype = basetype->array.type;
-					basenode = basenode->array.type;
-				}
-				else
+				struct erw_ASTNode* membernode = erw_ast_getchild(
+					self->ast,
+					members,
+					i
+				);
+				struct erw_ASTNode* basenode = erw_ast_getnode(
+					self->ast,
+					membernode->vardeclr.type
+				);
+				struct erw_TypeStructMember member = {
+					.type = erw_scope_createtype(self, basenode, lines),
+					.name = erw_ast_getstr(self->ast, membernode->vardeclr.name)
+				};
+
+				struct erw_Type* basetype = member.type;
+				while(1)
 				{
-					break;
+					if(basetype->info == erw_TYPEINFO_ARRAY)
+					{
+						basetype = basetype->array.type;
+						basenode = erw_ast_getnode(
+							self->ast, 
+							basenode->array.type
+						);
+					}
+					else
+					{
+						break;
+					}
 				}
-			}
 
-			if(basetype->info == erw_TYPEINFO_NAMED)
-			{
-				if(!strcmp(basetype->named.name, symbol->type->named.name))
+				if(basetype->info == erw_TYPEINFO_NAMED)
 				{
-					struct Str msg;
-					str_ctorfmt(
-						&msg, 
-						"Recursive definition of type '%s' declared at line"
-							" %zu, column %zu",
-						symbol->type->named.name,
-						symbol->node->token->linenum,
-						symbol->node->token->column
-					);
-					erw_error(
-						msg.data, 
-						lines[basenode->token->linenum - 1].data, 
-						basenode->token->linenum, 
-						basenode->token->column,
-						basenode->token->column 
-							+ vec_getsize(basenode->token->text) - 2
-					);
-					str_dtor(&msg);
+					if(basetype->named.name == symbol->type->named.name)
+					{
+						struct erw_Token declr = erw_ast_gettoken(
+							self->ast, 
+							symbol->node->token
+						);
+						struct erw_Token base = erw_ast_gettoken(
+							self->ast, 
+							basenode->token
+						);
+						struct Str msg;
+						str_ctorfmt(
+							&msg, 
+							"Recursive definition of type '%s' declared at line"
+								" %zu, column %zu",
+							symbol->type->named.name,
+							declr.linenum,
+							declr.column
+						);
+						erw_error(
+							msg.data, 
+							erw_lines_get(lines, base.linenum), 
+							base.linenum, 
+							base.column,
+							base.column + base.len - 1
+						);
+						str_dtor(&msg);
+					}
 				}
-			}
 
-			for(size_t j = 0; j < vec_getsize(newtype->struct_.members); j++)
-			{
-				if(!strcmp(newtype->struct_.members[j].name, member.name))
+				size_t numothers = vec_getsize(newtype->struct_.members);
+				for(size_t j = 0; j < numothers; j++)
 				{
-					struct Str msg;
-					str_ctorfmt(
-						&msg,
-						"Redefinition of struct member ('%s') declared at line"
-							" %zu, column %zu", 
-						member.name,
-						node->typedeclr.type->struct_.members[j]->vardeclr.name
-							->linenum,
-						node->typedeclr.type->struct_.members[j]->vardeclr.name
-							->column
-					);
-
-					erw_error(
-						msg.data, 
-						lines[node->typedeclr.type->struct_.members[i]->vardeclr
-							.name->linenum - 1 ].data, 
-						node->typedeclr.type->struct_.members[i]->vardeclr
-							.name->linenum, 
-						node->typedeclr.type->struct_.members[i]->vardeclr
-							.name->column,
-						node->typedeclr.type->struct_.members[i]->vardeclr
-							.name->column 
-							+ vec_getsize(
-								node->typedeclr.type->struct_.members[i]
-									->vardeclr.name->text) - 2
-					);
-					str_dtor(&msg);
+					if(newtype->struct_.members[j].name == member.name)
+					{
+						struct erw_Token name = erw_ast_gettoken(
+							self->ast, 
+							membernode->vardeclr.name
+						);
+						struct erw_ASTNode* othernode = erw_ast_getchild(
+							self->ast, 
+							members, 
+							j
+						);
+						struct erw_Token othername = erw_ast_gettoken(
+							self->ast, 
+							othernode->vardeclr.name
+						);
+						struct Str msg;
+						str_ctorfmt(
+							&msg,
+							"Redefinition of struct member ('%s') declared at"
+								" line %zu, column %zu", 
+							member.name,
+							othername.linenum,
+							othername.column
+						);
+
+						erw_error(
+							msg.data, 
+							erw_lines_get(lines, name.linenum), 
+							name.linenum, 
+							name.column,
+							name.column + name.len - 1
+						);
+						str_dtor(&msg);
+					}
 				}
+
+				newtype->size += member.type->size;
+				vec_pushback(newtype->struct_.members, member);
 			}
 
-			newtype->size += member.type->size;
-			vec_pushback(newtype->struct_.members, member);
+			symbol->type->named.type = newtype;
+			symbol->type->named.size = newtype->size;
 		}
-
-		symbol->type->named.type = newtype;
-		symbol->type->named.size = newtype->size;
-	}
-	else if(node->typedeclr.type->type == erw_ASTNODETYPE_UNION)
-	{
-		struct erw_Type* newtype = erw_type_new(erw_TYPEINFO_UNION, NULL);
-		size_t largestsize = 0;
-		for(size_t i = 0; 
-			i < vec_getsize(node->typedeclr.type->union_.members);
-			i++)
+		break;
+	case erw_ASTNODETYPE_UNION:
 		{
-			struct erw_Type* tmptype = erw_scope_createtype(
-				self, 
-				node->typedeclr.type->union_.members[i],
-				lines
-			);
-
-			for(size_t j = 0; j < vec_getsize(newtype->union_.members); j++)
+			struct erw_Type* newtype = erw_type_new(erw_TYPEINFO_UNION);
+			struct erw_ASTList members = typenode->union_.members;
+			size_t largestsize = 0;
+			for(size_t i = 0; i < members.size; i++)
 			{
-				if(erw_type_compare(tmptype, newtype->union_.members[j]))
-				{
-					struct Str msg;
-					struct Str str = erw_type_tostring(tmptype);
-					str_ctorfmt(
-						&msg,
-						"Redefinition of struct member ('%s') declared at line"
-							" %zu, column %zu", 
-						str.data,
-						node->typedeclr.type->union_.members[j]->token->linenum,
-						node->typedeclr.type->union_.members[j]->token->column
-					);
+				struct erw_ASTNode* membernode = erw_ast_getchild(
+					self->ast,
+					members,
+					i
+				);
+				struct erw_Type* tmptype = erw_scope_createtype(
+					self, 
+					membernode,
+					lines
+				);
 
-					erw_error(
-						msg.data, 
-						lines[node->typedeclr.type->union_.members[i]->token
-							->linenum - 1].data, 
-						node->typedeclr.type->union_.members[i]->token->linenum, 
-						node->typedeclr.type->union_.members[i]->token->column,
-						node->typedeclr.type->union_.members[i]->token->column 
-							+ vec_getsize(
-								node->typedeclr.type->union_.members[i]->token
-									->text) - 2
-					);
+				for(size_t j = 0; j < vec_getsize(newtype->union_.members); j++)
+				{
+					if(erw_type_compare(tmptype, newtype->union_.members[j]))
+					{
+						struct erw_Token token = erw_ast_gettoken(
+							self->ast, 
+							membernode->token
+						);
+						struct erw_Token othertoken = erw_ast_gettoken(
+							self->ast, 
+							erw_ast_getchild(self->ast, members, j)->token
+						);
+						struct Str msg;
+						struct Str str = erw_type_tostring(tmptype);
+						str_ctorfmt(
+							&msg,
+							"Redefinition of struct member ('%s') declared at"
+								" line %zu, column %zu", 
+							str.data,
+							othertoken.linenum,
+							othertoken.column
+						);
+
+						erw_error(
+							msg.data, 
+							erw_lines_get(lines, token.linenum), 
+							token.linenum, 
+							token.column,
+							token.column + token.len - 1
+						);
+
+						str_dtor(&str);
+						str_dtor(&msg);
+					}
+				}
 
-					str_dtor(&str);
-					str_dtor(&msg);
+				if(tmptype->size > largestsize)
+				{
+					largestsize = tmptype->size;
 				}
-			}
 
-			if(tmptype->size > largestsize)
-			{
-				largestsize = tmptype->size;
+				vec_pushback(newtype->union_.members, tmptype);
 			}
 
-			vec_pushback(newtype->union_.members, tmptype);
+			newtype->union_.size = largestsize;
+			symbol->type->named.type = newtype;
+			symbol->type->named.size = newtype->size;
 		}
-
-		newtype->union_.size = largestsize;
-		symbol->type->named.type = newtype;
-		symbol->type->named.size = newtype->size;
-	}
-	else if(node->typedeclr.type->type == erw_ASTNODETYPE_ENUM)
-	{
-		struct erw_Type* newtype = erw_type_new(erw_TYPEINFO_ENUM, NULL);
-		newtype->enum_.size = sizeof(int); //NOTE: Temporary
-
-		size_t defaultvalue = 0;
-		for(size_t i = 0; 
-			i < vec_getsize(node->typedeclr.type->enum_.members);
-			i++)
+		break;
+	case erw_ASTNODETYPE_ENUM:
 		{
-			struct erw_TypeEnumMember member;
-			member.name = node->typedeclr.type->enum_.members[i]->enummember
-				.name->text;
-			for(size_t j = 0; j < vec_getsize(newtype->enum_.members); j++)
+			struct erw_Type* newtype = erw_type_new(erw_TYPEINFO_ENUM);
+			newtype->enum_.size = sizeof(int); //NOTE: Temporary
+
+			struct erw_ASTList members = typenode->enum_.members;
+			size_t defaultvalue = 0;
+			for(size_t i = 0; i < members.size; i++)
 			{
-				if(!strcmp(newtype->enum_.members[j].name, member.name))
+				struct erw_ASTNode* membernode = erw_ast_getchild(
+					self->ast,
+					members,
+					i
+				);
+				struct erw_Token name = erw_ast_gettoken(
+					self->ast, 
+					membernode->enummember.name
+				);
+				struct erw_ASTNode* valuenode = erw_ast_get(
+					self->ast,
+					membernode->enummember.value
+				);
+				struct erw_TypeEnumMember member;
+				member.name = erw_token_getstr(&name);
+				for(size_t j = 0; j < vec_getsize(newtype->enum_.members); j++)
 				{
-					struct Str msg;
-					str_ctorfmt(
-						&msg,
-						"Redefinition of enum member ('%s') declared at line"
-							" %zu, column %zu", 
-						member.name,
-						node->typedeclr.type->enum_.members[j]->enummember.name
-							->linenum,
-						node->typedeclr.type->enum_.members[j]->enummember.name
-							->column
+					struct erw_ASTNode* othernode = erw_ast_getchild(
+						self->ast,
+						members,
+						j
 					);
-
-					erw_error(
-						msg.data, 
-						lines[node->typedeclr.type->enum_.members[i]->enummember
-							.name->linenum - 1].data, 
-						node->typedeclr.type->enum_.members[i]->enummember.name
-							->linenum, 
-						node->typedeclr.type->enum_.members[i]->enummember.name
-							->column, 
-						node->typedeclr.type->enum_.members[i]->enummember.name
-							->column + vec_getsize(
-								node->typedeclr.type->enum_.members[i]
-									->enummember.name->text) - 2
+					struct erw_Token othername = erw_ast_gettoken(
+						self->ast, 
+						othernode->enummember.name
 					);
+					if(newtype->enum_.members[j].name == member.name)
+					{
+						struct Str msg;
+						str_ctorfmt(
+							&msg,
+							"Redefinition of enum member ('%s') declared at"
+								" line %zu, column %zu", 
+							member.name,
+							othername.linenum,
+							othername.column
+						);
+
+						erw_error(
+							msg.data, 
+							erw_lines_get(lines, name.linenum), 
+							name.linenum, 
+							name.column, 
+							name.column + name.len - 1
+						);
+
+						str_dtor(&msg);
+					}
 
-					str_dtor(&msg);
-				}
-
-				if(node->typedeclr.type->enum_.members[i]->enummember.value)
-				{
-					if(node->typedeclr.type->enum_.members[j]->enummember.value)
+					if(valuenode)
 					{
-						if(!strcmp(
-							node->typedeclr.type->enum_.members[i]->enummember
-								.value->token->text,
-							node->typedeclr.type->enum_.members[j]->enummember
-								.value->token->text))
+						struct erw_ASTNode* othervaluenode = erw_ast_get(
+							self->ast,
+							othernode->enummember.value
+						);
+						if(othervaluenode)
 						{
-							struct Str msg;
-							str_ctorfmt(
-								&msg,
-								"Enum member with same the value as '%s'"
-									" declared at line %zu, column %zu", 
-								node->typedeclr.type->enum_.members[i]
-									->enummember.name->text,
-								node->typedeclr.type->enum_.members[j]
-									->enummember.name->linenum,
-								node->typedeclr.type->enum_.members[j]
-									->enummember .name->column
+							struct erw_Literal value = erw_ast_getliteral(
+								self->ast, 
+								valuenode->token
 							);
-
-							erw_error(
-								msg.data, 
-								lines[node->typedeclr.type->enum_.members[i]
-									->enummember.name->linenum - 1].data, 
-								node->typedeclr.type->enum_.members[i]
-									->enummember.name->linenum, 
-								node->typedeclr.type->enum_.members[i]
-									->enummember.name->column, 
-								node->typedeclr.type->enum_.members[i]
-									->enummember.name->column + vec_getsize(
-										node->typedeclr.type->enum_.members[i]
-											->enummember.name->text) - 2
+							struct erw_Literal othervalue = erw_ast_getliteral(
+								self->ast, 
+								othervaluenode->token
 							);
-
-							str_dtor(&msg);
+							if(value.value.uint == othervalue.value.uint)
+							{
+								struct Str msg;
+								str_ctorfmt(
+									&msg,
+									"Enum member with same the value as '%s'"
+										" declared at line %zu, column %zu", 
+									erw_token_getstr(&name),
+									othername.linenum,
+									othername.column
+								);
+
+								erw_error(
+									msg.data, 
+									erw_lines_get(lines, name.linenum), 
+									name.linenum, 
+									name.column, 
+									name.column + name.len - 1
+								);
+
+								str_dtor(&msg);
+							}
 						}
 					}
 				}
-			}
 
-			if(node->typedeclr.type->enum_.members[i]->enummember.value)
-			{
-				size_t value = atol(
-					node->typedeclr.type->enum_.members[i]->enummember.value
-						->token->text
-				);
-
-				if(value < defaultvalue) //Should be allowed happen?
+				if(valuenode)
 				{
-					struct Str msg;
-					str_ctorfmt(
-						&msg,
-						"Too small value given to enum member '%s' (%zu)",
-						member.name,
-						value
-					);
-
-					erw_error(
-						msg.data, 
-						lines[node->typedeclr.type->enum_.members[i]
-							->enummember.name->linenum - 1].data, 
-						node->typedeclr.type->enum_.members[i]
-							->enummember.name->linenum, 
-						node->typedeclr.type->enum_.members[i]
-							->enummember.name->column, 
-						node->typedeclr.type->enum_.members[i]
-							->enummember.name->column + vec_getsize(
-								node->typedeclr.type->enum_.members[i]
-									->enummember.name->text) - 2
-					);
+					size_t value = erw_ast_getliteral(
+						self->ast, 
+						valuenode->token
+					).value.uint;
 
-					str_dtor(&msg);
-				}
-				else
-				{
-					defaultvalue = value;
+					if(value < defaultvalue) //Should be allowed happen?
+					{
+						struct Str msg;
+						str_ctorfmt(
+							&msg,
+							"Too small value given to enum member '%s' (%zu)",
+							member.name,
+							value
+						);
+
+						erw_error(
+							msg.data, 
+							erw_lines_get(lines, name.linenum), 
+							name.linenum, 
+							name.column, 
+							name.column + name.len - 1
+						);
+
+						str_dtor(&msg);
+					}
+					else
+					{
+						defaultvalue = value;
+					}
 				}
+
+				member.value = defaultvalue;
+				defaultvalue++;
+				vec_pushback(newtype->enum_.members, member);
 			}
 
-			member.value = defaultvalue;
-			defaultvalue++;
-			vec_pushback(newtype->enum_.members, member);
+			symbol->type->named.type = newtype;
+			symbol->type->named.size = newtype->size;
 		}
-
-		symbol->type->named.type = newtype;
-		symbol->type->named.size = newtype->size;
-	}
-	else
-	{
-		log_assert(0, "this should not happen (%s)", node->type->name);
+		break;
+	default:
+		log_assert(
+			0,
+			"this should not happen (%s)",
+			erw_astnodetypenames[node->type]
+		);
 	}
 }
 
 static void erw_scope_printinternal(
 	struct erw_Scope* self, 
 	size_t level, 
-	struct Str* lines)
+	struct erw_Lines* lines)
 {
 	for(size_t i = 0; i < level; i++)
 	{
@@ -1021,7 +1209,7 @@ static void erw_scope_printinternal(
 			struct Str str = erw_type_tostring(self->functions[i].type);
 			printf(
 				"─ Function: %s (%s)\n", 
-				self->functions[i].node->funcdef.name->text, 
+				erw_scope_funcname(self, i), 
 				str.data
 			);
 			str_dtor(&str);
@@ -1030,7 +1218,7 @@ static void erw_scope_printinternal(
 		{
 			printf(
 				"─ Function: %s\n", 
-				self->functions[i].node->funcdef.name->text
+				erw_scope_funcname(self, i)
 			);
 		}
 	}
@@ -1046,7 +1234,7 @@ static void erw_scope_printinternal(
 		struct Str str = erw_type_tostring(self->variables[i].type);
 		printf(
 			"─ Variable: %s (%s)\n", 
-			self->variables[i].node->vardeclr.name->text, 
+			erw_scope_varname(self, i), 
 			str.data
 		);
 		str_dtor(&str);
@@ -1058,7 +1246,7 @@ static void erw_scope_printinternal(
 	}
 }
 
-void erw_scope_print(struct erw_Scope* self, struct Str* lines)
+void erw_scope_print(struct erw_Scope* self, struct erw_Lines* lines)
 {
 	log_assert(self, "is NULL");
 	log_assert(lines, "is NULL");
@@ -1079,26 +1267,18 @@ void erw_scope_dtor(struct erw_Scope* self)
 	}
 
 	vec_dtor(self->types);
-	for(size_t i = 0; i < vec_getsize(self->functions); i++)
-	{
-		if(self->functions[i].type)
-		{
-			erw_type_dtor(self->functions[i].type);
-		}
-	}
-
+	//Function and variable types are builtins, declared types or made by 
+	//erw_type_get*, so they aren't freed here
 	vec_dtor(self->functions);
-	for(size_t i = 0; i < vec_getsize(self->variables); i++)
-	{
-		erw_type_dtor(self->variables[i].type);
-	}
-
 	vec_dtor(self->variables);
 	for(size_t i = 0; i < vec_getsize(self->children); i++)
 	{
 		erw_scope_dtor(self->children[i]);
 	}
 
+	free(self->funcindex.slots);
+	free(self->varindex.slots);
+	free(self->typeindex.slots);
 	vec_dtor(self->finalizers);
 	vec_dtor(self->children);
 	free(self);
@@ -52,6 +52,22 @@ struct erw_Finalizer //Is this really a good name?
 	size_t index;
 };
 
+struct erw_SymbolSlot
+{
+	size_t hash;
+	size_t index; //Index + 1 into the symbol vec, 0 if the slot is empty
+};
+
+//Open addressing hash table from names to indices of one of the symbol vecs 
+//in erw_Scope. It catches up with its vec on lookup, which means symbols can 
+//be pushed to the vec directly
+struct erw_SymbolIndex
+{
+	struct erw_SymbolSlot* slots;
+	size_t capacity; //0 or a power of 2
+	size_t count;
+};
+
 struct erw_Scope
 {
 	Vec(struct erw_FuncDeclr) functions;
@@ -59,7 +75,11 @@ struct erw_Scope
 	Vec(struct erw_TypeDeclr*) types;
 	Vec(struct erw_Scope*) children;
 	Vec(struct erw_Finalizer) finalizers;
+	struct erw_SymbolIndex funcindex;
+	struct erw_SymbolIndex varindex;
+	struct erw_SymbolIndex typeindex;
 	struct erw_Scope* parent;
+	const struct erw_AST* ast; //Inherited from the parent
 	const char* funcname;
 	size_t index;
 	int isfunction;
@@ -71,6 +91,7 @@ struct erw_Scope* erw_scope_new(
 	size_t index,
 	int isfunction
 );
+//NOTE: Names passed to erw_scope_find* have to be atoms (see erw_intern)
 struct erw_VarDeclr* erw_scope_findvar(
 	struct erw_Scope* self, 
 	const char* name
@@ -81,40 +102,40 @@ struct erw_FuncDeclr* erw_scope_findfunc(
 );
 struct erw_VarDeclr* erw_scope_getvar(
 	struct erw_Scope* self, 
-	struct erw_Token* token,
-	struct Str* lines
+	uint32_t index, //Of the token in the AST
+	struct erw_Lines* lines
 );
 struct erw_FuncDeclr* erw_scope_getfunc(
 	struct erw_Scope* self, 
-	struct erw_Token* token,
-	struct Str* lines
+	uint32_t index, //Of the token in the AST
+	struct erw_Lines* lines
 );
 struct erw_Type* erw_scope_gettype(
 	struct erw_Scope* self, 
-	struct erw_Token* token,
-	struct Str* lines
+	uint32_t index, //Of the token in the AST
+	struct erw_Lines* lines
 );
 struct erw_Type* erw_scope_createtype(
 	struct erw_Scope* self, 
 	struct erw_ASTNode* node,
-	struct Str* lines
+	struct erw_Lines* lines
 );
 void erw_scope_addvardeclr(
 	struct erw_Scope* self, 
 	struct erw_ASTNode* node,
-	struct Str* lines
+	struct erw_Lines* lines
 );
 void erw_scope_addfuncdeclr(
 	struct erw_Scope* self, 
 	struct erw_ASTNode* node,
-	struct Str* lines
+	struct erw_Lines* lines
 );
 void erw_scope_addtypedeclr(
 	struct erw_Scope* self, 
 	struct erw_ASTNode* node,
-	struct Str* lines
+	struct erw_Lines* lines
 );
-void erw_scope_print(struct erw_Scope* self, struct Str* lines);
+void erw_scope_print(struct erw_Scope* self, struct erw_Lines* lines);
 void erw_scope_dtor(struct erw_Scope* self);
 
 #endif
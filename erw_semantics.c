@@ -19,10 +19,13 @@
 
 #include "erw_semantics.h"
 #include "erw_error.h"
+#include "erw_intern.h"
 #include "log.h"
 #include <stdlib.h>
 
-static struct erw_ASTNode* erw_getfirstnode(struct erw_ASTNode* expr)
+static struct erw_ASTNode* erw_getfirstnode(
+	const struct erw_AST* ast,
+	struct erw_ASTNode* expr)
 {
 	struct erw_ASTNode* firstnode = expr;
 	while(firstnode->type == erw_ASTNODETYPE_UNEXPR 
@@ -31,32 +34,26 @@ static struct erw_ASTNode* erw_getfirstnode(struct erw_ASTNode* expr)
 		|| firstnode->type == erw_ASTNODETYPE_ACCESS
 		|| firstnode->type == erw_ASTNODETYPE_FUNCCALL)
 	{
-		if(firstnode->type == erw_ASTNODETYPE_UNEXPR)
+		switch(firstnode->type)
 		{
+		case erw_ASTNODETYPE_UNEXPR:
 			if(firstnode->unexpr.left)
 			{
-				break;
-			}
-			else
-			{
-				firstnode = firstnode->unexpr.expr;
+				return firstnode;
 			}
-		}
-		else if(firstnode->type == erw_ASTNODETYPE_BINEXPR)
-		{
-			firstnode = firstnode->binexpr.expr1;
-		}
-		else if(firstnode->type == erw_ASTNODETYPE_ACCESS)
-		{
-			firstnode = firstnode->access.expr;
-		}
-		else if(firstnode->type == erw_ASTNODETYPE_CAST
-			|| firstnode->type == erw_ASTNODETYPE_FUNCCALL)
-		{
+
+			firstnode = erw_ast_getnode(ast, firstnode->unexpr.expr);
 			break;
-		}
-		else
-		{
+		case erw_ASTNODETYPE_BINEXPR:
+			firstnode = erw_ast_getnode(ast, firstnode->binexpr.expr1);
+			break;
+		case erw_ASTNODETYPE_ACCESS:
+			firstnode = erw_ast_getnode(ast, firstnode->access.expr);
+			break;
+		case erw_ASTNODETYPE_CAST:
+		case erw_ASTNODETYPE_FUNCCALL:
+			return firstnode;
+		default:
 			log_assert(0, "this shouldn't happen");
 		}
 	}
@@ -64,7 +61,9 @@ static struct erw_ASTNode* erw_getfirstnode(struct erw_ASTNode* expr)
 	return firstnode;
 }
 
-static struct erw_ASTNode* erw_getlastnode(struct erw_ASTNode* expr)
+static struct erw_ASTNode* erw_getlastnode(
+	const struct erw_AST* ast,
+	struct erw_ASTNode* expr)
 {
 	struct erw_ASTNode* lastnode = expr;
 	while(lastnode->type == erw_ASTNODETYPE_UNEXPR 
@@ -74,53 +73,50 @@ static struct erw_ASTNode* erw_getlastnode(struct erw_ASTNode* expr)
 		|| lastnode->type == erw_ASTNODETYPE_UNIONLITERAL
 		|| lastnode->type == erw_ASTNODETYPE_ARRAYLITERAL)
 	{
-		if(lastnode->type == erw_ASTNODETYPE_UNEXPR)
+		switch(lastnode->type)
 		{
-			if(lastnode->unexpr.left)
+		case erw_ASTNODETYPE_UNEXPR:
+			if(!lastnode->unexpr.left)
 			{
-				lastnode = lastnode->unexpr.expr;
+				return lastnode;
 			}
-			else
-			{
-				break;
-			}
-		}
-		else if(lastnode->type == erw_ASTNODETYPE_BINEXPR)
-		{
-			lastnode = lastnode->binexpr.expr2;
-		}
-		else if(lastnode->type == erw_ASTNODETYPE_ACCESS)
-		{
-			lastnode = lastnode->access.expr;
-		}
-		else if(lastnode->type == erw_ASTNODETYPE_CAST)
-		{
-			lastnode = lastnode->cast.expr;
-		}
-		else if(lastnode->type == erw_ASTNODETYPE_FUNCCALL)
-		{
-			lastnode = lastnode->funccall.args[
-				vec_getsize(lastnode->funccall.args) - 1
-			];
-		}
-		else if(lastnode->type == erw_ASTNODETYPE_STRUCTLITERAL)
-		{
-			lastnode = lastnode->structliteral.values[
-				vec_getsize(lastnode->structliteral.values) - 1
-			];
-		}
-		else if(lastnode->type == erw_ASTNODETYPE_UNIONLITERAL)
-		{
-			lastnode = lastnode->unionliteral.value;
-		}
-		else if(lastnode->type == erw_ASTNODETYPE_ARRAYLITERAL)
-		{
-			lastnode = lastnode->arrayliteral.values[
-				vec_getsize(lastnode->arrayliteral.values) - 1
-			];
-		}
-		else
-		{
+
+			lastnode = erw_ast_getnode(ast, lastnode->unexpr.expr);
+			break;
+		case erw_ASTNODETYPE_BINEXPR:
+			lastnode = erw_ast_getnode(ast, lastnode->binexpr.expr2);
+			break;
+		case erw_ASTNODETYPE_ACCESS:
+			lastnode = erw_ast_getnode(ast, lastnode->access.expr);
+			break;
+		case erw_ASTNODETYPE_CAST:
+			lastnode = erw_ast_getnode(ast, lastnode->cast.expr);
+			break;
+		case erw_ASTNODETYPE_FUNCCALL:
+			lastnode = erw_ast_getchild(
+				ast,
+				lastnode->funccall.args,
+				lastnode->funccall.args.size - 1
+			);
+			break;
+		case erw_ASTNODETYPE_STRUCTLITERAL:
+			lastnode = erw_ast_getchild(
+				ast,
+				lastnode->structliteral.values,
+				lastnode->structliteral.values.size - 1
+			);
+			break;
+		case erw_ASTNODETYPE_UNIONLITERAL:
+			lastnode = erw_ast_getnode(ast, lastnode->unionliteral.value);
+			break;
+		case erw_ASTNODETYPE_ARRAYLITERAL:
+			lastnode = erw_ast_getchild(
+				ast,
+				lastnode->arrayliteral.values,
+				lastnode->arrayliteral.values.size - 1
+			);
+			break;
+		default:
 			log_assert(0, "this shouldn't happen");
 		}
 	}
@@ -129,10 +125,11 @@ static struct erw_ASTNode* erw_getlastnode(struct erw_ASTNode* expr)
 }
 
 static void erw_checkboolean(
+	const struct erw_AST* ast,
 	struct erw_Type* type,
 	struct erw_ASTNode* firstnode,
 	struct erw_ASTNode* lastnode,
-	struct Str* lines)
+	struct erw_Lines* lines)
 {
 	log_assert(type, "is NULL");
 	log_assert(
@@ -161,15 +158,16 @@ static void erw_checkboolean(
 			typename.data
 		);
 
+		struct erw_Token firsttoken = erw_ast_gettoken(ast, firstnode->token);
+		struct erw_Token lasttoken = erw_ast_gettoken(ast, lastnode->token);
 		erw_error(
 			msg.data, 
-			lines[firstnode->token->linenum - 1].data,
-			firstnode->token->linenum, 
-			firstnode->token->column,
-			(lastnode->token->linenum == firstnode->token->linenum) 
-				? (size_t)(lastnode->token->column + vec_getsize(
-						lastnode->token->text)) - 2
-				: lines[firstnode->token->linenum - 1].len
+			erw_lines_get(lines, firsttoken.linenum),
+			firsttoken.linenum, 
+			firsttoken.column,
+			(lasttoken.linenum == firsttoken.linenum) 
+				? lasttoken.column + lasttoken.len - 1
+				: erw_lines_getlen(lines, firsttoken.linenum)
 		);
 		str_dtor(&msg);
 		str_dtor(&typename);
@@ -177,10 +175,11 @@ static void erw_checkboolean(
 }
 
 static void erw_checknumerical(
+	const struct erw_AST* ast,
 	struct erw_Type* type,
 	struct erw_ASTNode* firstnode,
 	struct erw_ASTNode* lastnode,
-	struct Str* lines)
+	struct erw_Lines* lines)
 {
 	log_assert(type, "is NULL");
 	log_assert(
@@ -208,15 +207,16 @@ static void erw_checknumerical(
 			typename.data
 		);
 
+		struct erw_Token firsttoken = erw_ast_gettoken(ast, firstnode->token);
+		struct erw_Token lasttoken = erw_ast_gettoken(ast, lastnode->token);
 		erw_error(
 			msg.data, 
-			lines[firstnode->token->linenum - 1].data,
-			firstnode->token->linenum, 
-			firstnode->token->column,
-			(lastnode->token->linenum == firstnode->token->linenum) 
-				? (size_t)(lastnode->token->column + vec_getsize(
-						lastnode->token->text)) - 2
-				: lines[firstnode->token->linenum - 1].len
+			erw_lines_get(lines, firsttoken.linenum),
+			firsttoken.linenum, 
+			firsttoken.column,
+			(lasttoken.linenum == firsttoken.linenum) 
+				? lasttoken.column + lasttoken.len - 1
+				: erw_lines_getlen(lines, firsttoken.linenum)
 		);
 		str_dtor(&msg);
 	}
@@ -227,7 +227,7 @@ static void erw_checkint(
 	struct erw_Type* type,
 	struct erw_ASTNode* firstnode,
 	struct erw_ASTNode* lastnode,
-	struct Str* lines)
+	struct erw_Lines* lines)
 {
 	log_assert(type, "is NULL");
 	log_assert(firstnode, "is NULL");
@@ -247,13 +247,12 @@ static void erw_checkint(
 
 		erw_error(
 			msg.data, 
-			lines[firstnode->token.linenum - 1].data,
+			erw_lines_get(lines, firstnode->token.linenum),
 			firstnode->token.linenum, 
 			firstnode->token.column,
 			(lastnode->token.linenum == firstnode->token.linenum) 
-				? (size_t)(lastnode->token.column + vec_getsize(
-						lastnode->token.text)) - 2
-				: lines[firstnode->token.linenum - 1].len
+				? lastnode->token.column + lastnode->token.len - 1
+				: erw_lines_getlen(lines, firstnode->token.linenum)
 		);
 		str_dtor(&msg);
 	}
@@ -263,13 +262,13 @@ static void erw_checkint(
 static struct erw_Type* erw_getexprtype(
 	struct erw_Scope* scope,
 	struct erw_ASTNode* exprnode,
-	struct Str* lines
+	struct erw_Lines* lines
 );
 
 static struct erw_Type* erw_getaccesstype(
 	struct erw_Scope* scope, 
 	struct erw_ASTNode* accessnode, 
-	struct Str* lines)
+	struct erw_Lines* lines)
 {
 	log_assert(scope, "is NULL");
 	log_assert(accessnode, "is NULL");
@@ -277,27 +276,36 @@ static struct erw_Type* erw_getaccesstype(
 
 	struct erw_Type* type = erw_getexprtype(
 		scope, 
-		accessnode->binexpr.expr1,
+		erw_ast_getnode(scope->ast, accessnode->binexpr.expr1),
 		lines
 	);
 
 	struct erw_TypeStructMember* ret = NULL;
-	struct erw_ASTNode* firstnode = erw_getlastnode(accessnode->binexpr.expr1);
+	struct erw_ASTNode* firstnode = erw_getlastnode(
+		scope->ast,
+		erw_ast_getnode(scope->ast, accessnode->binexpr.expr1)
+	);
 	if(!type)
 	{
 		struct Str msg;
 		str_ctorfmt(
 			&msg, 
 			"Attempt to access member of literal ('%s')", 
-			accessnode->binexpr.expr1->type->name
+			erw_astnodetypenames[
+				erw_ast_getnode(scope->ast, accessnode->binexpr.expr1)->type
+			]
 		);
 
+		struct erw_Token firsttoken = erw_ast_gettoken(
+			scope->ast, 
+			firstnode->token
+		);
 		erw_error(
 			msg.data, 
-			lines[firstnode->token->linenum - 1].data,
-			firstnode->token->linenum, 
-			firstnode->token->column,
-			firstnode->token->column + vec_getsize(firstnode->token->text) - 2
+			erw_lines_get(lines, firsttoken.linenum),
+			firsttoken.linenum, 
+			firsttoken.column,
+			firsttoken.column + firsttoken.len - 1
 		);
 		str_dtor(&msg);
 	}
@@ -319,22 +327,29 @@ static struct erw_Type* erw_getaccesstype(
 				typename.data
 			);
 
+			struct erw_Token firsttoken = erw_ast_gettoken(
+				scope->ast, 
+				firstnode->token
+			);
 			erw_error(
 				msg.data, 
-				lines[firstnode->token->linenum - 1].data,
-				firstnode->token->linenum, 
-				firstnode->token->column,
-				firstnode->token->column + vec_getsize(firstnode->token->text)
-					- 2
+				erw_lines_get(lines, firsttoken.linenum),
+				firsttoken.linenum, 
+				firsttoken.column,
+				firsttoken.column + firsttoken.len - 1
 			);
 			str_dtor(&msg);
 		}
 
-		struct erw_ASTNode* node = erw_getfirstnode(accessnode->binexpr.expr2);
+		struct erw_ASTNode* node = erw_getfirstnode(
+			scope->ast,
+			erw_ast_getnode(scope->ast, accessnode->binexpr.expr2)
+		);
 		struct erw_TypeStructMember* member = NULL;
 		for(size_t i = 0; i < vec_getsize(base->struct_.members); i++)
 		{
-			if(!strcmp(base->struct_.members[i].name, node->token->text))
+			if(erw_ast_getstr(scope->ast, node->token) 
+				== base->struct_.members[i].name)
 			{
 				member = &base->struct_.members[i];
 				ret = member;
@@ -349,16 +364,17 @@ static struct erw_Type* erw_getaccesstype(
 				&msg, 
 				"Struct '%s' ('%s') has no member named '%s'", 
 				typename.data,
-				firstnode->token->text,
-				node->token->text
+				erw_ast_getstr(scope->ast, firstnode->token),
+				erw_ast_getstr(scope->ast, node->token)
 			);
 
+			struct erw_Token token = erw_ast_gettoken(scope->ast, node->token);
 			erw_error(
 				msg.data, 
-				lines[node->token->linenum - 1].data,
-				node->token->linenum, 
-				node->token->column,
-				node->token->column + vec_getsize(node->token->text) - 2
+				erw_lines_get(lines, token.linenum),
+				token.linenum, 
+				token.column,
+				token.column + token.len - 1
 			);
 			str_dtor(&msg);
 			str_dtor(&typename);
@@ -372,14 +388,14 @@ static void erw_checkexprtype(
 	struct erw_Scope* scope,
 	struct erw_ASTNode* exprnode,
 	struct erw_Type* type,
-	struct Str* lines
+	struct erw_Lines* lines
 );
 
 static struct erw_Type* erw_deduceliteraltype(
 	struct erw_Scope* scope,
 	struct erw_Type* type,
 	struct erw_ASTNode* literal,
-	struct Str* lines)
+	struct erw_Lines* lines)
 {
 	log_assert(scope, "is NULL");
 	log_assert(type, "is NULL");
@@ -388,7 +404,7 @@ static struct erw_Type* erw_deduceliteraltype(
 			|| literal->type == erw_ASTNODETYPE_UNIONLITERAL
 			|| literal->type == erw_ASTNODETYPE_ARRAYLITERAL, 
 		"invalid literal (%s)",
-		literal->type->name
+		erw_astnodetypenames[literal->type]
 	);
 	log_assert(literal, "is NULL");
 	log_assert(lines, "is NULL");
@@ -402,43 +418,46 @@ static struct erw_Type* erw_deduceliteraltype(
 	if(base->info == erw_TYPEINFO_STRUCT 
 		&& literal->type == erw_ASTNODETYPE_STRUCTLITERAL)
 	{
-		Vec(struct erw_Token*) members = vec_ctor(struct erw_Token*, 0);
-		for(size_t i = 0; i < vec_getsize(literal->structliteral.names); i++)
+		Vec(struct erw_Token) members = vec_ctor(struct erw_Token, 0);
+		for(size_t i = 0; i < literal->structliteral.names.size; i++)
 		{
+			struct erw_ASTNode* namenode = erw_ast_getchild(
+				scope->ast,
+				literal->structliteral.names,
+				i
+			);
+			struct erw_Token name = erw_ast_gettoken(
+				scope->ast, 
+				namenode->token
+			);
 			int found = 0;
 			for(size_t j = 0; j < vec_getsize(base->struct_.members); j++)
 			{
-				if(!strcmp(
-					literal->structliteral.names[i]->text, 
-					base->struct_.members[j].name))
+				if(erw_token_getstr(&name) 
+					== base->struct_.members[j].name)
 				{
 					for(size_t k = 0; k < vec_getsize(members); k++)
 					{
-						if(!strcmp(
-							members[k]->text, 
-							literal->structliteral.names[i]->text))
+						if(erw_token_getstr(&members[k]) 
+							== erw_token_getstr(&name))
 						{
 							struct Str msg;
 							str_ctorfmt(
 								&msg, 
 								"Member '%s' has already been initialized at"
 									" line %zu, column %zu", 
-								members[k]->text,
-								members[k]->linenum,
-								members[k]->column
+								erw_token_getstr(&members[k]),
+								members[k].linenum,
+								members[k].column
 							);
 
 							erw_error(
 								msg.data, 
-								lines[
-									literal->structliteral.names[i]->linenum - 1
-								].data,
-								literal->structliteral.names[i]->linenum, 
-								literal->structliteral.names[i]->column,
-								literal->structliteral.names[i]->column 
-									+ vec_getsize(
-										literal->structliteral.names[i]->text
-									) - 2
+								erw_lines_get(lines, name.linenum),
+								name.linenum, 
+								name.column,
+								name.column 
+									+ name.len - 1
 							);
 
 							str_dtor(&msg);
@@ -448,13 +467,17 @@ static struct erw_Type* erw_deduceliteraltype(
 					//Check for errors
 					erw_checkexprtype(
 						scope, 
-						literal->structliteral.values[i], 
+						erw_ast_getchild(
+							scope->ast,
+							literal->structliteral.values,
+							i
+						),
 						base->struct_.members[j].type,
 						lines
 					);
 
 					found = 1;
-					vec_pushback(members, literal->structliteral.names[i]);
+					vec_pushback(members, name);
 					break;
 				}
 			}
@@ -467,16 +490,16 @@ static struct erw_Type* erw_deduceliteraltype(
 					&msg, 
 					"Struct '%s' has no member named '%s'", 
 					typename.data,
-					literal->structliteral.names[i]->text
+					erw_token_getstr(&name)
 				);
 
 				erw_error(
 					msg.data, 
-					lines[literal->structliteral.names[i]->linenum - 1].data,
-					literal->structliteral.names[i]->linenum, 
-					literal->structliteral.names[i]->column,
-					literal->structliteral.names[i]->column 
-						+ vec_getsize(literal->structliteral.names[i]->text) - 2
+					erw_lines_get(lines, name.linenum),
+					name.linenum, 
+					name.column,
+					name.column 
+						+ name.len - 1
 				);
 
 				str_dtor(&msg);
@@ -503,7 +526,8 @@ static struct erw_Type* erw_deduceliteraltype(
 				int found = 0;
 				for(size_t j = 0; j < nummembers; j++)
 				{
-					if(!strcmp(members[j]->text, base->struct_.members[i].name))
+					if(erw_token_getstr(&members[j]) 
+						== base->struct_.members[i].name)
 					{
 						found = 1;
 						break;
@@ -520,12 +544,16 @@ static struct erw_Type* erw_deduceliteraltype(
 				}
 			}
 
+			struct erw_Token literaltoken = erw_ast_gettoken(
+				scope->ast, 
+				literal->token
+			);
 			erw_error(
 				msg.data, 
-				lines[literal->token->linenum - 1].data,
-				literal->token->linenum,
-				literal->token->column,
-				literal->token->column + vec_getsize(literal->token->text) - 2
+				erw_lines_get(lines, literaltoken.linenum),
+				literaltoken.linenum,
+				literaltoken.column,
+				literaltoken.column + literaltoken.len - 1
 			);
 
 			str_dtor(&msg);
@@ -537,7 +565,7 @@ static struct erw_Type* erw_deduceliteraltype(
 	{
 		struct erw_Type* literaltype = erw_scope_createtype(
 			scope, 
-			literal->unionliteral.type, 
+			erw_ast_getnode(scope->ast, literal->unionliteral.type), 
 			lines
 		);
 
@@ -551,7 +579,7 @@ static struct erw_Type* erw_deduceliteraltype(
 				//Check for errors
 				erw_checkexprtype(
 					scope, 
-					literal->unionliteral.value, 
+					erw_ast_getnode(scope->ast, literal->unionliteral.value), 
 					literaltype,
 					lines
 				);
@@ -574,12 +602,16 @@ static struct erw_Type* erw_deduceliteraltype(
 				literalname.data
 			);
 
+			struct erw_Token literaltoken = erw_ast_gettoken(
+				scope->ast, 
+				literal->token
+			);
 			erw_error(
 				msg.data, 
-				lines[literal->token->linenum - 1].data,
-				literal->token->linenum,
-				literal->token->column,
-				literal->token->column + vec_getsize(literal->token->text) - 2
+				erw_lines_get(lines, literaltoken.linenum),
+				literaltoken.linenum,
+				literaltoken.column,
+				literaltoken.column + literaltoken.len - 1
 			);
 
 			str_dtor(&msg);
@@ -591,13 +623,13 @@ static struct erw_Type* erw_deduceliteraltype(
 	else if(base->info == erw_TYPEINFO_ARRAY
 		&& literal->type == erw_ASTNODETYPE_ARRAYLITERAL)
 	{
-		size_t literalnum = vec_getsize(literal->arrayliteral.values);
+		size_t literalnum = literal->arrayliteral.values.size;
 		for(size_t i = 0; i < literalnum; i++)
 		{
 			//Check for errors
 			erw_checkexprtype(
 				scope, 
-				literal->arrayliteral.values[i], 
+				erw_ast_getchild(scope->ast, literal->arrayliteral.values, i), 
 				base->array.type,
 				lines
 			);
@@ -615,12 +647,16 @@ static struct erw_Type* erw_deduceliteraltype(
 				literalnum
 			);
 
+			struct erw_Token literaltoken = erw_ast_gettoken(
+				scope->ast, 
+				literal->token
+			);
 			erw_error(
 				msg.data, 
-				lines[literal->token->linenum - 1].data,
-				literal->token->linenum,
-				literal->token->column,
-				literal->token->column + vec_getsize(literal->token->text) - 2
+				erw_lines_get(lines, literaltoken.linenum),
+				literaltoken.linenum,
+				literaltoken.column,
+				literaltoken.column + literaltoken.len - 1
 			);
 
 			str_dtor(&msg);
@@ -637,15 +673,19 @@ static struct erw_Type* erw_deduceliteraltype(
 			"Unable to deduce type '%s' (%s) from '%s'",
 			typename.data,
 			basename.data,
-			literal->type->name
+			erw_astnodetypenames[literal->type]
+		);
+		struct erw_Token literaltoken = erw_ast_gettoken(
+			scope->ast, 
+			literal->token
 		);
 		erw_error(
 			msg.data, 
-			lines[literal->token->linenum - 1].data,
-			literal->token->linenum, 
-			literal->token->column,
-			literal->token->column 
-				+ vec_getsize(literal->token->text) - 2
+			erw_lines_get(lines, literaltoken.linenum),
+			literaltoken.linenum, 
+			literaltoken.column,
+			literaltoken.column 
+				+ literaltoken.len - 1
 		);
 
 		str_dtor(&msg);
@@ -659,39 +699,69 @@ static struct erw_Type* erw_deduceliteraltype(
 static void erw_checkfunccall(
 	struct erw_Scope* scope,
 	struct erw_ASTNode* callnode,
-	struct Str* lines
+	struct erw_Lines* lines
 );
 
+//Numbers that don't fit 64 bits were already flagged by the tokenizer
+static void erw_checkliteralsize(
+	const struct erw_AST* ast,
+	uint32_t index, 
+	struct erw_Lines* lines)
+{
+	if(erw_ast_getliteral(ast, index).flags 
+		& (erw_TOKENFLAG_UINTOVERFLOW | erw_TOKENFLAG_FLOATOVERFLOW))
+	{
+		struct erw_Token token = erw_ast_gettoken(ast, index);
+		struct Str msg;
+		str_ctorfmt(
+			&msg,
+			"%s is too large",
+			erw_tokentypeinfos[token.type].name
+		);
+
+		erw_error(
+			msg.data, 
+			erw_lines_get(lines, token.linenum), 
+			token.linenum, 
+			token.column,
+			token.column + token.len - 1
+		);
+		str_dtor(&msg);
+	}
+}
+
 static struct erw_Type* erw_getexprtype(
 	struct erw_Scope* scope,
 	struct erw_ASTNode* exprnode,
-	struct Str* lines)
+	struct erw_Lines* lines)
 {
 	log_assert(scope, "is NULL");
 	log_assert(exprnode, "is NULL");
 	log_assert(lines, "is NULL");
 
 	struct erw_Type* ret = NULL;
-	if(exprnode->type == erw_ASTNODETYPE_CAST)
+	switch(exprnode->type)
 	{
-		//TODO: Check if types are compatible
-		ret = erw_scope_createtype(scope, exprnode->cast.type, lines); 
-
-		//Check for errors
-		struct erw_Type* type = erw_getexprtype(
-			scope, 
-			exprnode->cast.expr, 
-			lines
-		);
-
-		if(type)
+	case erw_ASTNODETYPE_CAST:
 		{
-			erw_type_dtor(type);
+			//TODO: Check if types are compatible
+			ret = erw_scope_createtype(
+				scope,
+				erw_ast_getnode(scope->ast, exprnode->cast.type),
+				lines
+			);
+
+			//Check for errors
+			erw_getexprtype(
+				scope, 
+				erw_ast_getnode(scope->ast, exprnode->cast.expr), 
+				lines
+			);
 		}
-	}
-	else if(exprnode->type == erw_ASTNODETYPE_BINEXPR)
-	{
-		if(exprnode->token->type == erw_TOKENTYPE_OPERATOR_ACCESS)
+		break;
+	case erw_ASTNODETYPE_BINEXPR:
+		if(erw_ast_gettokentype(scope->ast, exprnode->token) 
+			== erw_TOKENTYPE_OPERATOR_ACCESS)
 		{
 			ret = erw_getaccesstype(scope, exprnode, lines);
 		}
@@ -699,37 +769,46 @@ static struct erw_Type* erw_getexprtype(
 		{
 			struct erw_Type* typesym1 = erw_getexprtype(
 				scope, 
-				exprnode->binexpr.expr1, 
+				erw_ast_getnode(scope->ast, exprnode->binexpr.expr1), 
 				lines
 			);
 
 			struct erw_Type* typesym2 = erw_getexprtype(
 				scope, 
-				exprnode->binexpr.expr2, 
+				erw_ast_getnode(scope->ast, exprnode->binexpr.expr2), 
 				lines
 			);
 
 			struct erw_ASTNode* firstnode = erw_getfirstnode(
-				exprnode->binexpr.expr1
+				scope->ast,
+				erw_ast_getnode(scope->ast, exprnode->binexpr.expr1)
 			);
 
 			struct erw_ASTNode* lastnode = erw_getlastnode(
-				exprnode->binexpr.expr2
+				scope->ast,
+				erw_ast_getnode(scope->ast, exprnode->binexpr.expr2)
 			);
 
 			if(!typesym1 && !typesym2)
 			{
 				struct Str msg;
 				str_ctor(&msg, "Cannot deduce type (got two untyped literals)");
+				struct erw_Token firsttoken = erw_ast_gettoken(
+					scope->ast, 
+					firstnode->token
+				);
+				struct erw_Token lasttoken = erw_ast_gettoken(
+					scope->ast, 
+					lastnode->token
+				);
 				erw_error(
 					msg.data, 
-					lines[firstnode->token->linenum - 1].data,
-					firstnode->token->linenum, 
-					lastnode->token->column,
-					(lastnode->token->linenum == firstnode->token->linenum) 
-						? (size_t)(lastnode->token->column + vec_getsize(
-								lastnode->token->text)) - 2
-						: lines[firstnode->token->linenum - 1].len
+					erw_lines_get(lines, firsttoken.linenum),
+					firsttoken.linenum, 
+					lasttoken.column,
+					(lasttoken.linenum == firsttoken.linenum) 
+						? lasttoken.column + lasttoken.len - 1
+						: erw_lines_getlen(lines, firsttoken.linenum)
 				);
 				str_dtor(&msg);
 			}
@@ -743,19 +822,28 @@ static struct erw_Type* erw_getexprtype(
 					str_ctorfmt(
 						&msg,
 						"%s expected type '%s', got type '%s'",
-						exprnode->token->type->name,
+						erw_tokentypeinfos[
+							erw_ast_gettokentype(scope->ast, exprnode->token)
+						].name,
 						typename1.data,
 						typename2.data
 					);
+					struct erw_Token firsttoken = erw_ast_gettoken(
+						scope->ast, 
+						firstnode->token
+					);
+					struct erw_Token lasttoken = erw_ast_gettoken(
+						scope->ast, 
+						lastnode->token
+					);
 					erw_error(
 						msg.data, 
-						lines[firstnode->token->linenum - 1].data,
-						firstnode->token->linenum, 
-						lastnode->token->column,
-						(lastnode->token->linenum == firstnode->token->linenum) 
-							? (size_t)(lastnode->token->column + vec_getsize(
-									lastnode->token->text)) - 2
-							: lines[firstnode->token->linenum - 1].len
+						erw_lines_get(lines, firsttoken.linenum),
+						firsttoken.linenum, 
+						lasttoken.column,
+						(lasttoken.linenum == firsttoken.linenum) 
+							? lasttoken.column + lasttoken.len - 1
+							: erw_lines_getlen(lines, firsttoken.linenum)
 					);
 					str_dtor(&msg);
 					str_dtor(&typename2);
@@ -769,12 +857,18 @@ static struct erw_Type* erw_getexprtype(
 				if(typesym1)
 				{
 					type = typesym1;
-					literal = exprnode->binexpr.expr2;
+					literal = erw_ast_getnode(
+						scope->ast,
+						exprnode->binexpr.expr2
+					);
 				}
 				else
 				{
 					type = typesym2;
-					literal = exprnode->binexpr.expr1;
+					literal = erw_ast_getnode(
+						scope->ast,
+						exprnode->binexpr.expr1
+					);
 				}
 
 				ret = erw_deduceliteraltype(
@@ -785,400 +879,510 @@ static struct erw_Type* erw_getexprtype(
 				);
 			}
 
-			if(exprnode->token->type == erw_TOKENTYPE_OPERATOR_LESS 
-				|| exprnode->token->type == erw_TOKENTYPE_OPERATOR_LESSOREQUAL 
-				|| exprnode->token->type == erw_TOKENTYPE_OPERATOR_GREATER 
-				|| exprnode->token->type 
-					== erw_TOKENTYPE_OPERATOR_GREATEROREQUAL)
+			switch(erw_ast_gettokentype(scope->ast, exprnode->token))
 			{
+			case erw_TOKENTYPE_OPERATOR_LESS:
+			case erw_TOKENTYPE_OPERATOR_LESSOREQUAL:
+			case erw_TOKENTYPE_OPERATOR_GREATER:
+			case erw_TOKENTYPE_OPERATOR_GREATEROREQUAL:
 				ret = erw_type_builtins[erw_TYPEBUILTIN_BOOL];
-				erw_checknumerical(typesym1, firstnode, lastnode, lines);
-				erw_type_dtor(typesym1);
-			}
-			else if(exprnode->token->type == erw_TOKENTYPE_OPERATOR_EQUAL 
-				|| exprnode->token->type == erw_TOKENTYPE_OPERATOR_NOTEQUAL)
-			{
+				erw_checknumerical(
+					scope->ast,
+					typesym1,
+					firstnode,
+					lastnode,
+					lines
+				);
+				break;
+			case erw_TOKENTYPE_OPERATOR_EQUAL:
+			case erw_TOKENTYPE_OPERATOR_NOTEQUAL:
 				ret = erw_type_builtins[erw_TYPEBUILTIN_BOOL];
-				erw_type_dtor(typesym1);
-			}
-			else if(exprnode->token->type == erw_TOKENTYPE_OPERATOR_OR 
-				|| exprnode->token->type == erw_TOKENTYPE_OPERATOR_AND)
-			{
+				break;
+			case erw_TOKENTYPE_OPERATOR_OR:
+			case erw_TOKENTYPE_OPERATOR_AND:
 				ret = erw_type_builtins[erw_TYPEBUILTIN_BOOL];
-				erw_checkboolean(typesym1, firstnode, lastnode, lines);
-				erw_type_dtor(typesym1);
-			}
-			else
-			{
+				erw_checkboolean(
+					scope->ast,
+					typesym1,
+					firstnode,
+					lastnode,
+					lines
+				);
+				break;
+			default:
 				ret = typesym1;
-				erw_checknumerical(ret, firstnode, lastnode, lines);
+				erw_checknumerical(scope->ast, ret, firstnode, lastnode, lines);
+				break;
 			}
-
-			erw_type_dtor(typesym2);
 		}
-	}
-	else if(exprnode->type == erw_ASTNODETYPE_UNEXPR)
-	{
-		struct erw_ASTNode* firstnode = erw_getfirstnode(exprnode->unexpr.expr);
-		struct erw_ASTNode* lastnode = erw_getlastnode(exprnode->unexpr.expr);
-		if(exprnode->token->type == erw_TOKENTYPE_OPERATOR_BITAND)
+		break;
+	case erw_ASTNODETYPE_UNEXPR:
 		{
-			if(exprnode->unexpr.left)
+			struct erw_ASTNode* firstnode = erw_getfirstnode(
+				scope->ast,
+				erw_ast_getnode(scope->ast, exprnode->unexpr.expr)
+			);
+			struct erw_ASTNode* lastnode = erw_getlastnode(
+				scope->ast,
+				erw_ast_getnode(scope->ast, exprnode->unexpr.expr)
+			);
+			if(erw_ast_gettokentype(scope->ast, exprnode->token) 
+				== erw_TOKENTYPE_OPERATOR_BITAND)
 			{
-				//Should it only handle identifiers?
-				struct erw_Type* type = erw_type_new(
-					erw_TYPEINFO_REFERENCE, 
-					NULL
-				);
+				if(exprnode->unexpr.left)
+				{
+					//Should it only handle identifiers?
+					struct erw_Type* type = erw_getexprtype(
+						scope, 
+						erw_ast_getnode(scope->ast, exprnode->unexpr.expr), 
+						lines
+					);
 
-				type->reference.mutable = 0; //NOTE: Temporary
-				type->reference.size = sizeof(void*); //NOTE: Temporary
-				type->reference.type = erw_getexprtype(
-					scope, 
-					exprnode->unexpr.expr, 
-					lines
-				);
+					if(!type)
+					{
+						struct Str msg;
+						str_ctor(
+							&msg,
+							"Cannot deduce type (got untyped literal)"
+						);
+						struct erw_Token firsttoken = erw_ast_gettoken(
+							scope->ast, 
+							firstnode->token
+						);
+						struct erw_Token lasttoken = erw_ast_gettoken(
+							scope->ast, 
+							lastnode->token
+						);
+						erw_error(
+							msg.data, 
+							erw_lines_get(lines, firsttoken.linenum),
+							firsttoken.linenum, 
+							firsttoken.column,
+							(lasttoken.linenum 
+								== firsttoken.linenum) 
+								? lasttoken.column 
+									+ lasttoken.len - 1
+								: erw_lines_getlen(lines, firsttoken.linenum)
+						);
+						str_dtor(&msg);
+					}
 
-				if(!type->reference.type)
+					ret = erw_type_getreference(type, 0); //NOTE: Temporary
+				}
+				else
 				{
-					struct Str msg;
-					str_ctor(&msg, "Cannot deduce type (got untyped literal)");
-					erw_error(
-						msg.data, 
-						lines[firstnode->token->linenum - 1].data,
-						firstnode->token->linenum, 
-						firstnode->token->column,
-						(lastnode->token->linenum == firstnode->token->linenum) 
-							? (size_t)(lastnode->token->column + vec_getsize(
-									lastnode->token->text)) - 2
-							: lines[firstnode->token->linenum - 1].len
+					struct erw_Type* type = erw_getexprtype(
+						scope,
+						erw_ast_getnode(scope->ast, exprnode->unexpr.expr),
+						lines
 					);
-					str_dtor(&msg);
-				}
 
-				ret = type;
+					if(!type)
+					{
+						struct Str msg;
+						str_ctor(
+							&msg,
+							"Cannot deduce type (got untyped literal)"
+						);
+						struct erw_Token firsttoken = erw_ast_gettoken(
+							scope->ast, 
+							firstnode->token
+						);
+						struct erw_Token lasttoken = erw_ast_gettoken(
+							scope->ast, 
+							lastnode->token
+						);
+						erw_error(
+							msg.data, 
+							erw_lines_get(lines, firsttoken.linenum),
+							firsttoken.linenum, 
+							firsttoken.column,
+							(lasttoken.linenum 
+								== firsttoken.linenum) 
+								? lasttoken.column 
+									+ lasttoken.len - 1
+								: erw_lines_getlen(lines, firsttoken.linenum)
+						);
+						str_dtor(&msg);
+					}
+				
+					if(type->info != erw_TYPEINFO_REFERENCE)
+					{
+						struct Str str = erw_type_tostring(type);
+						struct Str msg;
+						str_ctorfmt(
+							&msg, 
+							"Trying to dereference a non-reference type (%s)",
+							str.data
+						);
+						struct erw_Token firsttoken = erw_ast_gettoken(
+							scope->ast, 
+							firstnode->token
+						);
+						struct erw_Token lasttoken = erw_ast_gettoken(
+							scope->ast, 
+							lastnode->token
+						);
+						erw_error(
+							msg.data, 
+							erw_lines_get(lines, firsttoken.linenum),
+							firsttoken.linenum, 
+							firsttoken.column,
+							(lasttoken.linenum 
+								== firsttoken.linenum) 
+								? lasttoken.column 
+									+ lasttoken.len - 1
+								: erw_lines_getlen(lines, firsttoken.linenum)
+						);
+						str_dtor(&msg);
+						str_dtor(&str);
+					}
+
+					ret = type->reference.type;
+				}
 			}
 			else
 			{
-				struct erw_Type* type = erw_getexprtype(
+				ret = erw_getexprtype(
 					scope,
-					exprnode->unexpr.expr,
+					erw_ast_getnode(scope->ast, exprnode->unexpr.expr),
 					lines
 				);
-
-				if(!type)
+				if(!ret)
 				{
 					struct Str msg;
 					str_ctor(&msg, "Cannot deduce type (got untyped literal)");
+					struct erw_Token firsttoken = erw_ast_gettoken(
+						scope->ast, 
+						firstnode->token
+					);
+					struct erw_Token lasttoken = erw_ast_gettoken(
+						scope->ast, 
+						lastnode->token
+					);
 					erw_error(
 						msg.data, 
-						lines[firstnode->token->linenum - 1].data,
-						firstnode->token->linenum, 
-						firstnode->token->column,
-						(lastnode->token->linenum == firstnode->token->linenum) 
-							? (size_t)(lastnode->token->column + vec_getsize(
-									lastnode->token->text)) - 2
-							: lines[firstnode->token->linenum - 1].len
+						erw_lines_get(lines, firsttoken.linenum),
+						firsttoken.linenum, 
+						firsttoken.column,
+						(lasttoken.linenum == firsttoken.linenum) 
+							? lasttoken.column + lasttoken.len - 1
+							: erw_lines_getlen(lines, firsttoken.linenum)
 					);
 					str_dtor(&msg);
 				}
-				
-				if(type->info != erw_TYPEINFO_REFERENCE)
+
+				switch(erw_ast_gettokentype(scope->ast, exprnode->token))
 				{
-					struct Str str = erw_type_tostring(type);
-					struct Str msg;
-					str_ctorfmt(
-						&msg, 
-						"Trying to dereference a non-reference type (%s)",
-						str.data
+				case erw_TOKENTYPE_OPERATOR_NOT:
+					erw_checkboolean(
+						scope->ast,
+						ret,
+						firstnode,
+						lastnode,
+						lines
 					);
-					erw_error(
-						msg.data, 
-						lines[firstnode->token->linenum - 1].data,
-						firstnode->token->linenum, 
-						firstnode->token->column,
-						(lastnode->token->linenum == firstnode->token->linenum) 
-							? (size_t)(lastnode->token->column + vec_getsize(
-									lastnode->token->text)) - 2
-							: lines[firstnode->token->linenum - 1].len
+					break;
+				case erw_TOKENTYPE_OPERATOR_SUB:
+					erw_checknumerical(
+						scope->ast,
+						ret,
+						firstnode,
+						lastnode,
+						lines
+					);
+					break;
+				default:
+					log_assert(
+						0, 
+						"this shouldn't happen (%s)", 
+						erw_tokentypeinfos[
+							erw_ast_gettokentype(scope->ast, exprnode->token)
+						].name
 					);
-					str_dtor(&msg);
-					str_dtor(&str);
 				}
-
-				ret = type->reference.type;
 			}
 		}
-		else
+		break;
+	case erw_ASTNODETYPE_ACCESS:
 		{
-			ret = erw_getexprtype(scope, exprnode->unexpr.expr, lines);
-			if(!ret)
+			struct erw_ASTNode* firstnode = erw_getfirstnode(
+				scope->ast,
+				erw_ast_getnode(scope->ast, exprnode->access.expr)
+			);
+			struct erw_ASTNode* lastnode = erw_getlastnode(
+				scope->ast,
+				erw_ast_getnode(scope->ast, exprnode->access.expr)
+			);
+			struct erw_Type* type = erw_getexprtype(
+				scope,
+				erw_ast_getnode(scope->ast, exprnode->access.expr),
+				lines
+			);
+
+			if(!type)
 			{
 				struct Str msg;
 				str_ctor(&msg, "Cannot deduce type (got untyped literal)");
+				struct erw_Token firsttoken = erw_ast_gettoken(
+					scope->ast, 
+					firstnode->token
+				);
+				struct erw_Token lasttoken = erw_ast_gettoken(
+					scope->ast, 
+					lastnode->token
+				);
 				erw_error(
 					msg.data, 
-					lines[firstnode->token->linenum - 1].data,
-					firstnode->token->linenum, 
-					firstnode->token->column,
-					(lastnode->token->linenum == firstnode->token->linenum) 
-						? (size_t)(lastnode->token->column + vec_getsize(
-								lastnode->token->text)) - 2
-						: lines[firstnode->token->linenum - 1].len
+					erw_lines_get(lines, firsttoken.linenum),
+					firsttoken.linenum, 
+					firsttoken.column,
+					(lasttoken.linenum == firsttoken.linenum) 
+						? lasttoken.column + lasttoken.len - 1
+						: erw_lines_getlen(lines, firsttoken.linenum)
 				);
 				str_dtor(&msg);
 			}
-
-			if(exprnode->token->type == erw_TOKENTYPE_OPERATOR_NOT)
-			{
-				erw_checkboolean(ret, firstnode, lastnode, lines);
-			}
-			else if(exprnode->token->type == erw_TOKENTYPE_OPERATOR_SUB)
-			{
-				erw_checknumerical(ret, firstnode, lastnode, lines);
-			}
-			else
+		
+			//TODO: Check if index is too big/small if array
+			if(type->info != erw_TYPEINFO_ARRAY 
+				&& type->info != erw_TYPEINFO_SLICE)
 			{
-				log_assert(
-					0, 
-					"this shouldn't happen (%s)", 
-					exprnode->token->type->name
+				struct Str str = erw_type_tostring(type);
+				struct Str msg;
+				str_ctorfmt(
+					&msg, 
+					"Trying to access a non-array/slice type (%s)",
+					str.data
+				);
+				struct erw_Token firsttoken = erw_ast_gettoken(
+					scope->ast, 
+					firstnode->token
 				);
+				struct erw_Token lasttoken = erw_ast_gettoken(
+					scope->ast, 
+					lastnode->token
+				);
+				erw_error(
+					msg.data, 
+					erw_lines_get(lines, firsttoken.linenum),
+					firsttoken.linenum, 
+					firsttoken.column,
+					(lasttoken.linenum == firsttoken.linenum) 
+						? lasttoken.column + lasttoken.len - 1
+						: erw_lines_getlen(lines, firsttoken.linenum)
+				);
+				str_dtor(&msg);
+				str_dtor(&str);
 			}
-		}
-	}
-	else if(exprnode->type == erw_ASTNODETYPE_ACCESS)
-	{
-		struct erw_ASTNode* firstnode = erw_getfirstnode(exprnode->access.expr);
-		struct erw_ASTNode* lastnode = erw_getlastnode(exprnode->access.expr);
-		struct erw_Type* type = erw_getexprtype(
-			scope,
-			exprnode->access.expr,
-			lines
-		);
 
-		if(!type)
-		{
-			struct Str msg;
-			str_ctor(&msg, "Cannot deduce type (got untyped literal)");
-			erw_error(
-				msg.data, 
-				lines[firstnode->token->linenum - 1].data,
-				firstnode->token->linenum, 
-				firstnode->token->column,
-				(lastnode->token->linenum == firstnode->token->linenum) 
-					? (size_t)(lastnode->token->column + vec_getsize(
-							lastnode->token->text)) - 2
-					: lines[firstnode->token->linenum - 1].len
-			);
-			str_dtor(&msg);
+			ret = type->array.type;
 		}
-		
-		//TODO: Check if index is too big/small if array
-		if(type->info != erw_TYPEINFO_ARRAY && type->info != erw_TYPEINFO_SLICE)
+		break;
+	case erw_ASTNODETYPE_FUNCCALL:
 		{
-			struct Str str = erw_type_tostring(type);
-			struct Str msg;
-			str_ctorfmt(
-				&msg, 
-				"Trying to access a non-array/slice type (%s)",
-				str.data
-			);
-			erw_error(
-				msg.data, 
-				lines[firstnode->token->linenum - 1].data,
-				firstnode->token->linenum, 
-				firstnode->token->column,
-				(lastnode->token->linenum == firstnode->token->linenum) 
-					? (size_t)(lastnode->token->column + vec_getsize(
-							lastnode->token->text)) - 2
-					: lines[firstnode->token->linenum - 1].len
+			erw_checkfunccall(scope, exprnode, lines);
+			struct erw_ASTNode* callee = erw_ast_getnode(
+				scope->ast,
+				exprnode->funccall.callee
 			);
-			str_dtor(&msg);
-			str_dtor(&str);
-		}
+			struct erw_Type* type;
+			if(callee->type == erw_ASTNODETYPE_LITERAL)
+			{
+				struct erw_FuncDeclr* func = erw_scope_getfunc(
+					scope, 
+					callee->token,
+					lines
+				);
 
-		ret = type->array.type;
-	}
-	else if(exprnode->type == erw_ASTNODETYPE_FUNCCALL)
-	{
-		erw_checkfunccall(scope, exprnode, lines);
-		struct erw_Type* type;
-		if(exprnode->funccall.callee->type == erw_ASTNODETYPE_LITERAL)
-		{
-			struct erw_FuncDeclr* func = erw_scope_getfunc(
-				scope, 
-				exprnode->funccall.callee->token,
-				lines
-			);
+				type = func->type;
+			}
+			else
+			{
+				struct erw_Type* newtype = erw_getaccesstype(
+					scope,
+					callee,
+					lines
+				);
 
-			type = func->type;
-		}
-		else
-		{
-			struct erw_Type* newtype = erw_getaccesstype(
-				scope, 
-				exprnode->funccall.callee, 
-				lines
-			);
+				//Assume newtype is erw_TYPEINFO_FUNC, already checked in
+				//checkfunccall
 
-			//Assume newtype is erw_TYPEINFO_FUNC, already checked in
-			//checkfunccall
+				type = newtype->func.type;
+			}
 
-			type = newtype->func.type;
-		}
+			if(type)
+			{ 
+				ret = type;
+			}
+			else
+			{ 
+				struct erw_ASTNode* firstnode = erw_getfirstnode(
+					scope->ast,
+					callee
+				);
+				struct erw_ASTNode* lastnode = erw_getlastnode(
+					scope->ast,
+					callee
+				);
 
-		if(type)
-		{ 
-			ret = type;
+				struct Str msg;
+				str_ctor(&msg, "Void function used in expression");
+				struct erw_Token firsttoken = erw_ast_gettoken(
+					scope->ast, 
+					firstnode->token
+				);
+				struct erw_Token lasttoken = erw_ast_gettoken(
+					scope->ast, 
+					lastnode->token
+				);
+				erw_error(
+					msg.data, 
+					erw_lines_get(lines, firsttoken.linenum),
+					firsttoken.linenum, 
+					firsttoken.column,
+					(lasttoken.linenum == firsttoken.linenum) 
+						? lasttoken.column + lasttoken.len - 1
+						: erw_lines_getlen(lines, firsttoken.linenum)
+				);
+				str_dtor(&msg);
+			}
 		}
-		else
-		{ 
-			struct erw_ASTNode* firstnode = erw_getfirstnode(
-				exprnode->funccall.callee
-			);
-			struct erw_ASTNode* lastnode = erw_getlastnode(
-				exprnode->funccall.callee
-			);
-
-			struct Str msg;
-			str_ctor(&msg, "Void function used in expression");
-			erw_error(
-				msg.data, 
-				lines[firstnode->token->linenum - 1].data,
-				firstnode->token->linenum, 
-				firstnode->token->column,
-				(lastnode->token->linenum == firstnode->token->linenum) 
-					? (size_t)(lastnode->token->column + vec_getsize(
-							lastnode->token->text)) - 2
-					: lines[firstnode->token->linenum - 1].len
-			);
-			str_dtor(&msg);
-		}
-	}
-	else if(exprnode->type == erw_ASTNODETYPE_LITERAL)
-	{
-		if(exprnode->token->type == erw_TOKENTYPE_LITERAL_BOOL)
-		{ 
-			ret = erw_type_builtins[erw_TYPEBUILTIN_BOOL];
-		}
-		else if(exprnode->token->type == erw_TOKENTYPE_LITERAL_INT)
+		break;
+	case erw_ASTNODETYPE_LITERAL:
+		switch(erw_ast_gettokentype(scope->ast, exprnode->token))
 		{
+		case erw_TOKENTYPE_LITERAL_BOOL:
+			ret = erw_type_builtins[erw_TYPEBUILTIN_BOOL];
+			break;
+		case erw_TOKENTYPE_LITERAL_INT:
+			erw_checkliteralsize(scope->ast, exprnode->token, lines);
 			ret = erw_type_builtins[erw_TYPEBUILTIN_INT32];
-		}
-		else if(exprnode->token->type == erw_TOKENTYPE_LITERAL_FLOAT)
-		{
+			break;
+		case erw_TOKENTYPE_LITERAL_FLOAT:
+			erw_checkliteralsize(scope->ast, exprnode->token, lines);
 			ret = erw_type_builtins[erw_TYPEBUILTIN_FLOAT32];
-		}
-		else if(exprnode->token->type == erw_TOKENTYPE_LITERAL_CHAR)
-		{
+			break;
+		case erw_TOKENTYPE_LITERAL_CHAR:
 			ret = erw_type_builtins[erw_TYPEBUILTIN_CHAR];
-		}
-		else if(exprnode->token->type == erw_TOKENTYPE_LITERAL_STRING)
-		{
-			ret = erw_type_new(erw_TYPEINFO_SLICE, NULL);
-			ret->slice.type = erw_type_builtins[erw_TYPEBUILTIN_CHAR];
-			ret->slice.mutable = 0; //NOTE: Temporary
-			ret->slice.size = sizeof(void*); //NOTE: Temporary
-		}
-		else if(exprnode->token->type == erw_TOKENTYPE_IDENT)
-		{
-			struct erw_VarDeclr* var = erw_scope_findvar(
-				scope, 
-				exprnode->token->text
-			);
-
-			struct erw_FuncDeclr* func = erw_scope_findfunc(
-				scope, 
-				exprnode->token->text
+			break;
+		case erw_TOKENTYPE_LITERAL_STRING:
+			ret = erw_type_getslice(
+				erw_type_builtins[erw_TYPEBUILTIN_CHAR], 
+				0 //NOTE: Temporary
 			);
-
-			if(!var && !func)
-			{ 
-				struct Str msg;
-				str_ctor(
-					&msg,
-					"Undefined identifier"
+			break;
+		case erw_TOKENTYPE_IDENT:
+			{
+				struct erw_VarDeclr* var = erw_scope_findvar(
+					scope, 
+					erw_ast_getstr(scope->ast, exprnode->token)
 				);
 
-				erw_error(
-					msg.data, 
-					lines[exprnode->token->linenum - 1].data, 
-					exprnode->token->linenum, 
-					exprnode->token->column,
-					exprnode->token->column + vec_getsize(exprnode->token->text)
-						- 2
+				struct erw_FuncDeclr* func = erw_scope_findfunc(
+					scope, 
+					erw_ast_getstr(scope->ast, exprnode->token)
 				);
-				str_dtor(&msg);
-			}
 
-			if(var)
-			{
-				var->used = 1;
-				ret = var->type;
-			}
-			else //func
-			{
-				func->used = 1;
-				ret = erw_scope_createtype(scope, func->node, lines);
-			}
+				if(!var && !func)
+				{ 
+					struct Str msg;
+					str_ctor(
+						&msg,
+						"Undefined identifier"
+					);
 
-			/* TODO: Implement this*/
-			if(!var->hasvalue)
-			{
-				struct Str msg;
-				str_ctorfmt(
-					&msg, 
-					"Uninitialized variable used in expression. Declared at"
-						" line %zu, column %zu",
-					var->node->vardeclr.name->linenum,
-					var->node->vardeclr.name->column
-				);
-				erw_error(
-					msg.data, 
-					lines[exprnode->token->linenum - 1].data,
-					exprnode->token->linenum, 
-					exprnode->token->column,
-					exprnode->token->column +
-						vec_getsize(exprnode->token->text) - 2
-				);
-				str_dtor(&msg);
+					struct erw_Token exprtoken = erw_ast_gettoken(
+						scope->ast, 
+						exprnode->token
+					);
+					erw_error(
+						msg.data, 
+						erw_lines_get(lines, exprtoken.linenum), 
+						exprtoken.linenum, 
+						exprtoken.column,
+						exprtoken.column + exprtoken.len - 1
+					);
+					str_dtor(&msg);
+				}
+
+				if(var)
+				{
+					var->used = 1;
+					ret = var->type;
+				}
+				else //func
+				{
+					func->used = 1;
+					ret = erw_scope_createtype(scope, func->node, lines);
+				}
+
+				/* TODO: Implement this*/
+				if(!var->hasvalue)
+				{
+					struct Str msg;
+					struct erw_Token varname = erw_ast_gettoken(
+						scope->ast, 
+						var->node->vardeclr.name
+					);
+					str_ctorfmt(
+						&msg, 
+						"Uninitialized variable used in expression. Declared at"
+							" line %zu, column %zu",
+						varname.linenum,
+						varname.column
+					);
+					struct erw_Token exprtoken = erw_ast_gettoken(
+						scope->ast, 
+						exprnode->token
+					);
+					erw_error(
+						msg.data, 
+						erw_lines_get(lines, exprtoken.linenum),
+						exprtoken.linenum, 
+						exprtoken.column,
+						exprtoken.column +
+							exprtoken.len - 1
+					);
+					str_dtor(&msg);
+				}
 			}
-		}
-		else
-		{
+			break;
+		default:
 			log_assert(
 				0,
 				"this shouldn't happen: %s (%s) (%zu, %zu)", 
-				exprnode->token->text, 
-				exprnode->token->type->name,
-				exprnode->token->linenum,
-				exprnode->token->column
+				erw_ast_getstr(scope->ast, exprnode->token), 
+				erw_tokentypeinfos[
+					erw_ast_gettokentype(scope->ast, exprnode->token)
+				].name,
+				erw_ast_gettoken(scope->ast, exprnode->token).linenum,
+				erw_ast_gettoken(scope->ast, exprnode->token).column
 			);
+			break;
 		}
-	}
-	else if(exprnode->type == erw_ASTNODETYPE_STRUCTLITERAL)
-	{
+		break;
+	case erw_ASTNODETYPE_STRUCTLITERAL:
 		//Return NULL
-	}
-	else if(exprnode->type == erw_ASTNODETYPE_UNIONLITERAL)
-	{
+		break;
+	case erw_ASTNODETYPE_UNIONLITERAL:
 		//Return NULL
-	}
-	else if(exprnode->type == erw_ASTNODETYPE_ARRAYLITERAL)
-	{
+		break;
+	case erw_ASTNODETYPE_ARRAYLITERAL:
 		//Return NULL
-	}
-	else
-	{
+		break;
+	default:
 		log_assert(
 			0,
 			"this shouldn't happen: %s (%s) (%zu, %zu)", 
-			exprnode->token->text, 
-			exprnode->token->type->name,
-			exprnode->token->linenum,
-			exprnode->token->column
+			erw_ast_getstr(scope->ast, exprnode->token), 
+			erw_tokentypeinfos[
+				erw_ast_gettokentype(scope->ast, exprnode->token)
+			].name,
+			erw_ast_gettoken(scope->ast, exprnode->token).linenum,
+			erw_ast_gettoken(scope->ast, exprnode->token).column
 		);
+		break;
 	}
 
 	return ret;
@@ -1188,7 +1392,7 @@ static void erw_checkexprtype(
 	struct erw_Scope* scope,
 	struct erw_ASTNode* exprnode,
 	struct erw_Type* type,
-	struct Str* lines)
+	struct erw_Lines* lines)
 {
 	log_assert(scope, "is NULL");
 	log_assert(exprnode, "is NULL");
@@ -1200,8 +1404,14 @@ static void erw_checkexprtype(
 	{
 		if(!erw_type_compare(type, type2))
 		{
-			struct erw_ASTNode* firstnode = erw_getfirstnode(exprnode);
-			struct erw_ASTNode* lastnode = erw_getlastnode(exprnode);
+			struct erw_ASTNode* firstnode = erw_getfirstnode(
+				scope->ast,
+				exprnode
+			);
+			struct erw_ASTNode* lastnode = erw_getlastnode(
+				scope->ast,
+				exprnode
+			);
 
 			struct Str typestr = erw_type_tostring(type);
 			struct Str type2str = erw_type_tostring(type2);
@@ -1213,20 +1423,25 @@ static void erw_checkexprtype(
 				type2str.data
 			);
 
+			struct erw_Token firsttoken = erw_ast_gettoken(
+				scope->ast, 
+				firstnode->token
+			);
+			struct erw_Token lasttoken = erw_ast_gettoken(
+				scope->ast, 
+				lastnode->token
+			);
 			erw_error(
 				msg.data, 
-				lines[firstnode->token->linenum - 1].data,
-				firstnode->token->linenum, 
-				firstnode->token->column,
-				(lastnode->token->linenum == firstnode->token->linenum) 
-					? (size_t)(lastnode->token->column + vec_getsize(
-							lastnode->token->text)) - 2
-					: lines[firstnode->token->linenum - 1].len
+				erw_lines_get(lines, firsttoken.linenum),
+				firsttoken.linenum, 
+				firsttoken.column,
+				(lasttoken.linenum == firsttoken.linenum) 
+					? lasttoken.column + lasttoken.len - 1
+					: erw_lines_getlen(lines, firsttoken.linenum)
 			);
 			str_dtor(&msg);
 		}
-
-		erw_type_dtor(type2);
 	}
 	else
 	{
@@ -1237,33 +1452,37 @@ static void erw_checkexprtype(
 static void erw_checkfunccall(
 	struct erw_Scope* scope,
 	struct erw_ASTNode* callnode,
-	struct Str* lines)
+	struct erw_Lines* lines)
 {
 	log_assert(scope, "is NULL");
 	log_assert(callnode, "is NULL");
 	log_assert(
 		callnode->type == erw_ASTNODETYPE_FUNCCALL, 
 		"invalid type (%s)",
-		callnode->type->name
+		erw_astnodetypenames[callnode->type]
 	);
 	log_assert(lines, "is NULL");
 	
-	struct erw_ASTNode* firstnode = erw_getfirstnode(callnode->funccall.callee);
-	struct erw_ASTNode* lastnode = erw_getlastnode(callnode->funccall.callee);
+	struct erw_ASTNode* callee = erw_ast_getnode(
+		scope->ast,
+		callnode->funccall.callee
+	);
+	struct erw_ASTNode* firstnode = erw_getfirstnode(scope->ast, callee);
+	struct erw_ASTNode* lastnode = erw_getlastnode(scope->ast, callee);
 
 	struct erw_FuncDeclr* func = NULL;
 	struct erw_Type* type = NULL;
 	size_t numparams = 0;
-	if(callnode->funccall.callee->type == erw_ASTNODETYPE_LITERAL)
+	if(callee->type == erw_ASTNODETYPE_LITERAL)
 	{
 		func = erw_scope_getfunc(
 			scope, 
-			callnode->funccall.callee->token, 
+			callee->token, 
 			lines
 		);
 
-		numparams = vec_getsize(func->node->funcdef.params);
-		if(strcmp(scope->funcname, callnode->funccall.callee->token->text)) 
+		numparams = func->node->funcdef.params.size;
+		if(erw_ast_getstr(scope->ast, callee->token) != scope->funcname)
 			//Don't flag as used if no extern function calls it
 		{
 			func->used = 1;
@@ -1271,7 +1490,7 @@ static void erw_checkfunccall(
 	}
 	else
 	{
-		type = erw_getaccesstype(scope, callnode->funccall.callee, lines);
+		type = erw_getaccesstype(scope, callee, lines);
 		if(type->info != erw_TYPEINFO_FUNC)
 		{
 			struct Str str = erw_type_tostring(type);
@@ -1281,15 +1500,22 @@ static void erw_checkfunccall(
 				"Attempt to call non-function type ('%s')",
 				str.data
 			);
+			struct erw_Token firsttoken = erw_ast_gettoken(
+				scope->ast, 
+				firstnode->token
+			);
+			struct erw_Token lasttoken = erw_ast_gettoken(
+				scope->ast, 
+				lastnode->token
+			);
 			erw_error(
 				msg.data, 
-				lines[firstnode->token->linenum - 1].data,
-				firstnode->token->linenum, 
-				firstnode->token->column,
-				(lastnode->token->linenum == firstnode->token->linenum) 
-					? (size_t)(lastnode->token->column + vec_getsize(
-							lastnode->token->text)) - 2
-					: lines[firstnode->token->linenum - 1].len
+				erw_lines_get(lines, firsttoken.linenum),
+				firsttoken.linenum, 
+				firsttoken.column,
+				(lasttoken.linenum == firsttoken.linenum) 
+					? lasttoken.column + lasttoken.len - 1
+					: erw_lines_getlen(lines, firsttoken.linenum)
 			);
 			str_dtor(&msg);
 			str_dtor(&str);
@@ -1298,7 +1524,7 @@ static void erw_checkfunccall(
 		numparams = vec_getsize(type->func.params);
 	}
 
-	if(numparams != vec_getsize(callnode->funccall.args))
+	if(numparams != callnode->funccall.args.size)
 	{ 
 		struct Str msg;
 		str_ctorfmt(
@@ -1306,18 +1532,25 @@ static void erw_checkfunccall(
 			"Incorrect number of arguments in function call. Expected %zu, got"
 				" %zu", 
 			numparams,
-			vec_getsize(callnode->funccall.args)
+			(size_t)callnode->funccall.args.size
 		);
 
+		struct erw_Token firsttoken = erw_ast_gettoken(
+			scope->ast, 
+			firstnode->token
+		);
+		struct erw_Token lasttoken = erw_ast_gettoken(
+			scope->ast, 
+			lastnode->token
+		);
 		erw_error(
 			msg.data, 
-			lines[firstnode->token->linenum - 1].data,
-			firstnode->token->linenum, 
-			firstnode->token->column,
-			(lastnode->token->linenum == firstnode->token->linenum) 
-				? (size_t)(lastnode->token->column + vec_getsize(
-						lastnode->token->text)) - 2
-				: lines[firstnode->token->linenum - 1].len
+			erw_lines_get(lines, firsttoken.linenum),
+			firsttoken.linenum, 
+			firsttoken.column,
+			(lasttoken.linenum == firsttoken.linenum) 
+				? lasttoken.column + lasttoken.len - 1
+				: erw_lines_getlen(lines, firsttoken.linenum)
 		);
 		str_dtor(&msg);
 	}
@@ -1325,11 +1558,16 @@ static void erw_checkfunccall(
 	for(size_t i = 0; i < numparams; i++)
 	{
 		struct erw_Type* type2 = NULL;
-		if(callnode->funccall.callee->type == erw_ASTNODETYPE_LITERAL)
+		if(callee->type == erw_ASTNODETYPE_LITERAL)
 		{
+			struct erw_ASTNode* param = erw_ast_getchild(
+				scope->ast,
+				func->node->funcdef.params,
+				i
+			);
 			type2 = erw_scope_createtype(
 				scope,
-				func->node->funcdef.params[i]->vardeclr.type,
+				erw_ast_getnode(scope->ast, param->vardeclr.type),
 				lines
 			);
 
@@ -1342,7 +1580,7 @@ static void erw_checkfunccall(
 
 		erw_checkexprtype(
 			scope, 
-			callnode->funccall.args[i], 
+			erw_ast_getchild(scope->ast, callnode->funccall.args, i), 
 			type2,
 			lines
 		);
@@ -1352,204 +1590,233 @@ static void erw_checkfunccall(
 static void erw_checkfunc(
 	struct erw_Scope* scope, 
 	struct erw_ASTNode* funcnode, 
-	struct Str* lines
+	struct erw_Lines* lines
 );
 
 static void erw_checkblock(
 	struct erw_Scope* scope,
 	struct erw_ASTNode* blocknode,
-	struct Str* lines)
+	struct erw_Lines* lines)
 {
 	log_assert(scope, "is NULL");
 	log_assert(blocknode, "is NULL");
 	log_assert(
 		blocknode->type == erw_ASTNODETYPE_BLOCK, 
 		"invalid size (%s)", 
-		blocknode->type->name
+		erw_astnodetypenames[blocknode->type]
 	);
 	log_assert(lines, "is NULL");
 
-	for(size_t i = 0; i < vec_getsize(blocknode->block.stmts); i++)
+	for(size_t i = 0; i < blocknode->block.stmts.size; i++)
 	{ 
-		if(blocknode->block.stmts[i]->type == erw_ASTNODETYPE_FUNCDEF)
-		{
-			erw_checkfunc(scope, blocknode->block.stmts[i], lines);
-		}
-		else if(blocknode->block.stmts[i]->type == erw_ASTNODETYPE_TYPEDECLR)
-		{
-			erw_scope_addtypedeclr(scope, blocknode->block.stmts[i], lines);
-		}
-		else if(blocknode->block.stmts[i]->type == erw_ASTNODETYPE_VARDECLR)
+		struct erw_ASTNode* stmt = erw_ast_getchild(
+			scope->ast,
+			blocknode->block.stmts,
+			i
+		);
+		switch(stmt->type)
 		{
-			erw_scope_addvardeclr(scope, blocknode->block.stmts[i], lines);
-			if(blocknode->block.stmts[i]->vardeclr.value)
+		case erw_ASTNODETYPE_FUNCDEF:
+			erw_checkfunc(scope, stmt, lines);
+			break;
+		case erw_ASTNODETYPE_TYPEDECLR:
+			erw_scope_addtypedeclr(scope, stmt, lines);
+			break;
+		case erw_ASTNODETYPE_VARDECLR:
+			erw_scope_addvardeclr(scope, stmt, lines);
+			if(stmt->vardeclr.value)
 			{ 
 				struct erw_Type* vartype = erw_scope_createtype(
 					scope,
-					blocknode->block.stmts[i]->vardeclr.type,
+					erw_ast_getnode(scope->ast, stmt->vardeclr.type),
 					lines
 				);
 
 				erw_checkexprtype(
 					scope, 
-					blocknode->block.stmts[i]->vardeclr.value, 
+					erw_ast_getnode(scope->ast, stmt->vardeclr.value), 
 					vartype, 
 					lines
 				);
-
-				erw_type_dtor(vartype);
 			}
-		}
-		else if(blocknode->block.stmts[i]->type == erw_ASTNODETYPE_IF)
-		{
-			struct erw_Type* iftype = erw_getexprtype(
-				scope, 
-				blocknode->block.stmts[i]->if_.expr, 
-				lines
-			);
-
-			struct erw_ASTNode* firstnode = erw_getfirstnode(
-				blocknode->block.stmts[i]->if_.expr
-			);
-
-			struct erw_ASTNode* lastnode = erw_getlastnode(
-				blocknode->block.stmts[i]->if_.expr
-			);
-
-			erw_checkboolean(iftype, firstnode, lastnode, lines);
-			erw_type_dtor(iftype);
-			struct erw_Scope* newscope = erw_scope_new(
-				scope, 
-				scope->funcname,
-				vec_getsize(scope->children),
-				0
-			);
-
-			erw_checkblock(
-				newscope, 
-				blocknode->block.stmts[i]->if_.block, 
-				lines)
-			;
-			for(size_t j = 0; 
-				j < vec_getsize(blocknode->block.stmts[i]->if_.elseifs); 
-				j++)
-			{ 
-				struct erw_Type* elseiftype = erw_getexprtype(
-					scope,
-					blocknode->block.stmts[i]->if_.elseifs[j]->elseif.expr, 
+			break;
+		case erw_ASTNODETYPE_IF:
+			{
+				struct erw_Type* iftype = erw_getexprtype(
+					scope, 
+					erw_ast_getnode(scope->ast, stmt->if_.expr), 
 					lines
 				);
-				firstnode = erw_getfirstnode(
-					blocknode->block.stmts[i]->if_.elseifs[j]->elseif.expr
-				);
 
-				lastnode = erw_getlastnode(
-					blocknode->block.stmts[i]->if_.elseifs[j]->elseif .expr
+				struct erw_ASTNode* firstnode = erw_getfirstnode(
+					scope->ast,
+					erw_ast_getnode(scope->ast, stmt->if_.expr)
 				);
 
-				erw_checkboolean(elseiftype, firstnode, lastnode, lines);
-				erw_type_dtor(elseiftype);
-				newscope = erw_scope_new(
-					scope, 
-					scope->funcname,
-					vec_getsize(scope->children),
-					0
+				struct erw_ASTNode* lastnode = erw_getlastnode(
+					scope->ast,
+					erw_ast_getnode(scope->ast, stmt->if_.expr)
 				);
-				erw_checkblock(
-					newscope, 
-					blocknode->block.stmts[i]->if_.elseifs[j]->elseif.block, 
+
+				erw_checkboolean(
+					scope->ast,
+					iftype,
+					firstnode,
+					lastnode,
 					lines
 				);
-			}
-
-			if(blocknode->block.stmts[i]->if_.else_)
-			{ 
-				newscope = erw_scope_new(
+				struct erw_Scope* newscope = erw_scope_new(
 					scope, 
 					scope->funcname,
 					vec_getsize(scope->children),
 					0
 				);
+
 				erw_checkblock(
 					newscope, 
-					blocknode->block.stmts[i]->if_.else_->else_.block, 
-					lines
-				);
-			}
-		}
-		else if(blocknode->block.stmts[i]->type == erw_ASTNODETYPE_RETURN)
-		{
-			struct erw_Token token = { //XXX: Ugly
-				.text = (char*)scope->funcname, 
-				.type = erw_TOKENTYPE_IDENT
-			};
-			struct erw_FuncDeclr* func = erw_scope_getfunc(
-				scope, 
-				&token,
-				lines
-			);
+					erw_ast_getnode(scope->ast, stmt->if_.block), 
+					lines)
+				;
+				for(size_t j = 0; j < stmt->if_.elseifs.size; j++)
+				{ 
+					struct erw_ASTNode* elseif = erw_ast_getchild(
+						scope->ast,
+						stmt->if_.elseifs,
+						j
+					);
+					struct erw_Type* elseiftype = erw_getexprtype(
+						scope,
+						erw_ast_getnode(scope->ast, elseif->elseif.expr), 
+						lines
+					);
+					firstnode = erw_getfirstnode(
+						scope->ast,
+						erw_ast_getnode(scope->ast, elseif->elseif.expr)
+					);
 
-			if(func->node->funcdef.type) //Has return type, i.e not void
-			{
-				if(!blocknode->block.stmts[i]->return_.expr) 
-				{
-					struct Str typename = erw_type_tostring(func->type);
-					struct Str msg;
-					str_ctorfmt(
-						&msg,
-						"Function ('%s') should return a value of type "
-							"'%s'.",
-						func->node->funcdef.name->text,
-						typename.data
+					lastnode = erw_getlastnode(
+						scope->ast,
+						erw_ast_getnode(scope->ast, elseif->elseif.expr)
 					);
 
-					erw_error(
-						msg.data, 
-						lines[blocknode->block.stmts[i]->token->linenum - 1]
-							.data, 
-						blocknode->block.stmts[i]->token->linenum, 
-						blocknode->block.stmts[i]->token->column,
-						blocknode->block.stmts[i]->token->column + 
-							vec_getsize(blocknode->block.stmts[i]->token->text)
-							- 2
+					erw_checkboolean(
+						scope->ast,
+						elseiftype,
+						firstnode,
+						lastnode,
+						lines
+					);
+					newscope = erw_scope_new(
+						scope, 
+						scope->funcname,
+						vec_getsize(scope->children),
+						0
+					);
+					erw_checkblock(
+						newscope, 
+						erw_ast_getnode(scope->ast, elseif->elseif.block), 
+						lines
 					);
-					str_dtor(&msg);
 				}
 
-				erw_checkexprtype(
-					scope, 
-					blocknode->block.stmts[i]->return_.expr, 
-					func->type, 
-					lines
-				);
+				if(stmt->if_.else_)
+				{ 
+					newscope = erw_scope_new(
+						scope, 
+						scope->funcname,
+						vec_getsize(scope->children),
+						0
+					);
+					erw_checkblock(
+						newscope, 
+						erw_ast_getnode(
+							scope->ast,
+							erw_ast_getnode(
+								scope->ast,
+								stmt->if_.else_
+							)->else_.block
+						), 
+						lines
+					);
+				}
 			}
-			else
+			break;
+		case erw_ASTNODETYPE_RETURN:
 			{
-				if(blocknode->block.stmts[i]->return_.expr) 
+				struct erw_FuncDeclr* func = erw_scope_findfunc(
+					scope, 
+					scope->funcname
+				);
+
+				if(func->node->funcdef.type) //Has return type, i.e not void
 				{
-					struct Str msg;
-					str_ctorfmt(
-						&msg,
-						"Function ('%s') should not return anything.",
-						func->node->funcdef.name->text
-					);
+					if(!stmt->return_.expr) 
+					{
+						struct Str typename = erw_type_tostring(func->type);
+						struct Str msg;
+						str_ctorfmt(
+							&msg,
+							"Function ('%s') should return a value of type "
+								"'%s'.",
+							erw_ast_getstr(
+								scope->ast, 
+								func->node->funcdef.name
+							),
+							typename.data
+						);
+
+						struct erw_Token stmttoken = erw_ast_gettoken(
+							scope->ast, 
+							stmt->token
+						);
+						erw_error(
+							msg.data, 
+							erw_lines_get(lines, stmttoken.linenum), 
+							stmttoken.linenum, 
+							stmttoken.column,
+							stmttoken.column + 
+								stmttoken.len - 1
+						);
+						str_dtor(&msg);
+					}
 
-					erw_error(
-						msg.data, 
-						lines[blocknode->block.stmts[i]->token->linenum - 1]
-							.data, 
-						blocknode->block.stmts[i]->token->linenum, 
-						blocknode->block.stmts[i]->token->column,
-						blocknode->block.stmts[i]->token->column + 
-							vec_getsize(blocknode->block.stmts[i]->token->text)
-							- 2
+					erw_checkexprtype(
+						scope, 
+						erw_ast_getnode(scope->ast, stmt->return_.expr), 
+						func->type, 
+						lines
 					);
-					str_dtor(&msg);
+				}
+				else
+				{
+					if(stmt->return_.expr) 
+					{
+						struct Str msg;
+						str_ctorfmt(
+							&msg,
+							"Function ('%s') should not return anything.",
+							erw_ast_getstr(scope->ast, func->node->funcdef.name)
+						);
+
+						struct erw_Token stmttoken = erw_ast_gettoken(
+							scope->ast, 
+							stmt->token
+						);
+						erw_error(
+							msg.data, 
+							erw_lines_get(lines, stmttoken.linenum), 
+							stmttoken.linenum, 
+							stmttoken.column,
+							stmttoken.column + 
+								stmttoken.len - 1
+						);
+						str_dtor(&msg);
+					}
 				}
 			}
-		}
+			break;
 		/*
-		else if(blocknode->block.stmts[i]->type == erw_TOKENTYPE_FOREIGN)
+		else if(stmt->type == erw_TOKENTYPE_FOREIGN)
 		{ 
 			struct erw_ASTNode* foreignnode = blocknode->branches[i];
 			struct erw_ASTNode* argsnode = foreignnode->branches[0];
@@ -1560,227 +1827,296 @@ static void erw_checkblock(
 			}
 		}
 		*/
-		else if(blocknode->block.stmts[i]->type == erw_ASTNODETYPE_DEFER)
-		{
-			vec_pushback(
-				scope->finalizers,
-				(struct erw_Finalizer){
-					.node = blocknode->block.stmts[i]->defer.block,
-					.index = vec_getsize(scope->children)
-				}
-			);
-
-			struct erw_Scope* newscope = erw_scope_new(
-				scope, 
-				scope->funcname,
-				vec_getsize(scope->children),
-				0
-			);
-
-			erw_checkblock(
-				newscope, 
-				blocknode->block.stmts[i]->defer.block, 
-				lines
-			);
-		}
-		else if(blocknode->block.stmts[i]->type == erw_ASTNODETYPE_UNSAFE)
-		{
-			//TODO: Check for unsafe stuff
-			struct erw_Scope* newscope = erw_scope_new(
-				scope, 
-				scope->funcname,
-				vec_getsize(scope->children),
-				0
-			);
-
-			erw_checkblock(
-				newscope, 
-				blocknode->block.stmts[i]->unsafe.block, 
-				lines
-			);
-		}
-		else if(blocknode->block.stmts[i]->type == erw_ASTNODETYPE_WHILE)
-		{
-			struct erw_Type* exprtype = erw_getexprtype(
-				scope, 
-				blocknode->block.stmts[i]->while_.expr, 
-				lines
-			);
-
-			struct erw_ASTNode* firstnode = erw_getfirstnode(
-				blocknode->block.stmts[i]->while_ .expr
-			);
-
-			struct erw_ASTNode* lastnode = erw_getlastnode(
-				blocknode->block.stmts[i]->while_.expr
-			);
+		case erw_ASTNODETYPE_DEFER:
+			{
+				vec_pushback(
+					scope->finalizers,
+					(struct erw_Finalizer){
+						.node = erw_ast_getnode(scope->ast, stmt->defer.block),
+						.index = vec_getsize(scope->children)
+					}
+				);
 
-			erw_checkboolean(exprtype, firstnode, lastnode, lines);
-			erw_type_dtor(exprtype);
-			struct erw_Scope* newscope = erw_scope_new(
-				scope, 
-				scope->funcname,
-				vec_getsize(scope->children),
-				0
-			);
+				struct erw_Scope* newscope = erw_scope_new(
+					scope, 
+					scope->funcname,
+					vec_getsize(scope->children),
+					0
+				);
 
-			erw_checkblock(
-				newscope, 
-				blocknode->block.stmts[i]->while_.block, 
-				lines
-			);
-		}
-		else if(blocknode->block.stmts[i]->type == erw_ASTNODETYPE_ASSIGNMENT)
-		{
-			struct erw_ASTNode* basenode = blocknode->block.stmts[i]->assignment
-				.assignee;
-			while(basenode->type != erw_ASTNODETYPE_LITERAL)
+				erw_checkblock(
+					newscope, 
+					erw_ast_getnode(scope->ast, stmt->defer.block), 
+					lines
+				);
+			}
+			break;
+		case erw_ASTNODETYPE_UNSAFE:
 			{
-				basenode = basenode->unexpr.expr;
+				//TODO: Check for unsafe stuff
+				struct erw_Scope* newscope = erw_scope_new(
+					scope, 
+					scope->funcname,
+					vec_getsize(scope->children),
+					0
+				);
+
+				erw_checkblock(
+					newscope, 
+					erw_ast_getnode(scope->ast, stmt->unsafe.block), 
+					lines
+				);
 			}
+			break;
+		case erw_ASTNODETYPE_WHILE:
+			{
+				struct erw_Type* exprtype = erw_getexprtype(
+					scope, 
+					erw_ast_getnode(scope->ast, stmt->while_.expr), 
+					lines
+				);
 
-			struct erw_VarDeclr* var = erw_scope_getvar(
-				scope, 
-				basenode->token,
-				lines
-			);
+				struct erw_ASTNode* firstnode = erw_getfirstnode(
+					scope->ast,
+					erw_ast_getnode(scope->ast, stmt->while_.expr)
+				);
 
-			struct erw_Type* type = erw_getexprtype(
-				scope, 
-				blocknode->block.stmts[i]->assignment.assignee,
-				lines
-			);
-			erw_checkexprtype(
-				scope, 
-				blocknode->block.stmts[i]->assignment.expr, 
-				type,
-				lines
-			);
+				struct erw_ASTNode* lastnode = erw_getlastnode(
+					scope->ast,
+					erw_ast_getnode(scope->ast, stmt->while_.expr)
+				);
 
-			struct erw_ASTNode* firstnode = erw_getfirstnode(
-				blocknode->block.stmts[i]->assignment.assignee
-			);
-			struct erw_ASTNode* lastnode = erw_getlastnode(
-				blocknode->block.stmts[i]->assignment.assignee
-			);
+				erw_checkboolean(
+					scope->ast,
+					exprtype,
+					firstnode,
+					lastnode,
+					lines
+				);
+				struct erw_Scope* newscope = erw_scope_new(
+					scope, 
+					scope->funcname,
+					vec_getsize(scope->children),
+					0
+				);
 
-			if(blocknode->block.stmts[i]->token->type 
-				!= erw_TOKENTYPE_OPERATOR_ASSIGN) //Fix firstnode?
-			{ 
-				if(!var->node->vardeclr.mutable)
+				erw_checkblock(
+					newscope, 
+					erw_ast_getnode(scope->ast, stmt->while_.block), 
+					lines
+				);
+			}
+			break;
+		case erw_ASTNODETYPE_ASSIGNMENT:
+			{
+				struct erw_ASTNode* basenode = erw_ast_getnode(
+					scope->ast,
+					stmt->assignment.assignee
+				);
+				while(basenode->type != erw_ASTNODETYPE_LITERAL)
 				{
-					struct Str msg;
-					str_ctorfmt(
-						&msg, 
-						"Operation '%s' is not allowed on an"
-							" immutable variable, declared at line %zu,"
-							" column %zu",
-						blocknode->block.stmts[i]->token->text,
-						var->node->vardeclr.name->linenum, 
-						var->node->vardeclr.name->column
+					basenode = erw_ast_getnode(
+						scope->ast,
+						basenode->unexpr.expr
 					);
-
-					erw_error(
-						msg.data, 
-						lines[firstnode->token->linenum - 1].data,
-						firstnode->token->linenum, 
-						firstnode->token->column,
-						(lastnode->token->linenum == firstnode->token->linenum) 
-							? (size_t)(lastnode->token->column + vec_getsize(
-									lastnode->token->text)) - 2
-							: lines[firstnode->token->linenum - 1].len
-					);
-					str_dtor(&msg);
 				}
 
-				if(!var->hasvalue)
-				{
-					struct Str msg;
-					str_ctorfmt(
-						&msg, 
-						"Operation '%s' is not allowed on an"
-							" uninitialized variable, declared at line %zu,"
-							" column %zu",
-						blocknode->block.stmts[i]->token->text,
-						var->node->vardeclr.name->linenum, 
-						var->node->vardeclr.name->column
-					);
+				struct erw_VarDeclr* var = erw_scope_getvar(
+					scope, 
+					basenode->token,
+					lines
+				);
 
-					erw_error(
-						msg.data, 
-						lines[firstnode->token->linenum - 1].data,
-						firstnode->token->linenum, 
-						firstnode->token->column,
-						(lastnode->token->linenum == firstnode->token->linenum) 
-							? (size_t)(lastnode->token->column + vec_getsize(
-									lastnode->token->text)) - 2
-							: lines[firstnode->token->linenum - 1].len
-					);
-					str_dtor(&msg);
-				}
+				struct erw_Type* type = erw_getexprtype(
+					scope, 
+					erw_ast_getnode(scope->ast, stmt->assignment.assignee),
+					lines
+				);
+				erw_checkexprtype(
+					scope, 
+					erw_ast_getnode(scope->ast, stmt->assignment.expr), 
+					type,
+					lines
+				);
 
-				firstnode = erw_getfirstnode(
-					blocknode->block.stmts[i]->assignment.expr
+				struct erw_ASTNode* firstnode = erw_getfirstnode(
+					scope->ast,
+					erw_ast_getnode(scope->ast, stmt->assignment.assignee)
 				);
-				lastnode = erw_getlastnode(
-					blocknode->block.stmts[i]->assignment.expr
+				struct erw_ASTNode* lastnode = erw_getlastnode(
+					scope->ast,
+					erw_ast_getnode(scope->ast, stmt->assignment.assignee)
 				);
-				
-				erw_checknumerical(type, firstnode, lastnode, lines);
-			}
-			else
-			{
-				if(var->hasvalue && !var->node->vardeclr.mutable)
-				{
-					struct Str msg;
-					str_ctorfmt(
-						&msg, 
-						"Reassignment of immutable variable, declared at line"
-							"%zu, column %zu",
-						var->node->vardeclr.name->linenum, 
-						var->node->vardeclr.name->column
-					);
 
-					erw_error(
-						msg.data, 
-						lines[firstnode->token->linenum - 1].data,
-						firstnode->token->linenum, 
-						firstnode->token->column,
-						(lastnode->token->linenum == firstnode->token->linenum) 
-							? (size_t)(lastnode->token->column + vec_getsize(
-									lastnode->token->text)) - 2
-							: lines[firstnode->token->linenum - 1].len
+				if(erw_ast_gettokentype(scope->ast, stmt->token) 
+					!= erw_TOKENTYPE_OPERATOR_ASSIGN) //Fix firstnode?
+				{ 
+					if(!var->node->vardeclr.mutable)
+					{
+						struct Str msg;
+						struct erw_Token varname = erw_ast_gettoken(
+							scope->ast, 
+							var->node->vardeclr.name
+						);
+						str_ctorfmt(
+							&msg, 
+							"Operation '%s' is not allowed on an"
+								" immutable variable, declared at line %zu,"
+								" column %zu",
+							erw_ast_getstr(scope->ast, stmt->token),
+							varname.linenum, 
+							varname.column
+						);
+
+						struct erw_Token firsttoken = erw_ast_gettoken(
+							scope->ast, 
+							firstnode->token
+						);
+						struct erw_Token lasttoken = erw_ast_gettoken(
+							scope->ast, 
+							lastnode->token
+						);
+						erw_error(
+							msg.data, 
+							erw_lines_get(lines, firsttoken.linenum),
+							firsttoken.linenum, 
+							firsttoken.column,
+							(lasttoken.linenum 
+								== firsttoken.linenum) 
+								? lasttoken.column 
+									+ lasttoken.len - 1
+								: erw_lines_getlen(lines, firsttoken.linenum)
+						);
+						str_dtor(&msg);
+					}
+
+					if(!var->hasvalue)
+					{
+						struct Str msg;
+						struct erw_Token varname = erw_ast_gettoken(
+							scope->ast, 
+							var->node->vardeclr.name
+						);
+						str_ctorfmt(
+							&msg, 
+							"Operation '%s' is not allowed on an"
+								" uninitialized variable, declared at line %zu,"
+								" column %zu",
+							erw_ast_getstr(scope->ast, stmt->token),
+							varname.linenum, 
+							varname.column
+						);
+
+						struct erw_Token firsttoken = erw_ast_gettoken(
+							scope->ast, 
+							firstnode->token
+						);
+						struct erw_Token lasttoken = erw_ast_gettoken(
+							scope->ast, 
+							lastnode->token
+						);
+						erw_error(
+							msg.data, 
+							erw_lines_get(lines, firsttoken.linenum),
+							firsttoken.linenum, 
+							firsttoken.column,
+							(lasttoken.linenum 
+								== firsttoken.linenum) 
+								? lasttoken.column 
+									+ lasttoken.len - 1
+								: erw_lines_getlen(lines, firsttoken.linenum)
+						);
+						str_dtor(&msg);
+					}
+
+					firstnode = erw_getfirstnode(
+						scope->ast,
+						erw_ast_getnode(scope->ast, stmt->assignment.expr)
+					);
+					lastnode = erw_getlastnode(
+						scope->ast,
+						erw_ast_getnode(scope->ast, stmt->assignment.expr)
+					);
+				
+					erw_checknumerical(
+						scope->ast,
+						type,
+						firstnode,
+						lastnode,
+						lines
 					);
-					str_dtor(&msg);
 				}
+				else
+				{
+					if(var->hasvalue && !var->node->vardeclr.mutable)
+					{
+						struct Str msg;
+						struct erw_Token varname = erw_ast_gettoken(
+							scope->ast, 
+							var->node->vardeclr.name
+						);
+						str_ctorfmt(
+							&msg, 
+							"Reassignment of immutable variable, declared"
+								" at line%zu, column %zu",
+							varname.linenum, 
+							varname.column
+						);
+
+						struct erw_Token firsttoken = erw_ast_gettoken(
+							scope->ast, 
+							firstnode->token
+						);
+						struct erw_Token lasttoken = erw_ast_gettoken(
+							scope->ast, 
+							lastnode->token
+						);
+						erw_error(
+							msg.data, 
+							erw_lines_get(lines, firsttoken.linenum),
+							firsttoken.linenum, 
+							firsttoken.column,
+							(lasttoken.linenum 
+								== firsttoken.linenum) 
+								? lasttoken.column 
+									+ lasttoken.len - 1
+								: erw_lines_getlen(lines, firsttoken.linenum)
+						);
+						str_dtor(&msg);
+					}
 				
-				var->hasvalue = 1;
+					var->hasvalue = 1;
+				}
 			}
-		}
-		else if(blocknode->block.stmts[i]->type == erw_ASTNODETYPE_LITERAL)
-		{
-			struct Str msg;
-			str_ctor(&msg, "Unexpected literal");
-			erw_error(
-				msg.data, 
-				lines[blocknode->block.stmts[i]->token->linenum - 1].data,
-				blocknode->block.stmts[i]->token->linenum, 
-				blocknode->block.stmts[i]->token->column,
-				blocknode->block.stmts[i]->token->column +
-					vec_getsize(blocknode->block.stmts[i]->token->text) - 2
-			);
-			str_dtor(&msg);
-		}
-		else if(blocknode->block.stmts[i]->type == erw_ASTNODETYPE_FUNCCALL)
-		{
-			erw_checkfunccall(scope, blocknode->block.stmts[i], lines);
-		}
-		else
-		{
+			break;
+		case erw_ASTNODETYPE_LITERAL:
+			{
+				struct Str msg;
+				str_ctor(&msg, "Unexpected literal");
+				struct erw_Token stmttoken = erw_ast_gettoken(
+					scope->ast, 
+					stmt->token
+				);
+				erw_error(
+					msg.data, 
+					erw_lines_get(lines, stmttoken.linenum),
+					stmttoken.linenum, 
+					stmttoken.column,
+					stmttoken.column +
+						stmttoken.len - 1
+				);
+				str_dtor(&msg);
+			}
+			break;
+		case erw_ASTNODETYPE_FUNCCALL:
+			erw_checkfunccall(scope, stmt, lines);
+			break;
+		default:
 			log_info(
 				"this shouldn't happen (%s)", 
-				blocknode->block.stmts[i]->type->name
+				erw_astnodetypenames[stmt->type]
 			);
+			break;
 		}
 	}
 }
@@ -1788,48 +2124,59 @@ static void erw_checkblock(
 static void erw_checkfunc(
 	struct erw_Scope* scope, 
 	struct erw_ASTNode* funcnode, 
-	struct Str* lines)
+	struct erw_Lines* lines)
 {
 	log_assert(scope, "is NULL");
 	log_assert(funcnode, "is NULL");
 	log_assert(
 		funcnode->type == erw_ASTNODETYPE_FUNCDEF, 
 		"invalid size (%s)", 
-		funcnode->type->name
+		erw_astnodetypenames[funcnode->type]
 	);
 	log_assert(lines, "is NULL");
 
 	erw_scope_addfuncdeclr(scope, funcnode, lines);
 	struct erw_Scope* newscope = erw_scope_new(
 		scope, 
-		funcnode->funcdef.name->text,
+		erw_ast_getstr(scope->ast, funcnode->funcdef.name),
 		vec_getsize(scope->children),
 		1
 	);
 
-	for(size_t j = 0; j < vec_getsize(funcnode->funcdef.params); j++)
+	for(size_t j = 0; j < funcnode->funcdef.params.size; j++)
 	{ 
-		erw_scope_addvardeclr(newscope, funcnode->funcdef.params[j], lines);
+		struct erw_ASTNode* param = erw_ast_getchild(
+			scope->ast,
+			funcnode->funcdef.params,
+			j
+		);
+		erw_scope_addvardeclr(newscope, param, lines);
 
 		//Ugly
 		struct erw_VarDeclr* var = erw_scope_getvar(
 			newscope, 
-			funcnode->funcdef.params[j]->vardeclr.name,
+			param->vardeclr.name,
 			lines
 		);
 		var->hasvalue = 1;
 	}
 
-	erw_checkblock(newscope, funcnode->funcdef.block, lines);
+	erw_checkblock(
+		newscope,
+		erw_ast_getnode(scope->ast, funcnode->funcdef.block),
+		lines
+	);
 }
 
-static int erw_checkifreturn(struct erw_ASTNode* ifnode)
+static int erw_checkifreturn(
+	const struct erw_AST* ast,
+	struct erw_ASTNode* ifnode)
 {
 	log_assert(ifnode, "is NULL");
 	log_assert(
 		ifnode->type == erw_ASTNODETYPE_IF, 
 		"invalid size (%s)", 
-		ifnode->type->name
+		erw_astnodetypenames[ifnode->type]
 	);
 
 	if(!ifnode->if_.else_)
@@ -1837,74 +2184,84 @@ static int erw_checkifreturn(struct erw_ASTNode* ifnode)
 		return 0;
 	}
 
-	if(!vec_getsize(ifnode->if_.block->block.stmts))
+	struct erw_ASTList stmts = ast->nodes[ifnode->if_.block].block.stmts;
+	if(!stmts.size)
 	{
 		return 0;
 	}
 
-	struct erw_ASTNode* laststatement = ifnode->if_.block->block.stmts[
-		vec_getsize(ifnode->if_.block->block.stmts) - 1
-	];
+	struct erw_ASTNode* laststatement = erw_ast_getchild(
+		ast,
+		stmts,
+		stmts.size - 1
+	);
 
-	if(laststatement->type == erw_ASTNODETYPE_RETURN) {}
-	else if(laststatement->type == erw_ASTNODETYPE_IF)
+	switch(laststatement->type)
 	{
-		if(!erw_checkifreturn(laststatement))
+	case erw_ASTNODETYPE_RETURN:
+		break;
+	case erw_ASTNODETYPE_IF:
+		if(!erw_checkifreturn(ast, laststatement))
 		{
 			return 0;
 		}
-	}
-	else
-	{
+		break;
+	default:
 		return 0;
 	}
 
-	for(size_t i = 0; i < vec_getsize(ifnode->if_.elseifs); i++)
+	for(size_t i = 0; i < ifnode->if_.elseifs.size; i++)
 	{
-		if(!vec_getsize(ifnode->if_.elseifs[i]->elseif.block->block.stmts))
+		struct erw_ASTNode* elseif = erw_ast_getchild(
+			ast,
+			ifnode->if_.elseifs,
+			i
+		);
+		stmts = ast->nodes[elseif->elseif.block].block.stmts;
+		if(!stmts.size)
 		{
 			return 0;
 		}
 
-		laststatement = ifnode->if_.elseifs[i]->elseif.block->block.stmts[
-			vec_getsize(ifnode->if_.elseifs[i]->elseif.block->block.stmts) - 1
-		];
+		laststatement = erw_ast_getchild(ast, stmts, stmts.size - 1);
 
-		if(laststatement->type == erw_ASTNODETYPE_RETURN) {}
-		else if(laststatement->type == erw_ASTNODETYPE_IF)
+		switch(laststatement->type)
 		{
-			if(!erw_checkifreturn(laststatement))
+		case erw_ASTNODETYPE_RETURN:
+			break;
+		case erw_ASTNODETYPE_IF:
+			if(!erw_checkifreturn(ast, laststatement))
 			{
 				return 0;
 			}
-		}
-		else
-		{
+			break;
+		default:
 			return 0;
 		}
 	}
 
 	if(ifnode->if_.else_)
 	{
-		if(!vec_getsize(ifnode->if_.else_->else_.block->block.stmts))
+		struct erw_ASTNode* else_ = erw_ast_getnode(ast, ifnode->if_.else_);
+		stmts = ast->nodes[else_->else_.block].block.stmts;
+		if(!stmts.size)
 		{
 			return 0;
 		}
 
-		laststatement = ifnode->if_.else_->else_.block->block.stmts[
-			vec_getsize(ifnode->if_.else_->else_.block->block.stmts) - 1
-		];
+		laststatement = erw_ast_getchild(ast, stmts, stmts.size - 1);
 
-		if(laststatement->type == erw_ASTNODETYPE_RETURN) {}
-		else if(laststatement->type == erw_ASTNODETYPE_IF)
+		switch(laststatement->type)
 		{
-			if(!erw_checkifreturn(laststatement))
+		case erw_ASTNODETYPE_RETURN:
+			break;
+		case erw_ASTNODETYPE_IF:
+			if(!erw_checkifreturn(ast, laststatement))
 			{
 				return 0;
 			}
-		}
-		else
-		{
+			break;
+		default:
 			return 0;
 		}
 	}
@@ -1916,7 +2273,7 @@ static int erw_checkifreturn(struct erw_ASTNode* ifnode)
 	return 1;
 }
 
-static void erw_checkreturn(struct erw_Scope* scope, struct Str* lines)
+static void erw_checkreturn(struct erw_Scope* scope, struct erw_Lines* lines)
 {
 	log_assert(scope, "is NULL");
 	log_assert(lines, "is NULL");
@@ -1925,22 +2282,29 @@ static void erw_checkreturn(struct erw_Scope* scope, struct Str* lines)
 	{
 		if(scope->functions[i].type) //Has return type
 		{
-			struct erw_ASTNode* blocknode = scope->functions[i].node->funcdef
-				.block;
+			struct erw_ASTNode* blocknode = erw_ast_getnode(
+				scope->ast,
+				scope->functions[i].node->funcdef.block
+			);
 			int hasreturn = 0;
-			if(vec_getsize(blocknode->block.stmts))
+			if(blocknode->block.stmts.size)
 			{
-				struct erw_ASTNode* laststatement = blocknode->block.stmts[
-					vec_getsize(blocknode->block.stmts) - 1
-				];
+				struct erw_ASTNode* laststatement = erw_ast_getchild(
+					scope->ast,
+					blocknode->block.stmts,
+					blocknode->block.stmts.size - 1
+				);
 			
-				if(laststatement->type == erw_ASTNODETYPE_RETURN)
+				switch(laststatement->type)
 				{
+				case erw_ASTNODETYPE_RETURN:
 					hasreturn = 1;
-				}
-				else if(laststatement->type == erw_ASTNODETYPE_IF)
-				{
-					hasreturn = erw_checkifreturn(laststatement);
+					break;
+				case erw_ASTNODETYPE_IF:
+					hasreturn = erw_checkifreturn(scope->ast, laststatement);
+					break;
+				default:
+					break;
 				}
 			}
 
@@ -1948,15 +2312,17 @@ static void erw_checkreturn(struct erw_Scope* scope, struct Str* lines)
 			{
 				struct Str msg;
 				str_ctor(&msg, "Function expects return at the end");
+				struct erw_Token funcname = erw_ast_gettoken(
+					scope->ast, 
+					scope->functions[i].node->funcdef.name
+				);
 				erw_error(
 					msg.data, 
-					lines[scope->functions[i].node->funcdef.name->linenum - 1]
-						.data,
-					scope->functions[i].node->funcdef.name->linenum, 
-					scope->functions[i].node->funcdef.name->column,
-					scope->functions[i].node->funcdef.name->column +
-						vec_getsize(
-							scope->functions[i].node->funcdef.name->text) - 2
+					erw_lines_get(lines, funcname.linenum),
+					funcname.linenum, 
+					funcname.column,
+					funcname.column +
+						funcname.len - 1
 				);
 				str_dtor(&msg);
 			}
@@ -1969,7 +2335,7 @@ static void erw_checkreturn(struct erw_Scope* scope, struct Str* lines)
 	}
 }
 
-static void erw_checkunused(struct erw_Scope* scope, struct Str* lines)
+static void erw_checkunused(struct erw_Scope* scope, struct erw_Lines* lines)
 {
 	log_assert(scope, "is NULL");
 	log_assert(lines, "is NULL");
@@ -1981,13 +2347,17 @@ static void erw_checkunused(struct erw_Scope* scope, struct Str* lines)
 		{
 			struct Str msg;
 			str_ctor(&msg, "Unused variable");
+			struct erw_Token varname = erw_ast_gettoken(
+				scope->ast, 
+				var->node->vardeclr.name
+			);
 			erw_warning(
 				msg.data, 
-				lines[var->node->vardeclr.name->linenum - 1].data,
-				var->node->vardeclr.name->linenum, 
-				var->node->vardeclr.name->column,
-				var->node->vardeclr.name->column + 
-					vec_getsize(var->node->vardeclr.name->text) - 2
+				erw_lines_get(lines, varname.linenum),
+				varname.linenum, 
+				varname.column,
+				varname.column + 
+					varname.len - 1
 			);
 			str_dtor(&msg);
 		}
@@ -2000,13 +2370,17 @@ static void erw_checkunused(struct erw_Scope* scope, struct Str* lines)
 		{
 			struct Str msg;
 			str_ctor(&msg, "Unused function");
+			struct erw_Token funcname = erw_ast_gettoken(
+				scope->ast, 
+				func->node->funcdef.name
+			);
 			erw_warning(
 				msg.data, 
-				lines[func->node->funcdef.name->linenum - 1].data,
-				func->node->funcdef.name->linenum, 
-				func->node->funcdef.name->column,
-				func->node->funcdef.name->column +
-					vec_getsize(func->node->funcdef.name->text) - 2
+				erw_lines_get(lines, funcname.linenum),
+				funcname.linenum, 
+				funcname.column,
+				funcname.column +
+					funcname.len - 1
 			);
 			str_dtor(&msg);
 		}
@@ -2019,13 +2393,17 @@ static void erw_checkunused(struct erw_Scope* scope, struct Str* lines)
 		{
 			struct Str msg;
 			str_ctor(&msg, "Unused type");
+			struct erw_Token declrname = erw_ast_gettoken(
+				scope->ast, 
+				type->node->typedeclr.name
+			);
 			erw_warning(
 				msg.data,
-				lines[type->node->typedeclr.name->linenum - 1].data,
-				type->node->typedeclr.name->linenum,
-				type->node->typedeclr.name->column,
-				type->node->typedeclr.name->column +
-					vec_getsize(type->node->typedeclr.name->text) - 2
+				erw_lines_get(lines, declrname.linenum),
+				declrname.linenum,
+				declrname.column,
+				declrname.column +
+					declrname.len - 1
 			);
 			str_dtor(&msg);
 		}
@@ -2037,12 +2415,15 @@ static void erw_checkunused(struct erw_Scope* scope, struct Str* lines)
 	}
 }
 
-void erw_checkmain(struct erw_Scope* scope, struct Str* lines)
+void erw_checkmain(struct erw_Scope* scope, struct erw_Lines* lines)
 {
 	log_assert(scope, "is NULL");
 	log_assert(lines, "is NULL");
 
-	struct erw_FuncDeclr* func = erw_scope_findfunc(scope, "main");
+	struct erw_FuncDeclr* func = erw_scope_findfunc(
+		scope, 
+		erw_intern("main", sizeof("main") - 1)
+	);
 	if(!func)
 	{
 		erw_error("No main function found", NULL, 0, 0, 0);
@@ -2053,13 +2434,17 @@ void erw_checkmain(struct erw_Scope* scope, struct Str* lines)
 			func->type, 
 			erw_type_builtins[erw_TYPEBUILTIN_INT32]))
 	{
+		struct erw_Token funcname = erw_ast_gettoken(
+			scope->ast, 
+			func->node->funcdef.name
+		);
 		erw_error(
 			"Expected main to return 'Int32'",
-			lines[func->node->funcdef.name->linenum - 1].data,
-			func->node->funcdef.name->linenum,
-			func->node->funcdef.name->column,
-			func->node->funcdef.name->column +
-				vec_getsize(func->node->funcdef.name->text) - 2
+			erw_lines_get(lines, funcname.linenum),
+			funcname.linenum,
+			funcname.column,
+			funcname.column +
+				funcname.len - 1
 		);
 	}
 
@@ -2067,19 +2452,16 @@ void erw_checkmain(struct erw_Scope* scope, struct Str* lines)
 	func->used = 1;
 }
 
-struct erw_Scope* erw_checksemantics(struct erw_ASTNode* ast, struct Str* lines)
+struct erw_Scope* erw_checksemantics(
+	const struct erw_AST* ast, 
+	struct erw_Lines* lines)
 {
 	log_assert(ast, "is NULL");
-	log_assert(
-		ast->type == 
-		erw_ASTNODETYPE_START, 
-		"invalid type (%s)", 
-		ast->type->name
-	);
 	log_assert(lines, "is NULL");
 
 	//NOTE: Global scope is temporarily named NULL
 	struct erw_Scope* globalscope = erw_scope_new(NULL, NULL, 0, 1); 
+	globalscope->ast = ast;
 
 	//Add all builtin types
 	for(size_t i = 0; i < erw_TYPEBUILTIN_COUNT; i++)
@@ -2099,15 +2481,20 @@ struct erw_Scope* erw_checksemantics(struct erw_ASTNode* ast, struct Str* lines)
 		vec_pushback(globalscope->types, type);
 	}
 
-	for(size_t i = 0; i < vec_getsize(ast->start.children); i++)
+	struct erw_ASTList children = ast->nodes[0].start.children;
+	for(size_t i = 0; i < children.size; i++)
 	{
-		if(ast->start.children[i]->type == erw_ASTNODETYPE_FUNCDEF)
-		{
-			erw_checkfunc(globalscope, ast->start.children[i], lines);
-		}
-		else if(ast->start.children[i]->type == erw_ASTNODETYPE_TYPEDECLR)
+		struct erw_ASTNode* child = erw_ast_getchild(ast, children, i);
+		switch(child->type)
 		{
-			erw_scope_addtypedeclr(globalscope, ast->start.children[i], lines);
+		case erw_ASTNODETYPE_FUNCDEF:
+			erw_checkfunc(globalscope, child, lines);
+			break;
+		case erw_ASTNODETYPE_TYPEDECLR:
+			erw_scope_addtypedeclr(globalscope, child, lines);
+			break;
+		default:
+			break;
 		}
 	}
 
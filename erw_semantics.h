@@ -24,8 +24,8 @@
 #include "erw_scope.h"
 
 struct erw_Scope* erw_checksemantics(
-	struct erw_ASTNode* ast, 
-	struct Str* lines
+	const struct erw_AST* ast, 
+	struct erw_Lines* lines
 );
 
 #endif
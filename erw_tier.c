@@ -0,0 +1,915 @@
+/*
+	Copyright (C) 2017 Erik Wallström
+
+	This file is part of Erwall.
+
+	Erwall is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Erwall is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Erwall.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "erw_tier.h"
+#include "erw_ir.h"
+#include "log.h"
+#include <dlfcn.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+//Native code gets everything from the host through erw_TierRuntime, so the
+//shared objects don't link against anything but libm. The helpers have to
+//behave like the interpreter.
+static const char erw_tier_prelude[] =
+	"#include <math.h>\n"
+	"#include <stddef.h>\n"
+	"#include <stdint.h>\n"
+	"#include <string.h>\n"
+	"\n"
+	"struct erw_TierRuntime\n"
+	"{\n"
+	"\tvoid (*call)(struct erw_TierRuntime* runtime, size_t func);\n"
+	"\tvoid (*error)(const char* message);\n"
+	"\tvoid* interpreter;\n"
+	"\tuint64_t* registers;\n"
+	"\tsize_t depth;\n"
+	"};\n"
+	"\n"
+	"#define erw_ERROR(message) \\\n"
+	"\t(runtime->error(message), __builtin_unreachable())\n"
+	"\n"
+	"static double erw_f(uint64_t value)\n"
+	"{\n"
+	"\tdouble ret;\n"
+	"\tmemcpy(&ret, &value, sizeof(ret));\n"
+	"\treturn ret;\n"
+	"}\n"
+	"\n"
+	"static uint64_t erw_u(double value)\n"
+	"{\n"
+	"\tuint64_t ret;\n"
+	"\tmemcpy(&ret, &value, sizeof(ret));\n"
+	"\treturn ret;\n"
+	"}\n"
+	"\n"
+	"static int erw_cmp(int64_t a, int64_t b)\n"
+	"{\n"
+	"\treturn (a > b) - (a < b);\n"
+	"}\n"
+	"\n"
+	"static int erw_ucmp(uint64_t a, uint64_t b)\n"
+	"{\n"
+	"\treturn (a > b) - (a < b);\n"
+	"}\n"
+	"\n"
+	"static int erw_fcmp(double a, double b)\n"
+	"{\n"
+	"\treturn isunordered(a, b) ? 2 : (a > b) - (a < b);\n"
+	"}\n"
+	"\n"
+	"static uint64_t erw_pow(int64_t base, int64_t exponent)\n"
+	"{\n"
+	"\tif(exponent < 0)\n"
+	"\t{\n"
+	"\t\tif(base == 1 || base == -1)\n"
+	"\t\t{\n"
+	"\t\t\treturn (exponent & 1) ? base : 1;\n"
+	"\t\t}\n"
+	"\n"
+	"\t\treturn 0;\n"
+	"\t}\n"
+	"\n"
+	"\tuint64_t ret = 1;\n"
+	"\tuint64_t tmp = base;\n"
+	"\twhile(exponent)\n"
+	"\t{\n"
+	"\t\tif(exponent & 1)\n"
+	"\t\t{\n"
+	"\t\t\tret *= tmp;\n"
+	"\t\t}\n"
+	"\n"
+	"\t\ttmp *= tmp;\n"
+	"\t\texponent >>= 1;\n"
+	"\t}\n"
+	"\n"
+	"\treturn ret;\n"
+	"}\n"
+	"\n"
+	"static uint64_t erw_ftoi(double value)\n"
+	"{\n"
+	"\tif(value >= -9223372036854775808.0 && value < 9223372036854775808.0)\n"
+	"\t{\n"
+	"\t\treturn (int64_t)value;\n"
+	"\t}\n"
+	"\n"
+	"\treturn (uint64_t)INT64_MIN;\n"
+	"}\n"
+	"\n";
+
+//C for the instructions that don't depend on the rest of the function. $N
+//is the register in operand N, #N its value and @N the label of a target.
+//Registers are uint64_t locals, flags are the same as in the interpreter.
+static const char* const erw_tier_templates[erw_INSTRUCTIONID_COUNT] = {
+	[erw_INSTRUCTIONID_LOADL8] = "$0 = #1;",
+	[erw_INSTRUCTIONID_LOADL16] = "$0 = #1;",
+	[erw_INSTRUCTIONID_LOADL32] = "$0 = #1;",
+	[erw_INSTRUCTIONID_LOADL64] = "$0 = #1;",
+	[erw_INSTRUCTIONID_ADD] = "$0 = $1 + $2;",
+	[erw_INSTRUCTIONID_SUB] = "$0 = $1 - $2;",
+	[erw_INSTRUCTIONID_MUL] = "$0 = $1 * $2;",
+	[erw_INSTRUCTIONID_DIV] =
+		"if(!$2) erw_ERROR(\"Division by zero\");\n"
+		"\t$0 = (int64_t)$2 == -1 ? 0 - $1 "
+			": (uint64_t)((int64_t)$1 / (int64_t)$2);",
+	[erw_INSTRUCTIONID_POW] = "$0 = erw_pow($1, $2);",
+	[erw_INSTRUCTIONID_MOD] =
+		"if(!$2) erw_ERROR(\"Division by zero\");\n"
+		"\t$0 = (int64_t)$2 == -1 ? 0 "
+			": (uint64_t)((int64_t)$1 % (int64_t)$2);",
+	[erw_INSTRUCTIONID_UDIV] =
+		"if(!$2) erw_ERROR(\"Division by zero\");\n"
+		"\t$0 = $1 / $2;",
+	[erw_INSTRUCTIONID_UMOD] =
+		"if(!$2) erw_ERROR(\"Division by zero\");\n"
+		"\t$0 = $1 % $2;",
+	[erw_INSTRUCTIONID_FADD] = "$0 = erw_u(erw_f($1) + erw_f($2));",
+	[erw_INSTRUCTIONID_FSUB] = "$0 = erw_u(erw_f($1) - erw_f($2));",
+	[erw_INSTRUCTIONID_FMUL] = "$0 = erw_u(erw_f($1) * erw_f($2));",
+	[erw_INSTRUCTIONID_FDIV] = "$0 = erw_u(erw_f($1) / erw_f($2));",
+	[erw_INSTRUCTIONID_FPOW] = "$0 = erw_u(pow(erw_f($1), erw_f($2)));",
+	[erw_INSTRUCTIONID_FMOD] = "$0 = erw_u(fmod(erw_f($1), erw_f($2)));",
+	[erw_INSTRUCTIONID_NEG] = "$0 = 0 - $1;",
+	[erw_INSTRUCTIONID_FNEG] = "$0 = erw_u(-erw_f($1));",
+	[erw_INSTRUCTIONID_NOT] = "$0 = !$1;",
+	[erw_INSTRUCTIONID_ITOF] = "$0 = erw_u((double)(int64_t)$1);",
+	[erw_INSTRUCTIONID_UTOF] = "$0 = erw_u((double)$1);",
+	[erw_INSTRUCTIONID_FTOI] = "$0 = erw_ftoi(erw_f($1));",
+	[erw_INSTRUCTIONID_SEXT8] = "$0 = (uint64_t)(int8_t)$1;",
+	[erw_INSTRUCTIONID_SEXT16] = "$0 = (uint64_t)(int16_t)$1;",
+	[erw_INSTRUCTIONID_SEXT32] = "$0 = (uint64_t)(int32_t)$1;",
+	[erw_INSTRUCTIONID_ZEXT8] = "$0 = (uint8_t)$1;",
+	[erw_INSTRUCTIONID_ZEXT16] = "$0 = (uint16_t)$1;",
+	[erw_INSTRUCTIONID_ZEXT32] = "$0 = (uint32_t)$1;",
+	[erw_INSTRUCTIONID_MOV] = "$0 = $1;",
+	[erw_INSTRUCTIONID_LOAD] = "$0 = s[#1];",
+	[erw_INSTRUCTIONID_STORE] = "s[#0] = $1;",
+	[erw_INSTRUCTIONID_RET] = "runtime->depth--;\n\treturn r0;",
+	[erw_INSTRUCTIONID_CMP] = "flags = erw_cmp($0, $1);",
+	[erw_INSTRUCTIONID_UCMP] = "flags = erw_ucmp($0, $1);",
+	[erw_INSTRUCTIONID_FCMP] = "flags = erw_fcmp(erw_f($0), erw_f($1));",
+	[erw_INSTRUCTIONID_JMP] = "goto L@0;",
+	[erw_INSTRUCTIONID_JNE] = "if(flags != 0) goto L@0;",
+	[erw_INSTRUCTIONID_JGE] = "if(flags == 0 || flags == 1) goto L@0;",
+	[erw_INSTRUCTIONID_JLE] = "if(flags == 0 || flags == -1) goto L@0;",
+	[erw_INSTRUCTIONID_JE] = "if(flags == 0) goto L@0;",
+	[erw_INSTRUCTIONID_JG] = "if(flags == 1) goto L@0;",
+	[erw_INSTRUCTIONID_JL] = "if(flags == -1) goto L@0;",
+	[erw_INSTRUCTIONID_JZ] = "if(!$0) goto L@1;",
+	[erw_INSTRUCTIONID_JNZ] = "if($0) goto L@1;",
+	[erw_INSTRUCTIONID_SETNE] = "$0 = flags != 0;",
+	[erw_INSTRUCTIONID_SETGE] = "$0 = flags == 0 || flags == 1;",
+	[erw_INSTRUCTIONID_SETLE] = "$0 = flags == 0 || flags == -1;",
+	[erw_INSTRUCTIONID_SETE] = "$0 = flags == 0;",
+	[erw_INSTRUCTIONID_SETG] = "$0 = flags == 1;",
+	[erw_INSTRUCTIONID_SETL] = "$0 = flags == -1;",
+	[erw_INSTRUCTIONID_CMPJNE] =
+		"flags = erw_cmp($0, $1);\n\tif(flags != 0) goto L@2;",
+	[erw_INSTRUCTIONID_CMPJGE] =
+		"flags = erw_cmp($0, $1);\n\tif(flags != -1) goto L@2;",
+	[erw_INSTRUCTIONID_CMPJLE] =
+		"flags = erw_cmp($0, $1);\n\tif(flags != 1) goto L@2;",
+	[erw_INSTRUCTIONID_CMPJE] =
+		"flags = erw_cmp($0, $1);\n\tif(flags == 0) goto L@2;",
+	[erw_INSTRUCTIONID_CMPJG] =
+		"flags = erw_cmp($0, $1);\n\tif(flags == 1) goto L@2;",
+	[erw_INSTRUCTIONID_CMPJL] =
+		"flags = erw_cmp($0, $1);\n\tif(flags == -1) goto L@2;",
+	[erw_INSTRUCTIONID_UCMPJNE] =
+		"flags = erw_ucmp($0, $1);\n\tif(flags != 0) goto L@2;",
+	[erw_INSTRUCTIONID_UCMPJGE] =
+		"flags = erw_ucmp($0, $1);\n\tif(flags != -1) goto L@2;",
+	[erw_INSTRUCTIONID_UCMPJLE] =
+		"flags = erw_ucmp($0, $1);\n\tif(flags != 1) goto L@2;",
+	[erw_INSTRUCTIONID_UCMPJE] =
+		"flags = erw_ucmp($0, $1);\n\tif(flags == 0) goto L@2;",
+	[erw_INSTRUCTIONID_UCMPJG] =
+		"flags = erw_ucmp($0, $1);\n\tif(flags == 1) goto L@2;",
+	[erw_INSTRUCTIONID_UCMPJL] =
+		"flags = erw_ucmp($0, $1);\n\tif(flags == -1) goto L@2;",
+	[erw_INSTRUCTIONID_ADDI] = "$0 = $1 + (uint64_t)(int32_t)#2;",
+};
+
+//What erw_tier_generate needs to know about a function
+struct erw_TierFuncInfo
+{
+	const struct erw_BytecodeFuncEntry* entry;
+	size_t end; //Offset after the last instruction
+	Vec(struct erw_IRInstruction) instructions;
+	Vec(size_t) depths; //Pushed registers before each instruction
+	Vec(uint8_t) isused; //Per register
+	size_t maxdepth;
+	size_t numslots;
+	int istranslated;
+};
+
+//Decodes the function and follows the pushes and pops through it. Returns 0
+//if it uses anything native code can't do, in which case it stays
+//interpreted: HALT, jumps out of the function, falling off its end or
+//pushes that don't balance.
+static int erw_tier_analyze(
+	struct erw_BytecodeImage* image,
+	struct erw_TierFuncInfo* info)
+{
+	const uint8_t* code = image->instructions;
+	size_t pos = info->entry->offset;
+	while(pos < info->end)
+	{
+		struct erw_IRInstruction instruction = {
+			.id = code[pos],
+			.offset = pos
+		};
+
+		if(instruction.id >= erw_INSTRUCTIONID_COUNT
+			|| instruction.id == erw_INSTRUCTIONID_HALT
+			|| erw_instructioninfos[instruction.id].size > info->end - pos)
+		{
+			return 0;
+		}
+
+		const char* operands = erw_instructioninfos[instruction.id].operands;
+		const uint8_t* operand = code + pos + 1;
+		for(size_t i = 0; operands[i]; i++)
+		{
+			size_t size = erw_operandsize(operands[i]);
+			for(size_t j = 0; j < size; j++)
+			{
+				instruction.operands[i] |= (uint64_t)operand[j] << (j * 8);
+			}
+
+			if(operands[i] == 'r')
+			{
+				info->isused[instruction.operands[i]] = 1;
+			}
+
+			operand += size;
+		}
+
+		size_t numimplicit = 0; //Registers r0, r1, ... used implicitly
+		if(instruction.id == erw_INSTRUCTIONID_CALL)
+		{
+			const struct erw_BytecodeFuncEntry* callee =
+				erw_bytecodeimage_findfunc(image, instruction.operands[0]);
+			if(!callee || callee->offset != instruction.operands[0])
+			{
+				return 0;
+			}
+
+			instruction.numargs = callee->numparams;
+			numimplicit = callee->numparams;
+		}
+		else if(instruction.id == erw_INSTRUCTIONID_PUSHN
+			|| instruction.id == erw_INSTRUCTIONID_POPN)
+		{
+			numimplicit = instruction.operands[0];
+		}
+		else if(instruction.id == erw_INSTRUCTIONID_ENTER)
+		{
+			if(pos != info->entry->offset)
+			{
+				return 0;
+			}
+
+			info->numslots = instruction.operands[0];
+		}
+
+		if(numimplicit > erw_NUMREGISTERS)
+		{
+			return 0;
+		}
+
+		memset(info->isused, 1, numimplicit);
+		vec_pushback(info->instructions, instruction);
+		pos += erw_instructioninfos[instruction.id].size;
+	}
+
+	size_t numinstructions = vec_getsize(info->instructions);
+	vec_expand(info->depths, 0, numinstructions);
+	for(size_t i = 0; i < numinstructions; i++)
+	{
+		info->depths[i] = SIZE_MAX;
+		const struct erw_IRInstruction* instruction = &info->instructions[i];
+		if(instruction->id == erw_INSTRUCTIONID_LOAD
+			&& instruction->operands[1] >= info->numslots)
+		{
+			info->numslots = instruction->operands[1] + 1;
+		}
+		else if(instruction->id == erw_INSTRUCTIONID_STORE
+			&& instruction->operands[0] >= info->numslots)
+		{
+			info->numslots = instruction->operands[0] + 1;
+		}
+	}
+
+	//Every path to an instruction has to have pushed the same registers, so
+	//that they can be kept in locals
+	if(!numinstructions)
+	{
+		return 0;
+	}
+
+	Vec(size_t) worklist = vec_ctor(size_t, 0);
+	info->depths[0] = 0;
+	vec_pushback(worklist, 0);
+	int ret = 1;
+	while(ret && vec_getsize(worklist))
+	{
+		size_t i = worklist[vec_getsize(worklist) - 1];
+		vec_popback(worklist);
+
+		const struct erw_IRInstruction* instruction = &info->instructions[i];
+		size_t depth = info->depths[i];
+		size_t popped = instruction->id == erw_INSTRUCTIONID_POP ? 1
+			: instruction->id == erw_INSTRUCTIONID_POPN
+				? instruction->operands[0]
+			: 0;
+		if(popped > depth)
+		{
+			ret = 0;
+			break;
+		}
+
+		depth -= popped;
+		depth += instruction->id == erw_INSTRUCTIONID_PUSH ? 1
+			: instruction->id == erw_INSTRUCTIONID_PUSHN
+				? instruction->operands[0]
+			: 0;
+		if(depth > info->maxdepth)
+		{
+			info->maxdepth = depth;
+		}
+
+		size_t successors[2];
+		size_t numsuccessors = 0;
+		enum erw_InstructionID id = instruction->id;
+		if(id != erw_INSTRUCTIONID_JMP && id != erw_INSTRUCTIONID_RET)
+		{
+			successors[numsuccessors++] = i + 1;
+		}
+
+		if(erw_ir_isbranch(id))
+		{
+			const char* operands = erw_instructioninfos[id].operands;
+			size_t target = erw_ir_search(
+				info->instructions,
+				instruction->operands[strchr(operands, 't') - operands]
+			);
+			successors[numsuccessors++] = target;
+		}
+
+		for(size_t j = 0; j < numsuccessors; j++)
+		{
+			size_t successor = successors[j];
+			if(successor >= numinstructions)
+			{
+				ret = 0;
+			}
+			else if(info->depths[successor] == SIZE_MAX)
+			{
+				info->depths[successor] = depth;
+				vec_pushback(worklist, successor);
+			}
+			else if(info->depths[successor] != depth)
+			{
+				ret = 0;
+			}
+		}
+	}
+
+	vec_dtor(worklist);
+	return ret;
+}
+
+//Appends template from erw_tier_templates with the operands of instruction
+static void erw_tier_expand(
+	struct Str* code,
+	const char* template,
+	const struct erw_IRInstruction* instruction)
+{
+	while(*template)
+	{
+		size_t len = strcspn(template, "$#@");
+		str_appendfmt(code, "%.*s", (int)len, template);
+		template += len;
+		if(!*template)
+		{
+			break;
+		}
+
+		uint64_t operand = instruction->operands[template[1] - '0'];
+		str_appendfmt(
+			code,
+			*template == '$' ? "r%" PRIu64
+				: *template == '#' ? "%" PRIu64 "u"
+				: "%" PRIu64,
+			operand
+		);
+		template += 2;
+	}
+}
+
+//Appends fmt, which takes the index of the parameter, for every parameter
+static void erw_tier_generateparams(
+	struct Str* code,
+	const struct erw_TierFuncInfo* info,
+	const char* fmt)
+{
+	for(size_t i = 0; i < info->entry->numparams; i++)
+	{
+		str_appendfmt(code, fmt, i);
+	}
+}
+
+static void erw_tier_generatecall(
+	struct Str* code,
+	const struct erw_IRInstruction* instruction,
+	const struct erw_TierFuncInfo* callee)
+{
+	size_t func = instruction->operands[0];
+	if(callee)
+	{
+		str_appendfmt(
+			code,
+			"\tif(runtime->depth < %i)\n\t{\n\t\tr0 = erw_func%zu(runtime",
+			erw_TIER_MAXDEPTH,
+			func
+		);
+		erw_tier_generateparams(code, callee, ", r%zu");
+		str_append(code, ");\n\t}\n\telse\n");
+	}
+
+	//Anything else goes through the host, which interprets it if there is no
+	//native code for it yet
+	str_append(code, "\t{\n");
+	for(size_t i = 0; i < instruction->numargs; i++)
+	{
+		str_appendfmt(code, "\t\truntime->registers[%zu] = r%zu;\n", i, i);
+	}
+
+	str_appendfmt(
+		code,
+		"\t\truntime->call(runtime, %zu);\n"
+			"\t\tr0 = runtime->registers[0];\n"
+			"\t}\n",
+		func
+	);
+}
+
+static void erw_tier_generatefunc(
+	struct Str* code,
+	struct erw_TierFuncInfo* info,
+	const struct erw_TierFuncInfo* infos,
+	size_t numinfos)
+{
+	size_t offset = info->entry->offset;
+	str_appendfmt(
+		code,
+		"static uint64_t erw_func%zu(struct erw_TierRuntime* runtime",
+		offset
+	);
+	erw_tier_generateparams(code, info, ", uint64_t a%zu");
+	str_append(code, ")\n{\n");
+	for(size_t i = 0; i < erw_NUMREGISTERS; i++)
+	{
+		if(info->isused[i] && i < info->entry->numparams)
+		{
+			str_appendfmt(code, "\tuint64_t r%zu = a%zu;\n", i, i);
+		}
+		else if(info->isused[i])
+		{
+			str_appendfmt(code, "\tuint64_t r%zu = 0;\n", i);
+		}
+	}
+
+	for(size_t i = 0; i < info->maxdepth; i++)
+	{
+		str_appendfmt(code, "\tuint64_t p%zu = 0;\n", i);
+	}
+
+	if(info->numslots)
+	{
+		str_appendfmt(code, "\tuint64_t s[%zu] = {0};\n", info->numslots);
+	}
+
+	str_append(code, "\tint flags = 0;\n\truntime->depth++;\n");
+
+	Vec(uint8_t) istarget = vec_ctor(uint8_t, 0);
+	vec_expand(istarget, 0, vec_getsize(info->instructions));
+	memset(istarget, 0, vec_getsize(info->instructions));
+	for(size_t i = 0; i < vec_getsize(info->instructions); i++)
+	{
+		const struct erw_IRInstruction* instruction = &info->instructions[i];
+		const char* operands = erw_instructioninfos[instruction->id].operands;
+		const char* target = strchr(operands, 't');
+		if(info->depths[i] != SIZE_MAX
+			&& erw_ir_isbranch(instruction->id))
+		{
+			istarget[erw_ir_search(
+				info->instructions,
+				instruction->operands[target - operands]
+			)] = 1;
+		}
+	}
+
+	for(size_t i = 0; i < vec_getsize(info->instructions); i++)
+	{
+		//Unreachable code is left out, it can't be jumped to either
+		size_t depth = info->depths[i];
+		if(depth == SIZE_MAX)
+		{
+			continue;
+		}
+
+		const struct erw_IRInstruction* instruction = &info->instructions[i];
+		if(istarget[i])
+		{
+			str_appendfmt(code, "L%zu:;\n", instruction->offset);
+		}
+
+		const uint64_t* operands = instruction->operands;
+		switch(instruction->id)
+		{
+		case erw_INSTRUCTIONID_PUSH:
+			str_appendfmt(code, "\tp%zu = r%" PRIu64 ";\n", depth, operands[0]);
+			break;
+		case erw_INSTRUCTIONID_POP:
+			str_appendfmt(
+				code,
+				"\tr%" PRIu64 " = p%zu;\n",
+				operands[0],
+				depth - 1
+			);
+			break;
+		case erw_INSTRUCTIONID_PUSHN:
+			for(size_t j = 0; j < operands[0]; j++)
+			{
+				str_appendfmt(code, "\tp%zu = r%zu;\n", depth + j, j);
+			}
+			break;
+		case erw_INSTRUCTIONID_POPN:
+			for(size_t j = 0; j < operands[0]; j++)
+			{
+				str_appendfmt(
+					code,
+					"\tr%zu = p%zu;\n",
+					j,
+					depth - operands[0] + j
+				);
+			}
+			break;
+		case erw_INSTRUCTIONID_CALL:
+			{
+				const struct erw_TierFuncInfo* callee = NULL;
+				for(size_t j = 0; j < numinfos; j++)
+				{
+					if(infos[j].istranslated
+						&& infos[j].entry->offset == operands[0])
+					{
+						callee = &infos[j];
+					}
+				}
+
+				erw_tier_generatecall(code, instruction, callee);
+			}
+			break;
+		case erw_INSTRUCTIONID_ENTER:
+			break; //The slots are zeroed when they're declared
+		default:
+			str_append(code, "\t");
+			erw_tier_expand(
+				code,
+				erw_tier_templates[instruction->id],
+				instruction
+			);
+			str_append(code, "\n");
+			break;
+		}
+	}
+
+	str_append(code, "}\n\n");
+	vec_dtor(istarget);
+}
+
+struct Str erw_tier_generate(
+	struct erw_BytecodeImage* image,
+	const size_t* funcs,
+	size_t numfuncs)
+{
+	log_assert(image, "is NULL");
+	log_assert(funcs, "is NULL");
+
+	Vec(struct erw_TierFuncInfo) infos = vec_ctor(
+		struct erw_TierFuncInfo,
+		numfuncs
+	);
+	for(size_t i = 0; i < numfuncs; i++)
+	{
+		const struct erw_BytecodeFuncEntry* entry =
+			erw_bytecodeimage_findfunc(image, funcs[i]);
+		log_assert(
+			entry && entry->offset == funcs[i],
+			"not a function (%zu)",
+			funcs[i]
+		);
+
+		size_t index = entry - image->functions;
+		struct erw_TierFuncInfo info = {
+			.entry = entry,
+			.end = index + 1 < image->numfunctions
+				? entry[1].offset
+				: image->numinstructions,
+			.instructions = vec_ctor(struct erw_IRInstruction, 0),
+			.depths = vec_ctor(size_t, 0),
+			.isused = vec_ctor(uint8_t, erw_NUMREGISTERS)
+		};
+		vec_expand(info.isused, 0, erw_NUMREGISTERS);
+		memset(info.isused, 0, erw_NUMREGISTERS);
+		info.isused[0] = 1; //Returned
+		info.istranslated = erw_tier_analyze(image, &info);
+		vec_pushback(infos, info);
+	}
+
+	struct Str code;
+	str_ctor(&code, erw_tier_prelude);
+	for(size_t i = 0; i < numfuncs; i++)
+	{
+		if(infos[i].istranslated)
+		{
+			str_appendfmt(
+				&code,
+				"static uint64_t erw_func%zu(struct erw_TierRuntime* runtime",
+				funcs[i]
+			);
+			erw_tier_generateparams(&code, &infos[i], ", uint64_t a%zu");
+			str_append(&code, ");\n");
+		}
+	}
+
+	str_append(&code, "\n");
+	for(size_t i = 0; i < numfuncs; i++)
+	{
+		if(infos[i].istranslated)
+		{
+			erw_tier_generatefunc(&code, &infos[i], infos, numfuncs);
+		}
+	}
+
+	//The entry points take their arguments from the registers, like CALL
+	for(size_t i = 0; i < numfuncs; i++)
+	{
+		if(infos[i].istranslated)
+		{
+			str_appendfmt(
+				&code,
+				"void erw_native%zu(struct erw_TierRuntime* runtime)\n"
+					"{\n"
+					"\tuint64_t* r = runtime->registers;\n"
+					"\tr[0] = erw_func%zu(runtime",
+				funcs[i],
+				funcs[i]
+			);
+			erw_tier_generateparams(&code, &infos[i], ", r[%zu]");
+			str_append(&code, ");\n}\n\n");
+		}
+
+		vec_dtor(infos[i].instructions);
+		vec_dtor(infos[i].depths);
+		vec_dtor(infos[i].isused);
+	}
+
+	vec_dtor(infos);
+	return code;
+}
+static void erw_tier_error(const char* message)
+{
+	log_error("%s", message);
+}
+
+//Calls made by native code to functions it doesn't contain
+static void erw_tier_call(struct erw_TierRuntime* runtime, size_t func)
+{
+	struct erw_Interpreter* interpreter = runtime->interpreter;
+	erw_TierNative native = erw_tier_lookup(interpreter->tier, func);
+	if(native)
+	{
+		native(runtime);
+	}
+	else
+	{
+		erw_interpreter_call(interpreter, func);
+	}
+}
+
+//Failures are quiet, the functions just stay interpreted
+static void erw_tier_compile(struct erw_Tier* self, Vec(size_t) funcs)
+{
+	if(!self->dir[0])
+	{
+		return;
+	}
+
+	char cpath[64];
+	char sopath[64];
+	snprintf(cpath, sizeof(cpath), "%s/%zu.c", self->dir, self->numcompiled);
+	snprintf(sopath, sizeof(sopath), "%s/%zu.so", self->dir, self->numcompiled);
+	self->numcompiled++;
+
+	struct Str code = erw_tier_generate(
+		self->image,
+		funcs,
+		vec_getsize(funcs)
+	);
+	FILE* file = fopen(cpath, "w");
+	if(!file)
+	{
+		str_dtor(&code);
+		return;
+	}
+
+	int iswritten = fwrite(code.data, 1, code.len, file) == code.len;
+	iswritten &= !fclose(file);
+	str_dtor(&code);
+
+	struct Str command;
+	str_ctorfmt(
+		&command,
+		"gcc %s -o %s -shared -fPIC -w -O2 -march=native -lm 2>/dev/null",
+		cpath,
+		sopath
+	);
+	int ret = iswritten ? system(command.data) : -1;
+	str_dtor(&command);
+	remove(cpath);
+
+	//The mapping stays after the file is removed
+	void* library = ret ? NULL : dlopen(sopath, RTLD_NOW | RTLD_LOCAL);
+	remove(sopath);
+	if(!library)
+	{
+		return;
+	}
+
+	vec_pushback(self->libraries, library);
+	for(size_t i = 0; i < vec_getsize(funcs); i++)
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "erw_native%zu", funcs[i]);
+		erw_TierNative native = (erw_TierNative)dlsym(library, name);
+		if(native)
+		{
+			atomic_store_explicit(
+				&self->funcs[funcs[i]].native,
+				native,
+				memory_order_release
+			);
+		}
+	}
+}
+
+static void* erw_tier_work(void* udata)
+{
+	struct erw_Tier* self = udata;
+	pthread_mutex_lock(&self->mutex);
+	while(1)
+	{
+		while(!self->isstopping && !vec_getsize(self->queue))
+		{
+			pthread_cond_wait(&self->cond, &self->mutex);
+		}
+
+		if(self->isstopping)
+		{
+			break;
+		}
+
+		//Everything queued so far is compiled together, so functions that
+		//got hot at the same time can call each other directly
+		Vec(size_t) funcs = self->queue;
+		self->queue = vec_ctor(size_t, 0);
+		pthread_mutex_unlock(&self->mutex);
+		erw_tier_compile(self, funcs);
+		vec_dtor(funcs);
+		pthread_mutex_lock(&self->mutex);
+	}
+
+	pthread_mutex_unlock(&self->mutex);
+	return NULL;
+}
+
+struct erw_Tier* erw_tier_ctor(
+	struct erw_Tier* self,
+	struct erw_BytecodeImage* image,
+	struct erw_Interpreter* interpreter)
+{
+	log_assert(self, "is NULL");
+	log_assert(image, "is NULL");
+	log_assert(interpreter, "is NULL");
+
+	self->image = image;
+	self->funcs = vec_ctor(struct erw_TierFunc, image->numinstructions);
+	vec_expand(self->funcs, 0, image->numinstructions);
+	for(size_t i = 0; i < image->numinstructions; i++)
+	{
+		atomic_init(&self->funcs[i].native, NULL);
+		self->funcs[i].calls = 0;
+	}
+
+	self->runtime = (struct erw_TierRuntime){
+		.call = erw_tier_call,
+		.error = erw_tier_error,
+		.interpreter = interpreter,
+		.registers = interpreter->registers
+	};
+
+	self->queue = vec_ctor(size_t, 0);
+	self->isstopping = 0;
+	self->libraries = vec_ctor(void*, 0);
+	self->numcompiled = 0;
+	strcpy(self->dir, "/tmp/erwtierXXXXXX");
+	if(!mkdtemp(self->dir))
+	{
+		self->dir[0] = '\0';
+	}
+
+	if(pthread_mutex_init(&self->mutex, NULL)
+		|| pthread_cond_init(&self->cond, NULL)
+		|| pthread_create(&self->worker, NULL, erw_tier_work, self))
+	{
+		log_error("Failed to start the tier worker <%s>", __func__);
+	}
+
+	return self;
+}
+
+erw_TierNative erw_tier_lookup(struct erw_Tier* self, size_t func)
+{
+	log_assert(self, "is NULL");
+	log_assert(func < vec_getsize(self->funcs), "invalid function (%zu)", func);
+
+	struct erw_TierFunc* entry = &self->funcs[func];
+	erw_TierNative native = atomic_load_explicit(
+		&entry->native,
+		memory_order_acquire
+	);
+	if(native)
+	{
+		return self->runtime.depth < erw_TIER_MAXDEPTH ? native : NULL;
+	}
+
+	if(entry->calls < erw_TIER_THRESHOLD
+		&& ++entry->calls == erw_TIER_THRESHOLD)
+	{
+		pthread_mutex_lock(&self->mutex);
+		vec_pushback(self->queue, func);
+		pthread_cond_signal(&self->cond);
+		pthread_mutex_unlock(&self->mutex);
+	}
+
+	return NULL;
+}
+
+void erw_tier_dtor(struct erw_Tier* self)
+{
+	log_assert(self, "is NULL");
+
+	pthread_mutex_lock(&self->mutex);
+	self->isstopping = 1;
+	pthread_cond_signal(&self->cond);
+	pthread_mutex_unlock(&self->mutex);
+	pthread_join(self->worker, NULL);
+	pthread_cond_destroy(&self->cond);
+	pthread_mutex_destroy(&self->mutex);
+
+	for(size_t i = 0; i < vec_getsize(self->libraries); i++)
+	{
+		dlclose(self->libraries[i]);
+	}
+
+	if(self->dir[0])
+	{
+		rmdir(self->dir);
+	}
+
+	vec_dtor(self->libraries);
+	vec_dtor(self->queue);
+	vec_dtor(self->funcs);
+}
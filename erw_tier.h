@@ -0,0 +1,93 @@
+/*
+	Copyright (C) 2017 Erik Wallström
+
+	This file is part of Erwall.
+
+	Erwall is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Erwall is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Erwall.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ERW_TIER_H
+#define ERW_TIER_H
+
+#include "erw_interpreter.h"
+#include "erw_bytecode.h"
+#include "str.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define erw_TIER_THRESHOLD 1000 //Calls before a function is compiled
+//Native calls nested deeper than this run in the interpreter instead, which
+//keeps deep recursion on the VM stack rather than the C stack
+#define erw_TIER_MAXDEPTH 1024
+
+//Passed to native code, which declares the same struct, see erw_tier.c
+struct erw_TierRuntime
+{
+	void (*call)(struct erw_TierRuntime* runtime, size_t func);
+	void (*error)(const char* message);
+	struct erw_Interpreter* interpreter;
+	union erw_Register* registers; //Of the interpreter
+	size_t depth; //Active native calls
+};
+
+//Takes its arguments from the registers and returns in r0, like CALL
+typedef void (*erw_TierNative)(struct erw_TierRuntime* runtime);
+
+struct erw_TierFunc
+{
+	_Atomic(erw_TierNative) native; //Set by the worker once it's compiled
+	uint32_t calls; //Stops counting at erw_TIER_THRESHOLD
+};
+
+//Hot functions are translated from bytecode to C and compiled with gcc on a
+//worker thread. The shared objects are loaded with dlopen and their functions
+//are picked up by the next call, until then they keep being interpreted.
+struct erw_Tier
+{
+	struct erw_BytecodeImage* image;
+	Vec(struct erw_TierFunc) funcs; //Per offset, used at function entries
+	struct erw_TierRuntime runtime;
+
+	//Shared with the worker
+	pthread_t worker;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	Vec(size_t) queue; //Offsets of the functions to compile
+	int isstopping;
+
+	//Only used by the worker
+	char dir[32]; //Temporary directory of the generated files
+	Vec(void*) libraries;
+	size_t numcompiled;
+};
+
+//NOTE: The image and the interpreter have to outlive the tier
+struct erw_Tier* erw_tier_ctor(
+	struct erw_Tier* self,
+	struct erw_BytecodeImage* image,
+	struct erw_Interpreter* interpreter
+);
+//Counts a call of the function at offset func. Returns its native code if it
+//has been compiled and can be called, NULL if it has to be interpreted.
+erw_TierNative erw_tier_lookup(struct erw_Tier* self, size_t func);
+//Translates the functions at the given offsets to a C translation unit
+struct Str erw_tier_generate(
+	struct erw_BytecodeImage* image,
+	const size_t* funcs,
+	size_t numfuncs
+);
+//Waits for the worker to finish the compilation it's busy with
+void erw_tier_dtor(struct erw_Tier* self);
+
+#endif
@@ -19,135 +19,459 @@
 
 #include "erw_tokenizer.h"
 #include "erw_error.h"
+#include "erw_intern.h"
 #include "log.h"
 
 #include <ctype.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
-//Wall of erw_TokenType initializations
-const struct erw_TokenType* const erw_TOKENTYPE_KEYWORD_RETURN =
-	&(struct erw_TokenType){"Keyword 'return'"};
-const struct erw_TokenType* const erw_TOKENTYPE_KEYWORD_FUNC =
-	&(struct erw_TokenType){"Keyword 'func'"};
-const struct erw_TokenType* const erw_TOKENTYPE_KEYWORD_LET =
-	&(struct erw_TokenType){"Keyword 'let'"};
-const struct erw_TokenType* const erw_TOKENTYPE_KEYWORD_MUT =
-	&(struct erw_TokenType){"Keyword 'mut'"};
-const struct erw_TokenType* const erw_TOKENTYPE_KEYWORD_TYPE =
-	&(struct erw_TokenType){"Keyword 'type'"};
-const struct erw_TokenType* const erw_TOKENTYPE_KEYWORD_IF =
-	&(struct erw_TokenType){"Keyword 'if'"};
-const struct erw_TokenType* const erw_TOKENTYPE_KEYWORD_ELSEIF =
-	&(struct erw_TokenType){"Keyword 'elseif'"};
-const struct erw_TokenType* const erw_TOKENTYPE_KEYWORD_ELSE =
-	&(struct erw_TokenType){"Keyword 'else'"};
-const struct erw_TokenType* const erw_TOKENTYPE_KEYWORD_CAST =
-	&(struct erw_TokenType){"Keyword 'cast'"};
-const struct erw_TokenType* const erw_TOKENTYPE_KEYWORD_DEFER =
-	&(struct erw_TokenType){"Keyword 'defer'"};
-const struct erw_TokenType* const erw_TOKENTYPE_KEYWORD_WHILE =
-	&(struct erw_TokenType){"Keyword 'while'"};
-const struct erw_TokenType* const erw_TOKENTYPE_KEYWORD_STRUCT =
-	&(struct erw_TokenType){"Keyword 'struct'"};
-const struct erw_TokenType* const erw_TOKENTYPE_KEYWORD_UNION =
-	&(struct erw_TokenType){"Keyword 'union'"};
-const struct erw_TokenType* const erw_TOKENTYPE_KEYWORD_ENUM = 
-	&(struct erw_TokenType){"Keyword 'enum'"};
-const struct erw_TokenType* const erw_TOKENTYPE_KEYWORD_ARRAY =
-	&(struct erw_TokenType){"Keyword 'array'"};
-const struct erw_TokenType* const erw_TOKENTYPE_KEYWORD_UNSAFE =
-	&(struct erw_TokenType){"Keyword 'unsafe'"};
-const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_DECLR =
-	&(struct erw_TokenType){"Operator 'Declaration'"};
-const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_ADD =
-	&(struct erw_TokenType){"Operator 'Add'"};
-const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_SUB =
-	&(struct erw_TokenType){"Operator 'Subtract'"};
-const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_MUL =
-	&(struct erw_TokenType){"Operator 'Multiply'"};
-const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_DIV =
-	&(struct erw_TokenType){"Operator 'Divide'"};
-const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_MOD =
-	&(struct erw_TokenType){"Operator 'Modulo'"};
-const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_POW =
-	&(struct erw_TokenType){"Operator 'Exponentiate'"};
-const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_RETURN =
-	&(struct erw_TokenType){"Operator 'Return'"};
-const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_EQUAL =
-	&(struct erw_TokenType){"Operator 'Equal'"};
-const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_NOT =
-	&(struct erw_TokenType){"Operator 'Not'"};
-const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_NOTEQUAL =
-	&(struct erw_TokenType){"Operator 'Not Equal'"};
-const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_LESS =
-	&(struct erw_TokenType){"Operator 'Less Than'"};
-const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_GREATER =
-	&(struct erw_TokenType){"Operator 'Greater Than'"};
-const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_LESSOREQUAL =
-	&(struct erw_TokenType){"Operator 'Less Than or Equal'"};
-const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_GREATEROREQUAL =
-	&(struct erw_TokenType){"Operator 'Greater Than or Equal'"};
-const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_AND =
-	&(struct erw_TokenType){"Operator 'Logical And'"};
-const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_OR =
-	&(struct erw_TokenType){"Operator 'Logical Or'"};
-const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_ASSIGN =
-	&(struct erw_TokenType){"Operator 'Assign'"};
-const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_ADDASSIGN =
-	&(struct erw_TokenType){"Operator 'Add and Assign'"};
-const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_SUBASSIGN =
-	&(struct erw_TokenType){"Operator 'Subtract and Assign'"};
-const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_MULASSIGN =
-	&(struct erw_TokenType){"Operator 'Multiply and Assign'"};
-const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_DIVASSIGN =
-	&(struct erw_TokenType){"Operator 'Divide and Assign'"};
-const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_MODASSIGN =
-	&(struct erw_TokenType){"Operator 'Modulo and Assign'"};
-const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_POWASSIGN =
-	&(struct erw_TokenType){"Operator 'Exponentiate and assign'"};
-const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_BITOR =
-	&(struct erw_TokenType){"Operator 'Bitwise Or'"};
-const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_BITAND =
-	&(struct erw_TokenType){"Operator 'Bitwise And'"};
-const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_ACCESS =
-	&(struct erw_TokenType){"Operator 'Access'"};
-const struct erw_TokenType* const erw_TOKENTYPE_LITERAL_INT =
-	&(struct erw_TokenType){"Literal Int"};
-const struct erw_TokenType* const erw_TOKENTYPE_LITERAL_FLOAT =
-	&(struct erw_TokenType){"Literal Float"};
-const struct erw_TokenType* const erw_TOKENTYPE_LITERAL_STRING =
-	&(struct erw_TokenType){"Literal String"};
-const struct erw_TokenType* const erw_TOKENTYPE_LITERAL_CHAR =
-	&(struct erw_TokenType){"Literal Char"};
-const struct erw_TokenType* const erw_TOKENTYPE_LITERAL_BOOL =
-	&(struct erw_TokenType){"Literal Bool"};
-const struct erw_TokenType* const erw_TOKENTYPE_IDENT =
-	&(struct erw_TokenType){"Identifier"};
-const struct erw_TokenType* const erw_TOKENTYPE_TYPE =
-	&(struct erw_TokenType){"Type"};
-const struct erw_TokenType* const erw_TOKENTYPE_END =
-	&(struct erw_TokenType){"End"};
-const struct erw_TokenType* const erw_TOKENTYPE_COMMA =
-	&(struct erw_TokenType){"Comma"};
-const struct erw_TokenType* const erw_TOKENTYPE_LPAREN =
-	&(struct erw_TokenType){"Left Parenthesis"};
-const struct erw_TokenType* const erw_TOKENTYPE_RPAREN =
-	&(struct erw_TokenType){"Right Parenthesis"};
-const struct erw_TokenType* const erw_TOKENTYPE_LCURLY =
-	&(struct erw_TokenType){"Left Curly Bracket"};
-const struct erw_TokenType* const erw_TOKENTYPE_RCURLY =
-	&(struct erw_TokenType){"Right Curly Bracket"};
-const struct erw_TokenType* const erw_TOKENTYPE_LBRACKET =
-	&(struct erw_TokenType){"Left Bracket"};
-const struct erw_TokenType* const erw_TOKENTYPE_RBRACKET =
-	&(struct erw_TokenType){"Right Bracket"};
-const struct erw_TokenType* const erw_TOKENTYPE_FOREIGN =
-	&(struct erw_TokenType){"Foreign function call"};
-
-Vec(struct erw_Token) erw_tokenize(const char* source, Vec(struct Str) lines)
+#if defined(__AVX2__)
+	#include <immintrin.h>
+	#define erw_VECSIZE 32
+	typedef __m256i erw_Vec;
+	#define erw_vecload(p) _mm256_load_si256((const __m256i*)(p))
+	#define erw_vecmatch(v, c) \
+		(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(c)))
+#elif defined(__SSE2__)
+	#include <emmintrin.h>
+	#define erw_VECSIZE 16
+	typedef __m128i erw_Vec;
+	#define erw_vecload(p) _mm_load_si128((const __m128i*)(p))
+	#define erw_vecmatch(v, c) \
+		(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c)))
+#endif
+
+#ifdef erw_VECSIZE
+	#define erw_VECMASK (uint32_t)(((uint64_t)1 << erw_VECSIZE) - 1)
+	#define erw_NOSANITIZE __attribute__((no_sanitize_address))
+#else
+	#define erw_NOSANITIZE
+#endif
+
+const struct erw_TokenTypeInfo erw_tokentypeinfos[] = {
+	[erw_TOKENTYPE_KEYWORD_RETURN] = {"Keyword 'return'", 0},
+	[erw_TOKENTYPE_KEYWORD_FUNC] = {"Keyword 'func'", 0},
+	[erw_TOKENTYPE_KEYWORD_LET] = {"Keyword 'let'", 0},
+	[erw_TOKENTYPE_KEYWORD_MUT] = {"Keyword 'mut'", 0},
+	[erw_TOKENTYPE_KEYWORD_TYPE] = {"Keyword 'type'", 0},
+	[erw_TOKENTYPE_KEYWORD_IF] = {"Keyword 'if'", 0},
+	[erw_TOKENTYPE_KEYWORD_ELSEIF] = {"Keyword 'elseif'", 0},
+	[erw_TOKENTYPE_KEYWORD_ELSE] = {"Keyword 'else'", 0},
+	[erw_TOKENTYPE_KEYWORD_CAST] = {"Keyword 'cast'", 0},
+	[erw_TOKENTYPE_KEYWORD_DEFER] = {"Keyword 'defer'", 0},
+	[erw_TOKENTYPE_KEYWORD_WHILE] = {"Keyword 'while'", 0},
+	[erw_TOKENTYPE_KEYWORD_STRUCT] = {"Keyword 'struct'", 0},
+	[erw_TOKENTYPE_KEYWORD_UNION] = {"Keyword 'union'", 0},
+	[erw_TOKENTYPE_KEYWORD_ENUM] = {"Keyword 'enum'", 0},
+	[erw_TOKENTYPE_KEYWORD_ARRAY] = {"Keyword 'array'", 0},
+	[erw_TOKENTYPE_KEYWORD_UNSAFE] = {"Keyword 'unsafe'", 0},
+	[erw_TOKENTYPE_OPERATOR_DECLR] = {"Operator 'Declaration'", 0},
+	[erw_TOKENTYPE_OPERATOR_ADD] = {"Operator 'Add'", 4},
+	[erw_TOKENTYPE_OPERATOR_SUB] = {"Operator 'Subtract'", 4},
+	[erw_TOKENTYPE_OPERATOR_MUL] = {"Operator 'Multiply'", 5},
+	[erw_TOKENTYPE_OPERATOR_DIV] = {"Operator 'Divide'", 5},
+	[erw_TOKENTYPE_OPERATOR_MOD] = {"Operator 'Modulo'", 5},
+	[erw_TOKENTYPE_OPERATOR_POW] = {"Operator 'Exponentiate'", 7},
+	[erw_TOKENTYPE_OPERATOR_RETURN] = {"Operator 'Return'", 0},
+	[erw_TOKENTYPE_OPERATOR_EQUAL] = {"Operator 'Equal'", 2},
+	[erw_TOKENTYPE_OPERATOR_NOT] = {"Operator 'Not'", 0},
+	[erw_TOKENTYPE_OPERATOR_NOTEQUAL] = {"Operator 'Not Equal'", 2},
+	[erw_TOKENTYPE_OPERATOR_LESS] = {"Operator 'Less Than'", 3},
+	[erw_TOKENTYPE_OPERATOR_GREATER] = {"Operator 'Greater Than'", 3},
+	[erw_TOKENTYPE_OPERATOR_LESSOREQUAL] =
+		{"Operator 'Less Than or Equal'", 3},
+	[erw_TOKENTYPE_OPERATOR_GREATEROREQUAL] =
+		{"Operator 'Greater Than or Equal'", 3},
+	[erw_TOKENTYPE_OPERATOR_AND] = {"Operator 'Logical And'", 1},
+	[erw_TOKENTYPE_OPERATOR_OR] = {"Operator 'Logical Or'", 1},
+	[erw_TOKENTYPE_OPERATOR_ASSIGN] = {"Operator 'Assign'", 0},
+	[erw_TOKENTYPE_OPERATOR_ADDASSIGN] = {"Operator 'Add and Assign'", 0},
+	[erw_TOKENTYPE_OPERATOR_SUBASSIGN] = {"Operator 'Subtract and Assign'", 0},
+	[erw_TOKENTYPE_OPERATOR_MULASSIGN] = {"Operator 'Multiply and Assign'", 0},
+	[erw_TOKENTYPE_OPERATOR_DIVASSIGN] = {"Operator 'Divide and Assign'", 0},
+	[erw_TOKENTYPE_OPERATOR_MODASSIGN] = {"Operator 'Modulo and Assign'", 0},
+	[erw_TOKENTYPE_OPERATOR_POWASSIGN] =
+		{"Operator 'Exponentiate and assign'", 0},
+	[erw_TOKENTYPE_OPERATOR_BITOR] = {"Operator 'Bitwise Or'", 0},
+	[erw_TOKENTYPE_OPERATOR_BITAND] = {"Operator 'Bitwise And'", 0},
+	[erw_TOKENTYPE_OPERATOR_ACCESS] = {"Operator 'Access'", 0},
+	[erw_TOKENTYPE_LITERAL_INT] = {"Literal Int", 0},
+	[erw_TOKENTYPE_LITERAL_FLOAT] = {"Literal Float", 0},
+	[erw_TOKENTYPE_LITERAL_STRING] = {"Literal String", 0},
+	[erw_TOKENTYPE_LITERAL_CHAR] = {"Literal Char", 0},
+	[erw_TOKENTYPE_LITERAL_BOOL] = {"Literal Bool", 0},
+	[erw_TOKENTYPE_IDENT] = {"Identifier", 0},
+	[erw_TOKENTYPE_TYPE] = {"Type", 0},
+	[erw_TOKENTYPE_END] = {"End", 0},
+	[erw_TOKENTYPE_COMMA] = {"Comma", 0},
+	[erw_TOKENTYPE_LPAREN] = {"Left Parenthesis", 0},
+	[erw_TOKENTYPE_RPAREN] = {"Right Parenthesis", 0},
+	[erw_TOKENTYPE_LCURLY] = {"Left Curly Bracket", 0},
+	[erw_TOKENTYPE_RCURLY] = {"Right Curly Bracket", 0},
+	[erw_TOKENTYPE_LBRACKET] = {"Left Bracket", 0},
+	[erw_TOKENTYPE_RBRACKET] = {"Right Bracket", 0},
+	[erw_TOKENTYPE_FOREIGN] = {"Foreign function call", 0},
+};
+
+_Static_assert(
+	erw_TOKENTYPE_COUNT <= UINT8_MAX + 1,
+	"Token types have to fit in a byte"
+);
+
+//Perfect hash of all keywords, see erw_getkeyword. Empty slots have len 0
+#define erw_KEYWORDHASH(text, len) \
+	(((text)[0] + (text)[1] + 2 * (text)[(len) - 1] + (len)) & 31)
+static const struct
+{
+	const char* name;
+	size_t len;
+	enum erw_TokenType type;
+} erw_keywords[32] = {
+	[3] = {"elseif", sizeof("elseif") - 1, erw_TOKENTYPE_KEYWORD_ELSEIF},
+	[4] = {"union", sizeof("union") - 1, erw_TOKENTYPE_KEYWORD_UNION},
+	[5] = {"func", sizeof("func") - 1, erw_TOKENTYPE_KEYWORD_FUNC},
+	[7] = {"or", sizeof("or") - 1, erw_TOKENTYPE_OPERATOR_OR},
+	[10] = {"array", sizeof("array") - 1, erw_TOKENTYPE_KEYWORD_ARRAY},
+	[13] = {"mut", sizeof("mut") - 1, erw_TOKENTYPE_KEYWORD_MUT},
+	[14] = {"while", sizeof("while") - 1, erw_TOKENTYPE_KEYWORD_WHILE},
+	[16] = {"cast", sizeof("cast") - 1, erw_TOKENTYPE_KEYWORD_CAST},
+	[17] = {"enum", sizeof("enum") - 1, erw_TOKENTYPE_KEYWORD_ENUM},
+	[18] = {"defer", sizeof("defer") - 1, erw_TOKENTYPE_KEYWORD_DEFER},
+	[19] = {"unsafe", sizeof("unsafe") - 1, erw_TOKENTYPE_KEYWORD_UNSAFE},
+	[20] = {"true", sizeof("true") - 1, erw_TOKENTYPE_LITERAL_BOOL},
+	[21] = {"struct", sizeof("struct") - 1, erw_TOKENTYPE_KEYWORD_STRUCT},
+	[22] = {"false", sizeof("false") - 1, erw_TOKENTYPE_LITERAL_BOOL},
+	[25] = {"return", sizeof("return") - 1, erw_TOKENTYPE_KEYWORD_RETURN},
+	[26] = {"and", sizeof("and") - 1, erw_TOKENTYPE_OPERATOR_AND},
+	[27] = {"type", sizeof("type") - 1, erw_TOKENTYPE_KEYWORD_TYPE},
+	[28] = {"let", sizeof("let") - 1, erw_TOKENTYPE_KEYWORD_LET},
+	[29] = {"if", sizeof("if") - 1, erw_TOKENTYPE_KEYWORD_IF},
+	[31] = {"else", sizeof("else") - 1, erw_TOKENTYPE_KEYWORD_ELSE},
+};
+
+//Returns erw_TOKENTYPE_IDENT if text is not a keyword. NOTE: erw_KEYWORDHASH 
+//and the table above have to be updated together when adding a keyword
+static enum erw_TokenType erw_getkeyword(const char* text, size_t len)
+{
+	if(len < 2 || len > sizeof("elseif") - 1)
+	{
+		return erw_TOKENTYPE_IDENT;
+	}
+
+	size_t hash = erw_KEYWORDHASH(text, len);
+	if(erw_keywords[hash].len == len && 
+		!memcmp(erw_keywords[hash].name, text, len))
+	{
+		return erw_keywords[hash].type;
+	}
+
+	return erw_TOKENTYPE_IDENT;
+}
+
+//NOTE: The vectorized scans below only do aligned loads. They may read past 
+//the terminating '\0', but never into a page that isn't mapped. This is
+//fine, but AddressSanitizer doesn't know that
+
+//Returns the position of the first character at or after pos that is not a 
+//blank (' ' or '\t')
+erw_NOSANITIZE static size_t erw_skipblanks(const char* source, size_t pos)
+{
+#ifdef erw_VECSIZE
+	const char* chunk = source + pos - (uintptr_t)(source + pos) % erw_VECSIZE;
+	uint32_t valid = (erw_VECMASK << (source + pos - chunk)) & erw_VECMASK;
+	while(1)
+	{
+		erw_Vec v = erw_vecload(chunk);
+		uint32_t found = ~(erw_vecmatch(v, ' ') | erw_vecmatch(v, '\t')) 
+			& valid;
+		if(found)
+		{
+			return (size_t)(chunk - source) + __builtin_ctz(found);
+		}
+
+		chunk += erw_VECSIZE;
+		valid = erw_VECMASK;
+	}
+#else
+	while(source[pos] == ' ' || source[pos] == '\t')
+	{
+		pos++;
+	}
+
+	return pos;
+#endif
+}
+
+//Returns the position of the first c1, c2 or '\0' at or after pos
+erw_NOSANITIZE static size_t erw_findchar(
+	const char* source, 
+	size_t pos, 
+	char c1, 
+	char c2)
+{
+#ifdef erw_VECSIZE
+	const char* chunk = source + pos - (uintptr_t)(source + pos) % erw_VECSIZE;
+	uint32_t valid = (erw_VECMASK << (source + pos - chunk)) & erw_VECMASK;
+	while(1)
+	{
+		erw_Vec v = erw_vecload(chunk);
+		uint32_t found = (erw_vecmatch(v, c1) | erw_vecmatch(v, c2) 
+			| erw_vecmatch(v, '\0')) & valid;
+		if(found)
+		{
+			return (size_t)(chunk - source) + __builtin_ctz(found);
+		}
+
+		chunk += erw_VECSIZE;
+		valid = erw_VECMASK;
+	}
+#else
+	while(source[pos] != c1 && source[pos] != c2 && source[pos] != '\0')
+	{
+		pos++;
+	}
+
+	return pos;
+#endif
+}
+
+//Identifiers and type names are interned, so that names can be compared by 
+//pointer in later stages
+static int erw_token_isatom(const struct erw_Token* token)
+{
+	return token->type == erw_TOKENTYPE_IDENT || 
+		token->type == erw_TOKENTYPE_TYPE ||
+		token->type == erw_TOKENTYPE_FOREIGN;
+}
+
+//Decodes the digits of an int literal
+static uint64_t erw_decodeint(const char* text, size_t len, uint8_t* flags)
+{
+	uint64_t ret = 0;
+	for(size_t i = 0; i < len; i++)
+	{
+		if(__builtin_mul_overflow(ret, 10, &ret) 
+			|| __builtin_add_overflow(ret, (uint64_t)(text[i] - '0'), &ret))
+		{
+			*flags |= erw_TOKENFLAG_INTOVERFLOW | erw_TOKENFLAG_UINTOVERFLOW;
+			return UINT64_MAX;
+		}
+	}
+
+	if(ret > INT64_MAX)
+	{
+		*flags |= erw_TOKENFLAG_INTOVERFLOW;
+	}
+
+	return ret;
+}
+
+//Powers of ten that doubles hold exactly
+static const double erw_exactpowersoften[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+//Decodes a float literal ('<digits>.<digits>'), correctly rounded. If the 
+//digits without the point fit in 53 bits and there are at most 22 decimals,
+//both they and the power of ten are exact doubles and one division rounds 
+//correctly (Clinger's fast path). Other literals are left to strtod.
+static double erw_decodefloat(const char* text, size_t len, uint8_t* flags)
+{
+	//Trailing zeros don't change the value, but would count as decimals
+	size_t end = len;
+	while(end && text[end - 1] == '0')
+	{
+		end--;
+	}
+
+	uint64_t mantissa = 0;
+	size_t numdigits = 0; //Not counting leading zeros
+	size_t numdecimals = 0;
+	int isdecimal = 0;
+	for(size_t i = 0; i < end; i++)
+	{
+		if(text[i] == '.')
+		{
+			isdecimal = 1;
+			continue;
+		}
+
+		numdecimals += isdecimal;
+		if(mantissa || text[i] != '0')
+		{
+			numdigits++;
+		}
+
+		if(numdigits <= 19)
+		{
+			mantissa = mantissa * 10 + (uint64_t)(text[i] - '0');
+		}
+	}
+
+	if(numdigits <= 19 
+		&& mantissa <= (UINT64_C(1) << 53) 
+		&& numdecimals <= 22)
+	{
+		return (double)mantissa / erw_exactpowersoften[numdecimals];
+	}
+
+	//The text isn't NUL-terminated, and strtod could read on into an 
+	//exponent that belongs to the next token
+	char buffer[64];
+	char* str = len < sizeof(buffer) ? buffer : malloc(len + 1);
+	if(!str)
+	{
+		log_error("malloc failed <%s>", __func__);
+	}
+
+	memcpy(str, text, len);
+	str[len] = '\0';
+	double ret = strtod(str, NULL);
+	if(str != buffer)
+	{
+		free(str);
+	}
+
+	if(isinf(ret))
+	{
+		*flags |= erw_TOKENFLAG_FLOATOVERFLOW;
+	}
+
+	return ret;
+}
+
+//Returns 0 if the token has no value
+static int erw_token_decode(
+	const struct erw_Token* token, 
+	struct erw_Literal* literal)
+{
+	switch(token->type)
+	{
+	case erw_TOKENTYPE_LITERAL_INT:
+		literal->value.uint = erw_decodeint(
+			token->text, 
+			token->len, 
+			&literal->flags
+		);
+		break;
+	case erw_TOKENTYPE_LITERAL_FLOAT:
+		literal->value.float_ = erw_decodefloat(
+			token->text, 
+			token->len, 
+			&literal->flags
+		);
+		break;
+	case erw_TOKENTYPE_LITERAL_CHAR:
+		literal->value.uint = (unsigned char)token->text[1];
+		break;
+	case erw_TOKENTYPE_LITERAL_BOOL:
+		literal->value.uint = token->len == sizeof("true") - 1;
+		break;
+	default:
+		return 0;
+	}
+
+	return 1;
+}
+
+static void erw_tokenstream_push(
+	struct erw_TokenStream* self, 
+	const struct erw_Token* token)
+{
+	if(self->numtokens == self->capacity)
+	{
+		self->capacity = self->capacity ? self->capacity * 2 : 1024;
+		self->types = realloc(self->types, self->capacity * sizeof(uint8_t));
+		self->offsets = realloc(
+			self->offsets, 
+			self->capacity * sizeof(uint32_t)
+		);
+		self->lens = realloc(self->lens, self->capacity * sizeof(uint32_t));
+		self->linenums = realloc(
+			self->linenums, 
+			self->capacity * sizeof(uint32_t)
+		);
+		self->columns = realloc(
+			self->columns, 
+			self->capacity * sizeof(uint32_t)
+		);
+		self->atoms = realloc(
+			self->atoms, 
+			self->capacity * sizeof(const char*)
+		);
+		if(!self->types 
+			|| !self->offsets 
+			|| !self->lens 
+			|| !self->linenums 
+			|| !self->columns
+			|| !self->atoms)
+		{
+			log_error("realloc failed, in <%s>", __func__);
+		}
+	}
+
+	size_t offset = (size_t)(token->text - self->source);
+	if(offset + token->len > UINT32_MAX)
+	{
+		log_error("Source files have to be smaller than 4 GiB");
+	}
+
+	size_t index = self->numtokens++;
+	self->types[index] = (uint8_t)token->type;
+	self->offsets[index] = offset;
+	self->lens[index] = token->len;
+	self->linenums[index] = token->linenum;
+	self->columns[index] = token->column;
+	self->atoms[index] = erw_token_isatom(token) 
+		? erw_intern(token->text, token->len) 
+		: NULL;
+}
+
+//For the last pushed token
+static void erw_tokenstream_pushliteral(
+	struct erw_TokenStream* self, 
+	const struct erw_Literal* literal)
+{
+	if(self->numliterals == self->literalcapacity)
+	{
+		self->literalcapacity = self->literalcapacity 
+			? self->literalcapacity * 2 
+			: 256;
+		self->literaltokens = realloc(
+			self->literaltokens, 
+			self->literalcapacity * sizeof(uint32_t)
+		);
+		self->values = realloc(
+			self->values, 
+			self->literalcapacity * sizeof(union erw_TokenValue)
+		);
+		self->flags = realloc(
+			self->flags, 
+			self->literalcapacity * sizeof(uint8_t)
+		);
+		if(!self->literaltokens || !self->values || !self->flags)
+		{
+			log_error("realloc failed, in <%s>", __func__);
+		}
+	}
+
+	size_t index = self->numliterals++;
+	self->literaltokens[index] = self->numtokens - 1;
+	self->values[index] = literal->value;
+	self->flags[index] = literal->flags;
+}
+
+struct erw_TokenStream erw_tokenize(
+	const char* source, 
+	struct erw_Lines* lines)
 {
 	log_assert(lines, "is NULL");
 
-	Vec(struct erw_Token) tokens = vec_ctor(struct erw_Token, 0);
+	struct erw_TokenStream tokens = {.source = source};
 
 	size_t pos = 0;
 	size_t line = 1;
@@ -157,8 +481,9 @@ Vec(struct erw_Token) erw_tokenize(const char* source, Vec(struct Str) lines)
 	{
 		if(isblank(source[pos]))
 		{
-			column++;
-			pos++;
+			size_t next = erw_skipblanks(source, pos);
+			column += next - pos;
+			pos = next;
 			continue;
 		}
 		else if(source[pos] == '\n')
@@ -177,6 +502,11 @@ Vec(struct erw_Token) erw_tokenize(const char* source, Vec(struct Str) lines)
 				size_t nested = 0;
 				do {
 					pos++;
+
+					//Everything up to the next '#' or newline is skipped
+					size_t next = erw_findchar(source, pos, '#', '\n');
+					column += next - pos;
+					pos = next;
 					if(source[pos] == '#')
 					{
 						if(source[pos + 1] == '[')
@@ -220,7 +550,7 @@ Vec(struct erw_Token) erw_tokenize(const char* source, Vec(struct Str) lines)
 
 					erw_error(
 						msg.data,
-						lines[startline - 1].data,
+						erw_lines_get(lines, startline),
 						startline,
 						startcolumn - 1,
 						column + 1
@@ -238,7 +568,7 @@ Vec(struct erw_Token) erw_tokenize(const char* source, Vec(struct Str) lines)
 
 				erw_error(
 					msg.data,
-					lines[line - 1].data,
+					erw_lines_get(lines, line),
 					line,
 					column,
 					column + 1
@@ -247,22 +577,16 @@ Vec(struct erw_Token) erw_tokenize(const char* source, Vec(struct Str) lines)
 			}
 			else //Single line comment
 			{
-				do {
-					column++;
-					pos++;
-				}
-				while(
-					source[pos] != '\n' &&
-					//source[pos] != ';' &&
-					source[pos] != '\0'
-				);
+				size_t next = erw_findchar(source, pos + 1, '\n', '\n');
+				column += next - pos;
+				pos = next;
 			}
 
 			continue;
 		}
 
 		struct erw_Token token = {
-			.text = vec_ctor(char, 0),
+			.text = source + pos,
 			.linenum = line,
 			.column = column
 		};
@@ -271,7 +595,6 @@ Vec(struct erw_Token) erw_tokenize(const char* source, Vec(struct Str) lines)
 		{
 			do {
 				column++;
-				vec_pushback(token.text, source[pos]);
 				pos++;
 			}
 			while(isalnum(source[pos]) || source[pos] == '_');
@@ -281,121 +604,17 @@ Vec(struct erw_Token) erw_tokenize(const char* source, Vec(struct Str) lines)
 		{
 			do {
 				column++;
-				vec_pushback(token.text, source[pos]);
 				pos++;
 			}
 			while(isalnum(source[pos]) || source[pos] == '_');
 
-			if(sizeof("let") - 1 == vec_getsize(token.text) &&
-				!memcmp("let", token.text, sizeof("let") - 1))
-			{
-				token.type = erw_TOKENTYPE_KEYWORD_LET;
-			}
-			else if(sizeof("mut") - 1 == vec_getsize(token.text) &&
-				!memcmp("mut", token.text, sizeof("mut") - 1))
-			{
-				token.type = erw_TOKENTYPE_KEYWORD_MUT;
-			}
-			else if(sizeof("func") - 1 == vec_getsize(token.text) &&
-				!memcmp("func", token.text, sizeof("func") - 1))
-			{
-				token.type = erw_TOKENTYPE_KEYWORD_FUNC;
-			}
-			else if(sizeof("type") - 1 == vec_getsize(token.text) &&
-				!memcmp("type", token.text, sizeof("type") - 1))
-			{
-				token.type = erw_TOKENTYPE_KEYWORD_TYPE;
-			}
-			else if(sizeof("return") - 1 == vec_getsize(token.text) &&
-				!memcmp("return", token.text, sizeof("return") - 1))
-			{
-				token.type = erw_TOKENTYPE_KEYWORD_RETURN;
-			}
-			else if(sizeof("if") - 1 == vec_getsize(token.text) &&
-				!memcmp("if", token.text, sizeof("if") - 1))
-			{
-				token.type = erw_TOKENTYPE_KEYWORD_IF;
-			}
-			else if(sizeof("elseif") - 1 == vec_getsize(token.text) &&
-				!memcmp("elseif", token.text, sizeof("elseif") - 1))
-			{
-				token.type = erw_TOKENTYPE_KEYWORD_ELSEIF;
-			}
-			else if(sizeof("else") - 1 == vec_getsize(token.text) &&
-				!memcmp("else", token.text, sizeof("else") - 1))
-			{
-				token.type = erw_TOKENTYPE_KEYWORD_ELSE;
-			}
-			else if(sizeof("cast") - 1 == vec_getsize(token.text) &&
-				!memcmp("cast", token.text, sizeof("cast") - 1))
-			{
-				token.type = erw_TOKENTYPE_KEYWORD_CAST;
-			}
-			else if(sizeof("defer") - 1 == vec_getsize(token.text) &&
-				!memcmp("defer", token.text, sizeof("defer") - 1))
-			{
-				token.type = erw_TOKENTYPE_KEYWORD_DEFER;
-			}
-			else if(sizeof("while") - 1 == vec_getsize(token.text) &&
-				!memcmp("while", token.text, sizeof("while") - 1))
-			{
-				token.type = erw_TOKENTYPE_KEYWORD_WHILE;
-			}
-			else if(sizeof("struct") - 1 == vec_getsize(token.text) &&
-				!memcmp("struct", token.text, sizeof("struct") - 1))
-			{
-				token.type = erw_TOKENTYPE_KEYWORD_STRUCT;
-			}
-			else if(sizeof("union") - 1 == vec_getsize(token.text) &&
-				!memcmp("union", token.text, sizeof("union") - 1))
-			{
-				token.type = erw_TOKENTYPE_KEYWORD_UNION;
-			}
-			else if(sizeof("enum") - 1 == vec_getsize(token.text) &&
-				!memcmp("enum", token.text, sizeof("enum") - 1))
-			{
-				token.type = erw_TOKENTYPE_KEYWORD_ENUM;
-			}
-			else if(sizeof("array") - 1 == vec_getsize(token.text) &&
-				!memcmp("array", token.text, sizeof("array") - 1))
-			{
-				token.type = erw_TOKENTYPE_KEYWORD_ARRAY;
-			}
-			else if(sizeof("unsafe") - 1 == vec_getsize(token.text) &&
-				!memcmp("unsafe", token.text, sizeof("unsafe") - 1))
-			{
-				token.type = erw_TOKENTYPE_KEYWORD_UNSAFE;
-			}
-			else if(sizeof("and") - 1 == vec_getsize(token.text) &&
-				!memcmp("and", token.text, sizeof("and") - 1))
-			{
-				token.type = erw_TOKENTYPE_OPERATOR_AND;
-			}
-			else if(sizeof("or") - 1 == vec_getsize(token.text) &&
-				!memcmp("or", token.text, sizeof("or") - 1))
-			{
-				token.type = erw_TOKENTYPE_OPERATOR_OR;
-			}
-			else if(sizeof("true") - 1 == vec_getsize(token.text) &&
-				!memcmp("true", token.text, sizeof("true") - 1))
-			{
-				token.type = erw_TOKENTYPE_LITERAL_BOOL;
-			}
-			else if(sizeof("false") - 1 == vec_getsize(token.text) &&
-				!memcmp("false", token.text, sizeof("false") - 1))
-			{
-				token.type = erw_TOKENTYPE_LITERAL_BOOL;
-			}
-			else
-			{
-				token.type = erw_TOKENTYPE_IDENT;
-			}
+			token.len = (size_t)(source + pos - token.text);
+			token.type = erw_getkeyword(token.text, token.len);
 		}
 		else if(isdigit(source[pos]))
 		{
 			do {
 				column++;
-				vec_pushback(token.text, source[pos]);
 				pos++;
 			}
 			while(isdigit(source[pos]));
@@ -404,7 +623,6 @@ Vec(struct erw_Token) erw_tokenize(const char* source, Vec(struct Str) lines)
 			{
 				do {
 					column++;
-					vec_pushback(token.text, source[pos]);
 					pos++;
 				}
 				while(isdigit(source[pos]));
@@ -440,7 +658,6 @@ Vec(struct erw_Token) erw_tokenize(const char* source, Vec(struct Str) lines)
 				{
 					token.type = erw_TOKENTYPE_OPERATOR_ADDASSIGN;
 					column++;
-					vec_pushback(token.text, source[pos]);
 					pos++;
 				}
 				else
@@ -454,14 +671,12 @@ Vec(struct erw_Token) erw_tokenize(const char* source, Vec(struct Str) lines)
 				{
 					token.type = erw_TOKENTYPE_OPERATOR_SUBASSIGN;
 					column++;
-					vec_pushback(token.text, source[pos]);
 					pos++;
 				}
 				else if(source[pos + 1] == '>')
 				{
 					token.type = erw_TOKENTYPE_OPERATOR_RETURN;
 					column++;
-					vec_pushback(token.text, source[pos]);
 					pos++;
 				}
 				else
@@ -475,7 +690,6 @@ Vec(struct erw_Token) erw_tokenize(const char* source, Vec(struct Str) lines)
 				{
 					token.type = erw_TOKENTYPE_OPERATOR_MULASSIGN;
 					column++;
-					vec_pushback(token.text, source[pos]);
 					pos++;
 				}
 				else
@@ -489,7 +703,6 @@ Vec(struct erw_Token) erw_tokenize(const char* source, Vec(struct Str) lines)
 				{
 					token.type = erw_TOKENTYPE_OPERATOR_DIVASSIGN;
 					column++;
-					vec_pushback(token.text, source[pos]);
 					pos++;
 				}
 				else
@@ -503,7 +716,6 @@ Vec(struct erw_Token) erw_tokenize(const char* source, Vec(struct Str) lines)
 				{
 					token.type = erw_TOKENTYPE_OPERATOR_MODASSIGN;
 					column++;
-					vec_pushback(token.text, source[pos]);
 					pos++;
 				}
 				else
@@ -517,7 +729,6 @@ Vec(struct erw_Token) erw_tokenize(const char* source, Vec(struct Str) lines)
 				{
 					token.type = erw_TOKENTYPE_OPERATOR_POWASSIGN;
 					column++;
-					vec_pushback(token.text, source[pos]);
 					pos++;
 				}
 				else
@@ -531,7 +742,6 @@ Vec(struct erw_Token) erw_tokenize(const char* source, Vec(struct Str) lines)
 				{
 					token.type = erw_TOKENTYPE_OPERATOR_EQUAL;
 					column++;
-					vec_pushback(token.text, source[pos]);
 					pos++;
 				}
 				else
@@ -545,7 +755,6 @@ Vec(struct erw_Token) erw_tokenize(const char* source, Vec(struct Str) lines)
 				{
 					token.type = erw_TOKENTYPE_OPERATOR_NOTEQUAL;
 					column++;
-					vec_pushback(token.text, source[pos]);
 					pos++;
 				}
 				else
@@ -559,7 +768,6 @@ Vec(struct erw_Token) erw_tokenize(const char* source, Vec(struct Str) lines)
 				{
 					token.type = erw_TOKENTYPE_OPERATOR_LESSOREQUAL;
 					column++;
-					vec_pushback(token.text, source[pos]);
 					pos++;
 				}
 				else
@@ -573,7 +781,6 @@ Vec(struct erw_Token) erw_tokenize(const char* source, Vec(struct Str) lines)
 				{
 					token.type = erw_TOKENTYPE_OPERATOR_GREATEROREQUAL;
 					column++;
-					vec_pushback(token.text, source[pos]);
 					pos++;
 				}
 				else
@@ -587,7 +794,6 @@ Vec(struct erw_Token) erw_tokenize(const char* source, Vec(struct Str) lines)
 				{
 					token.type = erw_TOKENTYPE_OPERATOR_AND;
 					column++;
-					vec_pushback(token.text, source[pos]);
 					pos++;
 				}
 				else*/
@@ -601,7 +807,6 @@ Vec(struct erw_Token) erw_tokenize(const char* source, Vec(struct Str) lines)
 				{
 					token.type = erw_TOKENTYPE_OPERATOR_OR;
 					column++;
-					vec_pushback(token.text, source[pos]);
 					pos++;
 				}
 				else*/
@@ -639,7 +844,6 @@ Vec(struct erw_Token) erw_tokenize(const char* source, Vec(struct Str) lines)
 				size_t startcolumn = column;
 				do {
 					column++;
-					vec_pushback(token.text, source[pos]);
 					pos++;
 				}
 				while(
@@ -659,7 +863,7 @@ Vec(struct erw_Token) erw_tokenize(const char* source, Vec(struct Str) lines)
 
 					erw_error(
 						msg.data,
-						lines[line - 1].data,
+						erw_lines_get(lines, line),
 						line,
 						startcolumn,
 						column
@@ -673,7 +877,6 @@ Vec(struct erw_Token) erw_tokenize(const char* source, Vec(struct Str) lines)
 				size_t startcolumn = column;
 				do {
 					column++;
-					vec_pushback(token.text, source[pos]);
 					pos++;
 				}
 				while(
@@ -684,18 +887,18 @@ Vec(struct erw_Token) erw_tokenize(const char* source, Vec(struct Str) lines)
 				token.type = erw_TOKENTYPE_LITERAL_CHAR;
 
 				if(source[pos] != '\'' ||
-					vec_getsize(token.text) != 2)
+					source + pos - token.text != 2)
 				{
 					struct Str msg;
 					str_ctorfmt(
 						&msg,
 						"Invalid %s (expected '<single letter>')",
-						erw_TOKENTYPE_LITERAL_CHAR->name
+						erw_tokentypeinfos[erw_TOKENTYPE_LITERAL_CHAR].name
 					);
 
 					erw_error(
 						msg.data,
-						lines[line - 1].data,
+						erw_lines_get(lines, line),
 						line,
 						startcolumn,
 						column
@@ -708,11 +911,11 @@ Vec(struct erw_Token) erw_tokenize(const char* source, Vec(struct Str) lines)
 				column++;
 				pos++;
 
+				token.text = source + pos; //Skip '@'
 				if(islower(source[pos]))
 				{
 					do {
 						column++;
-						vec_pushback(token.text, source[pos]);
 						pos++;
 					}
 					while(isalnum(source[pos]) || source[pos] == '_');
@@ -728,7 +931,7 @@ Vec(struct erw_Token) erw_tokenize(const char* source, Vec(struct Str) lines)
 
 					erw_error(
 						msg.data,
-						lines[line - 1].data,
+						erw_lines_get(lines, line),
 						line,
 						column - 1,
 						column - 1
@@ -737,7 +940,7 @@ Vec(struct erw_Token) erw_tokenize(const char* source, Vec(struct Str) lines)
 				}
 
 				token.type = erw_TOKENTYPE_FOREIGN;
-				goto done; //XXX skip vec_pushback in the end
+				goto done; //XXX skip the last character in the end
 
 			default:;
 				struct Str msg;
@@ -749,7 +952,7 @@ Vec(struct erw_Token) erw_tokenize(const char* source, Vec(struct Str) lines)
 
 				erw_error(
 					msg.data,
-					lines[line - 1].data,
+					erw_lines_get(lines, line),
 					line,
 					column,
 					column
@@ -757,27 +960,111 @@ Vec(struct erw_Token) erw_tokenize(const char* source, Vec(struct Str) lines)
 				str_dtor(&msg);
 			}
 
-			vec_pushback(token.text, source[pos]);
 			column++;
 			pos++;
 		}
 
 	done: //XXX
-		vec_pushback(token.text, '\0');
-		vec_pushback(tokens, token);
+		token.len = (size_t)(source + pos - token.text);
+		erw_tokenstream_push(&tokens, &token);
+		struct erw_Literal literal = {0};
+		if(erw_token_decode(&token, &literal))
+		{
+			erw_tokenstream_pushliteral(&tokens, &literal);
+		}
 	}
 
 	return tokens;
 }
 
-void erw_tokens_delete(Vec(struct erw_Token) tokens)
+struct erw_Token erw_tokenstream_get(
+	const struct erw_TokenStream* self, 
+	size_t index)
+{
+	log_assert(self, "is NULL");
+	log_assert(
+		index < self->numtokens, 
+		"out of bounds (%zu, %zu)", 
+		index, 
+		self->numtokens
+	);
+
+	struct erw_Token token = {
+		.text = self->source + self->offsets[index],
+		.len = self->lens[index],
+		.str = self->atoms[index],
+		.type = self->types[index],
+		.linenum = self->linenums[index],
+		.column = self->columns[index]
+	};
+	return token;
+}
+
+struct erw_Literal erw_tokenstream_getliteral(
+	const struct erw_TokenStream* self, 
+	size_t index)
 {
-	log_assert(tokens, "is NULL");
-	for(size_t i = 0; i < vec_getsize(tokens); i++)
+	log_assert(self, "is NULL");
+
+	//Binary search, literals are pushed in token order
+	size_t low = 0;
+	size_t high = self->numliterals;
+	while(low < high)
 	{
-		vec_dtor(tokens[i].text);
+		size_t mid = low + (high - low) / 2;
+		if(self->literaltokens[mid] < index)
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid;
+		}
 	}
 
-	vec_dtor(tokens);
+	log_assert(
+		low < self->numliterals && self->literaltokens[low] == index, 
+		"not a literal (%zu)", 
+		index
+	);
+	struct erw_Literal ret = {
+		.value = self->values[low],
+		.flags = self->flags[low]
+	};
+	return ret;
 }
 
+void erw_tokenstream_dtor(struct erw_TokenStream* self)
+{
+	log_assert(self, "is NULL");
+	free(self->types);
+	free(self->offsets);
+	free(self->lens);
+	free(self->linenums);
+	free(self->columns);
+	free(self->atoms);
+	free(self->literaltokens);
+	free(self->values);
+	free(self->flags);
+}
+
+//Strings of other tokens are interned as well, so tokens copied out of a 
+//stream don't own anything
+const char* erw_token_getstr(struct erw_Token* self)
+{
+	log_assert(self, "is NULL");
+	if(!self->str)
+	{
+		self->str = erw_intern(self->text, self->len);
+	}
+
+	return self->str;
+}
+
+int erw_token_equals(const struct erw_Token* self, const char* str)
+{
+	log_assert(self, "is NULL");
+	log_assert(str, "is NULL");
+
+	return !strncmp(self->text, str, self->len) && str[self->len] == '\0';
+}
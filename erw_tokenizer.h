@@ -20,83 +20,166 @@
 #ifndef ERW_TOKENIZER_H
 #define ERW_TOKENIZER_H
 
+#include "erw_error.h"
 #include "str.h"
 #include "vec.h"
 
-struct erw_TokenType
+#include <stdint.h>
+
+enum erw_TokenType
+{
+	erw_TOKENTYPE_KEYWORD_RETURN,
+	erw_TOKENTYPE_KEYWORD_FUNC,
+	erw_TOKENTYPE_KEYWORD_LET,
+	erw_TOKENTYPE_KEYWORD_MUT,
+	erw_TOKENTYPE_KEYWORD_TYPE,
+	erw_TOKENTYPE_KEYWORD_IF,
+	erw_TOKENTYPE_KEYWORD_ELSEIF,
+	erw_TOKENTYPE_KEYWORD_ELSE,
+	erw_TOKENTYPE_KEYWORD_CAST,
+	erw_TOKENTYPE_KEYWORD_DEFER,
+	erw_TOKENTYPE_KEYWORD_WHILE,
+	erw_TOKENTYPE_KEYWORD_STRUCT,
+	erw_TOKENTYPE_KEYWORD_UNION,
+	erw_TOKENTYPE_KEYWORD_ENUM,
+	erw_TOKENTYPE_KEYWORD_ARRAY,
+	erw_TOKENTYPE_KEYWORD_UNSAFE,
+	erw_TOKENTYPE_OPERATOR_DECLR,
+	erw_TOKENTYPE_OPERATOR_ADD,
+	erw_TOKENTYPE_OPERATOR_SUB,
+	erw_TOKENTYPE_OPERATOR_MUL,
+	erw_TOKENTYPE_OPERATOR_DIV,
+	erw_TOKENTYPE_OPERATOR_MOD,
+	erw_TOKENTYPE_OPERATOR_POW,
+	erw_TOKENTYPE_OPERATOR_RETURN,
+	erw_TOKENTYPE_OPERATOR_EQUAL,
+	erw_TOKENTYPE_OPERATOR_NOT,
+	erw_TOKENTYPE_OPERATOR_NOTEQUAL,
+	erw_TOKENTYPE_OPERATOR_LESS,
+	erw_TOKENTYPE_OPERATOR_GREATER,
+	erw_TOKENTYPE_OPERATOR_LESSOREQUAL,
+	erw_TOKENTYPE_OPERATOR_GREATEROREQUAL,
+	erw_TOKENTYPE_OPERATOR_AND,
+	erw_TOKENTYPE_OPERATOR_OR,
+	erw_TOKENTYPE_OPERATOR_ASSIGN,
+	erw_TOKENTYPE_OPERATOR_ADDASSIGN,
+	erw_TOKENTYPE_OPERATOR_SUBASSIGN,
+	erw_TOKENTYPE_OPERATOR_MULASSIGN,
+	erw_TOKENTYPE_OPERATOR_DIVASSIGN,
+	erw_TOKENTYPE_OPERATOR_MODASSIGN,
+	erw_TOKENTYPE_OPERATOR_POWASSIGN,
+	erw_TOKENTYPE_OPERATOR_BITOR,
+	erw_TOKENTYPE_OPERATOR_BITAND,
+	erw_TOKENTYPE_OPERATOR_ACCESS,
+	erw_TOKENTYPE_LITERAL_INT,
+	erw_TOKENTYPE_LITERAL_FLOAT,
+	erw_TOKENTYPE_LITERAL_STRING,
+	erw_TOKENTYPE_LITERAL_CHAR,
+	erw_TOKENTYPE_LITERAL_BOOL,
+	erw_TOKENTYPE_IDENT,
+	erw_TOKENTYPE_TYPE,
+	erw_TOKENTYPE_END,
+	erw_TOKENTYPE_COMMA,
+	erw_TOKENTYPE_LPAREN,
+	erw_TOKENTYPE_RPAREN,
+	erw_TOKENTYPE_LCURLY,
+	erw_TOKENTYPE_RCURLY,
+	erw_TOKENTYPE_LBRACKET,
+	erw_TOKENTYPE_RBRACKET,
+	erw_TOKENTYPE_FOREIGN, //?
+	erw_TOKENTYPE_COUNT,
+};
+
+struct erw_TokenTypeInfo
 {
 	const char* name;
+	//Of binary operators, higher binds tighter. 0 for other tokens.
+	int precedence;
 };
 
-extern const struct erw_TokenType* const erw_TOKENTYPE_KEYWORD_RETURN;
-extern const struct erw_TokenType* const erw_TOKENTYPE_KEYWORD_FUNC;
-extern const struct erw_TokenType* const erw_TOKENTYPE_KEYWORD_LET;
-extern const struct erw_TokenType* const erw_TOKENTYPE_KEYWORD_MUT;
-extern const struct erw_TokenType* const erw_TOKENTYPE_KEYWORD_TYPE;
-extern const struct erw_TokenType* const erw_TOKENTYPE_KEYWORD_IF;
-extern const struct erw_TokenType* const erw_TOKENTYPE_KEYWORD_ELSEIF;
-extern const struct erw_TokenType* const erw_TOKENTYPE_KEYWORD_ELSE;
-extern const struct erw_TokenType* const erw_TOKENTYPE_KEYWORD_CAST;
-extern const struct erw_TokenType* const erw_TOKENTYPE_KEYWORD_DEFER;
-extern const struct erw_TokenType* const erw_TOKENTYPE_KEYWORD_WHILE;
-extern const struct erw_TokenType* const erw_TOKENTYPE_KEYWORD_STRUCT;
-extern const struct erw_TokenType* const erw_TOKENTYPE_KEYWORD_UNION;
-extern const struct erw_TokenType* const erw_TOKENTYPE_KEYWORD_ENUM;
-extern const struct erw_TokenType* const erw_TOKENTYPE_KEYWORD_ARRAY;
-extern const struct erw_TokenType* const erw_TOKENTYPE_KEYWORD_UNSAFE;
-extern const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_DECLR;
-extern const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_ADD;
-extern const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_SUB;
-extern const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_MUL;
-extern const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_DIV;
-extern const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_MOD;
-extern const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_POW;
-extern const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_RETURN;
-extern const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_EQUAL;
-extern const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_NOT;
-extern const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_NOTEQUAL;
-extern const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_LESS;
-extern const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_GREATER;
-extern const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_LESSOREQUAL;
-extern const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_GREATEROREQUAL;
-extern const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_AND;
-extern const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_OR;
-extern const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_ASSIGN;
-extern const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_ADDASSIGN;
-extern const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_SUBASSIGN;
-extern const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_MULASSIGN;
-extern const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_DIVASSIGN;
-extern const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_MODASSIGN;
-extern const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_POWASSIGN;
-extern const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_BITOR;
-extern const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_BITAND;
-extern const struct erw_TokenType* const erw_TOKENTYPE_OPERATOR_ACCESS;
-extern const struct erw_TokenType* const erw_TOKENTYPE_LITERAL_INT;
-extern const struct erw_TokenType* const erw_TOKENTYPE_LITERAL_FLOAT;
-extern const struct erw_TokenType* const erw_TOKENTYPE_LITERAL_STRING;
-extern const struct erw_TokenType* const erw_TOKENTYPE_LITERAL_CHAR;
-extern const struct erw_TokenType* const erw_TOKENTYPE_LITERAL_BOOL;
-extern const struct erw_TokenType* const erw_TOKENTYPE_IDENT;
-extern const struct erw_TokenType* const erw_TOKENTYPE_TYPE;
-extern const struct erw_TokenType* const erw_TOKENTYPE_END;
-extern const struct erw_TokenType* const erw_TOKENTYPE_COMMA;
-extern const struct erw_TokenType* const erw_TOKENTYPE_LPAREN;
-extern const struct erw_TokenType* const erw_TOKENTYPE_RPAREN;
-extern const struct erw_TokenType* const erw_TOKENTYPE_LCURLY;
-extern const struct erw_TokenType* const erw_TOKENTYPE_RCURLY;
-extern const struct erw_TokenType* const erw_TOKENTYPE_LBRACKET;
-extern const struct erw_TokenType* const erw_TOKENTYPE_RBRACKET;
-extern const struct erw_TokenType* const erw_TOKENTYPE_FOREIGN; //?
+//Prefix '-' and '!' bind tighter than '*' but looser than '^'
+#define erw_PRECEDENCE_SIGN 6
+
+extern const struct erw_TokenTypeInfo erw_tokentypeinfos[];
 
+//Decoded by the tokenizer, so later stages don't parse the text again. Int, 
+//char and bool literals set uint (char literals to the character code, bools
+//to 0 or 1), float literals set float_.
+union erw_TokenValue
+{
+	uint64_t uint;
+	int64_t int_;
+	double float_;
+};
+
+//Set on literals that don't fit the value
+enum erw_TokenFlag
+{
+	erw_TOKENFLAG_INTOVERFLOW = 1 << 0, //Int literal above INT64_MAX
+	erw_TOKENFLAG_UINTOVERFLOW = 1 << 1, //Above UINT64_MAX, uint is that
+	erw_TOKENFLAG_FLOATOVERFLOW = 1 << 2, //Above DBL_MAX, float_ is infinity
+};
+
+//Int, float, char and bool literals, see erw_tokenstream_getliteral
+struct erw_Literal
+{
+	union erw_TokenValue value;
+	uint8_t flags; //enum erw_TokenFlag
+};
+
+//NOTE: text points into the source and is not NUL-terminated, use
+//erw_token_getstr if a C string is needed
 struct erw_Token
 {
-	Vec(char) text;
-	const struct erw_TokenType* type;
+	const char* text;
+	size_t len;
+	//The atom (see erw_intern) for identifiers, type names and foreign 
+	//tokens. Otherwise NULL until erw_token_getstr is called
+	const char* str;
+	enum erw_TokenType type;
 	size_t linenum;
 	size_t column;
 };
 
-Vec(struct erw_Token) erw_tokenize(const char* source, Vec(struct Str) lines);
-void erw_tokens_delete(Vec(struct erw_Token) tokens);
+//Tokens as parallel arrays, indexed by token. Looking ahead only touches the
+//types, erw_tokenstream_get unpacks a whole token.
+struct erw_TokenStream
+{
+	const char* source;
+	uint8_t* types; //enum erw_TokenType
+	uint32_t* offsets; //Of the text in source
+	uint32_t* lens;
+	uint32_t* linenums;
+	uint32_t* columns;
+	//Identifiers, type names and foreign tokens are interned when they are 
+	//pushed. NULL for other tokens.
+	const char** atoms;
+	size_t numtokens;
+	size_t capacity;
+	//Only literals have a value, so they are stored apart, in token order
+	uint32_t* literaltokens; //Indices of the literals
+	union erw_TokenValue* values;
+	uint8_t* flags; //enum erw_TokenFlag
+	size_t numliterals;
+	size_t literalcapacity;
+};
+
+//NOTE: Sources have to be smaller than 4 GiB
+struct erw_TokenStream erw_tokenize(
+	const char* source, 
+	struct erw_Lines* lines
+);
+struct erw_Token erw_tokenstream_get(
+	const struct erw_TokenStream* self, 
+	size_t index
+);
+//The token at index has to be an int, float, char or bool literal
+struct erw_Literal erw_tokenstream_getliteral(
+	const struct erw_TokenStream* self, 
+	size_t index
+);
+void erw_tokenstream_dtor(struct erw_TokenStream* self);
+const char* erw_token_getstr(struct erw_Token* self);
+int erw_token_equals(const struct erw_Token* self, const char* str);
 
 #endif
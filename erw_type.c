@@ -18,6 +18,7 @@
 */
 
 #include "erw_type.h"
+#include "arena.h"
 #include "log.h"
 #include "str.h"
 #include <stdlib.h>
@@ -139,9 +140,18 @@ struct erw_Type* const erw_type_builtins[] = {
 	},
 };
 
-struct erw_Type* erw_type_new(enum erw_TypeInfo info, struct erw_Type* parent)
+struct erw_Type* erw_type_new(enum erw_TypeInfo info)
 {
 	log_assert(info < erw_TYPEINFO_COUNT, "invalid info (%i)", info);
+	log_assert(
+		info != erw_TYPEINFO_REFERENCE 
+			&& info != erw_TYPEINFO_ARRAY 
+			&& info != erw_TYPEINFO_SLICE
+			&& info != erw_TYPEINFO_FUNC,
+		"structural types are created with erw_type_get* (%i)", 
+		info
+	);
+
 	struct erw_Type* self = calloc(1, sizeof(struct erw_Type));
 	if(!self)
 	{
@@ -160,16 +170,254 @@ struct erw_Type* erw_type_new(enum erw_TypeInfo info, struct erw_Type* parent)
 	{
 		self->enum_.members = vec_ctor(struct erw_TypeEnumMember, 0);
 	}
-	else if(info == erw_TYPEINFO_FUNC)
+
+	self->info = info;
+	return self;
+}
+
+struct erw_TypeSlot
+{
+	size_t hash;
+	struct erw_Type* type; //NULL if the slot is empty
+};
+
+//Every reference, array, slice and func type is created once, from canonical 
+//children, and stored here. Two such types built from the same parts are 
+//therefore the same pointer.
+static struct
+{
+	struct erw_TypeSlot* slots;
+	size_t capacity; //0 until the first structural type, then a power of 2
+	size_t count;
+	struct Arena arena;
+} erw_types;
+
+static size_t erw_type_hashcombine(size_t hash, size_t value)
+{
+	hash ^= value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+	return hash;
+}
+
+static size_t erw_type_hash(
+	enum erw_TypeInfo info, 
+	struct erw_Type* type, 
+	size_t value,
+	struct erw_Type** params,
+	size_t numparams)
+{
+	size_t hash = erw_type_hashcombine(info, (size_t)type);
+	hash = erw_type_hashcombine(hash, value);
+	for(size_t i = 0; i < numparams; i++)
 	{
-		self->func.params = vec_ctor(struct erw_Type*, 0);
+		hash = erw_type_hashcombine(hash, (size_t)params[i]);
 	}
 
-	self->parent = parent;
-	self->info = info;
+	return hash;
+}
+
+static int erw_type_matches(
+	struct erw_Type* self,
+	enum erw_TypeInfo info, 
+	struct erw_Type* type, 
+	size_t value,
+	struct erw_Type** params,
+	size_t numparams)
+{
+	if(self->info != info)
+	{
+		return 0;
+	}
+
+	if(info == erw_TYPEINFO_REFERENCE)
+	{
+		return self->reference.type == type 
+			&& (size_t)self->reference.mutable == value;
+	}
+	else if(info == erw_TYPEINFO_ARRAY)
+	{
+		return self->array.type == type && self->array.elements == value;
+	}
+	else if(info == erw_TYPEINFO_SLICE)
+	{
+		return self->slice.type == type 
+			&& (size_t)self->slice.mutable == value;
+	}
+
+	if(self->func.type != type || vec_getsize(self->func.params) != numparams)
+	{
+		return 0;
+	}
+
+	for(size_t i = 0; i < numparams; i++)
+	{
+		if(self->func.params[i] != params[i])
+		{
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+static void erw_type_insert(struct erw_TypeSlot slot)
+{
+	if((erw_types.count + 1) * 2 > erw_types.capacity)
+	{
+		struct erw_TypeSlot* oldslots = erw_types.slots;
+		size_t oldcapacity = erw_types.capacity;
+		erw_types.capacity *= 2;
+		erw_types.slots = calloc(
+			erw_types.capacity, 
+			sizeof(struct erw_TypeSlot)
+		);
+		if(!erw_types.slots)
+		{
+			log_error("calloc failed in <%s>", __func__);
+		}
+
+		erw_types.count = 0;
+		for(size_t i = 0; i < oldcapacity; i++)
+		{
+			if(oldslots[i].type)
+			{
+				erw_type_insert(oldslots[i]);
+			}
+		}
+
+		free(oldslots);
+	}
+
+	size_t i = slot.hash & (erw_types.capacity - 1);
+	while(erw_types.slots[i].type)
+	{
+		i = (i + 1) & (erw_types.capacity - 1);
+	}
+
+	erw_types.slots[i] = slot;
+	erw_types.count++;
+}
+
+static struct erw_Type* erw_type_get(
+	enum erw_TypeInfo info, 
+	struct erw_Type* type, 
+	size_t value,
+	struct erw_Type** params,
+	size_t numparams)
+{
+	if(!erw_types.capacity)
+	{
+		erw_types.capacity = 256;
+		erw_types.count = 0;
+		erw_types.slots = calloc(
+			erw_types.capacity, 
+			sizeof(struct erw_TypeSlot)
+		);
+		if(!erw_types.slots)
+		{
+			log_error("calloc failed in <%s>", __func__);
+		}
+
+		arena_ctor(&erw_types.arena, 0);
+	}
+
+	size_t hash = erw_type_hash(info, type, value, params, numparams);
+	size_t i = hash & (erw_types.capacity - 1);
+	while(erw_types.slots[i].type)
+	{
+		if(erw_types.slots[i].hash == hash && erw_type_matches(
+				erw_types.slots[i].type, 
+				info, 
+				type, 
+				value, 
+				params, 
+				numparams))
+		{
+			return erw_types.slots[i].type;
+		}
+
+		i = (i + 1) & (erw_types.capacity - 1);
+	}
+
+	struct erw_Type* self = arena_alloc(
+		&erw_types.arena, 
+		sizeof(struct erw_Type)
+	);
+	*self = (struct erw_Type){.info = info};
+	if(info == erw_TYPEINFO_REFERENCE)
+	{
+		self->reference.type = type;
+		self->reference.mutable = value;
+		self->reference.size = sizeof(void*); //NOTE: Temporary
+	}
+	else if(info == erw_TYPEINFO_ARRAY)
+	{
+		self->array.type = type;
+		self->array.elements = value;
+		self->array.size = value * type->size;
+	}
+	else if(info == erw_TYPEINFO_SLICE)
+	{
+		self->slice.type = type;
+		self->slice.mutable = value;
+		self->slice.size = sizeof(void*); //NOTE: Temporary
+	}
+	else
+	{
+		self->func.type = type;
+		self->func.size = sizeof(void(*)(void));
+		self->func.params = vec_ctorinarena(
+			struct erw_Type*, 
+			numparams, 
+			&erw_types.arena
+		);
+		if(numparams)
+		{
+			vec_pushbackwitharr(self->func.params, params, numparams);
+		}
+	}
+
+	erw_type_insert((struct erw_TypeSlot){.hash = hash, .type = self});
 	return self;
 }
 
+struct erw_Type* erw_type_getreference(struct erw_Type* type, int mutable)
+{
+	log_assert(type, "is NULL");
+	return erw_type_get(erw_TYPEINFO_REFERENCE, type, mutable, NULL, 0);
+}
+
+struct erw_Type* erw_type_getarray(struct erw_Type* type, size_t elements)
+{
+	log_assert(type, "is NULL");
+	return erw_type_get(erw_TYPEINFO_ARRAY, type, elements, NULL, 0);
+}
+
+struct erw_Type* erw_type_getslice(struct erw_Type* type, int mutable)
+{
+	log_assert(type, "is NULL");
+	return erw_type_get(erw_TYPEINFO_SLICE, type, mutable, NULL, 0);
+}
+
+struct erw_Type* erw_type_getfunc(
+	struct erw_Type* type, 
+	struct erw_Type** params, 
+	size_t numparams)
+{
+	log_assert(params || !numparams, "is NULL");
+	return erw_type_get(erw_TYPEINFO_FUNC, type, 0, params, numparams);
+}
+
+void erw_type_clear(void)
+{
+	if(erw_types.capacity)
+	{
+		free(erw_types.slots);
+		arena_dtor(&erw_types.arena);
+		erw_types.slots = NULL;
+		erw_types.capacity = 0;
+		erw_types.count = 0;
+	}
+}
 struct Str erw_type_tostring(struct erw_Type* type)
 {
 	log_assert(type, "is NULL");
@@ -282,94 +530,19 @@ int erw_type_compare(struct erw_Type* type1, struct erw_Type* type2)
 	log_assert(type1, "is NULL");
 	log_assert(type2, "is NULL");
 
-	if(type1->info != type2->info)
-	{
-		return 0;
-	}
-
-	if(type1->info == erw_TYPEINFO_NAMED)
-	{
-		if(!strcmp(type1->named.name, type2->named.name))
-		{
-			return 1;
-		}
-		else
-		{
-			return 0;
-		}
-	}
-	else if(type1->info == erw_TYPEINFO_REFERENCE)
-	{
-		if(type1->reference.mutable != type2->reference.mutable)
-		{
-			return 0;
-		}
-	}
-	else if(type1->info == erw_TYPEINFO_SLICE)
+	if(type1 == type2)
 	{
-		if(type1->slice.mutable != type2->slice.mutable)
-		{
-			return 0;
-		}
+		return 1;
 	}
-	else if(type1->info == erw_TYPEINFO_ARRAY)
-	{
-		if(type1->array.elements != type2->array.elements)
-		{
-			return 0;
-		}
-
-		/*
-		if(type1->array.mutable != type2->array.mutable)
-		{
-			return 0;
-		}
-		*/
-	}
-	else if(type1->info == erw_TYPEINFO_FUNC)
-	{
-		size_t numparams1 = vec_getsize(type1->func.params);
-		size_t numparams2 = vec_getsize(type2->func.params);
-		if(numparams1 != numparams2)
-		{
-			return 0;
-		}
 
-		for(size_t i = 0; i < numparams1; i++)
-		{
-			int result = erw_type_compare(
-				type1->func.params[i], 
-				type2->func.params[i]
-			);
-
-			if(!result)
-			{
-				return 0;
-			}
-		}
-
-		if(type1->func.type || type2->func.type)
-		{
-			if(type1->func.type && type2->func.type)
-			{
-				return erw_type_compare(type1->func.type, type2->func.type);
-			}
-			else
-			{
-				return 0;
-			}
-		}
-		else
-		{
-			return 1;
-		}
-	}
-	else
+	//Builtins and reference, array, slice and func types are unique (see 
+	//erw_type_get), so they are only equal to themselves
+	if(type1->info == erw_TYPEINFO_NAMED && type2->info == erw_TYPEINFO_NAMED)
 	{
-		log_assert(0, "this shouldn't happen (%i)'", type1->info);
+		return type1->named.name == type2->named.name; //Names are atoms
 	}
 
-	return erw_type_compare(type1->reference.type, type2->reference.type);
+	return 0;
 }
 
 void erw_type_dtor(struct erw_Type* self)
@@ -396,10 +569,6 @@ void erw_type_dtor(struct erw_Type* self)
 	{
 		vec_dtor(self->enum_.members);
 	}
-	else if(self->info == erw_TYPEINFO_FUNC)
-	{
-		vec_dtor(self->func.params);
-	}
 	/*
 	else if(self->info == erw_TYPEINFO_NAMED)
 	{
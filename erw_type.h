@@ -143,11 +143,26 @@ struct erw_Type
 		} int_;
 	};
 
-	struct erw_Type* parent;
 	enum erw_TypeInfo info;
 };
 
-struct erw_Type* erw_type_new(enum erw_TypeInfo info, struct erw_Type* parent);
+//Creates a named, struct, union, enum or empty type owned by the caller
+struct erw_Type* erw_type_new(enum erw_TypeInfo info);
+
+//Reference, array, slice and func types are hash-consed: each distinct type 
+//exists once and is owned by a global table, so identical types are the same
+//pointer. Children must be builtins, declared types or other erw_type_get* 
+//results. func types without a return type pass NULL as type.
+struct erw_Type* erw_type_getreference(struct erw_Type* type, int mutable);
+struct erw_Type* erw_type_getarray(struct erw_Type* type, size_t elements);
+struct erw_Type* erw_type_getslice(struct erw_Type* type, int mutable);
+struct erw_Type* erw_type_getfunc(
+	struct erw_Type* type, 
+	struct erw_Type** params, 
+	size_t numparams
+);
+void erw_type_clear(void); //Frees all types made by erw_type_get*
+
 struct Str erw_type_tostring(struct erw_Type* type);
 int erw_type_compare(struct erw_Type* type1, struct erw_Type* type2);
 void erw_type_dtor(struct erw_Type* self);
@@ -0,0 +1,373 @@
+/*
+	Copyright (C) 2017 Erik Wallström
+
+	This file is part of Erwall.
+
+	Erwall is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Erwall is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Erwall.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "erw_verifier.h"
+#include "erw_ir.h"
+#include "log.h"
+#include <stdlib.h>
+
+//Depths of offsets that don't start an instruction, and of instructions that
+//no path has reached yet
+#define erw_VERIFIER_NOINSTRUCTION UINT32_MAX
+#define erw_VERIFIER_UNVISITED (UINT32_MAX - 1)
+//Frames have to stay below the values above
+#define erw_VERIFIER_MAXFRAME (UINT32_MAX - 2)
+
+static void erw_verifier_error(const char* reason, size_t offset)
+{
+	log_error("Corrupt bytecode file (%s at %zu)", reason, offset);
+}
+
+//Decodes operand index of the instruction at pos
+static uint64_t erw_verifier_operand(
+	const uint8_t* code,
+	size_t pos,
+	size_t index)
+{
+	const char* operands = erw_instructioninfos[code[pos]].operands;
+	const uint8_t* operand = code + pos + 1;
+	for(size_t i = 0; i < index; i++)
+	{
+		operand += erw_operandsize(operands[i]);
+	}
+
+	uint64_t ret = 0;
+	for(size_t i = 0; i < erw_operandsize(operands[index]); i++)
+	{
+		ret |= (uint64_t)operand[i] << (i * 8);
+	}
+
+	return ret;
+}
+
+//What the verifier needs of an instruction, so its operands don't have to be
+//gone through one by one
+struct erw_VerifierInfo
+{
+	uint16_t registers; //Bit per byte that holds a register operand
+	uint8_t target; //Operand index of the jump target, 0 if it doesn't jump
+	uint8_t isend; //If it never falls through
+};
+
+static void erw_verifier_getinfos(struct erw_VerifierInfo* infos)
+{
+	for(size_t id = 0; id < erw_INSTRUCTIONID_COUNT; id++)
+	{
+		const char* operands = erw_instructioninfos[id].operands;
+		size_t offset = 1;
+		infos[id] = (struct erw_VerifierInfo){
+			.isend = id == erw_INSTRUCTIONID_JMP
+				|| id == erw_INSTRUCTIONID_RET
+				|| id == erw_INSTRUCTIONID_HALT
+		};
+		for(size_t i = 0; operands[i]; i++)
+		{
+			if(operands[i] == 'r')
+			{
+				infos[id].registers |= 1 << offset;
+			}
+			else if(operands[i] == 't' && erw_ir_isbranch(id))
+			{
+				infos[id].target = i + 1;
+			}
+
+			offset += erw_operandsize(operands[i]);
+		}
+	}
+}
+
+//Checks the instructions of the function [begin, end) one by one and marks
+//where they start in depths, which is indexed from begin
+static void erw_verifier_checkinstructions(
+	struct erw_BytecodeImage* image,
+	const struct erw_VerifierInfo* infos,
+	size_t begin,
+	size_t end,
+	uint32_t* depths)
+{
+	const uint8_t* code = image->instructions;
+	size_t pos = begin;
+	size_t last = begin;
+	while(pos < end)
+	{
+		enum erw_InstructionID id = code[pos];
+		if(id >= erw_INSTRUCTIONID_COUNT)
+		{
+			erw_verifier_error("invalid instruction", pos);
+		}
+
+		const struct erw_InstructionInfo* info = &erw_instructioninfos[id];
+		if(info->size > end - pos)
+		{
+			erw_verifier_error("truncated instruction", pos);
+		}
+
+		for(unsigned mask = infos[id].registers; mask; mask &= mask - 1)
+		{
+			if(code[pos + __builtin_ctz(mask)] >= image->numregisters)
+			{
+				erw_verifier_error("invalid register", pos);
+			}
+		}
+
+		//PUSHN and POPN copy the registers below their operand
+		if((id == erw_INSTRUCTIONID_PUSHN || id == erw_INSTRUCTIONID_POPN)
+			&& code[pos + 1] > image->numregisters)
+		{
+			erw_verifier_error("invalid register", pos);
+		}
+		else if(id == erw_INSTRUCTIONID_CALL)
+		{
+			size_t target = erw_verifier_operand(code, pos, 0);
+			const struct erw_BytecodeFuncEntry* callee =
+				erw_bytecodeimage_findfunc(image, target);
+			if(!callee || callee->offset != target)
+			{
+				erw_verifier_error("invalid call", pos);
+			}
+		}
+
+		depths[pos - begin] = erw_VERIFIER_UNVISITED;
+		last = pos;
+		pos += info->size;
+	}
+
+	if(!infos[code[last]].isend)
+	{
+		erw_verifier_error("function without an end", last);
+	}
+}
+
+//Gives successor the depth of the path that got there, returns 1 if it wasn't
+//reached before
+static int erw_verifier_reach(
+	uint32_t* depths,
+	size_t begin,
+	size_t successor,
+	size_t depth)
+{
+	if(depths[successor - begin] == erw_VERIFIER_UNVISITED)
+	{
+		depths[successor - begin] = depth;
+		return 1;
+	}
+	else if(depths[successor - begin] != depth)
+	{
+		erw_verifier_error("unbalanced stack", successor);
+	}
+
+	return 0;
+}
+
+//Follows every path through the function [begin, end), returns its frame size.
+//Only jump targets are queued, at most once each, so worklist needs end - begin
+//entries.
+static uint32_t erw_verifier_checkframe(
+	struct erw_BytecodeImage* image,
+	const struct erw_VerifierInfo* infos,
+	size_t begin,
+	size_t end,
+	uint32_t* depths,
+	size_t* worklist)
+{
+	const uint8_t* code = image->instructions;
+	size_t maxdepth = 0;
+	size_t numqueued = 0;
+	depths[0] = 0;
+	worklist[numqueued++] = begin;
+	while(numqueued)
+	{
+		//Falls through instruction by instruction until a path was already
+		//followed from there
+		size_t pos = worklist[--numqueued];
+		size_t depth = depths[pos - begin];
+		while(1)
+		{
+			enum erw_InstructionID id = code[pos];
+			size_t popped = 0;
+			size_t pushed = 0;
+			switch(id)
+			{
+			case erw_INSTRUCTIONID_ENTER:
+			case erw_INSTRUCTIONID_PUSHN:
+				pushed = erw_verifier_operand(code, pos, 0);
+				break;
+			case erw_INSTRUCTIONID_PUSH:
+				pushed = 1;
+				break;
+			case erw_INSTRUCTIONID_POP:
+				popped = 1;
+				break;
+			case erw_INSTRUCTIONID_POPN:
+				popped = erw_verifier_operand(code, pos, 0);
+				break;
+			case erw_INSTRUCTIONID_LOAD:
+				if(erw_verifier_operand(code, pos, 1) >= depth)
+				{
+					erw_verifier_error("invalid slot", pos);
+				}
+				break;
+			case erw_INSTRUCTIONID_STORE:
+				if(erw_verifier_operand(code, pos, 0) >= depth)
+				{
+					erw_verifier_error("invalid slot", pos);
+				}
+				break;
+			case erw_INSTRUCTIONID_CALL:
+				pushed = 2; //Only until the callee returns
+				popped = 2;
+				break;
+			default:
+				break;
+			}
+
+			if(pushed > erw_VERIFIER_MAXFRAME - depth)
+			{
+				erw_verifier_error("frame too large", pos);
+			}
+			else if(depth + pushed > maxdepth)
+			{
+				maxdepth = depth + pushed;
+			}
+
+			if(popped > depth + pushed)
+			{
+				erw_verifier_error("stack underflow", pos);
+			}
+
+			depth = depth + pushed - popped;
+
+			if(infos[id].target)
+			{
+				size_t target = erw_verifier_operand(
+					code,
+					pos,
+					infos[id].target - 1
+				);
+				if(target < begin
+					|| target >= end
+					|| depths[target - begin] == erw_VERIFIER_NOINSTRUCTION)
+				{
+					erw_verifier_error("invalid jump", pos);
+				}
+
+				if(erw_verifier_reach(depths, begin, target, depth))
+				{
+					worklist[numqueued++] = target;
+				}
+			}
+
+			if(infos[id].isend)
+			{
+				break;
+			}
+
+			pos += erw_instructioninfos[id].size;
+			if(!erw_verifier_reach(depths, begin, pos, depth))
+			{
+				break;
+			}
+		}
+	}
+
+	return maxdepth;
+}
+
+size_t erw_verifier_verify(struct erw_BytecodeImage* image)
+{
+	log_assert(image, "is NULL");
+
+	//Every offset has to belong to a function, and main has to be one
+	const struct erw_BytecodeFuncEntry* entry =
+		erw_bytecodeimage_findfunc(image, image->entry);
+	if(!image->numfunctions || image->functions[0].offset)
+	{
+		erw_verifier_error("code outside of functions", 0);
+	}
+	else if(!entry || entry->offset != image->entry)
+	{
+		erw_verifier_error("invalid entry", image->entry);
+	}
+
+	size_t numinstructions = image->numinstructions;
+	size_t maxsize = 0;
+	for(size_t i = 0; i < image->numfunctions; i++)
+	{
+		size_t begin = image->functions[i].offset;
+		size_t end = i + 1 < image->numfunctions
+			? image->functions[i + 1].offset
+			: numinstructions;
+		if(begin >= end)
+		{
+			erw_verifier_error("empty function", begin);
+		}
+		else if(end - begin > maxsize)
+		{
+			maxsize = end - begin;
+		}
+	}
+
+	struct erw_VerifierInfo infos[erw_INSTRUCTIONID_COUNT];
+	erw_verifier_getinfos(infos);
+
+	//Scratch space for one function at a time
+	size_t maxframesize = 0;
+	uint32_t* depths = malloc(maxsize * sizeof(uint32_t));
+	size_t* worklist = malloc(maxsize * sizeof(size_t));
+	if(!depths || !worklist)
+	{
+		log_error("malloc failed <%s>", __func__);
+	}
+
+	for(size_t i = 0; i < image->numfunctions; i++)
+	{
+		size_t begin = image->functions[i].offset;
+		size_t end = i + 1 < image->numfunctions
+			? image->functions[i + 1].offset
+			: numinstructions;
+		for(size_t j = 0; j < end - begin; j++)
+		{
+			depths[j] = erw_VERIFIER_NOINSTRUCTION;
+		}
+
+		erw_verifier_checkinstructions(
+			image,
+			infos,
+			begin,
+			end,
+			depths
+		);
+		size_t framesize = erw_verifier_checkframe(
+			image,
+			infos,
+			begin,
+			end,
+			depths,
+			worklist
+		);
+		if(framesize > maxframesize)
+		{
+			maxframesize = framesize;
+		}
+	}
+
+	free(worklist);
+	free(depths);
+	return maxframesize + 2;
+}
@@ -0,0 +1,37 @@
+/*
+	Copyright (C) 2017 Erik Wallström
+
+	This file is part of Erwall.
+
+	Erwall is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Erwall is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Erwall.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ERW_VERIFIER_H
+#define ERW_VERIFIER_H
+
+#include "erw_bytecode.h"
+
+//Checks that every function of image decodes to whole instructions, only
+//uses registers below image->numregisters, jumps to instructions of its own,
+//calls functions, ends in RET, JMP or HALT, and that every path to an
+//instruction leaves the same number of slots on its frame. Loads, stores and
+//pops have to stay within that.
+//
+//Returns the largest frame of any function in stack slots, counting ENTER,
+//pushes, the return address and frame of its own calls and those of the call
+//into it. While that much is left on the stack at every call nothing can
+//overflow in between. Corrupt bytecode is an error.
+size_t erw_verifier_verify(struct erw_BytecodeImage* image);
+
+#endif
@@ -1,6 +1,8 @@
 #include "file.h"
 #include "log.h"
 #include <errno.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 struct File* file_ctor(
 	struct File* self, 
@@ -15,6 +17,11 @@ struct File* file_ctor(
 		"invalid mode (%i)",
 		mode
 	);
+	log_assert(
+		!(mode & FILEMODE_MAP) || !(mode & FILEMODE_WRITE), 
+		"mapped files are read only (%i)",
+		mode
+	);
 
 	char* m;
 	if(mode & FILEMODE_READ && mode & FILEMODE_WRITE)
@@ -32,6 +39,7 @@ struct File* file_ctor(
 	}
 
 	self->mode = mode;
+	self->mapsize = 0;
 	self->raw = fopen(path, m);
 	if(!self->raw)
 	{
@@ -56,16 +64,52 @@ struct File* file_ctor(
 			log_error("%s", strerror(errno));
 		}
 
-		self->content = vec_ctor(char, filesize + 1);
-		if(filesize)
+		if(mode & FILEMODE_MAP)
 		{
-			vec_expand(self->content, 0, filesize + 1);
-			self->content[filesize] = '\0';
-			fread(self->content, 1, filesize, self->raw);
+			//Reserve at least one page more than the content, so that the 
+			//zero filled remainder of the last page is the '\0' terminator
+			size_t pagesize = sysconf(_SC_PAGESIZE);
+			self->mapsize = (filesize / pagesize + 1) * pagesize;
+			char* map = mmap(
+				NULL, 
+				self->mapsize, 
+				PROT_READ, 
+				MAP_PRIVATE | MAP_ANONYMOUS, 
+				-1, 
+				0
+			);
+			if(map == MAP_FAILED)
+			{
+				log_error("%s", strerror(errno));
+			}
+
+			if(filesize && mmap(
+				map, 
+				filesize, 
+				PROT_READ, 
+				MAP_PRIVATE | MAP_FIXED, 
+				fileno(self->raw), 
+				0) == MAP_FAILED)
+			{
+				log_error("%s", strerror(errno));
+			}
+
+			self->content = NULL;
+			self->data = map;
 		}
 		else
 		{
-			vec_pushback(self->content, '\0');
+			self->content = vec_ctor(char, filesize + 1);
+			if(filesize)
+			{
+				vec_expand(self->content, 0, filesize + 1);
+				self->content[filesize] = '\0';
+				fread(self->content, 1, filesize, self->raw);
+			}
+			else
+			{
+				vec_pushback(self->content, '\0');
+			}
 		}
 	}
 	else
@@ -74,6 +118,11 @@ struct File* file_ctor(
 		vec_pushback(self->content, '\0');
 	}
 
+	if(!self->mapsize)
+	{
+		self->data = self->content;
+	}
+
 	for(size_t i = 0; i <= strlen(path); i++)
 	{
 		self->extension = path + i;
@@ -114,7 +163,15 @@ void file_dtor(struct File* self)
 		file_flush(self);
 	}
 
-	vec_dtor(self->content);
+	if(self->mapsize)
+	{
+		munmap((void*)self->data, self->mapsize);
+	}
+	else
+	{
+		vec_dtor(self->content);
+	}
+
 	fclose(self->raw);
 }
 
@@ -8,12 +8,18 @@ enum FileMode
 {
 	FILEMODE_READ = 1 << 0,
 	FILEMODE_WRITE = 1 << 1,
+	//Maps the file instead of copying it, only allowed with FILEMODE_READ
+	FILEMODE_MAP = 1 << 2,
 };
 
 struct File
 {
 	FILE* raw;
-	Vec(char) content;
+	Vec(char) content; //NULL if FILEMODE_MAP is used
+	//NOTE: 'data' is always NUL-terminated. It points to the mapped file or 
+	//to content, which are freed in file_dtor
+	const char* data;
+	size_t mapsize;
 	//NOTE: 'extension' simply points to path, no memory is allocated
 	const char* extension;
 	enum FileMode mode;
@@ -4,8 +4,9 @@
 #include <stdlib.h>
 
 //TODO: Maybe add lastmessage and pass it to errorcallback
-static LogErrorCallback errorcallback;
-static void* errorudata;
+//Per thread, so threads can handle their errors differently
+static _Thread_local LogErrorCallback errorcallback;
+static _Thread_local void* errorudata;
 
 void log_msg(FILE* file, enum LogMsgType type, const char* fmt, ...)
 {
@@ -82,6 +83,10 @@ void log_msg(FILE* file, enum LogMsgType type, const char* fmt, ...)
 		{
 			errorcallback(errorudata);
 		}
+
+		//Threads that never set a handler, or a handler that returns, can't
+		//continue after an error
+		abort();
 	}
 }
 
@@ -41,7 +41,10 @@ enum LogMsgType
 void log_msg(FILE* file, enum LogMsgType type, const char* fmt, ...)
 	__attribute__((format (printf, 3, 4)));
 
-//TODO: Set different error fatal for different files, avoid global 
+//Called on errors by the calling thread only, other threads keep theirs. The
+//callback doesn't have to return (it can longjmp), if it does or no thread
+//set one the program aborts.
+//TODO: Set different error fatal for different files
 void log_seterrorhandler(LogErrorCallback callback, void* udata);
 
 void log_assert_(
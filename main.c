@@ -18,6 +18,13 @@
 */
 
 #include "erw_semantics.h"
+#include "erw_regalloc.h"
+#include "erw_peephole.h"
+#include "erw_profile.h"
+#include "erw_tier.h"
+#include "erw_jit.h"
+#include "erw_batch.h"
+#include "erw_intern.h"
 
 #include "argparser.h"
 #include "ansicode.h"
@@ -27,6 +34,7 @@
 #include <inttypes.h>
 #include <stdlib.h>
 #include <time.h>
+#include <unistd.h>
 
 static uint64_t getperformancefreq(void)
 {
@@ -95,25 +103,148 @@ static void compile(struct Str* code, const char* filename)
 	}
 }
 
-static Vec(struct Str) getlines(const char* source)
+//Calls main once per integer of filename (one per line) with it as argument,
+//and prints what each call returned in the same order
+static void runbatch(struct erw_BytecodeImage* image, const char* filename)
 {
-	log_assert(source, "is NULL");
+	FILE* file = fopen(filename, "r");
+	if(!file)
+	{
+		log_error("Could not open '%s'", filename);
+	}
+
+	Vec(struct erw_BatchJob) jobs = vec_ctor(struct erw_BatchJob, 1024);
+	int64_t input;
+	while(fscanf(file, "%" SCNd64, &input) == 1)
+	{
+		vec_pushback(jobs, (struct erw_BatchJob){.input = input});
+	}
+
+	if(!feof(file))
+	{
+		log_error("Invalid input in '%s'", filename);
+	}
+
+	fclose(file);
+
+	long numthreads = sysconf(_SC_NPROCESSORS_ONLN);
+	uint64_t timestart = getperformancecount();
+	erw_batch_run(
+		image,
+		image->entry,
+		jobs,
+		vec_getsize(jobs),
+		numthreads > 0 ? numthreads : 1
+	);
+	uint64_t timestop = getperformancecount();
 
-	Vec(struct Str) lines = vec_ctor(struct Str, 0);
-	char* newlinepos;
-	while((newlinepos = strchr(source, '\n')))
+	for(size_t i = 0; i < vec_getsize(jobs); i++)
 	{
-		struct Str line;
-		size_t offset = newlinepos - source + 1;
-		str_ctorfmt(&line, "%.*s", (int)(offset - 1), source);
-		vec_pushback(lines, line);
-		source += offset;
+		if(jobs[i].isfailed)
+		{
+			printf("%" PRId64 ": error\n", jobs[i].input);
+		}
+		else
+		{
+			printf("%" PRId64 ": %" PRId64 "\n", jobs[i].input, jobs[i].output);
+		}
 	}
 
-	struct Str line;
-	str_ctor(&line, "");
-	vec_pushback(lines, line);
-	return lines;
+	printf(
+		"(%f ms, %zu calls on %ld threads)\n\n",
+		(timestop - timestart) * 1000.0 / getperformancefreq(),
+		vec_getsize(jobs),
+		numthreads > 0 ? numthreads : 1
+	);
+	vec_dtor(jobs);
+}
+
+//Prints and/or runs the bytecode, as requested by --bytecode, --run,
+//--profile, --tier, --jit and --batch
+static void runbytecode(
+	struct erw_BytecodeImage* image, 
+	struct ArgParser* argparser, 
+	double timeelapsed
+)
+{
+	struct ANSICode titlecolor = {
+		.fg = ANSICODE_FG_GREEN, 
+		.bold = 1, 
+		.underline = 1
+	};
+
+	if(argparser->results[6].used)
+	{ 
+		ansicode_printf(&titlecolor, "\nBytecode:\n\n");
+		erw_bytecodeimage_print(image);
+		putchar('\n');
+		printf("(%f ms)\n\n", timeelapsed);
+	}
+
+	if(argparser->results[7].used)
+	{ 
+		ansicode_printf(&titlecolor, "\nProgram Output:\n\n");
+		struct erw_Interpreter interpreter;
+		erw_interpreter_ctor(&interpreter, image, 32 * 1024 * 1024);
+
+		struct erw_Profile profile;
+		if(argparser->results[10].used)
+		{
+			erw_profile_ctor(&profile, image->numinstructions);
+			interpreter.profile = &profile;
+		}
+
+		//Profiling counts every instruction, so it always interprets
+		struct erw_Jit jit;
+		struct erw_Tier tier;
+#ifdef __x86_64__
+		if(argparser->results[12].used && !argparser->results[10].used)
+		{
+			erw_jit_ctor(&jit, image, &interpreter);
+			interpreter.jit = &jit;
+		}
+		else
+#endif
+		if(argparser->results[11].used && !argparser->results[10].used)
+		{
+			erw_tier_ctor(&tier, image, &interpreter);
+			interpreter.tier = &tier;
+		}
+
+		uint64_t timestart = getperformancecount();
+		erw_interpreter_call(&interpreter, image->entry);
+		uint64_t timestop = getperformancecount();
+		printf("main returned %" PRId64 "\n", interpreter.registers[0].int_);
+		printf(
+			"(%f ms)\n\n", 
+			(timestop - timestart) * 1000.0 / getperformancefreq()
+		);
+		if(interpreter.tier)
+		{
+			erw_tier_dtor(&tier);
+		}
+
+		if(interpreter.jit)
+		{
+			erw_jit_dtor(&jit);
+		}
+
+		erw_interpreter_dtor(&interpreter);
+
+		if(argparser->results[10].used)
+		{
+			ansicode_printf(&titlecolor, "\nProfile:\n\n");
+			erw_profile_print(&profile, image, 20);
+			putchar('\n');
+			erw_profile_dtor(&profile);
+		}
+	}
+
+	if(argparser->results[13].used)
+	{
+		ansicode_printf(&titlecolor, "\nBatch Output:\n\n");
+		runbatch(image, argparser->results[13].arg);
+	}
 }
 
 static void onargerror(void* udata)
@@ -138,7 +269,14 @@ int main(int argc, char* argv[])
 		{"symtable", "Output the symbol table", 0},
 		{"generate", "Output C code", 0},
 		{"compile", "Compile the C code", 0},
+		{"bytecode", "Output bytecode", 0},
+		{"run", "Run the bytecode", 0},
+		{"output", "Where to save the bytecode (.erwc)", 1},
 		{"all", "Enable all options", 0},
+		{"profile", "Profile the bytecode while running it", 0},
+		{"tier", "Compile hot functions to native code while running", 0},
+		{"jit", "Compile functions to x86-64 when they are first called", 0},
+		{"batch", "Run main once per integer in a file, on every core", 1},
 	};
 
 	struct ArgParser argparser;
@@ -151,16 +289,48 @@ int main(int argc, char* argv[])
 		sizeof options / sizeof *options
 	);
 
-	if(argparser.results[6].used)
+#ifndef __x86_64__
+	if(argparser.results[12].used)
+	{
+		log_error("--jit is only supported on x86-64");
+	}
+#endif
+
+	if(argparser.results[9].used)
 	{
 		argparser.results[1].used = 1;
 		argparser.results[2].used = 1;
 		argparser.results[3].used = 1;
 		argparser.results[4].used = 1;
 		argparser.results[5].used = 1;
+		argparser.results[6].used = 1;
+		argparser.results[7].used = 1;
 	}
 
-	if(argparser.results[0].used)
+	const char* extension = argparser.results[0].used 
+		? strrchr(argparser.results[0].arg, '.') 
+		: NULL;
+	if(extension && !strcmp(extension, ".erwc"))
+	{
+		//Compiled bytecode skips everything up to the interpreter
+		log_seterrorhandler(onerror, NULL);
+		uint64_t timestart = getperformancecount();
+		struct erw_BytecodeImage image;
+		erw_bytecodeimage_ctorfromfile(&image, argparser.results[0].arg);
+		uint64_t timestop = getperformancecount();
+		runbytecode(
+			&image, 
+			&argparser, 
+			(timestop - timestart) * 1000.0 / getperformancefreq()
+		);
+		erw_bytecodeimage_dtor(&image);
+
+		printf(
+			"\nTotal time: %f ms\n", 
+			(getperformancecount() - timetotal) * 1000.0 / getperformancefreq()
+		);
+	}
+	else if(argparser.results[0].used)
 	{
 		log_seterrorhandler(onerror, NULL);
 		struct ANSICode titlecolor = {
@@ -170,53 +340,95 @@ int main(int argc, char* argv[])
 		};
 
 		struct File file;
-		file_ctor(&file, argparser.results[0].arg, FILEMODE_READ);
+		file_ctor(
+			&file, 
+			argparser.results[0].arg, 
+			FILEMODE_READ | FILEMODE_MAP
+		);
 
 		uint64_t timestart = getperformancecount();
-		Vec(struct Str) lines = getlines(file.content);
-		Vec(struct erw_Token) tokens = erw_tokenize(file.content, lines);
+		struct erw_Lines lines;
+		erw_lines_ctor(&lines, file.data);
+		struct erw_TokenStream tokens = erw_tokenize(file.data, &lines);
 		uint64_t timestop = getperformancecount();
 		double timeelapsed = (timestop - timestart) * 1000.0 
 			/ getperformancefreq();
 		if(argparser.results[1].used) //--tokenize
 		{ 
 			ansicode_printf(&titlecolor, "\nTokens:\n\n");
-			for(size_t i = 0; i < vec_getsize(tokens); i++)
+			for(size_t i = 0; i < tokens.numtokens; i++)
 			{
-				printf("%s: ", tokens[i].type->name);
+				struct erw_Token token = erw_tokenstream_get(&tokens, i);
+				printf("%s: ", erw_tokentypeinfos[token.type].name);
 				struct ANSICode color = {
 					.fg = ANSICODE_FG_BLUE, 
 					.bold = 1, 
 				};
-				ansicode_printf(&color, "%s\n", tokens[i].text);
+				ansicode_printf(
+					&color, 
+					"%.*s\n", 
+					(int)token.len, 
+					token.text
+				);
 			}
 			printf("\n(%f ms)\n\n", timeelapsed);
 		}
 
 		timestart = getperformancecount();
-		struct erw_ASTNode* ast = erw_parse(tokens, lines);
+		struct erw_AST ast = erw_parse(&tokens, &lines);
 		timestop = getperformancecount();
 		timeelapsed = (timestop - timestart) * 1000.0 / getperformancefreq();
 		if(argparser.results[2].used)
 		{ 
 			ansicode_printf(&titlecolor, "\nAbstract Syntax Tree:\n\n");
-			erw_ast_print(ast);
+			erw_ast_print(&ast);
 			putchar('\n');
 			printf("(%f ms)\n\n", timeelapsed);
 		}
 
 		timestart = getperformancecount();
-		struct erw_Scope* scope = erw_checksemantics(ast, lines);
+		struct erw_Scope* scope = erw_checksemantics(&ast, &lines);
 		timestop = getperformancecount();
 		timeelapsed = (timestop - timestart) * 1000.0 / getperformancefreq();
 		if(argparser.results[3].used)
 		{ 
 			ansicode_printf(&titlecolor, "\nSymbol Table:\n\n");
-			erw_scope_print(scope, lines);
+			erw_scope_print(scope, &lines);
 			putchar('\n');
 			printf("(%f ms)\n\n", timeelapsed);
 		}
 
+		//Only programs using types that fit in registers can be lowered yet
+		if(argparser.results[6].used 
+			|| argparser.results[7].used 
+			|| argparser.results[8].used
+			|| argparser.results[13].used)
+		{
+			timestart = getperformancecount();
+			struct erw_Bytecode bytecode = erw_bytecode_generate(
+				&ast, 
+				scope, 
+				&lines
+			);
+			erw_regalloc_allocate(&bytecode);
+			erw_peephole_optimize(&bytecode);
+			Vec(uint8_t) data = erw_bytecode_serialize(&bytecode);
+			struct erw_BytecodeImage image;
+			erw_bytecodeimage_ctor(&image, data, vec_getsize(data));
+			erw_bytecode_dtor(&bytecode);
+			timestop = getperformancecount();
+			timeelapsed = (timestop - timestart) * 1000.0 
+				/ getperformancefreq();
+			if(argparser.results[8].used)
+			{
+				erw_bytecodeimage_save(&image, argparser.results[8].arg);
+			}
+
+			runbytecode(&image, &argparser, timeelapsed);
+			erw_bytecodeimage_dtor(&image);
+			vec_dtor(data);
+		}
+
 		/*
 		//erw_optimize(ast, scope);
 		//erw_interpret(ast, scope);
@@ -250,15 +462,12 @@ int main(int argc, char* argv[])
 
 		//Cleanup
 		erw_scope_dtor(scope);
-		erw_ast_dtor(ast);
-		erw_tokens_delete(tokens);
-
-		for(size_t i = 0; i < vec_getsize(lines); i++)
-		{
-			str_dtor(&lines[i]);
-		}
+		erw_ast_dtor(&ast);
+		erw_tokenstream_dtor(&tokens);
+		erw_type_clear();
+		erw_intern_clear();
 
-		vec_dtor(lines);
+		erw_lines_dtor(&lines);
 		file_dtor(&file);
 
 		printf(
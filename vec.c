@@ -1,4 +1,5 @@
 #include "vec.h"
+#include "arena.h"
 #include "log.h"
 #include <stdlib.h>
 
@@ -10,6 +11,7 @@
 
 struct Vec_
 {
+	struct Arena* arena; //NULL if allocated with malloc
 	size_t size;
 	size_t buffersize;
 	size_t elementsize;
@@ -30,6 +32,28 @@ Vec(void) vec_ctor_(size_t elementsize, size_t elements)
 		log_error("malloc failed, in <%s>", __func__);
 	}
 
+	self->arena = NULL;
+	self->buffersize = buffersize;
+	self->elementsize = elementsize;
+	self->size = 0;
+
+	return self->buffer;
+}
+
+Vec(void) vec_ctorinarena_(
+	size_t elementsize, 
+	size_t elements, 
+	struct Arena* arena)
+{
+	log_assert(elementsize, "must be at least 1");
+	log_assert(arena, "is NULL");
+
+	//If elements is 0, use default size
+	size_t buffersize = (elements ? elements : VEC_DEFAULT_SIZE) 
+		* elementsize;
+	struct Vec_* self = arena_alloc(arena, sizeof(struct Vec_) + buffersize);
+
+	self->arena = arena;
 	self->buffersize = buffersize;
 	self->elementsize = elementsize;
 	self->size = 0;
@@ -42,7 +66,10 @@ void vec_dtor_(Vec(void) vec)
 	log_assert(vec, "is NULL");
 
 	struct Vec_* self = vec_tovector(vec);
-	free(self);
+	if(!self->arena)
+	{
+		free(self);
+	}
 }
 
 size_t vec_getsize_(Vec(void) vec)
@@ -67,7 +94,31 @@ void vec_expand_(Vec(void) vec, size_t pos, size_t elements)
 	);
 
 	self->size += elements;
-	if(self->buffersize < self->size * self->elementsize)
+	if(self->arena && self->buffersize < self->size * self->elementsize)
+	{
+		//Arena memory can't be reallocated. Grow geometrically and leave the 
+		//old buffer to the arena, which bounds the waste to the final size
+		size_t buffersize = self->buffersize * 2;
+		if(buffersize < self->size * self->elementsize)
+		{
+			buffersize = self->size * self->elementsize;
+		}
+
+		struct Vec_* newself = arena_alloc(
+			self->arena, 
+			sizeof(struct Vec_) + buffersize
+		);
+		memcpy(
+			newself, 
+			self, 
+			sizeof(struct Vec_) + (self->size - elements) * self->elementsize
+		);
+
+		newself->buffersize = buffersize;
+		self = newself;
+		*(void**)vec = self->buffer;
+	}
+	else if(self->buffersize < self->size * self->elementsize)
 	{
 		self->buffersize = self->size * self->elementsize + 
 			self->elementsize * VEC_NEW_SIZE;
@@ -6,9 +6,14 @@
 
 #define Vec(T) T*
 
+struct Arena;
+
 //Function wrappers
 #define vec_ctor(T, n) \
 	(T*)vec_ctor_(sizeof(T), (n))
+//NOTE: Memory of vecs created in an arena is owned by the arena
+#define vec_ctorinarena(T, n, a) \
+	(T*)vec_ctorinarena_(sizeof(T), (n), (a))
 #define vec_dtor(v) \
 	vec_dtor_(&(v))
 #define vec_getsize(v) \
@@ -48,6 +53,11 @@
 	memcpy((v), (a), (n) * sizeof(*(a)))
 
 Vec(void) vec_ctor_(size_t elementsize, size_t elements);
+Vec(void) vec_ctorinarena_(
+	size_t elementsize, 
+	size_t elements, 
+	struct Arena* arena
+);
 void vec_dtor_(Vec(void) vec);
 size_t vec_getsize_(Vec(void) vec);
 void vec_expand_(Vec(void) vec, size_t pos, size_t elements);